@@ -0,0 +1,804 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef INCLUDED_BLPARROWWRITER
+#define INCLUDED_BLPARROWWRITER
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace BloombergLP {
+
+// FlatBufferBuilder builds the little Flatbuffers metadata the Arrow IPC
+// format needs, the way the Flatbuffers library does: the buffer grows
+// towards its front, and every object is identified by its distance from
+// the end of the buffer, which does not change as more is prepended.
+// Scalars are written little-endian whatever the host.
+class FlatBufferBuilder
+{
+  public:
+    typedef unsigned Offset;
+
+  private:
+    std::vector<char>                     d_buffer;
+    size_t                                d_head;      // first byte in use
+    size_t                                d_minAlign;
+    Offset                                d_tableStart;
+    std::vector<std::pair<int, Offset> >  d_fields;    // slot and location
+
+    FlatBufferBuilder(const FlatBufferBuilder&);
+    FlatBufferBuilder& operator=(const FlatBufferBuilder&);
+
+    void reserve(size_t numBytes);
+
+    void putLittleEndian(unsigned long long value, size_t numBytes);
+
+  public:
+    FlatBufferBuilder();
+
+    Offset size() const;
+
+    void prep(size_t alignment, size_t additionalBytes);
+        // Pad so that 'additionalBytes' bytes prepended after the padding
+        // leave the front of the buffer aligned to 'alignment'.
+
+    void pad(size_t numBytes);
+
+    void putInt8(int value);
+    void putInt16(int value);
+    void putInt32(int value);
+    void putInt64(long long value);
+        // Prepend 'value' without any alignment.
+
+    Offset createString(const std::string& value);
+
+    void startVector(size_t elementSize, size_t count, size_t alignment);
+        // Begin a vector of 'count' elements, which are then prepended last
+        // first.
+
+    Offset endVector(size_t count);
+
+    void addOffsetElement(Offset target);
+        // Prepend to the vector being built a reference to 'target'.
+
+    void startTable();
+
+    void addInt8(int slot, int value);
+    void addInt16(int slot, int value);
+    void addInt32(int slot, int value);
+    void addInt64(int slot, long long value);
+    void addOffset(int slot, Offset target);
+
+    Offset endTable();
+
+    void finish(Offset root);
+
+    const char *data() const;
+};
+
+// ArrowFileWriter writes columns in the Arrow IPC file format, also known
+// as Feather version 2, which 'pyarrow.feather.read_table',
+// 'pandas.read_feather' and the other Arrow implementations read without
+// any conversion, and which 'pyarrow.parquet.write_table' turns into
+// Parquet.  It needs nothing but the standard library.
+//
+// Columns are declared with 'addColumn' before 'open'.  Rows are written a
+// batch at a time with 'beginBatch', one 'append' per column in the order
+// the columns were declared, and 'endBatch', so a long history can be
+// written as it is received with the same buffers reused for every batch.
+// No column has nulls.  The file is only readable once 'close', which the
+// destructor calls, has written its footer.
+class ArrowFileWriter
+{
+  public:
+    enum Type {
+        e_INT32,
+        e_INT64,
+        e_FLOAT64,
+        e_TIMESTAMP_NS,  // 'long long' nanoseconds since the epoch, in UTC
+        e_UTF8
+    };
+
+  private:
+    struct Column {
+        std::string d_name;
+        Type        d_type;
+    };
+
+    struct Block {
+        long long d_offset;
+        int       d_metadataLength;
+        long long d_bodyLength;
+    };
+
+    std::vector<Column>                        d_columns;
+    std::vector<Block>                         d_blocks;
+    std::FILE                                 *d_file_p;
+    long long                                  d_position;
+    bool                                       d_failed;
+    long long                                  d_numRowsWritten;
+
+    // The batch being built.
+    size_t                                     d_numRows;
+    size_t                                     d_nextColumn;
+    std::string                                d_body;
+    std::vector<std::pair<long long, long long> >
+                                               d_bufferRefs;
+
+    ArrowFileWriter(const ArrowFileWriter&);
+    ArrowFileWriter& operator=(const ArrowFileWriter&);
+
+    void write(const void *data, size_t length);
+
+    void addBuffer(const void *data, size_t length);
+        // Append to the body of the batch a buffer of 'length' bytes padded
+        // to 8 bytes, as the format requires.
+
+    void nextColumn(Type type);
+
+    FlatBufferBuilder::Offset buildSchema(FlatBufferBuilder *builder) const;
+
+    Block writeMessage(const FlatBufferBuilder& metadata,
+                       const std::string&       body);
+        // Write an encapsulated message: a continuation marker, the length
+        // of the metadata, the metadata padded to 8 bytes and then 'body'.
+
+    static bool isLittleEndian();
+
+  public:
+    ArrowFileWriter();
+
+    ~ArrowFileWriter();
+
+    void addColumn(const std::string& name, Type type);
+
+    int open(const char *path);
+        // Create the file at 'path' and write its schema.  Return 0 on
+        // success.
+
+    void beginBatch(size_t numRows);
+
+    void append(const std::vector<int>& values);
+        // Write the first 'numRows' values of the next column, which must be
+        // 'e_INT32'.
+
+    void append(const std::vector<long long>& values);
+        // Write the first 'numRows' values of the next column, which must be
+        // 'e_INT64' or 'e_TIMESTAMP_NS'.
+
+    void append(const std::vector<double>& values);
+        // Write the first 'numRows' values of the next column, which must be
+        // 'e_FLOAT64'.
+
+    void append(const std::vector<unsigned>&    indices,
+                const std::vector<std::string>& dictionary);
+        // Write the strings 'dictionary[indices[i]]' of the first 'numRows'
+        // rows to the next column, which must be 'e_UTF8'.
+
+    void endBatch();
+
+    int close();
+        // Write the footer and close the file.  Return 0 if every write
+        // succeeded.
+
+    bool isOpen() const;
+
+    long long numRowsWritten() const;
+
+    size_t numBatchesWritten() const;
+};
+
+                            // -----------------
+                            // FlatBufferBuilder
+                            // -----------------
+
+inline
+FlatBufferBuilder::FlatBufferBuilder()
+: d_buffer(1024)
+, d_head(1024)
+, d_minAlign(1)
+, d_tableStart(0)
+{
+}
+
+inline
+void FlatBufferBuilder::reserve(size_t numBytes)
+{
+    if (d_head >= numBytes) {
+        return;
+    }
+    size_t used     = d_buffer.size() - d_head;
+    size_t capacity = d_buffer.size() * 2;
+    while (capacity - used < numBytes) {
+        capacity *= 2;
+    }
+    std::vector<char> buffer(capacity);
+    if (used) {
+        std::memcpy(&buffer[capacity - used], &d_buffer[d_head], used);
+    }
+    d_buffer.swap(buffer);
+    d_head = capacity - used;
+}
+
+inline
+void FlatBufferBuilder::putLittleEndian(unsigned long long value,
+                                        size_t             numBytes)
+{
+    reserve(numBytes);
+    d_head -= numBytes;
+    for (size_t i = 0; i < numBytes; ++i) {
+        d_buffer[d_head + i] = static_cast<char>(value >> (8 * i) & 0xff);
+    }
+}
+
+inline
+FlatBufferBuilder::Offset FlatBufferBuilder::size() const
+{
+    return static_cast<Offset>(d_buffer.size() - d_head);
+}
+
+inline
+void FlatBufferBuilder::prep(size_t alignment, size_t additionalBytes)
+{
+    if (alignment > d_minAlign) {
+        d_minAlign = alignment;
+    }
+    pad((alignment - (size() + additionalBytes) % alignment) % alignment);
+}
+
+inline
+void FlatBufferBuilder::pad(size_t numBytes)
+{
+    for (size_t i = 0; i < numBytes; ++i) {
+        putLittleEndian(0, 1);
+    }
+}
+
+inline
+void FlatBufferBuilder::putInt8(int value)
+{
+    putLittleEndian(static_cast<unsigned long long>(value), 1);
+}
+
+inline
+void FlatBufferBuilder::putInt16(int value)
+{
+    putLittleEndian(static_cast<unsigned long long>(value), 2);
+}
+
+inline
+void FlatBufferBuilder::putInt32(int value)
+{
+    putLittleEndian(static_cast<unsigned long long>(value), 4);
+}
+
+inline
+void FlatBufferBuilder::putInt64(long long value)
+{
+    putLittleEndian(static_cast<unsigned long long>(value), 8);
+}
+
+inline
+FlatBufferBuilder::Offset FlatBufferBuilder::createString(
+                                                     const std::string& value)
+{
+    prep(4, value.size() + 1);
+    putInt8(0);
+    reserve(value.size());
+    d_head -= value.size();
+    if (!value.empty()) {
+        std::memcpy(&d_buffer[d_head], value.data(), value.size());
+    }
+    putInt32(static_cast<int>(value.size()));
+    return size();
+}
+
+inline
+void FlatBufferBuilder::startVector(size_t elementSize,
+                                    size_t count,
+                                    size_t alignment)
+{
+    prep(4, elementSize * count);
+    prep(alignment, elementSize * count);
+}
+
+inline
+FlatBufferBuilder::Offset FlatBufferBuilder::endVector(size_t count)
+{
+    putInt32(static_cast<int>(count));
+    return size();
+}
+
+inline
+void FlatBufferBuilder::addOffsetElement(Offset target)
+{
+    prep(4, 0);
+    putInt32(static_cast<int>(size() + 4 - target));
+}
+
+inline
+void FlatBufferBuilder::startTable()
+{
+    d_fields.clear();
+    d_tableStart = size();
+}
+
+inline
+void FlatBufferBuilder::addInt8(int slot, int value)
+{
+    putInt8(value);
+    d_fields.push_back(std::make_pair(slot, size()));
+}
+
+inline
+void FlatBufferBuilder::addInt16(int slot, int value)
+{
+    prep(2, 0);
+    putInt16(value);
+    d_fields.push_back(std::make_pair(slot, size()));
+}
+
+inline
+void FlatBufferBuilder::addInt32(int slot, int value)
+{
+    prep(4, 0);
+    putInt32(value);
+    d_fields.push_back(std::make_pair(slot, size()));
+}
+
+inline
+void FlatBufferBuilder::addInt64(int slot, long long value)
+{
+    prep(8, 0);
+    putInt64(value);
+    d_fields.push_back(std::make_pair(slot, size()));
+}
+
+inline
+void FlatBufferBuilder::addOffset(int slot, Offset target)
+{
+    addOffsetElement(target);
+    d_fields.push_back(std::make_pair(slot, size()));
+}
+
+inline
+FlatBufferBuilder::Offset FlatBufferBuilder::endTable()
+{
+    // The table starts with the distance back to its vtable, which is
+    // prepended right before it.
+    prep(4, 0);
+    putInt32(0);
+    Offset table = size();
+
+    int numSlots = 0;
+    for (size_t i = 0; i < d_fields.size(); ++i) {
+        if (d_fields[i].first + 1 > numSlots) {
+            numSlots = d_fields[i].first + 1;
+        }
+    }
+    std::vector<int> fieldOffsets(numSlots, 0);
+    for (size_t i = 0; i < d_fields.size(); ++i) {
+        fieldOffsets[d_fields[i].first] = table - d_fields[i].second;
+    }
+    for (int slot = numSlots - 1; slot >= 0; --slot) {
+        putInt16(fieldOffsets[slot]);
+    }
+    putInt16(static_cast<int>(table - d_tableStart));
+    putInt16((numSlots + 2) * 2);
+
+    Offset       vtable   = size();
+    unsigned     distance = vtable - table;
+    const size_t position = d_buffer.size() - table;
+    for (size_t i = 0; i < 4; ++i) {
+        d_buffer[position + i] = static_cast<char>(distance >> (8 * i) & 0xff);
+    }
+    d_fields.clear();
+    return table;
+}
+
+inline
+void FlatBufferBuilder::finish(Offset root)
+{
+    prep(d_minAlign, 4);
+    addOffsetElement(root);
+}
+
+inline
+const char *FlatBufferBuilder::data() const
+{
+    return &d_buffer[d_head];
+}
+
+                            // ---------------
+                            // ArrowFileWriter
+                            // ---------------
+
+namespace ArrowFormat {
+    // Values from the Arrow 'Schema.fbs', 'Message.fbs' and 'File.fbs'.
+
+    enum {
+        e_METADATA_V5 = 4
+    };
+
+    enum {
+        e_TYPE_INT            = 2,
+        e_TYPE_FLOATING_POINT = 3,
+        e_TYPE_UTF8           = 5,
+        e_TYPE_TIMESTAMP      = 10
+    };
+
+    enum {
+        e_HEADER_SCHEMA       = 1,
+        e_HEADER_RECORD_BATCH = 3
+    };
+
+    enum {
+        e_PRECISION_DOUBLE = 2,
+        e_UNIT_NANOSECOND  = 3
+    };
+
+    const char k_MAGIC[] = "ARROW1";
+}
+
+inline
+ArrowFileWriter::ArrowFileWriter()
+: d_file_p(0)
+, d_position(0)
+, d_failed(false)
+, d_numRowsWritten(0)
+, d_numRows(0)
+, d_nextColumn(0)
+{
+}
+
+inline
+ArrowFileWriter::~ArrowFileWriter()
+{
+    close();
+}
+
+inline
+bool ArrowFileWriter::isLittleEndian()
+{
+    const unsigned short one = 1;
+    return *reinterpret_cast<const unsigned char *>(&one) == 1;
+}
+
+inline
+void ArrowFileWriter::write(const void *data, size_t length)
+{
+    if (length && std::fwrite(data, 1, length, d_file_p) != length) {
+        d_failed = true;
+    }
+    d_position += length;
+}
+
+inline
+void ArrowFileWriter::addColumn(const std::string& name, Type type)
+{
+    assert(!d_file_p);
+    Column column;
+    column.d_name = name;
+    column.d_type = type;
+    d_columns.push_back(column);
+}
+
+inline
+FlatBufferBuilder::Offset ArrowFileWriter::buildSchema(
+                                            FlatBufferBuilder *builder) const
+{
+    std::vector<FlatBufferBuilder::Offset> fields;
+    for (size_t i = 0; i < d_columns.size(); ++i) {
+        const Column& column = d_columns[i];
+
+        FlatBufferBuilder::Offset name = builder->createString(column.d_name);
+        FlatBufferBuilder::Offset timezone = 0;
+        if (column.d_type == e_TIMESTAMP_NS) {
+            timezone = builder->createString("UTC");
+        }
+        builder->startVector(4, 0, 4);
+        FlatBufferBuilder::Offset children = builder->endVector(0);
+
+        int typeType = ArrowFormat::e_TYPE_INT;
+        builder->startTable();
+        switch (column.d_type) {
+          case e_INT32:
+          case e_INT64:
+            builder->addInt32(0, column.d_type == e_INT32 ? 32 : 64);
+            builder->addInt8(1, 1);                            // is_signed
+            break;
+          case e_FLOAT64:
+            typeType = ArrowFormat::e_TYPE_FLOATING_POINT;
+            builder->addInt16(0, ArrowFormat::e_PRECISION_DOUBLE);
+            break;
+          case e_TIMESTAMP_NS:
+            typeType = ArrowFormat::e_TYPE_TIMESTAMP;
+            builder->addOffset(1, timezone);
+            builder->addInt16(0, ArrowFormat::e_UNIT_NANOSECOND);
+            break;
+          case e_UTF8:
+            typeType = ArrowFormat::e_TYPE_UTF8;
+            break;
+        }
+        FlatBufferBuilder::Offset type = builder->endTable();
+
+        builder->startTable();
+        builder->addOffset(0, name);
+        builder->addOffset(3, type);
+        builder->addOffset(5, children);
+        builder->addInt8(2, typeType);
+        builder->addInt8(1, 0);                                 // nullable
+        fields.push_back(builder->endTable());
+    }
+
+    builder->startVector(4, fields.size(), 4);
+    for (size_t i = fields.size(); i > 0; --i) {
+        builder->addOffsetElement(fields[i - 1]);
+    }
+    FlatBufferBuilder::Offset fieldVector = builder->endVector(fields.size());
+
+    builder->startTable();
+    builder->addOffset(1, fieldVector);
+    builder->addInt16(0, isLittleEndian() ? 0 : 1);          // endianness
+    return builder->endTable();
+}
+
+inline
+ArrowFileWriter::Block ArrowFileWriter::writeMessage(
+                                        const FlatBufferBuilder& metadata,
+                                        const std::string&       body)
+{
+    static const char padding[8] = { 0 };
+
+    Block block;
+    block.d_offset         = d_position;
+    block.d_metadataLength = static_cast<int>((metadata.size() + 8 + 7)
+                                                              / 8 * 8);
+    block.d_bodyLength     = static_cast<long long>(body.size());
+
+    FlatBufferBuilder prefix;
+    prefix.putInt32(block.d_metadataLength - 8);
+    prefix.putInt32(-1);                             // continuation marker
+    write(prefix.data(), prefix.size());
+    write(metadata.data(), metadata.size());
+    write(padding, block.d_metadataLength - 8 - metadata.size());
+    write(body.data(), body.size());
+    return block;
+}
+
+inline
+int ArrowFileWriter::open(const char *path)
+{
+    assert(!d_file_p);
+    d_file_p = std::fopen(path, "wb");
+    if (!d_file_p) {
+        return -1;
+    }
+    d_position       = 0;
+    d_failed         = false;
+    d_numRowsWritten = 0;
+    d_blocks.clear();
+
+    static const char padding[2] = { 0 };
+    write(ArrowFormat::k_MAGIC, 6);
+    write(padding, 2);
+
+    FlatBufferBuilder builder;
+    FlatBufferBuilder::Offset schema = buildSchema(&builder);
+    builder.startTable();
+    builder.addInt64(3, 0);                                 // bodyLength
+    builder.addOffset(2, schema);
+    builder.addInt16(0, ArrowFormat::e_METADATA_V5);
+    builder.addInt8(1, ArrowFormat::e_HEADER_SCHEMA);
+    builder.finish(builder.endTable());
+    writeMessage(builder, std::string());
+    return d_failed ? -1 : 0;
+}
+
+inline
+void ArrowFileWriter::beginBatch(size_t numRows)
+{
+    d_numRows    = numRows;
+    d_nextColumn = 0;
+    d_body.clear();
+    d_bufferRefs.clear();
+}
+
+inline
+void ArrowFileWriter::addBuffer(const void *data, size_t length)
+{
+    long long offset = static_cast<long long>(d_body.size());
+    if (length) {
+        d_body.append(static_cast<const char *>(data), length);
+    }
+    d_body.append((8 - length % 8) % 8, '\0');
+    d_bufferRefs.push_back(std::make_pair(offset,
+                                          static_cast<long long>(length)));
+}
+
+inline
+void ArrowFileWriter::nextColumn(Type type)
+{
+    assert(d_nextColumn < d_columns.size());
+    assert(d_columns[d_nextColumn].d_type == type
+        || (d_columns[d_nextColumn].d_type == e_TIMESTAMP_NS
+            && type == e_INT64));
+    (void)type;
+    ++d_nextColumn;
+
+    addBuffer(0, 0);                       // no validity bitmap: no nulls
+}
+
+inline
+void ArrowFileWriter::append(const std::vector<int>& values)
+{
+    assert(values.size() >= d_numRows);
+    nextColumn(e_INT32);
+    addBuffer(d_numRows ? &values[0] : 0, d_numRows * sizeof(int));
+}
+
+inline
+void ArrowFileWriter::append(const std::vector<long long>& values)
+{
+    assert(values.size() >= d_numRows);
+    nextColumn(e_INT64);
+    addBuffer(d_numRows ? &values[0] : 0, d_numRows * sizeof(long long));
+}
+
+inline
+void ArrowFileWriter::append(const std::vector<double>& values)
+{
+    assert(values.size() >= d_numRows);
+    nextColumn(e_FLOAT64);
+    addBuffer(d_numRows ? &values[0] : 0, d_numRows * sizeof(double));
+}
+
+inline
+void ArrowFileWriter::append(const std::vector<unsigned>&    indices,
+                             const std::vector<std::string>& dictionary)
+{
+    assert(indices.size() >= d_numRows);
+    nextColumn(e_UTF8);
+
+    std::vector<int> offsets(d_numRows + 1);
+    std::string      characters;
+    for (size_t i = 0; i < d_numRows; ++i) {
+        characters += dictionary[indices[i]];
+        offsets[i + 1] = static_cast<int>(characters.size());
+    }
+    addBuffer(&offsets[0], offsets.size() * sizeof(int));
+    addBuffer(characters.data(), characters.size());
+}
+
+inline
+void ArrowFileWriter::endBatch()
+{
+    assert(d_nextColumn == d_columns.size());
+    if (!d_file_p) {
+        return;
+    }
+
+    FlatBufferBuilder builder;
+    builder.startVector(16, d_bufferRefs.size(), 8);
+    for (size_t i = d_bufferRefs.size(); i > 0; --i) {
+        builder.putInt64(d_bufferRefs[i - 1].second);
+        builder.putInt64(d_bufferRefs[i - 1].first);
+    }
+    FlatBufferBuilder::Offset buffers =
+                                    builder.endVector(d_bufferRefs.size());
+
+    builder.startVector(16, d_columns.size(), 8);
+    for (size_t i = 0; i < d_columns.size(); ++i) {
+        builder.putInt64(0);                                 // null_count
+        builder.putInt64(static_cast<long long>(d_numRows));
+    }
+    FlatBufferBuilder::Offset nodes = builder.endVector(d_columns.size());
+
+    builder.startTable();
+    builder.addInt64(0, static_cast<long long>(d_numRows));
+    builder.addOffset(1, nodes);
+    builder.addOffset(2, buffers);
+    FlatBufferBuilder::Offset recordBatch = builder.endTable();
+
+    builder.startTable();
+    builder.addInt64(3, static_cast<long long>(d_body.size()));
+    builder.addOffset(2, recordBatch);
+    builder.addInt16(0, ArrowFormat::e_METADATA_V5);
+    builder.addInt8(1, ArrowFormat::e_HEADER_RECORD_BATCH);
+    builder.finish(builder.endTable());
+
+    d_blocks.push_back(writeMessage(builder, d_body));
+    d_numRowsWritten += d_numRows;
+}
+
+inline
+int ArrowFileWriter::close()
+{
+    if (!d_file_p) {
+        return 0;
+    }
+
+    // End of stream, then the footer.
+    FlatBufferBuilder endOfStream;
+    endOfStream.putInt32(0);
+    endOfStream.putInt32(-1);
+    write(endOfStream.data(), endOfStream.size());
+
+    FlatBufferBuilder builder;
+    FlatBufferBuilder::Offset schema = buildSchema(&builder);
+
+    builder.startVector(24, d_blocks.size(), 8);
+    for (size_t i = d_blocks.size(); i > 0; --i) {
+        const Block& block = d_blocks[i - 1];
+        builder.putInt64(block.d_bodyLength);
+        builder.pad(4);
+        builder.putInt32(block.d_metadataLength);
+        builder.putInt64(block.d_offset);
+    }
+    FlatBufferBuilder::Offset recordBatches =
+                                          builder.endVector(d_blocks.size());
+
+    builder.startVector(24, 0, 8);
+    FlatBufferBuilder::Offset dictionaries = builder.endVector(0);
+
+    builder.startTable();
+    builder.addOffset(1, schema);
+    builder.addOffset(2, dictionaries);
+    builder.addOffset(3, recordBatches);
+    builder.addInt16(0, ArrowFormat::e_METADATA_V5);
+    builder.finish(builder.endTable());
+
+    write(builder.data(), builder.size());
+    FlatBufferBuilder footerLength;
+    footerLength.putInt32(static_cast<int>(builder.size()));
+    write(footerLength.data(), footerLength.size());
+    write(ArrowFormat::k_MAGIC, 6);
+
+    if (std::fclose(d_file_p) != 0) {
+        d_failed = true;
+    }
+    d_file_p = 0;
+    return d_failed ? -1 : 0;
+}
+
+inline
+bool ArrowFileWriter::isOpen() const
+{
+    return d_file_p != 0;
+}
+
+inline
+long long ArrowFileWriter::numRowsWritten() const
+{
+    return d_numRowsWritten;
+}
+
+inline
+size_t ArrowFileWriter::numBatchesWritten() const
+{
+    return d_blocks.size();
+}
+
+} // namespace BloombergLP {
+
+#endif // INCLUDED_BLPARROWWRITER
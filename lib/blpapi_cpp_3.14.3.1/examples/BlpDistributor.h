@@ -0,0 +1,889 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef INCLUDED_BLPDISTRIBUTOR
+#define INCLUDED_BLPDISTRIBUTOR
+
+#include "BlpEntitlementCache.h"
+#include "BlpIdentityPool.h"
+#include "BlpThreadUtil.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif // _WIN32
+
+namespace BloombergLP {
+
+// SharedBuffer holds the bytes of one message, serialized once, for every
+// user the message is delivered to.  It is immutable once created and
+// reference counted: each 'BufferRef' to it holds one reference, and the
+// last one to go frees it.  References may be taken and dropped from any
+// thread.
+class SharedBuffer
+{
+    volatile long d_refs;
+    std::string   d_data;
+
+    SharedBuffer(const SharedBuffer&);
+    SharedBuffer& operator=(const SharedBuffer&);
+
+    SharedBuffer(const char *data, size_t length)
+    : d_refs(1)
+    , d_data(data, length)
+    {
+    }
+
+    friend class BufferRef;
+
+  public:
+    const char *data() const
+    {
+        return d_data.data();
+    }
+
+    size_t size() const
+    {
+        return d_data.size();
+    }
+};
+
+class BufferRef
+{
+    SharedBuffer *d_buffer_p;
+
+    void acquire();
+    void release();
+
+  public:
+    BufferRef();
+
+    BufferRef(const char *data, size_t length);
+        // Create a buffer holding a copy of the 'length' bytes at 'data'.
+
+    BufferRef(const BufferRef& other);
+
+    ~BufferRef();
+
+    BufferRef& operator=(const BufferRef& other);
+
+    const SharedBuffer *operator->() const;
+
+    bool isNull() const;
+};
+
+// DeliveryQueue holds the buffers not yet delivered to one user.  It never
+// holds more than 'capacity' buffers: a user that does not keep up loses
+// its oldest buffers, which are counted, rather than holding up the others
+// or growing without bound.
+class DeliveryQueue
+{
+    std::deque<BufferRef> d_buffers;
+    size_t                d_capacity;
+    size_t                d_dropped;
+    mutable Mutex         d_lock;
+
+    DeliveryQueue(const DeliveryQueue&);
+    DeliveryQueue& operator=(const DeliveryQueue&);
+
+  public:
+    explicit DeliveryQueue(size_t capacity);
+
+    bool push(const BufferRef& buffer);
+        // Append 'buffer' and return true if the queue was empty.
+
+    bool pop(BufferRef *buffer);
+
+    size_t size() const;
+
+    size_t dropped() const;
+};
+
+class DeliveryObserver
+{
+  public:
+    virtual ~DeliveryObserver() {}
+
+    virtual void onDeliverable(size_t user) = 0;
+        // Called by 'Distributor::publish' when the queue of 'user' stops
+        // being empty.
+};
+
+// Distributor fans messages out to the users of an 'IdentityPool'.  Each
+// message is serialized once by the caller into a 'BufferRef' and
+// 'publish'ed to the set of users entitled to it, as an 'EntitlementCache'
+// computes it; every user's 'DeliveryQueue' then holds a reference to the
+// same buffer.  Buffers are taken off the queues by a transport (see
+// 'UnixSocketTransport') or by in-process consumers with 'pop'.
+//
+// 'publish' is called by one thread, 'pop' by any.
+class Distributor
+{
+    std::vector<DeliveryQueue *>  d_queues;
+    DeliveryObserver             *d_observer_p;
+    size_t                        d_published;
+    size_t                        d_deliveries;
+
+    Distributor(const Distributor&);
+    Distributor& operator=(const Distributor&);
+
+  public:
+    Distributor(size_t numUsers, size_t queueCapacity = 4096);
+
+    ~Distributor();
+
+    void setObserver(DeliveryObserver *observer);
+        // Set 'observer' to be told when a user has buffers to deliver.
+        // Must not be called while publishing.
+
+    static BufferRef frame(const std::string& payload);
+        // Return a buffer holding 'payload' preceded by its length as a
+        // 4-byte big-endian integer, the framing transports use.
+
+    size_t publish(const EntitlementCache::UserSet& users,
+                   const BufferRef&                 buffer);
+        // Queue 'buffer' for every user in 'users' and return the number of
+        // users it was queued for.
+
+    bool pop(size_t user, BufferRef *buffer);
+
+    size_t pending(size_t user) const;
+
+    size_t dropped(size_t user) const;
+
+    size_t numUsers() const;
+
+    size_t published() const;
+
+    size_t deliveries() const;
+        // Return the number of buffers queued, over every user.
+};
+
+#ifndef _WIN32
+
+// UnixSocketTransport serves the distributor's users over a Unix domain
+// stream socket.  A consumer connects to 'path' and writes the uuid of its
+// user in decimal followed by '\n'; from then on it reads the user's
+// frames, each a 4-byte big-endian length followed by that many bytes.  A
+// new connection for a user replaces the previous one, which is detached
+// from the user's queue before it is shut down.  A user with no consumer
+// connected keeps queueing, within its queue's capacity.
+//
+// The uuid a consumer states is only trusted as far as the peer's
+// credentials go, or any local process could claim an entitled user.  The
+// socket file is created with mode 0600, so by default only processes of
+// the transport's own user can connect, and every handshake must come from
+// that user.  To serve consumers running as other users, bind each of them
+// to its uid with 'setPeerUid' before 'start': the socket is then created
+// with mode 0666, and the handshake for a bound user is accepted only from
+// a peer whose uid, as the kernel reports it ('SO_PEERCRED' or
+// 'getpeereid'), is the one bound.  Keep the socket in a directory that
+// only those users can reach if other local users must not even connect.
+//
+// One thread, started by 'start', multiplexes every connection with
+// 'poll'; the distributor wakes it through a pipe when a user has something
+// to deliver.  Not available on Windows.
+class UnixSocketTransport : public DeliveryObserver
+{
+    struct Connection {
+        int         d_fd;
+        uid_t       d_peerUid;
+        size_t      d_user;         // valid once 'd_identified'
+        bool        d_identified;
+        std::string d_handshake;
+        BufferRef   d_current;      // being written
+        size_t      d_offset;
+    };
+
+    Distributor             *d_distributor_p;
+    const IdentityPool      *d_identities_p;
+    std::string              d_path;
+    int                      d_listenFd;
+    int                      d_wakeFds[2];
+    std::vector<Connection>  d_connections;
+    std::vector<uid_t>       d_peerUids;   // by user, 'k_NO_UID' if unbound
+    pthread_t                d_thread;
+    bool                     d_started;
+    volatile bool            d_running;
+    size_t                   d_framesSent;
+    size_t                   d_accepted;
+
+    UnixSocketTransport(const UnixSocketTransport&);
+    UnixSocketTransport& operator=(const UnixSocketTransport&);
+
+    static void *threadFunction(void *transport);
+
+    void run();
+
+    void accept();
+
+    bool readHandshake(Connection *connection);
+        // Read from 'connection' and return false if it must be closed.
+
+    bool flush(Connection *connection);
+        // Write as much as the socket takes and return false if
+        // 'connection' must be closed.
+
+    static bool setNonBlocking(int fd);
+
+    static bool peerUid(uid_t *uid, int fd);
+        // Load into 'uid' the effective uid of the process connected on
+        // 'fd' and return true, or return false if it is not known.
+
+    bool isPeerAllowed(const Connection& connection, size_t user) const;
+
+  public:
+    static const uid_t k_NO_UID = static_cast<uid_t>(-1);
+
+    UnixSocketTransport(Distributor        *distributor,
+                        const IdentityPool *identities,
+                        const std::string&  path);
+
+    ~UnixSocketTransport();
+
+    void setPeerUid(size_t user, uid_t uid);
+        // Accept consumers of 'user' only from processes running as 'uid',
+        // and let processes of other users connect to the socket.  Must be
+        // called before 'start'.
+
+    bool start();
+        // Listen on the path, replacing any socket file there, and start
+        // the I/O thread.  Return false on failure.
+
+    void stop();
+
+    virtual void onDeliverable(size_t user);
+
+    size_t framesSent() const;
+
+    size_t accepted() const;
+};
+
+#endif // _WIN32
+
+// ============================================================================
+//                      INLINE FUNCTION DEFINITIONS
+// ============================================================================
+
+                        // ---------------
+                        // class BufferRef
+                        // ---------------
+
+inline
+void BufferRef::acquire()
+{
+    if (d_buffer_p) {
+#ifdef _WIN32
+        InterlockedIncrement(&d_buffer_p->d_refs);
+#else
+        __sync_add_and_fetch(&d_buffer_p->d_refs, 1);
+#endif
+    }
+}
+
+inline
+void BufferRef::release()
+{
+    if (d_buffer_p) {
+#ifdef _WIN32
+        long refs = InterlockedDecrement(&d_buffer_p->d_refs);
+#else
+        long refs = __sync_sub_and_fetch(&d_buffer_p->d_refs, 1);
+#endif
+        if (refs == 0) {
+            delete d_buffer_p;
+        }
+        d_buffer_p = 0;
+    }
+}
+
+inline
+BufferRef::BufferRef()
+: d_buffer_p(0)
+{
+}
+
+inline
+BufferRef::BufferRef(const char *data, size_t length)
+: d_buffer_p(new SharedBuffer(data, length))
+{
+}
+
+inline
+BufferRef::BufferRef(const BufferRef& other)
+: d_buffer_p(other.d_buffer_p)
+{
+    acquire();
+}
+
+inline
+BufferRef::~BufferRef()
+{
+    release();
+}
+
+inline
+BufferRef& BufferRef::operator=(const BufferRef& other)
+{
+    if (d_buffer_p != other.d_buffer_p) {
+        release();
+        d_buffer_p = other.d_buffer_p;
+        acquire();
+    }
+    return *this;
+}
+
+inline
+const SharedBuffer *BufferRef::operator->() const
+{
+    return d_buffer_p;
+}
+
+inline
+bool BufferRef::isNull() const
+{
+    return d_buffer_p == 0;
+}
+
+                        // -------------------
+                        // class DeliveryQueue
+                        // -------------------
+
+inline
+DeliveryQueue::DeliveryQueue(size_t capacity)
+: d_capacity(capacity > 0 ? capacity : 1)
+, d_dropped(0)
+{
+}
+
+inline
+bool DeliveryQueue::push(const BufferRef& buffer)
+{
+    MutexGuard guard(&d_lock);
+    if (d_buffers.size() == d_capacity) {
+        d_buffers.pop_front();
+        ++d_dropped;
+    }
+    d_buffers.push_back(buffer);
+    return d_buffers.size() == 1;
+}
+
+inline
+bool DeliveryQueue::pop(BufferRef *buffer)
+{
+    MutexGuard guard(&d_lock);
+    if (d_buffers.empty()) {
+        return false;
+    }
+    *buffer = d_buffers.front();
+    d_buffers.pop_front();
+    return true;
+}
+
+inline
+size_t DeliveryQueue::size() const
+{
+    MutexGuard guard(&d_lock);
+    return d_buffers.size();
+}
+
+inline
+size_t DeliveryQueue::dropped() const
+{
+    MutexGuard guard(&d_lock);
+    return d_dropped;
+}
+
+                        // -----------------
+                        // class Distributor
+                        // -----------------
+
+inline
+Distributor::Distributor(size_t numUsers, size_t queueCapacity)
+: d_observer_p(0)
+, d_published(0)
+, d_deliveries(0)
+{
+    d_queues.reserve(numUsers);
+    for (size_t i = 0; i < numUsers; ++i) {
+        d_queues.push_back(new DeliveryQueue(queueCapacity));
+    }
+}
+
+inline
+Distributor::~Distributor()
+{
+    for (size_t i = 0; i < d_queues.size(); ++i) {
+        delete d_queues[i];
+    }
+}
+
+inline
+void Distributor::setObserver(DeliveryObserver *observer)
+{
+    d_observer_p = observer;
+}
+
+inline
+BufferRef Distributor::frame(const std::string& payload)
+{
+    std::string   framed(4 + payload.size(), '\0');
+    unsigned long length = static_cast<unsigned long>(payload.size());
+    framed[0] = static_cast<char>(length >> 24 & 0xff);
+    framed[1] = static_cast<char>(length >> 16 & 0xff);
+    framed[2] = static_cast<char>(length >> 8 & 0xff);
+    framed[3] = static_cast<char>(length & 0xff);
+    if (!payload.empty()) {
+        std::memcpy(&framed[4], payload.data(), payload.size());
+    }
+    return BufferRef(framed.data(), framed.size());
+}
+
+inline
+size_t Distributor::publish(const EntitlementCache::UserSet& users,
+                            const BufferRef&                 buffer)
+{
+    typedef EntitlementCache::Word Word;
+
+    size_t numQueued = 0;
+    for (size_t w = 0; w < users.size(); ++w) {
+        for (Word bits = users[w]; bits; bits &= bits - 1) {
+            // Find the lowest bit set.
+            size_t bit = 0;
+            while (!(bits >> bit & 1)) {
+                ++bit;
+            }
+            size_t user = w * EntitlementCache::k_BITS_PER_WORD + bit;
+            if (user >= d_queues.size()) {
+                break;
+            }
+            if (d_queues[user]->push(buffer) && d_observer_p) {
+                d_observer_p->onDeliverable(user);
+            }
+            ++numQueued;
+        }
+    }
+    ++d_published;
+    d_deliveries += numQueued;
+    return numQueued;
+}
+
+inline
+bool Distributor::pop(size_t user, BufferRef *buffer)
+{
+    return d_queues[user]->pop(buffer);
+}
+
+inline
+size_t Distributor::pending(size_t user) const
+{
+    return d_queues[user]->size();
+}
+
+inline
+size_t Distributor::dropped(size_t user) const
+{
+    return d_queues[user]->dropped();
+}
+
+inline
+size_t Distributor::numUsers() const
+{
+    return d_queues.size();
+}
+
+inline
+size_t Distributor::published() const
+{
+    return d_published;
+}
+
+inline
+size_t Distributor::deliveries() const
+{
+    return d_deliveries;
+}
+
+#ifndef _WIN32
+
+                        // -------------------------
+                        // class UnixSocketTransport
+                        // -------------------------
+
+inline
+UnixSocketTransport::UnixSocketTransport(Distributor        *distributor,
+                                         const IdentityPool *identities,
+                                         const std::string&  path)
+: d_distributor_p(distributor)
+, d_identities_p(identities)
+, d_path(path)
+, d_listenFd(-1)
+, d_started(false)
+, d_running(false)
+, d_framesSent(0)
+, d_accepted(0)
+{
+    d_wakeFds[0] = -1;
+    d_wakeFds[1] = -1;
+}
+
+inline
+UnixSocketTransport::~UnixSocketTransport()
+{
+    stop();
+}
+
+inline
+bool UnixSocketTransport::setNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+inline
+bool UnixSocketTransport::peerUid(uid_t *uid, int fd)
+{
+#if defined(SO_PEERCRED)
+    ucred     credentials;
+    socklen_t length = sizeof(credentials);
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length) != 0) {
+        return false;
+    }
+    *uid = credentials.uid;
+    return true;
+#else
+    gid_t gid;
+    return getpeereid(fd, uid, &gid) == 0;
+#endif
+}
+
+inline
+bool UnixSocketTransport::isPeerAllowed(const Connection& connection,
+                                        size_t            user) const
+{
+    uid_t allowed = k_NO_UID;
+    if (user < d_peerUids.size()) {
+        allowed = d_peerUids[user];
+    }
+    if (allowed == k_NO_UID) {
+        allowed = geteuid();
+    }
+    return connection.d_peerUid == allowed;
+}
+
+inline
+void UnixSocketTransport::setPeerUid(size_t user, uid_t uid)
+{
+    if (d_peerUids.size() <= user) {
+        d_peerUids.resize(user + 1, static_cast<uid_t>(k_NO_UID));
+    }
+    d_peerUids[user] = uid;
+}
+
+inline
+bool UnixSocketTransport::start()
+{
+    sockaddr_un address;
+    if (d_started || d_path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strcpy(address.sun_path, d_path.c_str());
+
+    d_listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (d_listenFd == -1) {
+        return false;
+    }
+    // Nothing can connect before 'listen', so the mode is set in time.
+    const mode_t mode = d_peerUids.empty() ? 0600 : 0666;
+    unlink(d_path.c_str());
+    if (bind(d_listenFd, (sockaddr *)&address, sizeof(address)) != 0
+            || chmod(d_path.c_str(), mode) != 0
+            || listen(d_listenFd, SOMAXCONN) != 0
+            || !setNonBlocking(d_listenFd)
+            || pipe(d_wakeFds) != 0) {
+        close(d_listenFd);
+        d_listenFd = -1;
+        return false;
+    }
+    setNonBlocking(d_wakeFds[0]);
+    setNonBlocking(d_wakeFds[1]);
+
+    d_distributor_p->setObserver(this);
+    d_running = true;
+    if (pthread_create(&d_thread, 0, &threadFunction, this) != 0) {
+        d_running = false;
+        d_distributor_p->setObserver(0);
+        return false;
+    }
+    d_started = true;
+    return true;
+}
+
+inline
+void UnixSocketTransport::stop()
+{
+    if (!d_started) {
+        return;
+    }
+    d_running = false;
+    onDeliverable(0);
+    pthread_join(d_thread, 0);
+    d_started = false;
+    d_distributor_p->setObserver(0);
+
+    for (size_t i = 0; i < d_connections.size(); ++i) {
+        close(d_connections[i].d_fd);
+    }
+    d_connections.clear();
+    close(d_listenFd);
+    close(d_wakeFds[0]);
+    close(d_wakeFds[1]);
+    unlink(d_path.c_str());
+}
+
+inline
+void UnixSocketTransport::onDeliverable(size_t)
+{
+    // A full pipe already has a wake-up pending.
+    char byte = 0;
+    ssize_t rc = write(d_wakeFds[1], &byte, 1);
+    (void)rc;
+}
+
+inline
+void *UnixSocketTransport::threadFunction(void *transport)
+{
+    static_cast<UnixSocketTransport *>(transport)->run();
+    return 0;
+}
+
+inline
+void UnixSocketTransport::run()
+{
+    std::vector<pollfd> fds;
+    while (d_running) {
+        fds.resize(2 + d_connections.size());
+        fds[0].fd     = d_listenFd;
+        fds[0].events = POLLIN;
+        fds[1].fd     = d_wakeFds[0];
+        fds[1].events = POLLIN;
+        for (size_t i = 0; i < d_connections.size(); ++i) {
+            Connection& connection = d_connections[i];
+            fds[2 + i].fd     = connection.d_fd;
+            fds[2 + i].events = POLLIN;
+            if (connection.d_identified
+                    && (!connection.d_current.isNull()
+                        || d_distributor_p->pending(connection.d_user))) {
+                fds[2 + i].events |= POLLOUT;
+            }
+        }
+        for (size_t i = 0; i < fds.size(); ++i) {
+            fds[i].revents = 0;
+        }
+
+        if (poll(&fds[0], fds.size(), 1000) < 0 && errno != EINTR) {
+            break;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            char buffer[256];
+            while (read(d_wakeFds[0], buffer, sizeof(buffer)) > 0) {
+            }
+        }
+
+        // Serve the connections polled, then close those that failed, before
+        // accepting new ones so that 'fds' still lines up.  A handshake may
+        // detach another connection, so none is copied until all are served.
+        std::vector<bool> keep(d_connections.size(), true);
+        for (size_t i = 0; i < d_connections.size(); ++i) {
+            Connection& connection = d_connections[i];
+            short       revents    = fds[2 + i].revents;
+            if (revents & (POLLERR | POLLNVAL)) {
+                keep[i] = false;
+            }
+            else if (revents & (POLLIN | POLLHUP)) {
+                keep[i] = readHandshake(&connection);
+            }
+            if (keep[i] && connection.d_identified) {
+                keep[i] = flush(&connection);
+            }
+        }
+        std::vector<Connection> open;
+        open.reserve(d_connections.size());
+        for (size_t i = 0; i < d_connections.size(); ++i) {
+            if (keep[i]) {
+                open.push_back(d_connections[i]);
+            }
+            else {
+                close(d_connections[i].d_fd);
+            }
+        }
+        d_connections.swap(open);
+
+        if (fds[0].revents & POLLIN) {
+            accept();
+        }
+    }
+}
+
+inline
+void UnixSocketTransport::accept()
+{
+    for (;;) {
+        int fd = ::accept(d_listenFd, 0, 0);
+        if (fd == -1) {
+            return;
+        }
+        if (!setNonBlocking(fd)) {
+            close(fd);
+            continue;
+        }
+#ifdef SO_NOSIGPIPE
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+        Connection connection;
+        if (!peerUid(&connection.d_peerUid, fd)) {
+            close(fd);
+            continue;
+        }
+        connection.d_fd         = fd;
+        connection.d_user       = 0;
+        connection.d_identified = false;
+        connection.d_offset     = 0;
+        d_connections.push_back(connection);
+        ++d_accepted;
+    }
+}
+
+inline
+bool UnixSocketTransport::readHandshake(Connection *connection)
+{
+    char    buffer[64];
+    ssize_t rc = read(connection->d_fd, buffer, sizeof(buffer));
+    if (rc == 0 || (rc < 0 && errno != EAGAIN && errno != EINTR)) {
+        return false;                                         // hung up
+    }
+    if (rc < 0 || connection->d_identified) {
+        return true;            // nothing read, or ignored after handshake
+    }
+
+    connection->d_handshake.append(buffer, rc);
+    size_t end = connection->d_handshake.find('\n');
+    if (end == std::string::npos) {
+        return connection->d_handshake.size() < 32;
+    }
+
+    int uuid = std::atoi(connection->d_handshake.substr(0, end).c_str());
+    for (size_t user = 0; user < d_identities_p->size(); ++user) {
+        if (d_identities_p->uuid(user) != uuid) {
+            continue;
+        }
+        if (!isPeerAllowed(*connection, user)) {
+            return false;                          // not that user's process
+        }
+        // The newest connection for a user replaces the others.  They are
+        // detached from the user's queue before being shut down, so that
+        // they no longer pop buffers only to fail sending them, and a frame
+        // one of them was part way through is sent whole to the new one.
+        for (size_t i = 0; i < d_connections.size(); ++i) {
+            Connection& other = d_connections[i];
+            if (&other != connection && other.d_identified
+                    && other.d_user == user) {
+                other.d_identified = false;
+                if (!other.d_current.isNull()) {
+                    connection->d_current = other.d_current;
+                    connection->d_offset  = 0;
+                    other.d_current       = BufferRef();
+                }
+                shutdown(other.d_fd, SHUT_RDWR);
+            }
+        }
+        connection->d_user       = user;
+        connection->d_identified = true;
+        return true;
+    }
+    return false;                                        // unknown user
+}
+
+inline
+bool UnixSocketTransport::flush(Connection *connection)
+{
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    for (;;) {
+        if (connection->d_current.isNull()) {
+            if (!d_distributor_p->pop(connection->d_user,
+                                      &connection->d_current)) {
+                return true;
+            }
+            connection->d_offset = 0;
+        }
+
+        const SharedBuffer *buffer = connection->d_current.operator->();
+        ssize_t rc = send(connection->d_fd,
+                          buffer->data() + connection->d_offset,
+                          buffer->size() - connection->d_offset,
+                          flags);
+        if (rc < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        connection->d_offset += rc;
+        if (connection->d_offset == buffer->size()) {
+            connection->d_current = BufferRef();
+            ++d_framesSent;
+        }
+    }
+}
+
+inline
+size_t UnixSocketTransport::framesSent() const
+{
+    return d_framesSent;
+}
+
+inline
+size_t UnixSocketTransport::accepted() const
+{
+    return d_accepted;
+}
+
+#endif // _WIN32
+
+} // namespace BloombergLP {
+
+#endif // INCLUDED_BLPDISTRIBUTOR
@@ -0,0 +1,246 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef INCLUDED_BLPENTITLEMENTCACHE
+#define INCLUDED_BLPENTITLEMENTCACHE
+
+#include "BlpIdentityPool.h"
+
+#include <blpapi_element.h>
+#include <blpapi_identity.h>
+#include <blpapi_service.h>
+
+#include <climits>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace BloombergLP {
+
+// EntitlementCache answers "which of the pool's users may see this
+// message" with a few word-wide ANDs instead of one
+// 'Identity::hasEntitlements' call per user.  It keeps, for each service
+// and EID it has seen, the set of ready users entitled to that EID as a
+// bitset indexed like the 'IdentityPool'.  A user is entitled to a message
+// if it is entitled to every EID of the message, so the users for a message
+// are the ready users ANDed with the bitset of each of its EIDs.  The bitset
+// of an EID is built the first time the EID is seen, with one
+// 'hasEntitlements' call per ready user.
+//
+// Every bitset is dropped when the pool's 'version' changes, that is when a
+// user is authorized or revoked or the entitlements of a user change, and
+// on 'invalidate', which event handlers call for AUTHORIZATION_STATUS
+// events.  The cache is not thread-safe; it is meant to be used by the
+// thread dispatching data.
+class EntitlementCache
+{
+  public:
+    typedef unsigned long     Word;
+    typedef std::vector<Word> UserSet;       // bit 'i' set for user 'i'
+
+    static const size_t k_BITS_PER_WORD = sizeof(Word) * CHAR_BIT;
+
+  private:
+    typedef std::pair<std::string, int> Key;  // service name and EID
+    typedef std::map<Key, UserSet>      UserSets;
+
+    const IdentityPool  *d_identities_p;
+    UserSets             d_userSets;
+    std::vector<size_t>  d_readyUsers;
+    UserSet              d_ready;
+    unsigned             d_version;
+    bool                 d_valid;
+
+    EntitlementCache(const EntitlementCache&);
+    EntitlementCache& operator=(const EntitlementCache&);
+
+    void refresh();
+        // Drop every bitset if the pool changed or the cache was
+        // invalidated.
+
+    const UserSet& usersEntitledTo(const blpapi::Service& service, int eid);
+
+  public:
+    explicit EntitlementCache(const IdentityPool *identities);
+
+    void entitledUsers(UserSet                *users,
+                       const blpapi::Service&  service,
+                       const blpapi::Element&  eids);
+        // Load into 'users' the ready users entitled to every EID in 'eids',
+        // an integer or array of integers, of 'service'.  If 'eids' is not
+        // valid, no entitlement is needed and every ready user is loaded.
+
+    void failedEntitlements(std::vector<int>       *failed,
+                            const blpapi::Service&  service,
+                            const blpapi::Element&  eids,
+                            size_t                  user);
+        // Load into 'failed' the EIDs in 'eids' that 'user' is not entitled
+        // to.
+
+    void readyUsers(UserSet *users);
+        // Load into 'users' every ready user.
+
+    void invalidate();
+
+    size_t numCachedEids() const;
+
+    static bool contains(const UserSet& users, size_t user);
+
+    static size_t count(const UserSet& users);
+};
+
+inline
+EntitlementCache::EntitlementCache(const IdentityPool *identities)
+: d_identities_p(identities)
+, d_version(0)
+, d_valid(false)
+{
+}
+
+inline
+void EntitlementCache::refresh()
+{
+    unsigned version = d_identities_p->version();
+    if (d_valid && version == d_version) {
+        return;
+    }
+
+    d_userSets.clear();
+    d_identities_p->ready(&d_readyUsers);
+    d_ready.assign((d_identities_p->size() + k_BITS_PER_WORD - 1)
+                                                           / k_BITS_PER_WORD,
+                   0);
+    for (size_t i = 0; i < d_readyUsers.size(); ++i) {
+        size_t user = d_readyUsers[i];
+        d_ready[user / k_BITS_PER_WORD] |= Word(1) << user % k_BITS_PER_WORD;
+    }
+    d_version = version;
+    d_valid   = true;
+}
+
+inline
+const EntitlementCache::UserSet& EntitlementCache::usersEntitledTo(
+                                               const blpapi::Service& service,
+                                               int                    eid)
+{
+    Key                key(service.name(), eid);
+    UserSets::iterator it = d_userSets.find(key);
+    if (it != d_userSets.end()) {
+        return it->second;
+    }
+
+    UserSet& users = d_userSets[key];
+    users.assign(d_ready.size(), 0);
+    for (size_t i = 0; i < d_readyUsers.size(); ++i) {
+        size_t user = d_readyUsers[i];
+        if (d_identities_p->identity(user).hasEntitlements(service, &eid, 1)) {
+            users[user / k_BITS_PER_WORD] |=
+                                        Word(1) << user % k_BITS_PER_WORD;
+        }
+    }
+    return users;
+}
+
+inline
+void EntitlementCache::entitledUsers(UserSet                *users,
+                                     const blpapi::Service&  service,
+                                     const blpapi::Element&  eids)
+{
+    refresh();
+    *users = d_ready;
+    if (!eids.isValid()) {
+        return;
+    }
+
+    // 'numValues' is 1 for a single EID.
+    size_t numEids = eids.numValues();
+    for (size_t i = 0; i < numEids; ++i) {
+        int eid = eids.getValueAsInt32(i);
+        const UserSet& entitled = usersEntitledTo(service, eid);
+        for (size_t w = 0; w < users->size(); ++w) {
+            (*users)[w] &= entitled[w];
+        }
+    }
+}
+
+inline
+void EntitlementCache::failedEntitlements(std::vector<int>       *failed,
+                                          const blpapi::Service&  service,
+                                          const blpapi::Element&  eids,
+                                          size_t                  user)
+{
+    refresh();
+    failed->clear();
+    if (!eids.isValid()) {
+        return;
+    }
+
+    // 'numValues' is 1 for a single EID.
+    size_t numEids = eids.numValues();
+    for (size_t i = 0; i < numEids; ++i) {
+        int eid = eids.getValueAsInt32(i);
+        if (!contains(usersEntitledTo(service, eid), user)) {
+            failed->push_back(eid);
+        }
+    }
+}
+
+inline
+void EntitlementCache::readyUsers(UserSet *users)
+{
+    refresh();
+    *users = d_ready;
+}
+
+inline
+void EntitlementCache::invalidate()
+{
+    d_valid = false;
+}
+
+inline
+size_t EntitlementCache::numCachedEids() const
+{
+    return d_userSets.size();
+}
+
+inline
+bool EntitlementCache::contains(const UserSet& users, size_t user)
+{
+    size_t word = user / k_BITS_PER_WORD;
+    return word < users.size()
+        && (users[word] >> user % k_BITS_PER_WORD & 1) != 0;
+}
+
+inline
+size_t EntitlementCache::count(const UserSet& users)
+{
+    size_t total = 0;
+    for (size_t w = 0; w < users.size(); ++w) {
+        for (Word bits = users[w]; bits; bits &= bits - 1) {
+            ++total;
+        }
+    }
+    return total;
+}
+
+} // namespace BloombergLP {
+
+#endif // INCLUDED_BLPENTITLEMENTCACHE
@@ -0,0 +1,694 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef INCLUDED_BLPHISTORYDOWNLOADER
+#define INCLUDED_BLPHISTORYDOWNLOADER
+
+#include "BlpIntradayDecoder.h"
+
+#include <blpapi_correlationid.h>
+#include <blpapi_element.h>
+#include <blpapi_event.h>
+#include <blpapi_highresolutionclock.h>
+#include <blpapi_identity.h>
+#include <blpapi_message.h>
+#include <blpapi_name.h>
+#include <blpapi_request.h>
+#include <blpapi_service.h>
+#include <blpapi_session.h>
+#include <blpapi_timepoint.h>
+
+#include <cstdio>
+#include <deque>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace BloombergLP {
+
+// HistoryDownloader downloads the history of many securities and fields by
+// splitting it into HistoricalDataRequests small enough to be served
+// quickly, and keeping up to 'maxInFlight' of them outstanding, typically
+// 'SessionOptions::maxPendingRequests'.  'plan' cuts the download into
+// chunks, each a range of securities, a range of fields and a range of
+// dates, so that no chunk asks for more than 'HistoryLimits::d_maxPoints'
+// values (securities times fields times periods, estimated from the
+// periodicity).  The date range is only split once a single security has
+// too many values.
+//
+// Each attempt of a chunk is sent with a 'CorrelationId' of its own, made
+// of the chunk's index and the attempt number.  Its partial responses are
+// kept until its final response arrives and are then handed to the
+// 'HistoryHandler' together, so a chunk that fails, with a 'responseError'
+// or a 'RequestFailure', is retried as a whole, up to 'maxAttempts' times,
+// without anything being delivered twice.  An attempt that fails in a
+// partial response is cancelled, and any message of it still arriving is
+// ignored rather than taken for the retry's.
+//
+// The downloader is not thread-safe: 'processEvent' is meant to be called
+// by the one thread that reads the session's events, as 'run' does.
+
+struct HistoryChunk {
+    size_t       d_firstSecurity;
+    size_t       d_numSecurities;
+    size_t       d_firstField;
+    size_t       d_numFields;
+    std::string  d_startDate;      // YYYYMMDD
+    std::string  d_endDate;        // YYYYMMDD, inclusive
+    unsigned     d_attempts;
+};
+
+struct HistoryLimits {
+    size_t d_maxSecurities;        // per request
+    size_t d_maxFields;            // per request
+    size_t d_maxPoints;            // securities * fields * periods
+
+    HistoryLimits();
+};
+
+class HistoryHandler {
+  public:
+    virtual ~HistoryHandler();
+
+    virtual void onSecurityData(const blpapi::Element& securityData,
+                                const HistoryChunk&    chunk) = 0;
+        // Called for every 'securityData' of 'chunk' once all of it has
+        // arrived.  The history of a security comes in several chunks if its
+        // fields or dates were split.
+
+    virtual void onChunkDone(const HistoryChunk& chunk);
+
+    virtual void onChunkFailed(const HistoryChunk&    chunk,
+                               const blpapi::Message& reason);
+        // Called when the last attempt of 'chunk' failed with 'reason'.
+};
+
+class HistoryDownloader {
+  public:
+    struct Statistics {
+        size_t     d_numChunks;
+        size_t     d_sent;             // attempts, retries included
+        size_t     d_completed;
+        size_t     d_retried;
+        size_t     d_failed;
+        size_t     d_inFlight;
+        size_t     d_messages;
+        size_t     d_securities;       // 'securityData' delivered
+        size_t     d_points;           // 'fieldData' rows delivered
+        long long  d_elapsedNs;        // since 'start'
+        long long  d_chunkNs;          // summed over completed chunks
+
+        Statistics();
+    };
+
+  private:
+    struct Pending {
+        HistoryChunk                  d_chunk;
+        std::vector<blpapi::Message>  d_messages;
+        blpapi::TimePoint             d_sentAt;
+        bool                          d_inFlight;
+    };
+
+    blpapi::Session                                     *d_session_p;
+    blpapi::Service                                      d_service;
+    blpapi::Identity                                     d_identity;
+    HistoryHandler                                      *d_handler_p;
+    std::vector<std::string>                             d_securities;
+    std::vector<std::string>                             d_fields;
+    std::vector<std::pair<std::string, std::string> >    d_options;
+    std::vector<Pending>                                 d_chunks;
+    std::deque<size_t>                                   d_queue;
+    size_t                                               d_maxInFlight;
+    unsigned                                             d_maxAttempts;
+    Statistics                                           d_stats;
+    blpapi::TimePoint                                    d_startedAt;
+
+    HistoryDownloader(const HistoryDownloader&);
+    HistoryDownloader& operator=(const HistoryDownloader&);
+
+    void sendRequests();
+        // Send queued chunks until 'd_maxInFlight' are outstanding.
+
+    void complete(size_t chunk);
+
+    void fail(size_t chunk, const blpapi::Message& reason);
+
+    size_t chunkOf(const blpapi::Message& msg) const;
+        // Return the index of the outstanding chunk 'msg' answers, or the
+        // number of chunks if it answers none or an earlier attempt.
+
+    blpapi::CorrelationId correlationId(size_t index) const;
+        // Return the id of the current attempt of the chunk 'index'.
+
+    size_t periodsIn(long long numDays) const;
+        // Estimate the values per field and security in 'numDays' days at
+        // the requested periodicity.
+
+    static bool parseDate(long long *days, const std::string& date);
+        // Load into 'days' the days from 1970-01-01 to 'date', formatted
+        // YYYYMMDD.  Return false if 'date' is not a valid date.
+
+    static std::string formatDate(long long days);
+
+  public:
+    HistoryDownloader(blpapi::Session       *session,
+                      const blpapi::Service&  refDataService,
+                      HistoryHandler        *handler,
+                      size_t                 maxInFlight,
+                      unsigned               maxAttempts = 3);
+
+    void setIdentity(const blpapi::Identity& identity);
+
+    void addSecurity(const std::string& security);
+
+    void addField(const std::string& field);
+
+    void setOption(const std::string& name, const std::string& value);
+        // Set the element 'name' of every request to 'value', for example
+        // 'periodicitySelection' to 'MONTHLY'.
+
+    size_t plan(const std::string&   startDate,
+                const std::string&   endDate,
+                const HistoryLimits& limits);
+        // Split the history of every security and field from 'startDate'
+        // to 'endDate', formatted YYYYMMDD, into chunks within 'limits' and
+        // return their number, which is 0 if the dates are not valid.
+
+    void start();
+        // Send the first chunks.
+
+    void processEvent(const blpapi::Event& event);
+        // Process the responses to chunks in 'event', ignoring any other
+        // message, and send more chunks.
+
+    void run();
+        // Start and process the session's events until every chunk is done
+        // or the session terminates.
+
+    bool isDone() const;
+
+    const HistoryChunk& chunk(size_t index) const;
+
+    const std::string& security(size_t index) const;
+
+    const std::string& field(size_t index) const;
+
+    Statistics statistics() const;
+};
+
+std::ostream& operator<<(std::ostream&                        stream,
+                         const HistoryDownloader::Statistics& stats);
+
+                            // -------------
+                            // HistoryLimits
+                            // -------------
+
+inline
+HistoryLimits::HistoryLimits()
+: d_maxSecurities(50)
+, d_maxFields(25)
+, d_maxPoints(50000)
+{
+}
+
+                            // --------------
+                            // HistoryHandler
+                            // --------------
+
+inline
+HistoryHandler::~HistoryHandler()
+{
+}
+
+inline
+void HistoryHandler::onChunkDone(const HistoryChunk&)
+{
+}
+
+inline
+void HistoryHandler::onChunkFailed(const HistoryChunk&, const blpapi::Message&)
+{
+}
+
+                            // -----------------
+                            // HistoryDownloader
+                            // -----------------
+
+inline
+HistoryDownloader::Statistics::Statistics()
+: d_numChunks(0)
+, d_sent(0)
+, d_completed(0)
+, d_retried(0)
+, d_failed(0)
+, d_inFlight(0)
+, d_messages(0)
+, d_securities(0)
+, d_points(0)
+, d_elapsedNs(0)
+, d_chunkNs(0)
+{
+}
+
+inline
+HistoryDownloader::HistoryDownloader(blpapi::Session       *session,
+                                     const blpapi::Service&  refDataService,
+                                     HistoryHandler        *handler,
+                                     size_t                 maxInFlight,
+                                     unsigned               maxAttempts)
+: d_session_p(session)
+, d_service(refDataService)
+, d_handler_p(handler)
+, d_maxInFlight(maxInFlight > 0 ? maxInFlight : 1)
+, d_maxAttempts(maxAttempts > 0 ? maxAttempts : 1)
+{
+}
+
+inline
+void HistoryDownloader::setIdentity(const blpapi::Identity& identity)
+{
+    d_identity = identity;
+}
+
+inline
+void HistoryDownloader::addSecurity(const std::string& security)
+{
+    d_securities.push_back(security);
+}
+
+inline
+void HistoryDownloader::addField(const std::string& field)
+{
+    d_fields.push_back(field);
+}
+
+inline
+void HistoryDownloader::setOption(const std::string& name,
+                                  const std::string& value)
+{
+    d_options.push_back(std::make_pair(name, value));
+}
+
+inline
+bool HistoryDownloader::parseDate(long long *days, const std::string& date)
+{
+    int year, month, day;
+    char extra;
+    if (date.size() != 8
+            || 3 != std::sscanf(date.c_str(),
+                                "%4d%2d%2d%c",
+                                &year,
+                                &month,
+                                &day,
+                                &extra)
+            || month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+
+    *days = IntradayTime::daysFromCivil(year, month, day);
+    return true;
+}
+
+inline
+std::string HistoryDownloader::formatDate(long long days)
+{
+    long long year;
+    unsigned  month;
+    unsigned  day;
+    IntradayTime::civilFromDays(&year, &month, &day, days);
+
+    char buffer[16];
+    std::sprintf(buffer,
+                 "%04d%02u%02u",
+                 static_cast<int>(year),
+                 month,
+                 day);
+    return buffer;
+}
+
+inline
+size_t HistoryDownloader::periodsIn(long long numDays) const
+{
+    std::string periodicity = "DAILY";
+    for (size_t i = 0; i < d_options.size(); ++i) {
+        if (d_options[i].first == "periodicitySelection") {
+            periodicity = d_options[i].second;
+        }
+    }
+
+    long long periods = numDays * 5 / 7 + 1;          // trading days
+    if (periodicity == "WEEKLY") {
+        periods = numDays / 7 + 1;
+    }
+    else if (periodicity == "MONTHLY") {
+        periods = numDays / 28 + 1;
+    }
+    else if (periodicity == "QUARTERLY") {
+        periods = numDays / 90 + 1;
+    }
+    else if (periodicity == "SEMI_ANNUALLY") {
+        periods = numDays / 181 + 1;
+    }
+    else if (periodicity == "YEARLY") {
+        periods = numDays / 365 + 1;
+    }
+    return static_cast<size_t>(periods);
+}
+
+inline
+size_t HistoryDownloader::plan(const std::string&   startDate,
+                               const std::string&   endDate,
+                               const HistoryLimits& limits)
+{
+    long long first, last;
+    if (!parseDate(&first, startDate) || !parseDate(&last, endDate)
+            || last < first || d_securities.empty() || d_fields.empty()) {
+        return 0;
+    }
+
+    const size_t maxFields   = limits.d_maxFields > 0 ? limits.d_maxFields
+                                                      : 1;
+    const size_t maxPoints   = limits.d_maxPoints > 0 ? limits.d_maxPoints
+                                                      : 1;
+    const size_t fieldsPer   = d_fields.size() < maxFields ? d_fields.size()
+                                                           : maxFields;
+    const long long numDays  = last - first + 1;
+    const size_t perSecurity = periodsIn(numDays) * fieldsPer;
+
+    size_t securitiesPer = 1;
+    size_t numSpans      = 1;
+    if (perSecurity > maxPoints) {
+        numSpans = (perSecurity + maxPoints - 1) / maxPoints;
+        if (numSpans > static_cast<size_t>(numDays)) {
+            numSpans = static_cast<size_t>(numDays);
+        }
+    }
+    else {
+        securitiesPer = maxPoints / perSecurity;
+        if (securitiesPer > limits.d_maxSecurities) {
+            securitiesPer = limits.d_maxSecurities;
+        }
+        if (securitiesPer == 0) {
+            securitiesPer = 1;
+        }
+    }
+    const long long spanDays = (numDays + numSpans - 1) / numSpans;
+
+    for (size_t s = 0; s < d_securities.size(); s += securitiesPer) {
+        for (size_t f = 0; f < d_fields.size(); f += fieldsPer) {
+            for (long long day = first; day <= last; day += spanDays) {
+                Pending pending;
+                HistoryChunk& chunk = pending.d_chunk;
+                chunk.d_firstSecurity = s;
+                chunk.d_numSecurities = d_securities.size() - s
+                                                                < securitiesPer
+                                      ? d_securities.size() - s
+                                      : securitiesPer;
+                chunk.d_firstField    = f;
+                chunk.d_numFields     = d_fields.size() - f < fieldsPer
+                                      ? d_fields.size() - f
+                                      : fieldsPer;
+                chunk.d_startDate     = formatDate(day);
+                chunk.d_endDate       = formatDate(
+                              day + spanDays - 1 < last ? day + spanDays - 1
+                                                        : last);
+                chunk.d_attempts      = 0;
+                pending.d_inFlight    = false;
+
+                d_queue.push_back(d_chunks.size());
+                d_chunks.push_back(pending);
+            }
+        }
+    }
+    d_stats.d_numChunks = d_chunks.size();
+    return d_chunks.size();
+}
+
+inline
+void HistoryDownloader::start()
+{
+    d_startedAt = blpapi::HighResolutionClock::now();
+    sendRequests();
+}
+
+inline
+void HistoryDownloader::sendRequests()
+{
+    while (d_stats.d_inFlight < d_maxInFlight && !d_queue.empty()) {
+        size_t        index   = d_queue.front();
+        Pending&      pending = d_chunks[index];
+        HistoryChunk& chunk   = pending.d_chunk;
+        d_queue.pop_front();
+
+        blpapi::Request request =
+                             d_service.createRequest("HistoricalDataRequest");
+        blpapi::Element securities = request.getElement("securities");
+        for (size_t i = 0; i < chunk.d_numSecurities; ++i) {
+            securities.appendValue(
+                         d_securities[chunk.d_firstSecurity + i].c_str());
+        }
+        blpapi::Element fields = request.getElement("fields");
+        for (size_t i = 0; i < chunk.d_numFields; ++i) {
+            fields.appendValue(d_fields[chunk.d_firstField + i].c_str());
+        }
+        request.set("startDate", chunk.d_startDate.c_str());
+        request.set("endDate", chunk.d_endDate.c_str());
+        for (size_t i = 0; i < d_options.size(); ++i) {
+            request.set(d_options[i].first.c_str(),
+                        d_options[i].second.c_str());
+        }
+
+        ++chunk.d_attempts;
+        pending.d_inFlight = true;
+        pending.d_sentAt   = blpapi::HighResolutionClock::now();
+        ++d_stats.d_inFlight;
+        ++d_stats.d_sent;
+        d_session_p->sendRequest(request, d_identity, correlationId(index));
+    }
+}
+
+inline
+blpapi::CorrelationId HistoryDownloader::correlationId(size_t index) const
+{
+    // The attempt number goes in the high word, the index in the low one.
+    const unsigned long long attempt = d_chunks[index].d_chunk.d_attempts;
+    return blpapi::CorrelationId(static_cast<long long>(attempt << 32
+                                                        | index));
+}
+
+inline
+size_t HistoryDownloader::chunkOf(const blpapi::Message& msg) const
+{
+    if (msg.numCorrelationIds() == 0) {
+        return d_chunks.size();
+    }
+    blpapi::CorrelationId cid = msg.correlationId();
+    if (cid.valueType() != blpapi::CorrelationId::INT_VALUE) {
+        return d_chunks.size();
+    }
+    unsigned long long index = static_cast<unsigned long long>(
+                                               cid.asInteger()) & 0xffffffffu;
+    if (index >= d_chunks.size()
+            || !d_chunks[index].d_inFlight
+            || correlationId(index) != cid) {
+        return d_chunks.size();
+    }
+    return static_cast<size_t>(index);
+}
+
+inline
+void HistoryDownloader::processEvent(const blpapi::Event& event)
+{
+    static const blpapi::Name RESPONSE_ERROR("responseError");
+    static const blpapi::Name REQUEST_FAILURE("RequestFailure");
+
+    const int eventType = event.eventType();
+    if (eventType != blpapi::Event::PARTIAL_RESPONSE
+            && eventType != blpapi::Event::RESPONSE
+            && eventType != blpapi::Event::REQUEST_STATUS) {
+        return;
+    }
+
+    blpapi::MessageIterator msgIter(event);
+    while (msgIter.next()) {
+        blpapi::Message msg   = msgIter.message();
+        size_t          index = chunkOf(msg);
+        if (index == d_chunks.size()) {
+            continue;
+        }
+        ++d_stats.d_messages;
+
+        if (eventType == blpapi::Event::REQUEST_STATUS) {
+            if (msg.messageType() == REQUEST_FAILURE) {
+                fail(index, msg);
+            }
+        }
+        else if (msg.hasElement(RESPONSE_ERROR)) {
+            if (eventType == blpapi::Event::PARTIAL_RESPONSE) {
+                // The request is still live; stop it before it is retried.
+                d_session_p->cancel(correlationId(index));
+            }
+            fail(index, msg);
+        }
+        else {
+            d_chunks[index].d_messages.push_back(msg);
+            if (eventType == blpapi::Event::RESPONSE) {
+                complete(index);
+            }
+        }
+    }
+    sendRequests();
+}
+
+inline
+void HistoryDownloader::complete(size_t index)
+{
+    static const blpapi::Name SECURITY_DATA("securityData");
+    static const blpapi::Name FIELD_DATA("fieldData");
+
+    Pending& pending = d_chunks[index];
+    pending.d_inFlight = false;
+    --d_stats.d_inFlight;
+    ++d_stats.d_completed;
+    d_stats.d_chunkNs += blpapi::TimePointUtil::nanosecondsBetween(
+                                        pending.d_sentAt,
+                                        blpapi::HighResolutionClock::now());
+
+    for (size_t i = 0; i < pending.d_messages.size(); ++i) {
+        blpapi::Element securityData;
+        if (0 != pending.d_messages[i].asElement().getElement(&securityData,
+                                                             SECURITY_DATA)) {
+            continue;
+        }
+        blpapi::Element fieldData;
+        if (0 == securityData.getElement(&fieldData, FIELD_DATA)) {
+            d_stats.d_points += fieldData.numValues();
+        }
+        ++d_stats.d_securities;
+        d_handler_p->onSecurityData(securityData, pending.d_chunk);
+    }
+
+    // Release the events the messages belong to.
+    std::vector<blpapi::Message>().swap(pending.d_messages);
+    d_handler_p->onChunkDone(pending.d_chunk);
+}
+
+inline
+void HistoryDownloader::fail(size_t index, const blpapi::Message& reason)
+{
+    Pending& pending = d_chunks[index];
+    pending.d_inFlight = false;
+    --d_stats.d_inFlight;
+    std::vector<blpapi::Message>().swap(pending.d_messages);
+
+    if (pending.d_chunk.d_attempts < d_maxAttempts) {
+        ++d_stats.d_retried;
+        d_queue.push_back(index);
+        return;
+    }
+    ++d_stats.d_failed;
+    d_handler_p->onChunkFailed(pending.d_chunk, reason);
+}
+
+inline
+void HistoryDownloader::run()
+{
+    static const blpapi::Name SESSION_TERMINATED("SessionTerminated");
+
+    start();
+    while (!isDone()) {
+        blpapi::Event event = d_session_p->nextEvent();
+        if (event.eventType() == blpapi::Event::SESSION_STATUS) {
+            blpapi::MessageIterator msgIter(event);
+            while (msgIter.next()) {
+                if (msgIter.message().messageType() == SESSION_TERMINATED) {
+                    return;
+                }
+            }
+        }
+        processEvent(event);
+    }
+}
+
+inline
+bool HistoryDownloader::isDone() const
+{
+    return d_queue.empty() && d_stats.d_inFlight == 0;
+}
+
+inline
+const HistoryChunk& HistoryDownloader::chunk(size_t index) const
+{
+    return d_chunks[index].d_chunk;
+}
+
+inline
+const std::string& HistoryDownloader::security(size_t index) const
+{
+    return d_securities[index];
+}
+
+inline
+const std::string& HistoryDownloader::field(size_t index) const
+{
+    return d_fields[index];
+}
+
+inline
+HistoryDownloader::Statistics HistoryDownloader::statistics() const
+{
+    Statistics stats = d_stats;
+    if (stats.d_sent > 0) {
+        stats.d_elapsedNs = blpapi::TimePointUtil::nanosecondsBetween(
+                                         d_startedAt,
+                                         blpapi::HighResolutionClock::now());
+    }
+    return stats;
+}
+
+inline
+std::ostream& operator<<(std::ostream&                        stream,
+                         const HistoryDownloader::Statistics& stats)
+{
+    double seconds = stats.d_elapsedNs / 1e9;
+    stream << "HistoryDownloader: chunks=" << stats.d_completed << '/'
+           << stats.d_numChunks
+           << " inFlight=" << stats.d_inFlight
+           << " sent=" << stats.d_sent
+           << " retried=" << stats.d_retried
+           << " failed=" << stats.d_failed
+           << " messages=" << stats.d_messages
+           << " securities=" << stats.d_securities
+           << " points=" << stats.d_points
+           << " elapsedSec=" << seconds;
+    if (seconds > 0) {
+        stream << " chunksPerSec=" << stats.d_completed / seconds
+               << " pointsPerSec=" << stats.d_points / seconds;
+    }
+    if (stats.d_completed > 0) {
+        stream << " meanChunkMs="
+               << stats.d_chunkNs / 1e6 / stats.d_completed;
+    }
+    return stream;
+}
+
+} // namespace BloombergLP {
+
+#endif // INCLUDED_BLPHISTORYDOWNLOADER
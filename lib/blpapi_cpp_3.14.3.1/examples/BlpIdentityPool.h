@@ -0,0 +1,359 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef INCLUDED_BLPIDENTITYPOOL
+#define INCLUDED_BLPIDENTITYPOOL
+
+#include "BlpThreadUtil.h"
+
+#include <blpapi_correlationid.h>
+#include <blpapi_event.h>
+#include <blpapi_identity.h>
+#include <blpapi_message.h>
+#include <blpapi_name.h>
+#include <blpapi_request.h>
+#include <blpapi_service.h>
+#include <blpapi_session.h>
+
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace BloombergLP {
+
+// IdentityPool authorizes many users with their uuid and IP address while
+// keeping at most 'maxInFlight' authorization requests outstanding.
+// Requests are sent on the pool's own 'EventQueue' with the user's index as
+// 'CorrelationId', so responses are matched to users in whatever order they
+// arrive.  Users are indexed in the order they are 'add'ed.
+//
+// The thread that calls 'start' drives the pool by calling 'poll' until
+// 'outstanding' is 0.  Users are added to the ready set as soon as they are
+// authorized, and removed from it if their authorization is revoked, so
+// other threads (typically the session's event handler) can fan data out to
+// 'ready' users while the rest are still being authorized.  Status events
+// keep arriving on the pool's queue afterwards, and one thread at a time
+// processes them with 'tryPoll', which does nothing until 'outstanding' is
+// 0, so the queue only ever has a single consumer and its events are
+// processed in order.  'version' changes whenever the ready set or a ready
+// user's entitlements may have changed.
+class IdentityPool
+{
+  public:
+    enum Status {
+        e_QUEUED,
+        e_IN_FLIGHT,
+        e_AUTHORIZED,
+        e_FAILED
+    };
+
+  private:
+    struct User {
+        int               d_uuid;
+        std::string       d_ipAddress;
+        blpapi::Identity  d_identity;
+        Status            d_status;
+    };
+
+    blpapi::Session     *d_session_p;
+    blpapi::Service      d_authService;
+    blpapi::EventQueue   d_queue;
+    std::deque<User>     d_users;       // a deque never moves identities
+    std::vector<size_t>  d_ready;       // in authorization order
+    size_t               d_next;        // next user to send a request for
+    size_t               d_inFlight;
+    size_t               d_maxInFlight;
+    size_t               d_numFailed;
+    unsigned             d_version;
+    mutable Mutex        d_lock;         // guards all but 'd_users' layout
+
+    IdentityPool(const IdentityPool&);
+    IdentityPool& operator=(const IdentityPool&);
+
+    void sendRequests();
+        // Send authorization requests until 'd_maxInFlight' are outstanding
+        // or every user has been sent one.  The caller holds 'd_lock'.
+
+    size_t processEvents(blpapi::Event        event,
+                         std::vector<size_t> *newlyReady);
+        // Process 'event' and every event already queued after it, top the
+        // window up and return the number of users outstanding.
+
+    void processMessage(const blpapi::Message&  msg,
+                        std::vector<size_t>    *newlyReady);
+        // The caller holds 'd_lock'.
+
+  public:
+    IdentityPool(size_t maxInFlight = 64);
+
+    size_t add(int uuid, const std::string& ipAddress);
+        // Add the user 'uuid' logged on at 'ipAddress' and return its index.
+        // All users must be added before 'start'.
+
+    void start(blpapi::Session *session, const char *authServiceName);
+        // Begin authorizing with the already opened 'authServiceName'.
+
+    size_t poll(std::vector<size_t> *newlyReady, int timeoutMs);
+        // Wait up to 'timeoutMs' for authorization events, process every
+        // event available, top the window up, and append to 'newlyReady'
+        // the users authorized meanwhile.  Return the number of users whose
+        // authorization is not yet complete.
+
+    size_t tryPoll(std::vector<size_t> *newlyReady);
+        // Do what 'poll' does without waiting if no event is queued.  Do
+        // nothing while the users' authorization is not complete, since the
+        // thread calling 'poll' is then the queue's consumer.  Only one
+        // thread may call 'tryPoll' at a time.
+
+    size_t outstanding() const;
+
+    unsigned version() const;
+
+    void ready(std::vector<size_t> *indices) const;
+        // Load into 'indices' the users currently authorized.
+
+    size_t numReady() const;
+
+    size_t numFailed() const;
+
+    size_t size() const;
+
+    Status status(size_t index) const;
+
+    int uuid(size_t index) const;
+
+    const blpapi::Identity& identity(size_t index) const;
+        // Return the identity of user 'index', which is only usable once
+        // the user is ready.
+};
+
+inline
+IdentityPool::IdentityPool(size_t maxInFlight)
+: d_session_p(0)
+, d_next(0)
+, d_inFlight(0)
+, d_maxInFlight(maxInFlight > 0 ? maxInFlight : 1)
+, d_numFailed(0)
+, d_version(0)
+{
+}
+
+inline
+size_t IdentityPool::add(int uuid, const std::string& ipAddress)
+{
+    User user;
+    user.d_uuid      = uuid;
+    user.d_ipAddress = ipAddress;
+    user.d_status    = e_QUEUED;
+    d_users.push_back(user);
+    return d_users.size() - 1;
+}
+
+inline
+void IdentityPool::start(blpapi::Session *session,
+                         const char      *authServiceName)
+{
+    MutexGuard guard(&d_lock);
+    d_session_p   = session;
+    d_authService = session->getService(authServiceName);
+    sendRequests();
+}
+
+inline
+void IdentityPool::sendRequests()
+{
+    while (d_inFlight < d_maxInFlight && d_next < d_users.size()) {
+        size_t  index = d_next++;
+        User&   user  = d_users[index];
+
+        blpapi::Request authRequest =
+                                   d_authService.createAuthorizationRequest();
+        authRequest.set("uuid", user.d_uuid);
+        authRequest.set("ipAddress", user.d_ipAddress.c_str());
+
+        user.d_identity = d_session_p->createIdentity();
+        user.d_status   = e_IN_FLIGHT;
+        ++d_inFlight;
+        blpapi::CorrelationId correlationId(static_cast<long long>(index));
+        d_session_p->sendAuthorizationRequest(authRequest,
+                                              &user.d_identity,
+                                              correlationId,
+                                              &d_queue);
+    }
+}
+
+inline
+size_t IdentityPool::poll(std::vector<size_t> *newlyReady, int timeoutMs)
+{
+    // Wait without the lock so that other threads can read the ready set.
+    return processEvents(d_queue.nextEvent(timeoutMs), newlyReady);
+}
+
+inline
+size_t IdentityPool::tryPoll(std::vector<size_t> *newlyReady)
+{
+    // Once 0, 'outstanding' stays 0 and the thread calling 'poll' no longer
+    // takes events from the queue.
+    size_t remaining = outstanding();
+    if (remaining > 0) {
+        return remaining;
+    }
+    blpapi::Event event;
+    if (0 != d_queue.tryNextEvent(&event)) {
+        return outstanding();
+    }
+    return processEvents(event, newlyReady);
+}
+
+inline
+size_t IdentityPool::processEvents(blpapi::Event        event,
+                                   std::vector<size_t> *newlyReady)
+{
+    MutexGuard guard(&d_lock);
+    do {
+        if (event.eventType() != blpapi::Event::TIMEOUT) {
+            blpapi::MessageIterator msgIter(event);
+            while (msgIter.next()) {
+                processMessage(msgIter.message(), newlyReady);
+            }
+        }
+    } while (0 == d_queue.tryNextEvent(&event));
+
+    sendRequests();
+    return d_users.size() - d_next + d_inFlight;
+}
+
+inline
+void IdentityPool::processMessage(const blpapi::Message&  msg,
+                                  std::vector<size_t>    *newlyReady)
+{
+    static const blpapi::Name AUTHORIZATION_SUCCESS("AuthorizationSuccess");
+    static const blpapi::Name AUTHORIZATION_REVOKED("AuthorizationRevoked");
+
+    blpapi::CorrelationId correlationId;
+    if (msg.numCorrelationIds() > 0) {
+        correlationId = msg.correlationId();
+    }
+    if (correlationId.valueType() != blpapi::CorrelationId::INT_VALUE
+            || correlationId.asInteger() < 0
+            || correlationId.asInteger() >= (long long)d_users.size()) {
+        std::cout << msg << std::endl;
+        return;
+    }
+
+    size_t index = static_cast<size_t>(correlationId.asInteger());
+    User&  user  = d_users[index];
+
+    // Any status message, such as 'EntitlementChanged', may change what the
+    // user is entitled to.
+    ++d_version;
+    if (user.d_status == e_IN_FLIGHT) {
+        --d_inFlight;
+        if (msg.messageType() == AUTHORIZATION_SUCCESS) {
+            user.d_status = e_AUTHORIZED;
+            d_ready.push_back(index);
+            newlyReady->push_back(index);
+            std::cout << user.d_uuid << " authorization success"
+                      << std::endl;
+        }
+        else {
+            // AuthorizationFailure, or a RequestFailure for the request.
+            user.d_status = e_FAILED;
+            ++d_numFailed;
+            std::cout << user.d_uuid << " authorization failed" << std::endl;
+            std::cout << msg << std::endl;
+        }
+    }
+    else if (user.d_status == e_AUTHORIZED
+             && msg.messageType() == AUTHORIZATION_REVOKED) {
+        user.d_status = e_FAILED;
+        ++d_numFailed;
+        d_ready.erase(std::find(d_ready.begin(), d_ready.end(), index));
+        std::cout << user.d_uuid << " authorization revoked" << std::endl;
+    }
+    else {
+        std::cout << msg << std::endl;
+    }
+}
+
+inline
+size_t IdentityPool::outstanding() const
+{
+    MutexGuard guard(&d_lock);
+    return d_users.size() - d_next + d_inFlight;
+}
+
+inline
+unsigned IdentityPool::version() const
+{
+    MutexGuard guard(&d_lock);
+    return d_version;
+}
+
+inline
+void IdentityPool::ready(std::vector<size_t> *indices) const
+{
+    MutexGuard guard(&d_lock);
+    indices->assign(d_ready.begin(), d_ready.end());
+}
+
+inline
+size_t IdentityPool::numReady() const
+{
+    MutexGuard guard(&d_lock);
+    return d_ready.size();
+}
+
+inline
+size_t IdentityPool::numFailed() const
+{
+    MutexGuard guard(&d_lock);
+    return d_numFailed;
+}
+
+inline
+size_t IdentityPool::size() const
+{
+    return d_users.size();
+}
+
+inline
+IdentityPool::Status IdentityPool::status(size_t index) const
+{
+    MutexGuard guard(&d_lock);
+    return d_users[index].d_status;
+}
+
+inline
+int IdentityPool::uuid(size_t index) const
+{
+    return d_users[index].d_uuid;
+}
+
+inline
+const blpapi::Identity& IdentityPool::identity(size_t index) const
+{
+    return d_users[index].d_identity;
+}
+
+} // namespace BloombergLP {
+
+#endif // INCLUDED_BLPIDENTITYPOOL
@@ -0,0 +1,646 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef INCLUDED_BLPINTRADAYDECODER
+#define INCLUDED_BLPINTRADAYDECODER
+
+#include "BlpArrowWriter.h"
+
+#include <blpapi_datetime.h>
+#include <blpapi_element.h>
+#include <blpapi_message.h>
+#include <blpapi_name.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace BloombergLP {
+
+// The decoders below append the bars or ticks of IntradayBarRequest and
+// IntradayTickRequest responses, PARTIAL_RESPONSE and RESPONSE alike, to
+// typed columns, one 'std::vector' per field, instead of handing out each
+// value as it is looked up by name.  The columns of a message are grown
+// once, to fit every item in it, and filled by index; 'clear' keeps their
+// capacity, so once a response has been written or printed the next one is
+// decoded without allocating.  Times are nanoseconds since the epoch, in
+// UTC, and the strings of ticks, whose values repeat, are stored as indices
+// into dictionaries.
+//
+// Fields are found by position: the position of every field is taken from
+// the first item of each message, and is checked against the field's name
+// before it is used, falling back to a lookup by name if the schema does
+// not give every item the same layout.
+
+class IntradayTime {
+  public:
+    static long long daysFromCivil(long long year,
+                                   unsigned  month,
+                                   unsigned  day);
+        // Return the days from 1970-01-01 to the specified date of the
+        // proleptic Gregorian calendar.
+
+    static void civilFromDays(long long *year,
+                              unsigned  *month,
+                              unsigned  *day,
+                              long long  days);
+        // Load into 'year', 'month' and 'day' the date 'days' after
+        // 1970-01-01, the inverse of 'daysFromCivil'.
+
+    static long long toNanoseconds(const blpapi::Datetime& datetime);
+        // Return the nanoseconds from the epoch to 'datetime', which is in
+        // UTC unless it has an offset.
+
+    static blpapi::Datetime toDatetime(long long nanoseconds);
+        // Return the UTC time, to the millisecond, 'nanoseconds' after the
+        // epoch.
+};
+
+class SequenceLayout {
+    // Positions of the fields of the items of an array of sequences.
+
+    std::vector<blpapi::Name>  d_names;
+    std::vector<size_t>        d_positions;
+
+  public:
+    size_t add(const char *name);
+        // Add the field 'name' and return its index.
+
+    void resolve(const blpapi::Element& item);
+        // Take the position of every field from 'item'.
+
+    bool find(blpapi::Element        *field,
+              const blpapi::Element&  item,
+              size_t                  index) const;
+        // Load into 'field' the field 'index' of 'item'.  Return false if
+        // 'item' has no such field or its value is null.
+};
+
+struct IntradayBarColumns {
+    std::vector<long long>  d_times;
+    std::vector<double>     d_open;
+    std::vector<double>     d_high;
+    std::vector<double>     d_low;
+    std::vector<double>     d_close;
+    std::vector<long long>  d_volume;
+    std::vector<int>        d_numEvents;
+    std::vector<double>     d_value;
+
+    void reserve(size_t numBars);
+
+    void resize(size_t numBars);
+
+    void clear();
+        // Remove every bar, keeping the capacity.
+
+    size_t size() const;
+
+    static void addColumns(ArrowFileWriter *writer);
+        // Declare the columns to 'writer', which must not be open yet.
+
+    void write(ArrowFileWriter *writer) const;
+        // Write every bar to 'writer' as one batch.
+};
+
+struct IntradayTickColumns {
+    typedef std::map<std::string, unsigned> Dictionary;
+
+    std::vector<long long>    d_times;
+    std::vector<unsigned>     d_types;           // into 'd_typeNames'
+    std::vector<double>       d_values;
+    std::vector<int>          d_sizes;
+    std::vector<unsigned>     d_conditions;      // into 'd_conditionNames'
+    std::vector<std::string>  d_typeNames;
+    std::vector<std::string>  d_conditionNames;  // 0 is "no condition"
+    Dictionary                d_typeIds;
+    Dictionary                d_conditionIds;
+
+    IntradayTickColumns();
+
+    unsigned typeId(const char *type);
+
+    unsigned conditionId(const char *conditionCodes);
+        // Return the index of the specified string in its dictionary, adding
+        // it first if need be.
+
+    void reserve(size_t numTicks);
+
+    void resize(size_t numTicks);
+
+    void clear();
+        // Remove every tick, keeping the capacity and the dictionaries.
+
+    size_t size() const;
+
+    static void addColumns(ArrowFileWriter *writer);
+        // Declare the columns to 'writer', which must not be open yet.
+
+    void write(ArrowFileWriter *writer) const;
+        // Write every tick to 'writer' as one batch.
+};
+
+class IntradayBarDecoder {
+    enum {
+        e_TIME,
+        e_OPEN,
+        e_HIGH,
+        e_LOW,
+        e_CLOSE,
+        e_VOLUME,
+        e_NUM_EVENTS,
+        e_VALUE
+    };
+
+    blpapi::Name    d_barData;
+    blpapi::Name    d_barTickData;
+    SequenceLayout  d_layout;
+
+  public:
+    IntradayBarDecoder();
+
+    size_t decode(IntradayBarColumns *columns, const blpapi::Message& msg);
+        // Append to 'columns' the bars in 'msg' and return how many there
+        // were.
+};
+
+class IntradayTickDecoder {
+    enum {
+        e_TIME,
+        e_TYPE,
+        e_VALUE,
+        e_SIZE,
+        e_CONDITION_CODES
+    };
+
+    blpapi::Name    d_tickData;
+    SequenceLayout  d_layout;
+
+  public:
+    IntradayTickDecoder();
+
+    size_t decode(IntradayTickColumns *columns, const blpapi::Message& msg);
+        // Append to 'columns' the ticks in 'msg' and return how many there
+        // were.
+};
+
+                            // ------------
+                            // IntradayTime
+                            // ------------
+
+inline
+long long IntradayTime::daysFromCivil(long long year,
+                                      unsigned  month,
+                                      unsigned  day)
+{
+    year -= month <= 2;
+    long long era       = (year >= 0 ? year : year - 399) / 400;
+    long long yearOfEra = year - era * 400;
+    long long dayOfYear = (153LL * (month > 2 ? month - 3 : month + 9) + 2) / 5
+                          + day - 1;
+    long long dayOfEra  = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100
+                          + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+inline
+void IntradayTime::civilFromDays(long long *year,
+                                 unsigned  *month,
+                                 unsigned  *day,
+                                 long long  days)
+{
+    days += 719468;
+    long long era       = (days >= 0 ? days : days - 146096) / 146097;
+    long long dayOfEra  = days - era * 146097;
+    long long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524
+                           - dayOfEra / 146096) / 365;
+    long long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4
+                                      - yearOfEra / 100);
+    long long mp        = (5 * dayOfYear + 2) / 153;
+    *day   = static_cast<unsigned>(dayOfYear - (153 * mp + 2) / 5 + 1);
+    *month = static_cast<unsigned>(mp < 10 ? mp + 3 : mp - 9);
+    *year  = yearOfEra + era * 400 + (*month <= 2);
+}
+
+inline
+long long IntradayTime::toNanoseconds(const blpapi::Datetime& datetime)
+{
+    long long ns = 0;
+    if (datetime.hasParts(blpapi::DatetimeParts::DATE)) {
+        ns = daysFromCivil(datetime.year(), datetime.month(), datetime.day())
+             * 86400LL * 1000000000LL;
+    }
+    if (datetime.hasParts(blpapi::DatetimeParts::TIME)) {
+        ns += (datetime.hours() * 3600LL + datetime.minutes() * 60LL
+               + datetime.seconds()) * 1000000000LL;
+    }
+    if (datetime.hasParts(blpapi::DatetimeParts::FRACSECONDS)) {
+        ns += datetime.nanoseconds();
+    }
+    if (datetime.hasParts(blpapi::DatetimeParts::OFFSET)) {
+        ns -= datetime.offset() * 60LL * 1000000000LL;
+    }
+    return ns;
+}
+
+inline
+blpapi::Datetime IntradayTime::toDatetime(long long nanoseconds)
+{
+    const long long nsPerDay = 86400LL * 1000000000LL;
+    long long days = nanoseconds / nsPerDay;
+    long long ns   = nanoseconds % nsPerDay;
+    if (ns < 0) {
+        ns += nsPerDay;
+        --days;
+    }
+
+    long long year;
+    unsigned  month;
+    unsigned  day;
+    civilFromDays(&year, &month, &day, days);
+
+    long long seconds = ns / 1000000000LL;
+    return blpapi::Datetime::createDatetime(
+         static_cast<unsigned>(year),
+         month,
+         day,
+         static_cast<unsigned>(seconds / 3600),
+         static_cast<unsigned>(seconds / 60 % 60),
+         static_cast<unsigned>(seconds % 60),
+         blpapi::Datetime::Milliseconds(
+                       static_cast<int>(ns % 1000000000LL / 1000000)));
+}
+
+                            // --------------
+                            // SequenceLayout
+                            // --------------
+
+inline
+size_t SequenceLayout::add(const char *name)
+{
+    d_names.push_back(blpapi::Name(name));
+    d_positions.push_back(0);
+    return d_names.size() - 1;
+}
+
+inline
+void SequenceLayout::resolve(const blpapi::Element& item)
+{
+    size_t numElements = item.numElements();
+    for (size_t i = 0; i < d_names.size(); ++i) {
+        d_positions[i] = numElements;
+    }
+    for (size_t position = 0; position < numElements; ++position) {
+        blpapi::Name name = item.getElement(position).name();
+        for (size_t i = 0; i < d_names.size(); ++i) {
+            if (name == d_names[i]) {
+                d_positions[i] = position;
+                break;
+            }
+        }
+    }
+}
+
+inline
+bool SequenceLayout::find(blpapi::Element        *field,
+                          const blpapi::Element&  item,
+                          size_t                  index) const
+{
+    if (0 != item.getElement(field, d_positions[index])
+            || field->name() != d_names[index]) {
+        if (0 != item.getElement(field, d_names[index])) {
+            return false;
+        }
+    }
+    return !field->isNull();
+}
+
+                            // ------------------
+                            // IntradayBarColumns
+                            // ------------------
+
+inline
+void IntradayBarColumns::reserve(size_t numBars)
+{
+    d_times.reserve(numBars);
+    d_open.reserve(numBars);
+    d_high.reserve(numBars);
+    d_low.reserve(numBars);
+    d_close.reserve(numBars);
+    d_volume.reserve(numBars);
+    d_numEvents.reserve(numBars);
+    d_value.reserve(numBars);
+}
+
+inline
+void IntradayBarColumns::resize(size_t numBars)
+{
+    d_times.resize(numBars);
+    d_open.resize(numBars);
+    d_high.resize(numBars);
+    d_low.resize(numBars);
+    d_close.resize(numBars);
+    d_volume.resize(numBars);
+    d_numEvents.resize(numBars);
+    d_value.resize(numBars);
+}
+
+inline
+void IntradayBarColumns::clear()
+{
+    resize(0);
+}
+
+inline
+size_t IntradayBarColumns::size() const
+{
+    return d_times.size();
+}
+
+inline
+void IntradayBarColumns::addColumns(ArrowFileWriter *writer)
+{
+    writer->addColumn("time", ArrowFileWriter::e_TIMESTAMP_NS);
+    writer->addColumn("open", ArrowFileWriter::e_FLOAT64);
+    writer->addColumn("high", ArrowFileWriter::e_FLOAT64);
+    writer->addColumn("low", ArrowFileWriter::e_FLOAT64);
+    writer->addColumn("close", ArrowFileWriter::e_FLOAT64);
+    writer->addColumn("volume", ArrowFileWriter::e_INT64);
+    writer->addColumn("numEvents", ArrowFileWriter::e_INT32);
+    writer->addColumn("value", ArrowFileWriter::e_FLOAT64);
+}
+
+inline
+void IntradayBarColumns::write(ArrowFileWriter *writer) const
+{
+    writer->beginBatch(size());
+    writer->append(d_times);
+    writer->append(d_open);
+    writer->append(d_high);
+    writer->append(d_low);
+    writer->append(d_close);
+    writer->append(d_volume);
+    writer->append(d_numEvents);
+    writer->append(d_value);
+    writer->endBatch();
+}
+
+                            // -------------------
+                            // IntradayTickColumns
+                            // -------------------
+
+inline
+IntradayTickColumns::IntradayTickColumns()
+: d_conditionNames(1)
+{
+    d_conditionIds[std::string()] = 0;
+}
+
+inline
+unsigned IntradayTickColumns::typeId(const char *type)
+{
+    std::pair<Dictionary::iterator, bool> inserted = d_typeIds.insert(
+              std::make_pair(std::string(type),
+                             static_cast<unsigned>(d_typeNames.size())));
+    if (inserted.second) {
+        d_typeNames.push_back(type);
+    }
+    return inserted.first->second;
+}
+
+inline
+unsigned IntradayTickColumns::conditionId(const char *conditionCodes)
+{
+    std::pair<Dictionary::iterator, bool> inserted = d_conditionIds.insert(
+              std::make_pair(std::string(conditionCodes),
+                             static_cast<unsigned>(d_conditionNames.size())));
+    if (inserted.second) {
+        d_conditionNames.push_back(conditionCodes);
+    }
+    return inserted.first->second;
+}
+
+inline
+void IntradayTickColumns::reserve(size_t numTicks)
+{
+    d_times.reserve(numTicks);
+    d_types.reserve(numTicks);
+    d_values.reserve(numTicks);
+    d_sizes.reserve(numTicks);
+    d_conditions.reserve(numTicks);
+}
+
+inline
+void IntradayTickColumns::resize(size_t numTicks)
+{
+    d_times.resize(numTicks);
+    d_types.resize(numTicks);
+    d_values.resize(numTicks);
+    d_sizes.resize(numTicks);
+    d_conditions.resize(numTicks);
+}
+
+inline
+void IntradayTickColumns::clear()
+{
+    resize(0);
+}
+
+inline
+size_t IntradayTickColumns::size() const
+{
+    return d_times.size();
+}
+
+inline
+void IntradayTickColumns::addColumns(ArrowFileWriter *writer)
+{
+    writer->addColumn("time", ArrowFileWriter::e_TIMESTAMP_NS);
+    writer->addColumn("type", ArrowFileWriter::e_UTF8);
+    writer->addColumn("value", ArrowFileWriter::e_FLOAT64);
+    writer->addColumn("size", ArrowFileWriter::e_INT32);
+    writer->addColumn("conditionCodes", ArrowFileWriter::e_UTF8);
+}
+
+inline
+void IntradayTickColumns::write(ArrowFileWriter *writer) const
+{
+    writer->beginBatch(size());
+    writer->append(d_times);
+    writer->append(d_types, d_typeNames);
+    writer->append(d_values);
+    writer->append(d_sizes);
+    writer->append(d_conditions, d_conditionNames);
+    writer->endBatch();
+}
+
+                            // ------------------
+                            // IntradayBarDecoder
+                            // ------------------
+
+inline
+IntradayBarDecoder::IntradayBarDecoder()
+: d_barData("barData")
+, d_barTickData("barTickData")
+{
+    d_layout.add("time");
+    d_layout.add("open");
+    d_layout.add("high");
+    d_layout.add("low");
+    d_layout.add("close");
+    d_layout.add("volume");
+    d_layout.add("numEvents");
+    d_layout.add("value");
+}
+
+inline
+size_t IntradayBarDecoder::decode(IntradayBarColumns     *columns,
+                                  const blpapi::Message&  msg)
+{
+    blpapi::Element barData;
+    blpapi::Element bars;
+    if (0 != msg.asElement().getElement(&barData, d_barData)
+            || 0 != barData.getElement(&bars, d_barTickData)) {
+        return 0;
+    }
+
+    const size_t numBars = bars.numValues();
+    const size_t first   = columns->size();
+    columns->resize(first + numBars);
+
+    blpapi::Element  bar;
+    blpapi::Element  field;
+    blpapi::Datetime time;
+    for (size_t i = 0; i < numBars; ++i) {
+        const size_t row = first + i;
+        bars.getValueAs(&bar, i);
+        if (i == 0) {
+            d_layout.resolve(bar);
+        }
+
+        if (d_layout.find(&field, bar, e_TIME)
+                && 0 == field.getValueAs(&time)) {
+            columns->d_times[row] = IntradayTime::toNanoseconds(time);
+        }
+        if (d_layout.find(&field, bar, e_OPEN)) {
+            field.getValueAs(&columns->d_open[row]);
+        }
+        if (d_layout.find(&field, bar, e_HIGH)) {
+            field.getValueAs(&columns->d_high[row]);
+        }
+        if (d_layout.find(&field, bar, e_LOW)) {
+            field.getValueAs(&columns->d_low[row]);
+        }
+        if (d_layout.find(&field, bar, e_CLOSE)) {
+            field.getValueAs(&columns->d_close[row]);
+        }
+        if (d_layout.find(&field, bar, e_VOLUME)) {
+            blpapi::Int64 volume = 0;
+            field.getValueAs(&volume);
+            columns->d_volume[row] = volume;
+        }
+        if (d_layout.find(&field, bar, e_NUM_EVENTS)) {
+            blpapi::Int32 numEvents = 0;
+            field.getValueAs(&numEvents);
+            columns->d_numEvents[row] = numEvents;
+        }
+        if (d_layout.find(&field, bar, e_VALUE)) {
+            field.getValueAs(&columns->d_value[row]);
+        }
+    }
+    return numBars;
+}
+
+                            // -------------------
+                            // IntradayTickDecoder
+                            // -------------------
+
+inline
+IntradayTickDecoder::IntradayTickDecoder()
+: d_tickData("tickData")
+{
+    d_layout.add("time");
+    d_layout.add("type");
+    d_layout.add("value");
+    d_layout.add("size");
+    d_layout.add("conditionCodes");
+}
+
+inline
+size_t IntradayTickDecoder::decode(IntradayTickColumns    *columns,
+                                   const blpapi::Message&  msg)
+{
+    blpapi::Element tickData;
+    blpapi::Element ticks;
+    if (0 != msg.asElement().getElement(&tickData, d_tickData)
+            || 0 != tickData.getElement(&ticks, d_tickData)) {
+        return 0;
+    }
+
+    const size_t numTicks = ticks.numValues();
+    const size_t first    = columns->size();
+    columns->resize(first + numTicks);
+
+    // Consecutive ticks are usually of the same type.
+    std::string       lastType;
+    unsigned          lastTypeId = 0;
+    blpapi::Element   tick;
+    blpapi::Element   field;
+    blpapi::Datetime  time;
+    for (size_t i = 0; i < numTicks; ++i) {
+        const size_t row = first + i;
+        ticks.getValueAs(&tick, i);
+        if (i == 0) {
+            d_layout.resolve(tick);
+        }
+
+        if (d_layout.find(&field, tick, e_TIME)
+                && 0 == field.getValueAs(&time)) {
+            columns->d_times[row] = IntradayTime::toNanoseconds(time);
+        }
+        if (d_layout.find(&field, tick, e_TYPE)) {
+            const char *type = field.getValueAsString();
+            if (i == 0 || lastType != type) {
+                lastTypeId = columns->typeId(type);
+                lastType   = type;
+            }
+            columns->d_types[row] = lastTypeId;
+        }
+        else {
+            columns->d_types[row] = columns->typeId("");
+        }
+        if (d_layout.find(&field, tick, e_VALUE)) {
+            field.getValueAs(&columns->d_values[row]);
+        }
+        if (d_layout.find(&field, tick, e_SIZE)) {
+            blpapi::Int32 size = 0;
+            field.getValueAs(&size);
+            columns->d_sizes[row] = size;
+        }
+        columns->d_conditions[row] = 0;
+        if (d_layout.find(&field, tick, e_CONDITION_CODES)) {
+            columns->d_conditions[row] =
+                            columns->conditionId(field.getValueAsString());
+        }
+    }
+    return numTicks;
+}
+
+} // namespace BloombergLP {
+
+#endif // INCLUDED_BLPINTRADAYDECODER
@@ -0,0 +1,306 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef INCLUDED_BLPPAGEDIFF
+#define INCLUDED_BLPPAGEDIFF
+
+#include <blpapi_eventformatter.h>
+#include <blpapi_name.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BLPPAGEDIFF_SSE2 1
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace BloombergLP {
+
+// Page is the character grid of a page topic, 'numRows' by 'numCols'
+// cells, blank when created.  Rows and columns are numbered from 0 here
+// and from 1 in the published messages.
+//
+// PageDiff finds the spans that differ between two versions of a page and
+// formats them as 'rowUpdate'/'spanUpdate' elements.  Rows that are equal
+// are skipped with one 'memcmp' each.  In a row that differs, 16 cells are
+// compared at a time with SSE2 where it is available, and the differing
+// columns are walked from the resulting bit masks.  Differences separated by
+// fewer than 'k_MERGE_GAP' equal cells are joined into one span, as a span
+// costs more than a few repeated characters.
+class Page
+{
+    int               d_numRows;
+    int               d_numCols;
+    std::vector<char> d_cells;
+
+  public:
+    explicit Page(int numRows = 25, int numCols = 80);
+
+    int numRows() const;
+
+    int numCols() const;
+
+    const char *row(int row) const;
+
+    void write(int row, int col, const std::string& text);
+        // Write 'text' at 'row' from 'col', clipped to the page.
+
+    void clear();
+        // Make every cell blank.
+};
+
+struct PageSpan {
+    int d_row;
+    int d_startCol;
+    int d_length;
+};
+
+struct PageDiff {
+    static const int k_MERGE_GAP = 4;
+
+    static void diff(std::vector<PageSpan> *spans,
+                     const Page&            from,
+                     const Page&            to);
+        // Load into 'spans', by row and column, the spans of 'to' that
+        // differ from 'from'.  The pages must have the same size.
+
+    static void imageSpans(std::vector<PageSpan> *spans, const Page& page);
+        // Load into 'spans' one span per row of 'page' that is not blank,
+        // from its first to its last non-blank cell.
+
+    static void formatImage(blpapi::EventFormatter& formatter,
+                            const Page&             page);
+        // Set 'numRows', 'numCols' and a 'rowUpdate' for every row of
+        // 'page' that is not blank, for a recap or initial paint.
+
+    static void formatRow(blpapi::EventFormatter&  formatter,
+                          const Page&              page,
+                          const PageSpan          *spans,
+                          size_t                   numSpans);
+        // Set 'rowNum' and a 'spanUpdate' for each of the 'numSpans' spans,
+        // which must all be on the same row of 'page'.
+};
+
+                            // ----
+                            // Page
+                            // ----
+
+inline
+Page::Page(int numRows, int numCols)
+: d_numRows(numRows)
+, d_numCols(numCols)
+, d_cells(static_cast<size_t>(numRows) * numCols, ' ')
+{
+}
+
+inline
+int Page::numRows() const
+{
+    return d_numRows;
+}
+
+inline
+int Page::numCols() const
+{
+    return d_numCols;
+}
+
+inline
+const char *Page::row(int row) const
+{
+    return &d_cells[static_cast<size_t>(row) * d_numCols];
+}
+
+inline
+void Page::write(int row, int col, const std::string& text)
+{
+    if (row < 0 || row >= d_numRows || col < 0 || col >= d_numCols) {
+        return;
+    }
+    size_t length = text.size();
+    if (length > static_cast<size_t>(d_numCols - col)) {
+        length = d_numCols - col;
+    }
+    std::memcpy(&d_cells[static_cast<size_t>(row) * d_numCols + col],
+                text.data(),
+                length);
+}
+
+inline
+void Page::clear()
+{
+    std::fill(d_cells.begin(), d_cells.end(), ' ');
+}
+
+                            // --------
+                            // PageDiff
+                            // --------
+
+namespace PageDiffImpl {
+
+inline
+unsigned diffMask(const char *a, const char *b, int length)
+    // Return a mask with bit 'i' set if 'a[i]' and 'b[i]' differ, for the
+    // first 'length' cells, at most 16.
+{
+#ifdef BLPPAGEDIFF_SSE2
+    if (length == 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a));
+        __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b));
+        return ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)))
+             & 0xFFFFu;
+    }
+#endif
+    unsigned mask = 0;
+    for (int i = 0; i < length; ++i) {
+        if (a[i] != b[i]) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+inline
+int lowestBit(unsigned mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<int>(index);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+} // namespace PageDiffImpl {
+
+inline
+void PageDiff::diff(std::vector<PageSpan> *spans,
+                    const Page&            from,
+                    const Page&            to)
+{
+    spans->clear();
+    const int numCols = to.numCols();
+    for (int r = 0; r < to.numRows(); ++r) {
+        const char *a = from.row(r);
+        const char *b = to.row(r);
+        if (!std::memcmp(a, b, numCols)) {
+            continue;
+        }
+        PageSpan span = { r, -1, 0 };
+        int      last = -1;                  // last differing column
+        for (int c = 0; c < numCols; c += 16) {
+            int      length = numCols - c < 16 ? numCols - c : 16;
+            unsigned mask   = PageDiffImpl::diffMask(a + c, b + c, length);
+            while (mask) {
+                int col = c + PageDiffImpl::lowestBit(mask);
+                mask &= mask - 1;
+                if (span.d_startCol < 0) {
+                    span.d_startCol = col;
+                }
+                else if (col - last - 1 >= k_MERGE_GAP) {
+                    span.d_length = last - span.d_startCol + 1;
+                    spans->push_back(span);
+                    span.d_startCol = col;
+                }
+                last = col;
+            }
+        }
+        span.d_length = last - span.d_startCol + 1;
+        spans->push_back(span);
+    }
+}
+
+inline
+void PageDiff::imageSpans(std::vector<PageSpan> *spans, const Page& page)
+{
+    spans->clear();
+    for (int r = 0; r < page.numRows(); ++r) {
+        const char *cells = page.row(r);
+        int         first = 0;
+        int         last  = page.numCols() - 1;
+        while (first <= last && cells[first] == ' ') {
+            ++first;
+        }
+        while (last >= first && cells[last] == ' ') {
+            --last;
+        }
+        if (first <= last) {
+            PageSpan span = { r, first, last - first + 1 };
+            spans->push_back(span);
+        }
+    }
+}
+
+inline
+void PageDiff::formatImage(blpapi::EventFormatter& formatter,
+                           const Page&             page)
+{
+    std::vector<PageSpan> spans;
+    imageSpans(&spans, page);
+
+    formatter.setElement("numRows", page.numRows());
+    formatter.setElement("numCols", page.numCols());
+    formatter.pushElement("rowUpdate");
+    for (size_t i = 0; i < spans.size(); ++i) {
+        formatter.appendElement();
+        formatRow(formatter, page, &spans[i], 1);
+        formatter.popElement();
+    }
+    formatter.popElement();
+}
+
+inline
+void PageDiff::formatRow(blpapi::EventFormatter&  formatter,
+                         const Page&              page,
+                         const PageSpan          *spans,
+                         size_t                   numSpans)
+{
+    static const blpapi::Name ROW_NUM("rowNum");
+    static const blpapi::Name SPAN_UPDATE("spanUpdate");
+    static const blpapi::Name START_COL("startCol");
+    static const blpapi::Name LENGTH("length");
+    static const blpapi::Name TEXT("text");
+
+    formatter.setElement(ROW_NUM, spans[0].d_row + 1);
+    formatter.pushElement(SPAN_UPDATE);
+    for (size_t i = 0; i < numSpans; ++i) {
+        const PageSpan& span = spans[i];
+        std::string text(page.row(span.d_row) + span.d_startCol,
+                         span.d_length);
+        formatter.appendElement();
+        formatter.setElement(START_COL, span.d_startCol + 1);
+        formatter.setElement(LENGTH, span.d_length);
+        formatter.setElement(TEXT, text.c_str());
+        formatter.popElement();
+    }
+    formatter.popElement();
+}
+
+} // namespace BloombergLP {
+
+#endif // INCLUDED_BLPPAGEDIFF
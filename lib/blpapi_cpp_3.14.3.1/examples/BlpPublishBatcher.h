@@ -0,0 +1,286 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef INCLUDED_BLPPUBLISHBATCHER
+#define INCLUDED_BLPPUBLISHBATCHER
+
+#include <blpapi_correlationid.h>
+#include <blpapi_event.h>
+#include <blpapi_eventformatter.h>
+#include <blpapi_name.h>
+#include <blpapi_providersession.h>
+#include <blpapi_service.h>
+#include <blpapi_topic.h>
+
+#include <cstddef>
+#include <ostream>
+
+namespace BloombergLP {
+
+// PublishBatcher packs the messages of a publishing pass into as few
+// events as it can.  Each 'appendMessage' takes an estimate of the size of
+// the message, and returns the formatter of the current event to set its
+// fields.  When the message would take the event past 'maxBytes' or
+// 'maxMessages', the current event is published first and the message
+// starts a new one, so one 'ProviderSession::publish' carries as much as
+// the budget allows and no event grows without bound.  A message larger
+// than 'maxBytes' goes out in an event of its own.  'flush' publishes what
+// is left; calling it at the end of every pass bounds how long a message
+// can wait in the batcher.
+//
+// Events are created when their first message is appended, so a pass with
+// nothing to publish creates no event.  The batcher is meant for the
+// single publishing thread.  A caller that fills messages under a lock the
+// publish must not be made under calls 'makeRoom' with an upper bound of
+// the message size before taking the lock; the 'appendMessage' that
+// follows then never publishes.
+class PublishBatcher
+{
+  public:
+    typedef void (*PublishCallback)(const blpapi::Event& event);
+
+    struct Statistics {
+        long long d_events;
+        long long d_messages;
+        long long d_bytes;              // estimated
+        long long d_fullOnBytes;        // events published at 'maxBytes'
+        long long d_fullOnMessages;     // events published at 'maxMessages'
+
+        Statistics();
+    };
+
+    static const size_t k_DEFAULT_MAX_BYTES    = 64 * 1024;
+    static const size_t k_DEFAULT_MAX_MESSAGES = 1024;
+    static const size_t k_MESSAGE_OVERHEAD     = 64;
+        // Rough cost of a message before its fields: type, topic, header.
+
+  private:
+    blpapi::ProviderSession *d_session_p;
+    blpapi::Service          d_service;
+    blpapi::Event            d_event;
+    blpapi::EventFormatter  *d_formatter_p;
+    size_t                   d_bytes;
+    size_t                   d_messages;
+    size_t                   d_maxBytes;
+    size_t                   d_maxMessages;
+    PublishCallback          d_callback;
+    Statistics               d_stats;
+
+    PublishBatcher(const PublishBatcher&);
+    PublishBatcher& operator=(const PublishBatcher&);
+
+    void reserve(size_t bytes);
+        // Make room for a message of 'bytes', and create an event if there
+        // is none.
+
+  public:
+    PublishBatcher(blpapi::ProviderSession *session,
+                   const blpapi::Service&   service,
+                   size_t                   maxBytes    = k_DEFAULT_MAX_BYTES,
+                   size_t                   maxMessages =
+                                                     k_DEFAULT_MAX_MESSAGES,
+                   PublishCallback          callback    = 0);
+        // Create a batcher publishing events of 'service' on 'session'.  If
+        // 'callback' is not null it is called with every event just before
+        // the event is published.
+
+    ~PublishBatcher();
+        // Destroy this batcher.  Messages not flushed are dropped.
+
+    blpapi::EventFormatter& appendMessage(const blpapi::Name&  messageType,
+                                          const blpapi::Topic& topic,
+                                          size_t               bytes);
+        // Append a message of 'messageType' on 'topic', estimated at
+        // 'bytes', and return the formatter to set its fields with.  The
+        // formatter is valid until the next call to this batcher.
+
+    blpapi::EventFormatter& appendRecapMessage(
+                                    const blpapi::Topic&          topic,
+                                    size_t                        bytes,
+                                    const blpapi::CorrelationId  *cid = 0);
+        // Like 'appendMessage', for a recap message.
+
+    void makeRoom(size_t bytes);
+        // Publish the current event if a message of 'bytes' does not fit in
+        // it, so that appending a message of at most 'bytes' next does not
+        // publish.
+
+    void flush();
+        // Publish the current event, if it has any message.
+
+    size_t numPendingMessages() const;
+
+    const Statistics& statistics() const;
+
+    static size_t fieldBytes(const blpapi::Name& name, size_t valueBytes);
+        // Return an estimate of the size of a field 'name' with a value of
+        // 'valueBytes'.
+};
+
+std::ostream& operator<<(std::ostream&                     stream,
+                         const PublishBatcher::Statistics& stats);
+
+                            // --------------
+                            // PublishBatcher
+                            // --------------
+
+inline
+PublishBatcher::Statistics::Statistics()
+: d_events(0)
+, d_messages(0)
+, d_bytes(0)
+, d_fullOnBytes(0)
+, d_fullOnMessages(0)
+{
+}
+
+inline
+PublishBatcher::PublishBatcher(blpapi::ProviderSession *session,
+                               const blpapi::Service&   service,
+                               size_t                   maxBytes,
+                               size_t                   maxMessages,
+                               PublishCallback          callback)
+: d_session_p(session)
+, d_service(service)
+, d_formatter_p(0)
+, d_bytes(0)
+, d_messages(0)
+, d_maxBytes(maxBytes)
+, d_maxMessages(maxMessages ? maxMessages : 1)
+, d_callback(callback)
+{
+}
+
+inline
+PublishBatcher::~PublishBatcher()
+{
+    delete d_formatter_p;
+}
+
+inline
+void PublishBatcher::makeRoom(size_t bytes)
+{
+    if (d_messages) {
+        if (d_messages + 1 > d_maxMessages) {
+            ++d_stats.d_fullOnMessages;
+            flush();
+        }
+        else if (d_bytes + bytes > d_maxBytes) {
+            ++d_stats.d_fullOnBytes;
+            flush();
+        }
+    }
+}
+
+inline
+void PublishBatcher::reserve(size_t bytes)
+{
+    makeRoom(bytes);
+    if (!d_formatter_p) {
+        d_event       = d_service.createPublishEvent();
+        d_formatter_p = new blpapi::EventFormatter(d_event);
+    }
+    d_bytes += bytes;
+    ++d_messages;
+}
+
+inline
+blpapi::EventFormatter& PublishBatcher::appendMessage(
+                                          const blpapi::Name&  messageType,
+                                          const blpapi::Topic& topic,
+                                          size_t               bytes)
+{
+    reserve(bytes);
+    d_formatter_p->appendMessage(messageType, topic);
+    return *d_formatter_p;
+}
+
+inline
+blpapi::EventFormatter& PublishBatcher::appendRecapMessage(
+                                    const blpapi::Topic&          topic,
+                                    size_t                        bytes,
+                                    const blpapi::CorrelationId  *cid)
+{
+    reserve(bytes);
+    d_formatter_p->appendRecapMessage(topic, cid);
+    return *d_formatter_p;
+}
+
+inline
+void PublishBatcher::flush()
+{
+    if (!d_messages) {
+        return;
+    }
+
+    // The formatter must be gone before the event is published.
+    delete d_formatter_p;
+    d_formatter_p = 0;
+
+    ++d_stats.d_events;
+    d_stats.d_messages += d_messages;
+    d_stats.d_bytes    += d_bytes;
+    d_bytes    = 0;
+    d_messages = 0;
+
+    if (d_callback) {
+        d_callback(d_event);
+    }
+    d_session_p->publish(d_event);
+}
+
+inline
+size_t PublishBatcher::numPendingMessages() const
+{
+    return d_messages;
+}
+
+inline
+const PublishBatcher::Statistics& PublishBatcher::statistics() const
+{
+    return d_stats;
+}
+
+inline
+size_t PublishBatcher::fieldBytes(const blpapi::Name& name, size_t valueBytes)
+{
+    // A field carries its name and a small type and length header.
+    return name.length() + valueBytes + 4;
+}
+
+inline
+std::ostream& operator<<(std::ostream&                     stream,
+                         const PublishBatcher::Statistics& stats)
+{
+    stream << "PublishBatcher: events=" << stats.d_events
+           << " messages=" << stats.d_messages
+           << " bytes=" << stats.d_bytes
+           << " fullOnBytes=" << stats.d_fullOnBytes
+           << " fullOnMessages=" << stats.d_fullOnMessages;
+    if (stats.d_events) {
+        stream << " messagesPerEvent=" << stats.d_messages / stats.d_events
+               << " bytesPerMessage="
+               << (stats.d_messages ? stats.d_bytes / stats.d_messages : 0);
+    }
+    return stream;
+}
+
+} // namespace BloombergLP {
+
+#endif // INCLUDED_BLPPUBLISHBATCHER
@@ -0,0 +1,425 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef INCLUDED_BLPPUBLISHSCHEDULER
+#define INCLUDED_BLPPUBLISHSCHEDULER
+
+#include "BlpThreadUtil.h"
+
+#include <blpapi_highresolutionclock.h>
+#include <blpapi_timepoint.h>
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+namespace BloombergLP {
+
+// PublishScheduler tells a publishing thread which topics to publish, and
+// when, instead of the thread waking on a fixed 'SLEEP' and formatting every
+// topic.  Each topic is added once and gets a 'Handle'.  'trigger' says the
+// source value of a topic changed; the topic becomes due at the end of the
+// scheduler's current window, every further trigger of it before then is
+// coalesced into the same publish, and every topic triggered in the same
+// window is returned by the same 'wait', to go out in one event.  With a
+// window of zero a triggered topic is due at once.  'setPeriod' makes a
+// topic due again a fixed time after each publish, for sources that tick on
+// their own; periodic deadlines are also rounded up to the window.
+//
+// Deadlines are kept in a hashed timer wheel of 'numSlots' slots, each one
+// tick wide, so that adding or moving a deadline is constant time however
+// many topics there are.  A topic has at most one live deadline; a trigger
+// that brings it forward leaves the old wheel entry behind, to be dropped
+// when its slot is next visited.  The publishing thread calls 'wait', which
+// sleeps on a condition variable until the earliest pending deadline, found
+// by scanning the wheel from the current tick, or until a trigger or 'stop'
+// if there is none, and then returns the user data of every due topic.
+//
+// Every function may be called from any thread, but only one thread should
+// call 'wait'.
+class PublishScheduler
+{
+  public:
+    typedef size_t Handle;
+
+    struct Statistics {
+        long long d_triggers;    // calls to 'trigger'
+        long long d_coalesced;   // triggers of a topic already pending
+        long long d_published;   // topics returned by 'wait'
+        long long d_batches;     // returns of 'wait' with due topics
+
+        Statistics();
+    };
+
+    static const int    k_DEFAULT_TICK_MICROS = 100;
+    static const size_t k_DEFAULT_NUM_SLOTS   = 1024;
+
+  private:
+    struct Topic {
+        void      *d_userData_p;
+        long long  d_periodTicks;   // 0 if not periodic
+        long long  d_deadline;      // tick, or -1 if there is none
+        bool       d_isDue;
+    };
+
+    struct Entry {
+        Handle    d_handle;
+        long long d_deadline;
+    };
+
+    typedef std::vector<Entry> Slot;
+
+    mutable Mutex       d_mutex;
+    Condition           d_condition;
+    std::vector<Topic>  d_topics;
+    std::vector<Slot>   d_wheel;
+    std::vector<Handle> d_due;
+    size_t              d_numEntries;
+    long long           d_nextTick;      // every earlier tick is expired
+    long long           d_tickNs;
+    long long           d_windowTicks;
+    blpapi::TimePoint   d_epoch;
+    bool                d_isWaiting;
+    bool                d_isStopped;
+    Statistics          d_stats;
+
+    PublishScheduler(const PublishScheduler&);
+    PublishScheduler& operator=(const PublishScheduler&);
+
+    long long elapsedNs() const;
+
+    long long toTicks(long long microseconds) const;
+        // Return 'microseconds' in ticks, rounded up.
+
+    long long align(long long tick) const;
+        // Return 'tick' rounded up to the end of its window.
+
+    void schedule(Handle handle, long long deadline);
+        // Make 'handle' due at the 'deadline' tick unless it is due already
+        // or has an earlier deadline.
+
+    void expire(long long now);
+        // Make due every topic whose deadline is at or before the 'now'
+        // tick.
+
+    void expireSlot(Slot *slot, long long now);
+
+    long long nextDeadline() const;
+        // Return the earliest live deadline, or -1 if there is none.
+
+  public:
+    explicit PublishScheduler(
+                         long long windowMicros = 0,
+                         long long tickMicros   = k_DEFAULT_TICK_MICROS,
+                         size_t    numSlots     = k_DEFAULT_NUM_SLOTS);
+        // Create a scheduler that batches triggers over windows of
+        // 'windowMicros', with deadlines rounded up to 'tickMicros'.
+
+    Handle add(void *userData);
+        // Add a topic that is not due, and return its handle.  'wait'
+        // returns 'userData' when the topic is due.
+
+    void setWindow(long long windowMicros);
+
+    void setPeriod(Handle handle, long long periodMicros);
+        // Make 'handle' due 'periodMicros' from now and after each time it
+        // is published.  A period of zero stops the periodic publishes.
+
+    void trigger(Handle handle);
+        // Note that the source of 'handle' changed, and make it due at the
+        // end of the current window.
+
+    void cancel(Handle handle);
+        // Drop the deadline and the period of 'handle'.  A topic that is
+        // already due is still returned by the next 'wait'.
+
+    int wait(std::vector<void *> *due);
+        // Wait until at least one topic is due and load the user data of
+        // every due topic into 'due'.  Return 0 on success and a non-zero
+        // value if the scheduler was stopped.
+
+    void stop();
+        // Make 'wait' return non-zero from now on.
+
+    Statistics statistics() const;
+};
+
+std::ostream& operator<<(std::ostream&                       stream,
+                         const PublishScheduler::Statistics& stats);
+
+                            // ----------------
+                            // PublishScheduler
+                            // ----------------
+
+inline
+PublishScheduler::Statistics::Statistics()
+: d_triggers(0)
+, d_coalesced(0)
+, d_published(0)
+, d_batches(0)
+{
+}
+
+inline
+PublishScheduler::PublishScheduler(long long windowMicros,
+                                   long long tickMicros,
+                                   size_t    numSlots)
+: d_wheel(numSlots ? numSlots : 1)
+, d_numEntries(0)
+, d_nextTick(0)
+, d_tickNs(tickMicros > 0 ? tickMicros * 1000 : 1000)
+, d_windowTicks(0)
+, d_epoch(blpapi::HighResolutionClock::now())
+, d_isWaiting(false)
+, d_isStopped(false)
+{
+    d_windowTicks = toTicks(windowMicros);
+}
+
+inline
+long long PublishScheduler::elapsedNs() const
+{
+    return blpapi::TimePointUtil::nanosecondsBetween(
+                                         d_epoch,
+                                         blpapi::HighResolutionClock::now());
+}
+
+inline
+long long PublishScheduler::toTicks(long long microseconds) const
+{
+    return microseconds > 0 ? (microseconds * 1000 + d_tickNs - 1) / d_tickNs
+                            : 0;
+}
+
+inline
+long long PublishScheduler::align(long long tick) const
+{
+    return d_windowTicks
+         ? (tick + d_windowTicks - 1) / d_windowTicks * d_windowTicks
+         : tick;
+}
+
+inline
+void PublishScheduler::schedule(Handle handle, long long deadline)
+{
+    Topic& topic = d_topics[handle];
+    if (topic.d_isDue
+     || (topic.d_deadline >= 0 && topic.d_deadline <= deadline)) {
+        ++d_stats.d_coalesced;
+        return;
+    }
+    if (deadline < d_nextTick) {
+        // The slot of 'deadline' was visited already on this turn.
+        topic.d_deadline = -1;
+        topic.d_isDue    = true;
+        d_due.push_back(handle);
+    }
+    else {
+        topic.d_deadline = deadline;
+        Entry entry = { handle, deadline };
+        d_wheel[static_cast<size_t>(deadline % d_wheel.size())].push_back(
+                                                                       entry);
+        ++d_numEntries;
+    }
+    if (d_isWaiting) {
+        d_condition.signal();
+    }
+}
+
+inline
+void PublishScheduler::expireSlot(Slot *slot, long long now)
+{
+    for (size_t i = 0; i < slot->size();) {
+        Entry& entry = (*slot)[i];
+        Topic& topic = d_topics[entry.d_handle];
+        if (topic.d_deadline == entry.d_deadline && entry.d_deadline > now) {
+            ++i;                                   // a later turn of the wheel
+            continue;
+        }
+        if (topic.d_deadline == entry.d_deadline) {
+            topic.d_deadline = -1;
+            topic.d_isDue    = true;
+            d_due.push_back(entry.d_handle);
+        }
+        entry = slot->back();                      // expired or stale
+        slot->pop_back();
+        --d_numEntries;
+    }
+}
+
+inline
+void PublishScheduler::expire(long long now)
+{
+    if (now < d_nextTick) {
+        return;
+    }
+    const long long numSlots = static_cast<long long>(d_wheel.size());
+    if (now - d_nextTick >= numSlots) {
+        // Every slot is behind; visit each once.
+        for (size_t i = 0; i < d_wheel.size(); ++i) {
+            expireSlot(&d_wheel[i], now);
+        }
+    }
+    else {
+        for (long long tick = d_nextTick; tick <= now; ++tick) {
+            expireSlot(&d_wheel[static_cast<size_t>(tick % numSlots)], now);
+        }
+    }
+    d_nextTick = now + 1;
+}
+
+inline
+long long PublishScheduler::nextDeadline() const
+{
+    // The entries of the slot of 'tick' are due at 'tick' or on a later
+    // turn of the wheel, so the first live entry due at its own slot's tick
+    // is the earliest; otherwise it is the earliest of the later turns.
+    const long long numSlots = static_cast<long long>(d_wheel.size());
+    long long       next     = -1;
+    for (long long tick = d_nextTick;
+         d_numEntries && tick < d_nextTick + numSlots;
+         ++tick) {
+        const Slot& slot = d_wheel[static_cast<size_t>(tick % numSlots)];
+        for (size_t i = 0; i < slot.size(); ++i) {
+            const long long deadline = slot[i].d_deadline;
+            if (d_topics[slot[i].d_handle].d_deadline != deadline) {
+                continue;                                           // stale
+            }
+            if (deadline == tick) {
+                return tick;
+            }
+            if (next < 0 || deadline < next) {
+                next = deadline;
+            }
+        }
+    }
+    return next;
+}
+
+inline
+PublishScheduler::Handle PublishScheduler::add(void *userData)
+{
+    MutexGuard guard(&d_mutex);
+    Topic topic = { userData, 0, -1, false };
+    d_topics.push_back(topic);
+    return d_topics.size() - 1;
+}
+
+inline
+void PublishScheduler::setWindow(long long windowMicros)
+{
+    MutexGuard guard(&d_mutex);
+    d_windowTicks = toTicks(windowMicros);
+}
+
+inline
+void PublishScheduler::setPeriod(Handle handle, long long periodMicros)
+{
+    MutexGuard guard(&d_mutex);
+    long long period = toTicks(periodMicros);
+    d_topics[handle].d_periodTicks = period;
+    if (period) {
+        schedule(handle, align(elapsedNs() / d_tickNs + period));
+    }
+}
+
+inline
+void PublishScheduler::trigger(Handle handle)
+{
+    MutexGuard guard(&d_mutex);
+    ++d_stats.d_triggers;
+    long long now = elapsedNs() / d_tickNs;
+    schedule(handle, d_windowTicks ? align(now + 1) : now);
+}
+
+inline
+void PublishScheduler::cancel(Handle handle)
+{
+    MutexGuard guard(&d_mutex);
+    d_topics[handle].d_periodTicks = 0;
+    d_topics[handle].d_deadline    = -1;
+}
+
+inline
+int PublishScheduler::wait(std::vector<void *> *due)
+{
+    MutexGuard guard(&d_mutex);
+    due->clear();
+    while (!d_isStopped) {
+        long long elapsed = elapsedNs();
+        long long now     = elapsed / d_tickNs;
+        expire(now);
+        if (!d_due.empty()) {
+            for (size_t i = 0; i < d_due.size(); ++i) {
+                Topic& topic = d_topics[d_due[i]];
+                topic.d_isDue = false;
+                due->push_back(topic.d_userData_p);
+                if (topic.d_periodTicks) {
+                    schedule(d_due[i], align(now + topic.d_periodTicks));
+                }
+            }
+            d_stats.d_published += d_due.size();
+            ++d_stats.d_batches;
+            d_due.clear();
+            return 0;
+        }
+        d_isWaiting = true;
+        long long deadline = nextDeadline();
+        if (deadline >= 0) {
+            // Sleep to the start of the earliest deadline's tick; a trigger
+            // that brings a deadline forward signals the condition.
+            long long ns = deadline * d_tickNs - elapsed;
+            d_condition.timedWait(&d_mutex, (ns + 999) / 1000);
+        }
+        else {
+            d_condition.wait(&d_mutex);
+        }
+        d_isWaiting = false;
+    }
+    return 1;
+}
+
+inline
+void PublishScheduler::stop()
+{
+    MutexGuard guard(&d_mutex);
+    d_isStopped = true;
+    d_condition.broadcast();
+}
+
+inline
+PublishScheduler::Statistics PublishScheduler::statistics() const
+{
+    MutexGuard guard(&d_mutex);
+    return d_stats;
+}
+
+inline
+std::ostream& operator<<(std::ostream&                       stream,
+                         const PublishScheduler::Statistics& stats)
+{
+    return stream << "PublishScheduler: triggers=" << stats.d_triggers
+                  << " coalesced=" << stats.d_coalesced
+                  << " published=" << stats.d_published
+                  << " batches=" << stats.d_batches;
+}
+
+} // namespace BloombergLP {
+
+#endif // INCLUDED_BLPPUBLISHSCHEDULER
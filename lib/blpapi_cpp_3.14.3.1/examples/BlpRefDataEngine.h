@@ -0,0 +1,580 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef INCLUDED_BLPREFDATAENGINE
+#define INCLUDED_BLPREFDATAENGINE
+
+#include <blpapi_correlationid.h>
+#include <blpapi_element.h>
+#include <blpapi_event.h>
+#include <blpapi_highresolutionclock.h>
+#include <blpapi_identity.h>
+#include <blpapi_message.h>
+#include <blpapi_name.h>
+#include <blpapi_request.h>
+#include <blpapi_service.h>
+#include <blpapi_session.h>
+#include <blpapi_timepoint.h>
+
+#include <algorithm>
+#include <cctype>
+#include <limits>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace BloombergLP {
+
+// RefDataEngine fetches the reference data of many securities and fields at
+// once.  It splits them into ReferenceDataRequests of at most
+// 'securitiesPerRequest' securities and 'k_MAX_FIELDS_PER_REQUEST' fields,
+// sends up to 'maxInFlight' of them at a time on an 'EventQueue' of its own,
+// so it works whether or not the session has an event handler, and decodes
+// the responses, partial or final and in whatever order they arrive, into
+// 'RefDataColumns'.
+//
+// 'RefDataColumns' keeps every value in one contiguous array of doubles,
+// field by field, so a field is a contiguous column of one value per
+// security that can be handed out without copying, for example as a NumPy
+// array.  Values that are not numbers, such as dates, strings and bulk
+// fields, are NaN in that array and kept as strings on the side.
+
+struct RefDataColumns {
+    std::vector<std::string>       d_securities;
+    std::vector<std::string>       d_fields;
+    std::vector<double>            d_values;          // see 'cell'
+    std::map<size_t, std::string>  d_strings;         // by cell
+    std::map<size_t, std::string>  d_errors;          // by cell
+    std::vector<std::string>       d_securityErrors;  // by security
+
+    size_t cell(size_t security, size_t field) const;
+        // Return the index in 'd_values' of the value of 'field' for
+        // 'security', which is 'field * d_securities.size() + security'.
+
+    const double *column(size_t field) const;
+
+    size_t numSecurities() const;
+
+    size_t numFields() const;
+};
+
+class RefDataEngine {
+  public:
+    enum {
+        e_SUCCESS        = 0,
+        e_TIMEOUT        = 1,   // no event for 'timeoutMs'
+        e_REQUEST_FAILED = 2    // some request failed, see 'd_errors'
+    };
+
+    static const size_t k_MAX_FIELDS_PER_REQUEST = 400;
+
+    struct Statistics {
+        size_t     d_requests;
+        size_t     d_messages;
+        size_t     d_values;      // numbers and strings decoded
+        long long  d_elapsedNs;
+
+        Statistics();
+    };
+
+  private:
+    struct Batch {
+        size_t d_firstSecurity;
+        size_t d_numSecurities;
+        size_t d_firstField;
+        size_t d_numFields;
+    };
+
+    typedef std::map<blpapi::Name, size_t> FieldIndex;
+
+    blpapi::Session  *d_session_p;
+    blpapi::Service   d_service;
+    blpapi::Identity  d_identity;
+    size_t            d_securitiesPerRequest;
+    size_t            d_maxInFlight;
+
+    RefDataEngine(const RefDataEngine&);
+    RefDataEngine& operator=(const RefDataEngine&);
+
+    void send(const RefDataColumns&  result,
+              const Batch&           batch,
+              size_t                 index,
+              blpapi::EventQueue    *queue);
+
+    static void decode(RefDataColumns         *result,
+                       Statistics             *stats,
+                       const Batch&            batch,
+                       const FieldIndex&       fieldIndex,
+                       const blpapi::Message&  msg);
+
+    static void failBatch(RefDataColumns     *result,
+                          const Batch&        batch,
+                          const std::string&  reason);
+        // Record 'reason' as the error of every value of 'batch'.
+
+    static std::string errorText(const blpapi::Element& errorInfo);
+
+    static void expandFields(RefDataColumns                  *result,
+                             const std::vector<std::string>&  fields,
+                             const std::vector<size_t>&       unique);
+        // Replace the columns of 'result', one per distinct field, by one
+        // per field in 'fields', field 'i' being a copy of the column
+        // 'unique[i]'.
+
+  public:
+    RefDataEngine(blpapi::Session       *session,
+                  const blpapi::Service&  refDataService,
+                  size_t                 securitiesPerRequest = 100,
+                  size_t                 maxInFlight = 16);
+
+    void setIdentity(const blpapi::Identity& identity);
+
+    int fetch(RefDataColumns                  *result,
+              const std::vector<std::string>&  securities,
+              const std::vector<std::string>&  fields,
+              int                              timeoutMs,
+              Statistics                      *stats = 0);
+        // Load into 'result' the value of every field in 'fields' for every
+        // security in 'securities'.  Return 'e_SUCCESS', or 'e_TIMEOUT' if
+        // no response came for 'timeoutMs' milliseconds, in which case the
+        // requests still outstanding are cancelled, or 'e_REQUEST_FAILED'.
+        // 'result' has whatever arrived in either case.  A field given more
+        // than once, whatever its case, is requested once and has the same
+        // values in each of its columns.
+};
+
+std::ostream& operator<<(std::ostream&                    stream,
+                         const RefDataEngine::Statistics& stats);
+
+                            // --------------
+                            // RefDataColumns
+                            // --------------
+
+inline
+size_t RefDataColumns::cell(size_t security, size_t field) const
+{
+    return field * d_securities.size() + security;
+}
+
+inline
+const double *RefDataColumns::column(size_t field) const
+{
+    return d_values.empty() ? 0 : &d_values[cell(0, field)];
+}
+
+inline
+size_t RefDataColumns::numSecurities() const
+{
+    return d_securities.size();
+}
+
+inline
+size_t RefDataColumns::numFields() const
+{
+    return d_fields.size();
+}
+
+                            // -------------
+                            // RefDataEngine
+                            // -------------
+
+inline
+RefDataEngine::Statistics::Statistics()
+: d_requests(0)
+, d_messages(0)
+, d_values(0)
+, d_elapsedNs(0)
+{
+}
+
+inline
+RefDataEngine::RefDataEngine(blpapi::Session       *session,
+                             const blpapi::Service&  refDataService,
+                             size_t                 securitiesPerRequest,
+                             size_t                 maxInFlight)
+: d_session_p(session)
+, d_service(refDataService)
+, d_securitiesPerRequest(securitiesPerRequest > 0 ? securitiesPerRequest
+                                                  : 1)
+, d_maxInFlight(maxInFlight > 0 ? maxInFlight : 1)
+{
+}
+
+inline
+void RefDataEngine::setIdentity(const blpapi::Identity& identity)
+{
+    d_identity = identity;
+}
+
+inline
+void RefDataEngine::send(const RefDataColumns&  result,
+                         const Batch&           batch,
+                         size_t                 index,
+                         blpapi::EventQueue    *queue)
+{
+    blpapi::Request request =
+                            d_service.createRequest("ReferenceDataRequest");
+    blpapi::Element securities = request.getElement("securities");
+    for (size_t i = 0; i < batch.d_numSecurities; ++i) {
+        securities.appendValue(
+                     result.d_securities[batch.d_firstSecurity + i].c_str());
+    }
+    blpapi::Element fields = request.getElement("fields");
+    for (size_t i = 0; i < batch.d_numFields; ++i) {
+        fields.appendValue(result.d_fields[batch.d_firstField + i].c_str());
+    }
+    d_session_p->sendRequest(
+                        request,
+                        d_identity,
+                        blpapi::CorrelationId(static_cast<long long>(index)),
+                        queue);
+}
+
+inline
+std::string RefDataEngine::errorText(const blpapi::Element& errorInfo)
+{
+    static const blpapi::Name CATEGORY("category");
+    static const blpapi::Name MESSAGE("message");
+
+    std::string     text;
+    blpapi::Element part;
+    if (0 == errorInfo.getElement(&part, CATEGORY)) {
+        text = part.getValueAsString();
+    }
+    if (0 == errorInfo.getElement(&part, MESSAGE)) {
+        text += " (";
+        text += part.getValueAsString();
+        text += ')';
+    }
+    return text;
+}
+
+inline
+void RefDataEngine::failBatch(RefDataColumns     *result,
+                              const Batch&        batch,
+                              const std::string&  reason)
+{
+    for (size_t f = 0; f < batch.d_numFields; ++f) {
+        for (size_t s = 0; s < batch.d_numSecurities; ++s) {
+            result->d_errors[result->cell(batch.d_firstSecurity + s,
+                                          batch.d_firstField + f)] = reason;
+        }
+    }
+}
+
+inline
+void RefDataEngine::expandFields(RefDataColumns                  *result,
+                                 const std::vector<std::string>&  fields,
+                                 const std::vector<size_t>&       unique)
+{
+    const size_t numSecurities = result->numSecurities();
+    result->d_fields = fields;
+    if (numSecurities == 0) {
+        return;
+    }
+
+    std::vector<double> values(numSecurities * fields.size());
+    for (size_t f = 0; f < fields.size(); ++f) {
+        std::copy(result->d_values.begin() + unique[f] * numSecurities,
+                  result->d_values.begin() + (unique[f] + 1) * numSecurities,
+                  values.begin() + f * numSecurities);
+    }
+    result->d_values.swap(values);
+
+    std::map<size_t, std::string> *maps[] = { &result->d_strings,
+                                              &result->d_errors };
+    for (size_t m = 0; m < sizeof maps / sizeof *maps; ++m) {
+        std::map<size_t, std::string> byCell;
+        for (size_t f = 0; f < fields.size(); ++f) {
+            std::map<size_t, std::string>::const_iterator it =
+                              maps[m]->lower_bound(unique[f] * numSecurities);
+            for (; it != maps[m]->end()
+                       && it->first < (unique[f] + 1) * numSecurities; ++it) {
+                byCell[result->cell(it->first % numSecurities, f)] =
+                                                                  it->second;
+            }
+        }
+        maps[m]->swap(byCell);
+    }
+}
+
+inline
+void RefDataEngine::decode(RefDataColumns         *result,
+                           Statistics             *stats,
+                           const Batch&            batch,
+                           const FieldIndex&       fieldIndex,
+                           const blpapi::Message&  msg)
+{
+    static const blpapi::Name SECURITY_DATA("securityData");
+    static const blpapi::Name SEQUENCE_NUMBER("sequenceNumber");
+    static const blpapi::Name SECURITY_ERROR("securityError");
+    static const blpapi::Name FIELD_DATA("fieldData");
+    static const blpapi::Name FIELD_EXCEPTIONS("fieldExceptions");
+    static const blpapi::Name FIELD_ID("fieldId");
+    static const blpapi::Name ERROR_INFO("errorInfo");
+
+    blpapi::Element securities;
+    if (0 != msg.asElement().getElement(&securities, SECURITY_DATA)) {
+        return;
+    }
+
+    const size_t    numSecurities = securities.numValues();
+    blpapi::Element securityData;
+    blpapi::Element element;
+    for (size_t i = 0; i < numSecurities; ++i) {
+        securities.getValueAs(&securityData, i);
+
+        // 'sequenceNumber' is the position of the security in the request.
+        blpapi::Int32 sequenceNumber = static_cast<blpapi::Int32>(i);
+        if (0 == securityData.getElement(&element, SEQUENCE_NUMBER)) {
+            element.getValueAs(&sequenceNumber);
+        }
+        if (sequenceNumber < 0
+                || static_cast<size_t>(sequenceNumber)
+                                                 >= batch.d_numSecurities) {
+            continue;
+        }
+        const size_t security = batch.d_firstSecurity + sequenceNumber;
+
+        if (0 == securityData.getElement(&element, SECURITY_ERROR)) {
+            result->d_securityErrors[security] = errorText(element);
+            continue;
+        }
+
+        blpapi::Element fieldData;
+        if (0 == securityData.getElement(&fieldData, FIELD_DATA)) {
+            const size_t numElements = fieldData.numElements();
+            for (size_t j = 0; j < numElements; ++j) {
+                fieldData.getElement(&element, j);
+                FieldIndex::const_iterator it =
+                                              fieldIndex.find(element.name());
+                if (it == fieldIndex.end()) {
+                    continue;
+                }
+                const size_t cell = result->cell(security, it->second);
+                ++stats->d_values;
+                if (element.isArray() || element.isComplexType()
+                        || 0 != element.getValueAs(&result->d_values[cell])) {
+                    std::string& text = result->d_strings[cell];
+                    if (0 != element.getValueAs(&text)) {
+                        std::ostringstream stream;
+                        element.print(stream, 0, -1);
+                        text = stream.str();
+                    }
+                }
+            }
+        }
+
+        blpapi::Element exceptions;
+        if (0 == securityData.getElement(&exceptions, FIELD_EXCEPTIONS)) {
+            const size_t numExceptions = exceptions.numValues();
+            for (size_t j = 0; j < numExceptions; ++j) {
+                blpapi::Element exception;
+                blpapi::Element errorInfo;
+                exceptions.getValueAs(&exception, j);
+                if (0 != exception.getElement(&element, FIELD_ID)
+                        || 0 != exception.getElement(&errorInfo,
+                                                     ERROR_INFO)) {
+                    continue;
+                }
+                FieldIndex::const_iterator it = fieldIndex.find(
+                                   blpapi::Name(element.getValueAsString()));
+                if (it != fieldIndex.end()) {
+                    result->d_errors[result->cell(security, it->second)] =
+                                                        errorText(errorInfo);
+                }
+            }
+        }
+    }
+}
+
+inline
+int RefDataEngine::fetch(RefDataColumns                  *result,
+                         const std::vector<std::string>&  securities,
+                         const std::vector<std::string>&  fields,
+                         int                              timeoutMs,
+                         Statistics                      *stats)
+{
+    static const blpapi::Name RESPONSE_ERROR("responseError");
+    static const blpapi::Name REQUEST_FAILURE("RequestFailure");
+    static const blpapi::Name REASON("reason");
+
+    Statistics localStats;
+    if (!stats) {
+        stats = &localStats;
+    }
+    *stats = Statistics();
+    const blpapi::TimePoint startedAt = blpapi::HighResolutionClock::now();
+
+    // Responses name fields by their mnemonic, in upper case, so a field
+    // given twice would fill only one of its columns: request each field
+    // once, and copy its values to the other columns at the end.
+    std::vector<std::string>      distinct;
+    std::vector<std::string>      mnemonics(fields);
+    std::vector<size_t>           unique(fields.size());
+    std::map<std::string, size_t> seen;
+    for (size_t i = 0; i < fields.size(); ++i) {
+        std::string& mnemonic = mnemonics[i];
+        for (size_t j = 0; j < mnemonic.size(); ++j) {
+            mnemonic[j] = static_cast<char>(
+                       std::toupper(static_cast<unsigned char>(mnemonic[j])));
+        }
+        std::pair<std::map<std::string, size_t>::iterator, bool> inserted =
+                      seen.insert(std::make_pair(mnemonic, distinct.size()));
+        if (inserted.second) {
+            distinct.push_back(fields[i]);
+        }
+        unique[i] = inserted.first->second;
+    }
+
+    result->d_securities = securities;
+    result->d_fields     = distinct;
+    result->d_values.assign(securities.size() * distinct.size(),
+                            std::numeric_limits<double>::quiet_NaN());
+    result->d_strings.clear();
+    result->d_errors.clear();
+    result->d_securityErrors.assign(securities.size(), std::string());
+
+    FieldIndex fieldIndex;
+    for (size_t i = 0; i < fields.size(); ++i) {
+        fieldIndex.insert(std::make_pair(blpapi::Name(mnemonics[i].c_str()),
+                                         unique[i]));
+        fieldIndex.insert(
+                 std::make_pair(blpapi::Name(fields[i].c_str()), unique[i]));
+    }
+
+    std::vector<Batch> batches;
+    for (size_t f = 0; f < distinct.size(); f += k_MAX_FIELDS_PER_REQUEST) {
+        for (size_t s = 0; s < securities.size();
+                                               s += d_securitiesPerRequest) {
+            Batch batch;
+            batch.d_firstSecurity = s;
+            batch.d_numSecurities = securities.size() - s
+                                                      < d_securitiesPerRequest
+                                  ? securities.size() - s
+                                  : d_securitiesPerRequest;
+            batch.d_firstField    = f;
+            batch.d_numFields     = distinct.size() - f
+                                                   < k_MAX_FIELDS_PER_REQUEST
+                                  ? distinct.size() - f
+                                  : k_MAX_FIELDS_PER_REQUEST;
+            batches.push_back(batch);
+        }
+    }
+
+    blpapi::EventQueue queue;
+    std::vector<bool>  inFlight(batches.size(), false);
+    size_t             next        = 0;
+    size_t             outstanding = 0;
+    int                rc          = e_SUCCESS;
+    while (next < batches.size() || outstanding > 0) {
+        while (next < batches.size() && outstanding < d_maxInFlight) {
+            send(*result, batches[next], next, &queue);
+            inFlight[next] = true;
+            ++next;
+            ++outstanding;
+            ++stats->d_requests;
+        }
+
+        blpapi::Event event = queue.nextEvent(timeoutMs);
+        if (event.eventType() == blpapi::Event::TIMEOUT) {
+            for (size_t i = 0; i < batches.size(); ++i) {
+                if (inFlight[i]) {
+                    d_session_p->cancel(
+                             blpapi::CorrelationId(static_cast<long long>(i)));
+                    failBatch(result, batches[i], "timed out");
+                }
+            }
+            rc = e_TIMEOUT;
+            break;
+        }
+
+        blpapi::MessageIterator msgIter(event);
+        while (msgIter.next()) {
+            blpapi::Message msg = msgIter.message();
+            if (msg.numCorrelationIds() == 0) {
+                continue;
+            }
+            blpapi::CorrelationId correlationId = msg.correlationId();
+            if (correlationId.valueType()
+                                     != blpapi::CorrelationId::INT_VALUE) {
+                continue;
+            }
+            long long index = correlationId.asInteger();
+            if (index < 0
+                    || index >= static_cast<long long>(batches.size())
+                    || !inFlight[index]) {
+                continue;
+            }
+            ++stats->d_messages;
+
+            const Batch&    batch = batches[index];
+            blpapi::Element errorInfo;
+            bool            done  = event.eventType()
+                                              == blpapi::Event::RESPONSE;
+            if (msg.messageType() == REQUEST_FAILURE) {
+                failBatch(result,
+                          batch,
+                          0 == msg.asElement().getElement(&errorInfo, REASON)
+                              ? errorText(errorInfo)
+                              : std::string("request failed"));
+                rc   = e_REQUEST_FAILED;
+                done = true;
+            }
+            else if (0 == msg.asElement().getElement(&errorInfo,
+                                                     RESPONSE_ERROR)) {
+                failBatch(result, batch, errorText(errorInfo));
+                rc = e_REQUEST_FAILED;
+            }
+            else {
+                decode(result, stats, batch, fieldIndex, msg);
+            }
+
+            if (done) {
+                inFlight[index] = false;
+                --outstanding;
+            }
+        }
+    }
+
+    if (distinct.size() != fields.size()) {
+        expandFields(result, fields, unique);
+    }
+
+    stats->d_elapsedNs = blpapi::TimePointUtil::nanosecondsBetween(
+                                         startedAt,
+                                         blpapi::HighResolutionClock::now());
+    return rc;
+}
+
+inline
+std::ostream& operator<<(std::ostream&                    stream,
+                         const RefDataEngine::Statistics& stats)
+{
+    return stream << "RefDataEngine: requests=" << stats.d_requests
+                  << " messages=" << stats.d_messages
+                  << " values=" << stats.d_values
+                  << " elapsedMs=" << stats.d_elapsedNs / 1000000;
+}
+
+} // namespace BloombergLP {
+
+#endif // INCLUDED_BLPREFDATAENGINE
@@ -0,0 +1,305 @@
+/* Copyright 2012. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+#ifndef INCLUDED_BLPSTREAMREGISTRY
+#define INCLUDED_BLPSTREAMREGISTRY
+
+#include "BlpThreadUtil.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace BloombergLP {
+
+// StreamRegistry maps topic strings to the streams a publisher owns.  The
+// topics are split over a power-of-two number of shards by the high bits of
+// their 64-bit FNV-1a hash, and each shard has its own 'Mutex', an
+// open-addressing table probed linearly from the low bits of the hash, and
+// its streams in the order they were added.  A TOPIC_SUBSCRIBED for one
+// topic therefore only waits for a publisher that is formatting the same
+// shard, and the publish loop locks one shard at a time instead of every
+// stream for the length of an event.
+//
+// Streams are never removed, as a publisher keeps a stream across
+// unsubscribe and resubscribe, so the tables need no tombstones.  The
+// registry owns the streams and deletes them when destroyed.  Every access
+// goes through a 'ShardGuard', which holds the lock of one shard.
+template <class STREAM>
+class StreamRegistry
+{
+    struct Slot {
+        unsigned long long d_hash;
+        size_t             d_index;    // 1 + index in 'd_streams', 0 if empty
+    };
+
+    struct Shard {
+        Mutex                           d_mutex;
+        std::vector<Slot>               d_slots;
+        std::vector<STREAM *>           d_streams;
+        std::vector<std::string>        d_topics;
+        std::vector<unsigned long long> d_hashes;
+    };
+
+    std::vector<Shard *> d_shards;
+    unsigned             d_shardShift;
+
+    StreamRegistry(const StreamRegistry&);
+    StreamRegistry& operator=(const StreamRegistry&);
+
+    static void grow(Shard *shard);
+
+    static void place(std::vector<Slot>  *slots,
+                      unsigned long long  hash,
+                      size_t              index);
+
+  public:
+    static const size_t k_DEFAULT_NUM_SHARDS = 64;
+
+    class ShardGuard
+    {
+        Shard *d_shard_p;
+        bool   d_locked;
+
+        ShardGuard(const ShardGuard&);
+        ShardGuard& operator=(const ShardGuard&);
+
+      public:
+        ShardGuard(StreamRegistry *registry, size_t shard);
+            // Lock the specified 'shard' of 'registry'.
+
+        ShardGuard(StreamRegistry *registry, const std::string& topic);
+            // Lock the shard of 'registry' that holds, or would hold,
+            // 'topic'.
+
+        ~ShardGuard();
+
+        void unlock();
+            // Release the lock before the guard goes out of scope.  The
+            // guard must not be used afterwards.
+
+        STREAM *find(const std::string& topic) const;
+            // Return the stream of 'topic', or 0 if there is none.  'topic'
+            // must belong to the locked shard.
+
+        STREAM *insert(const std::string& topic, STREAM *stream);
+            // Add 'stream' for 'topic', which must belong to the locked
+            // shard and not be in the registry yet, and take ownership of
+            // it.  Return 'stream'.
+
+        size_t size() const;
+            // Return the number of streams in the locked shard.
+
+        STREAM *stream(size_t index) const;
+            // Return the stream at 'index' in the locked shard, in the order
+            // the streams were added.
+    };
+
+    explicit StreamRegistry(size_t numShards = k_DEFAULT_NUM_SHARDS);
+        // Create a registry with 'numShards' shards, rounded up to a power of
+        // two and at most 65536.
+
+    ~StreamRegistry();
+        // Delete every stream.
+
+    size_t numShards() const;
+
+    size_t shardOf(const std::string& topic) const;
+
+    static unsigned long long hash(const std::string& topic);
+};
+
+                            // --------------
+                            // StreamRegistry
+                            // --------------
+
+template <class STREAM>
+StreamRegistry<STREAM>::StreamRegistry(size_t numShards)
+: d_shardShift(64)
+{
+    size_t count = 1;
+    while (count < numShards && count < 65536) {
+        count *= 2;
+        --d_shardShift;
+    }
+    d_shards.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        d_shards.push_back(new Shard());
+    }
+}
+
+template <class STREAM>
+StreamRegistry<STREAM>::~StreamRegistry()
+{
+    for (size_t i = 0; i < d_shards.size(); ++i) {
+        for (size_t j = 0; j < d_shards[i]->d_streams.size(); ++j) {
+            delete d_shards[i]->d_streams[j];
+        }
+        delete d_shards[i];
+    }
+}
+
+template <class STREAM>
+inline
+size_t StreamRegistry<STREAM>::numShards() const
+{
+    return d_shards.size();
+}
+
+template <class STREAM>
+inline
+size_t StreamRegistry<STREAM>::shardOf(const std::string& topic) const
+{
+    // Shift in two steps so that one shard, a shift of 64, is defined.
+    return static_cast<size_t>((hash(topic) >> 1) >> (d_shardShift - 1));
+}
+
+template <class STREAM>
+inline
+unsigned long long StreamRegistry<STREAM>::hash(const std::string& topic)
+{
+    unsigned long long h = 14695981039346656037ULL;
+    for (size_t i = 0; i < topic.size(); ++i) {
+        h ^= static_cast<unsigned char>(topic[i]);
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+template <class STREAM>
+void StreamRegistry<STREAM>::place(std::vector<Slot>  *slots,
+                                   unsigned long long  hash,
+                                   size_t              index)
+{
+    size_t mask = slots->size() - 1;
+    size_t i    = static_cast<size_t>(hash) & mask;
+    while ((*slots)[i].d_index) {
+        i = (i + 1) & mask;
+    }
+    (*slots)[i].d_hash  = hash;
+    (*slots)[i].d_index = index + 1;
+}
+
+template <class STREAM>
+void StreamRegistry<STREAM>::grow(Shard *shard)
+{
+    // Keep the table at most half full so that probes stay short.
+    size_t capacity = shard->d_slots.empty() ? 16 : shard->d_slots.size() * 2;
+    Slot   empty    = { 0, 0 };
+    std::vector<Slot> slots(capacity, empty);
+    for (size_t i = 0; i < shard->d_hashes.size(); ++i) {
+        place(&slots, shard->d_hashes[i], i);
+    }
+    shard->d_slots.swap(slots);
+}
+
+                     // ------------------------------
+                     // StreamRegistry<S>::ShardGuard
+                     // ------------------------------
+
+template <class STREAM>
+inline
+StreamRegistry<STREAM>::ShardGuard::ShardGuard(StreamRegistry *registry,
+                                               size_t          shard)
+: d_shard_p(registry->d_shards[shard])
+, d_locked(true)
+{
+    d_shard_p->d_mutex.lock();
+}
+
+template <class STREAM>
+inline
+StreamRegistry<STREAM>::ShardGuard::ShardGuard(StreamRegistry     *registry,
+                                               const std::string&  topic)
+: d_shard_p(registry->d_shards[registry->shardOf(topic)])
+, d_locked(true)
+{
+    d_shard_p->d_mutex.lock();
+}
+
+template <class STREAM>
+inline
+StreamRegistry<STREAM>::ShardGuard::~ShardGuard()
+{
+    unlock();
+}
+
+template <class STREAM>
+inline
+void StreamRegistry<STREAM>::ShardGuard::unlock()
+{
+    if (d_locked) {
+        d_locked = false;
+        d_shard_p->d_mutex.unlock();
+    }
+}
+
+template <class STREAM>
+STREAM *StreamRegistry<STREAM>::ShardGuard::find(
+                                                const std::string& topic) const
+{
+    if (d_shard_p->d_slots.empty()) {
+        return 0;
+    }
+    unsigned long long h    = hash(topic);
+    size_t             mask = d_shard_p->d_slots.size() - 1;
+    for (size_t i = static_cast<size_t>(h) & mask;
+         d_shard_p->d_slots[i].d_index;
+         i = (i + 1) & mask) {
+        const Slot& slot = d_shard_p->d_slots[i];
+        if (slot.d_hash == h
+         && d_shard_p->d_topics[slot.d_index - 1] == topic) {
+            return d_shard_p->d_streams[slot.d_index - 1];
+        }
+    }
+    return 0;
+}
+
+template <class STREAM>
+STREAM *StreamRegistry<STREAM>::ShardGuard::insert(const std::string& topic,
+                                                   STREAM            *stream)
+{
+    if ((d_shard_p->d_streams.size() + 1) * 2 > d_shard_p->d_slots.size()) {
+        grow(d_shard_p);
+    }
+    unsigned long long h = hash(topic);
+    place(&d_shard_p->d_slots, h, d_shard_p->d_streams.size());
+    d_shard_p->d_streams.push_back(stream);
+    d_shard_p->d_topics.push_back(topic);
+    d_shard_p->d_hashes.push_back(h);
+    return stream;
+}
+
+template <class STREAM>
+inline
+size_t StreamRegistry<STREAM>::ShardGuard::size() const
+{
+    return d_shard_p->d_streams.size();
+}
+
+template <class STREAM>
+inline
+STREAM *StreamRegistry<STREAM>::ShardGuard::stream(size_t index) const
+{
+    return d_shard_p->d_streams[index];
+}
+
+} // namespace BloombergLP {
+
+#endif // INCLUDED_BLPSTREAMREGISTRY
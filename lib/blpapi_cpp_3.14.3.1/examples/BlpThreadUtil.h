@@ -25,12 +25,15 @@
 #define SLEEP(s) Sleep((s) * 1000)
 #else
 #include <pthread.h>
+#include <sys/time.h>
 #include <unistd.h>
 #define SLEEP(s) sleep(s)
 #endif // _WIN32
 
 namespace BloombergLP {
 
+class Condition;
+
 class Mutex
 {
    // DATA
@@ -44,6 +47,9 @@ class Mutex
     Mutex(const Mutex&);
     Mutex& operator=(const Mutex&);
 
+    // FRIENDS
+    friend class Condition;
+
   public:
 
     // CREATORS
@@ -67,6 +73,45 @@ class Mutex
         // calling thread currently owns the lock on this mutex.
 };
 
+class Condition
+{
+   // DATA
+#ifdef _WIN32
+    CONDITION_VARIABLE d_cond;
+#else
+    pthread_cond_t d_cond;
+#endif
+
+    // NOT IMPLEMENTED
+    Condition(const Condition&);
+    Condition& operator=(const Condition&);
+
+  public:
+
+    // CREATORS
+    Condition();
+        // Create a condition variable with no waiting threads.
+
+    ~Condition();
+        // Destroy this condition variable.
+
+    // MANIPULATORS
+    void wait(Mutex *mutex);
+        // Atomically unlock the specified 'mutex', which the calling thread
+        // must own, and wait until this condition is signaled, then lock
+        // 'mutex' again.  Note that the wait may also end spuriously.
+
+    void timedWait(Mutex *mutex, long long microseconds);
+        // Like 'wait', but return after at most the specified
+        // 'microseconds' even if this condition is not signaled.
+
+    void signal();
+        // Wake one thread waiting on this condition, if any.
+
+    void broadcast();
+        // Wake every thread waiting on this condition.
+};
+
 class MutexGuard
 {
     // DATA
@@ -149,6 +194,93 @@ void Mutex::unlock()
 
 #endif // _WIN32
 
+#ifdef _WIN32
+
+inline
+Condition::Condition()
+{
+    InitializeConditionVariable(&d_cond);
+}
+
+inline
+Condition::~Condition()
+{
+}
+
+inline
+void Condition::wait(Mutex *mutex)
+{
+    SleepConditionVariableCS(&d_cond, &mutex->d_lock, INFINITE);
+}
+
+inline
+void Condition::timedWait(Mutex *mutex, long long microseconds)
+{
+    // Round up, so that a short wait does not become a busy loop.
+    SleepConditionVariableCS(&d_cond,
+                             &mutex->d_lock,
+                             static_cast<DWORD>((microseconds + 999) / 1000));
+}
+
+inline
+void Condition::signal()
+{
+    WakeConditionVariable(&d_cond);
+}
+
+inline
+void Condition::broadcast()
+{
+    WakeAllConditionVariable(&d_cond);
+}
+
+#else
+
+inline
+Condition::Condition()
+{
+    pthread_cond_init(&d_cond, 0);
+}
+
+inline
+Condition::~Condition()
+{
+    pthread_cond_destroy(&d_cond);
+}
+
+inline
+void Condition::wait(Mutex *mutex)
+{
+    pthread_cond_wait(&d_cond, &mutex->d_lock);
+}
+
+inline
+void Condition::timedWait(Mutex *mutex, long long microseconds)
+{
+    // 'pthread_cond_timedwait' takes an absolute time on the realtime clock.
+    timeval now;
+    gettimeofday(&now, 0);
+    long long usec = now.tv_usec + microseconds;
+    timespec deadline;
+    deadline.tv_sec  = now.tv_sec + static_cast<time_t>(usec / 1000000);
+    deadline.tv_nsec = static_cast<long>(usec % 1000000) * 1000;
+    pthread_cond_timedwait(&d_cond, &mutex->d_lock, &deadline);
+}
+
+inline
+void Condition::signal()
+{
+    pthread_cond_signal(&d_cond);
+}
+
+inline
+void Condition::broadcast()
+{
+    pthread_cond_broadcast(&d_cond);
+}
+
+#endif // _WIN32
+
 inline
 MutexGuard::MutexGuard(Mutex *mutex)
         : d_mutex_p(mutex)
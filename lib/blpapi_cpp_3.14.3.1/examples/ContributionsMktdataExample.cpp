@@ -40,6 +40,7 @@
 #include <map>
 #include <string>
 
+#include "BlpPublishScheduler.h"
 #include "BlpThreadUtil.h"
 
 using namespace BloombergLP;
@@ -68,6 +69,8 @@ namespace {
 
     Mutex g_lock;
 
+    PublishScheduler g_scheduler;
+
     enum AuthorizationStatus {
         WAITING,
         AUTHORIZED,
@@ -125,6 +128,7 @@ bool MyEventHandler::processEvent(const Event& event, ProviderSession* session)
         if (event.eventType() == Event::SESSION_STATUS) {
             if (msg.messageType() == SESSION_TERMINATED) {
                 g_running = false;
+                g_scheduler.stop();
             }
             continue;
         }
@@ -148,6 +152,8 @@ class ContributionsMktdataExample
     std::string              d_service;
     std::string              d_topic;
     std::string              d_authOptions;
+    int                      d_intervalMs;
+    int                      d_windowMicros;
 
     std::string              d_clientCredentials;
     std::string              d_clientCredentialsPassword;
@@ -166,7 +172,9 @@ class ContributionsMktdataExample
             << "\t[-p    <tcpPort>]    \tserver port (default: 8194)" << std::endl
             << "\t[-s    <service>]    \tservice name (default: //blp/mpfbapi)" << std::endl
             << "\t[-t    <topic>]      \tservice name (default: /ticker/AUDEUR Curncy)" << std::endl
-            << "\t[-auth <option>]     \tauthentication option: user|none|app=<app>|userapp=<app>|dir=<property> (default: user)\n"
+            << "\t[-auth <option>]     \tauthentication option: user|none|app=<app>|userapp=<app>|dir=<property> (default: user)" << std::endl
+            << "\t[-iv   <millis>]     \tinterval between contributions (default: 10000)" << std::endl
+            << "\t[-bw   <micros>]     \twindow over which contributions are batched into one event (default: 500)\n"
             << std::endl
             << "TLS OPTIONS (specify all or none):\n"
                "\t[-tls-client-credentials <file>] \tname a PKCS#12 file to use as a source of client credentials\n"
@@ -190,6 +198,10 @@ class ContributionsMktdataExample
                 d_service = argv[++i];
             else if (!std::strcmp(argv[i],"-t") &&  i + 1 < argc)
                 d_topic = argv[++i];
+            else if (!std::strcmp(argv[i],"-iv") &&  i + 1 < argc)
+                d_intervalMs = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i],"-bw") &&  i + 1 < argc)
+                d_windowMicros = std::atoi(argv[++i]);
             else if (!std::strcmp(argv[i], "-auth") && i + 1 < argc) {
                 ++ i;
                 if (!std::strcmp(argv[i], AUTH_OPTION_NONE)) {
@@ -244,6 +256,13 @@ class ContributionsMktdataExample
             }
         }
 
+        if (d_intervalMs <= 0 || d_windowMicros < 0) {
+            std::cerr << "The interval must be positive and the window not"
+                      << " negative" << std::endl;
+            printUsage();
+            return false;
+        }
+
         if (d_hosts.empty()) {
             d_hosts.push_back("localhost");
         }
@@ -259,6 +278,8 @@ public:
         , d_service("//blp/mpfbapi")
         , d_topic("/ticker/AUDEUR Curncy")
         , d_authOptions(AUTH_USER)
+        , d_intervalMs(10000)
+        , d_windowMicros(500)
         , d_readTlsData(false)
         , d_zfpOverLeasedLine(false)
     {
@@ -473,6 +494,11 @@ public:
                 Topic topic = session.getTopic(topicList.messageAt(i));
                 stream->setTopic(topic);
                 myStreams.push_back(stream);
+
+                // Contribute now, then every interval.
+                PublishScheduler::Handle handle = g_scheduler.add(stream);
+                g_scheduler.setPeriod(handle, d_intervalMs * 1000LL);
+                g_scheduler.trigger(handle);
             }
             else {
                 std::cout
@@ -487,15 +513,18 @@ public:
         Service service = session.getService(d_service.c_str());
 
         // Now we will start publishing
+        g_scheduler.setWindow(d_windowMicros);
         int value = 1;
-        while (myStreams.size() > 0 && g_running) {
+        std::vector<void *> due;
+        while (myStreams.size() > 0
+            && g_running
+            && 0 == g_scheduler.wait(&due)) {
             Event event = service.createPublishEvent();
             EventFormatter eventFormatter(event);
 
-            for (MyStreams::iterator iter = myStreams.begin();
-                 iter != myStreams.end(); ++iter)
-            {
-                eventFormatter.appendMessage(MARKET_DATA, (*iter)->getTopic());
+            for (size_t i = 0; i < due.size(); ++i) {
+                MyStream *stream = static_cast<MyStream *>(due[i]);
+                eventFormatter.appendMessage(MARKET_DATA, stream->getTopic());
                 eventFormatter.setElement("BID", 0.5 * ++value);
                 eventFormatter.setElement("ASK", value);
             }
@@ -507,7 +536,6 @@ public:
             }
 
             session.publish(event);
-            SLEEP(10);
         }
 
         session.stop();
@@ -17,6 +17,9 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
  * IN THE SOFTWARE.
  */
+#include "BlpEntitlementCache.h"
+#include "BlpIdentityPool.h"
+
 #include <blpapi_session.h>
 
 #include <blpapi_event.h>
@@ -42,8 +45,6 @@ namespace {
     const Name SECURITY_DATA("securityData");
     const Name SECURITY("security");
     const Name EID_DATA("eidData");
-    const Name AUTHORIZATION_SUCCESS("AuthorizationSuccess");
-    const Name AUTHORIZATION_FAILURE("AuthorizationFailure");
 
     const char* REFRENCEDATA_REQUEST = "ReferenceDataRequest";
     const char* APIAUTH_SVC          = "//blp/apiauth";
@@ -68,13 +69,12 @@ namespace {
 
 class SessionEventHandler: public  EventHandler
 {
-    std::vector<Identity> &d_identities;
-    std::vector<int> &d_uuids;
+    IdentityPool     &d_identities;
+    EntitlementCache  d_entitlements;
 
-    void printFailedEntitlements(std::vector<int> &failedEntitlements,
-        int numFailedEntitlements)
+    void printFailedEntitlements(const std::vector<int> &failedEntitlements)
     {
-        for (int i = 0; i < numFailedEntitlements; ++i) {
+        for (size_t i = 0; i < failedEntitlements.size(); ++i) {
             std::cout << failedEntitlements[i] << " ";
         }
         std::cout << std::endl;
@@ -88,6 +88,11 @@ class SessionEventHandler: public  EventHandler
         Element securities = msg.getElement(SECURITY_DATA);
         int numSecurities = securities.numValues();
 
+        // Distribute only to the users currently authorized.
+        EntitlementCache::UserSet ready;
+        EntitlementCache::UserSet entitled;
+        d_entitlements.readyUsers(&ready);
+
         std::cout << "Processing " << numSecurities << " securities:"
             << std::endl;
         for (int i = 0; i < numSecurities; ++i) {
@@ -98,38 +103,29 @@ class SessionEventHandler: public  EventHandler
                 entitlements = security.getElement(EID_DATA);
             }
 
-            int numUsers = d_identities.size();
-            if (entitlements.isValid() && entitlements.numValues() > 0) {
-                // Entitlements are required to access this data
-                failedEntitlements.resize(entitlements.numValues());
-                for (int j = 0; j < numUsers; ++j) {
-                    std::memset(&failedEntitlements[0], 0,
-                        sizeof(int) * failedEntitlements.size());
-                    int numFailures = failedEntitlements.size();
-                    if (d_identities[j].hasEntitlements(service, entitlements,
-                        &failedEntitlements[0], &numFailures)) {
-                            std::cout << "User: " << d_uuids[j] <<
-                                " is entitled to get data for: " << ticker
-                                << std::endl;
-                            // Now Distribute message to the user.
-                    }
-                    else {
-                        std::cout << "User: " << d_uuids[j] <<
-                            " is NOT entitled to get data for: "
-                            << ticker << " - Failed eids: " << std::endl;
-                        printFailedEntitlements(failedEntitlements,
-                                                numFailures);
-                    }
+            // The users entitled to the data, if entitlements are required
+            // to access it, are found with a few bitset ANDs per EID.
+            d_entitlements.entitledUsers(&entitled, service, entitlements);
+            for (size_t j = 0; j < d_identities.size(); ++j) {
+                if (!EntitlementCache::contains(ready, j)) {
+                    continue;
                 }
-            }
-            else {
-                // No Entitlements are required to access this data.
-                for (int j = 0; j < numUsers; ++j) {
-                    std::cout <<"User: " << d_uuids[j] <<
-                        " is entitled to get data for: "
-                        << ticker << std::endl;
+                if (EntitlementCache::contains(entitled, j)) {
+                    std::cout << "User: " << d_identities.uuid(j) <<
+                        " is entitled to get data for: " << ticker
+                        << std::endl;
                     // Now Distribute message to the user.
                 }
+                else {
+                    d_entitlements.failedEntitlements(&failedEntitlements,
+                                                      service,
+                                                      entitlements,
+                                                      j);
+                    std::cout << "User: " << d_identities.uuid(j)
+                        << " is NOT entitled to get data for: "
+                        << ticker << " - Failed eids: " << std::endl;
+                    printFailedEntitlements(failedEntitlements);
+                }
             }
         }
     }
@@ -150,9 +146,8 @@ class SessionEventHandler: public  EventHandler
 
 public :
 
-    SessionEventHandler(std::vector<Identity> &identities,
-                        std::vector<int> &uuids) :
-    d_identities(identities), d_uuids(uuids) {
+    SessionEventHandler(IdentityPool &identities) :
+    d_identities(identities), d_entitlements(&identities) {
     }
 
     bool processEvent(const Event &event, Session *session)
@@ -161,7 +156,11 @@ public :
         case Event::SESSION_STATUS:
         case Event::SERVICE_STATUS:
         case Event::REQUEST_STATUS:
+            printEvent(event);
+            break;
+
         case Event::AUTHORIZATION_STATUS:
+            d_entitlements.invalidate();
             printEvent(event);
             break;
 
@@ -190,8 +189,8 @@ class EntitlementsVerificationExample {
     int                       d_port;
     std::vector<std::string>  d_securities;
     std::vector<int>          d_uuids;
-    std::vector<Identity>     d_identities;
     std::vector<std::string>  d_programAddresses;
+    int                       d_maxInFlight;
 
     void printUsage()
     {
@@ -203,6 +202,8 @@ class EntitlementsVerificationExample {
             " eg:12345:10.20.30.40>]" << '\n'
             << "        [-ip    <ipAddress  = localhost>]" << '\n'
             << "        [-p     <tcpPort    = 8194>]" << '\n'
+            << "        [-w     <authorization requests in flight = 64>]"
+            << '\n'
             << "Note:" << '\n'
             <<"Multiple securities and credentials can be" <<
             " specified." << std::endl;
@@ -223,55 +224,21 @@ class EntitlementsVerificationExample {
         }
     }
 
-    bool authorizeUsers(EventQueue *authQueue, Session *session)
+    bool authorizeUsers(IdentityPool *identities, Session *session)
     {
-        Service authService = session->getService(APIAUTH_SVC);
-        bool is_any_user_authorized = false;
-
-        // Authorize each of the users
-        d_identities.reserve(d_uuids.size());
+        // Authorize the users with up to 'd_maxInFlight' requests
+        // outstanding rather than one after another.
         for (size_t i = 0; i < d_uuids.size(); ++i) {
-            d_identities.push_back(session->createIdentity());
-            Request authRequest = authService.createAuthorizationRequest();
-            authRequest.set("uuid", d_uuids[i]);
-            authRequest.set("ipAddress", d_programAddresses[i].c_str());
-
-            CorrelationId correlator(d_uuids[i]);
-            session->sendAuthorizationRequest(authRequest,
-                                              &d_identities[i],
-                                              correlator,
-                                              authQueue);
-
-            Event event = authQueue->nextEvent();
-
-            if (event.eventType() == Event::RESPONSE ||
-                event.eventType() == Event::PARTIAL_RESPONSE ||
-                event.eventType() == Event::REQUEST_STATUS ||
-                event.eventType() == Event::AUTHORIZATION_STATUS) {
-
-                MessageIterator msgIter(event);
-                while (msgIter.next()) {
-                    Message msg = msgIter.message();
-
-                    if (msg.messageType() == AUTHORIZATION_SUCCESS) {
-                        std::cout << msg.correlationId().asInteger()
-                            << " authorization success"
-                            << std::endl;
-                        is_any_user_authorized = true;
-                    }
-                    else if (msg.messageType() == AUTHORIZATION_FAILURE) {
-                        std::cout << msg.correlationId().asInteger()
-                            << " authorization failed"
-                            << std::endl;
-                        std::cout << msg << std::endl;
-                    }
-                    else {
-                        std::cout << msg << std::endl;
-                    }
-                }
-            }
+            identities->add(d_uuids[i], d_programAddresses[i]);
+        }
+        identities->start(session, APIAUTH_SVC);
+
+        std::vector<size_t> newlyReady;
+        while (identities->poll(&newlyReady, 10000) > 0) {
         }
-        return is_any_user_authorized;
+        std::cout << identities->numReady() << " of " << identities->size()
+            << " users authorized" << std::endl;
+        return identities->numReady() > 0;
     }
 
     void sendRefDataRequest(Session *session)
@@ -327,6 +294,11 @@ class EntitlementsVerificationExample {
                 d_port = std::atoi(argv[i]);
                 continue;
             }
+            else if (!std::strcmp(argv[i],"-w")) {
+                if (++i >= argc) return false;
+                d_maxInFlight = std::atoi(argv[i]);
+                continue;
+            }
             else return false;
         }
 
@@ -355,6 +327,7 @@ public:
     EntitlementsVerificationExample()
     : d_host("localhost")
     , d_port(8194)
+    , d_maxInFlight(64)
     {
     }
 
@@ -370,7 +343,8 @@ public:
 
         std::cout << "Connecting to " + d_host + ":" << d_port << std::endl;
 
-        SessionEventHandler eventHandler(d_identities, d_uuids);
+        IdentityPool identities(d_maxInFlight);
+        SessionEventHandler eventHandler(identities);
         Session session(sessionOptions, &eventHandler);
 
         if (!session.start()) {
@@ -380,10 +354,8 @@ public:
 
         openServices(&session);
 
-        EventQueue authQueue;
-
         // Authorize all the users that are interested in receiving data
-        if (authorizeUsers(&authQueue, &session)) {
+        if (authorizeUsers(&identities, &session)) {
             // Make the various requests that we need to make
             sendRefDataRequest(&session);
         }
@@ -393,13 +365,11 @@ public:
         std::cin.getline(dummy,2);
 
         {
-            // Check if there were any authorization events received on the
-            // 'authQueue'
+            // Process any authorization events received on the identity
+            // pool's queue since the users were authorized.
 
-            Event event;
-            while (0 == authQueue.tryNextEvent(&event)) {
-                printEvent(event);
-            }
+            std::vector<size_t> newlyReady;
+            identities.tryPoll(&newlyReady);
         }
 
         session.stop();
@@ -17,6 +17,10 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
  * IN THE SOFTWARE.
  */
+#include "BlpDistributor.h"
+#include "BlpEntitlementCache.h"
+#include "BlpIdentityPool.h"
+
 #include <blpapi_session.h>
 #include <blpapi_eventdispatcher.h>
 
@@ -30,6 +34,8 @@
 #include <blpapi_exception.h>
 
 #include <iostream>
+#include <sstream>
+#include <utility>
 #include <vector>
 #include <string>
 #include <stdlib.h>
@@ -41,8 +47,6 @@ using namespace blpapi;
 namespace {
 
     const Name EID("EID");
-    const Name AUTHORIZATION_SUCCESS("AuthorizationSuccess");
-    const Name AUTHORIZATION_FAILURE("AuthorizationFailure");
 
     const char* APIAUTH_SVC             = "//blp/apiauth";
     const char* MKTDATA_SVC             = "//blp/mktdata";
@@ -66,13 +70,17 @@ namespace {
 
 class SessionEventHandler: public  EventHandler
 {
-    std::vector<Identity>    &d_identities;
-    std::vector<int>         &d_uuids;
+    IdentityPool             &d_identities;
+    EntitlementCache          d_entitlements;
     std::vector<std::string> &d_securities;
     Name                      d_fieldName;
+    Distributor              *d_distributor_p;
 
     void processSubscriptionDataEvent(const Event &event)
     {
+        EntitlementCache::UserSet ready;
+        EntitlementCache::UserSet entitled;
+
         MessageIterator msgIter(event);
         while (msgIter.next()) {
             Message msg = msgIter.message();
@@ -88,33 +96,63 @@ class SessionEventHandler: public  EventHandler
             if (!field.isValid()) {
                 continue;
             }
-            bool needsEntitlement = msg.hasElement(EID);
+            Element eids;
+            if (msg.hasElement(EID)) {
+                eids = msg.getElement(EID);
+            }
+
+            // Users still being authorized join in once they are ready.
+            // Which of them are entitled is decided with a few bitset ANDs
+            // per EID rather than a 'hasEntitlements' call per user.
+            d_entitlements.entitledUsers(&entitled, service, eids);
+            if (d_distributor_p) {
+                distribute(topic, msg, entitled);
+                continue;
+            }
+            d_entitlements.readyUsers(&ready);
             for (size_t j = 0; j < d_identities.size(); ++j) {
-                Identity *handle = &d_identities[j];
-                if (!needsEntitlement ||
-                    handle->hasEntitlements(service,
-                        msg.getElement(EID), 0, 0))
-                {
-                    std::cout << "User: " << d_uuids[j] << " is entitled"
+                if (!EntitlementCache::contains(ready, j)) {
+                    continue;
+                }
+                int uuid = d_identities.uuid(j);
+                if (EntitlementCache::contains(entitled, j)) {
+                    std::cout << "User: " << uuid << " is entitled"
                               << " for " << field << std::endl;
                 }
                 else {
-                    std::cout << "User: " << d_uuids[j] << " is NOT entitled"
+                    std::cout << "User: " << uuid << " is NOT entitled"
                               << " for " << d_fieldName << std::endl;
                 }
             }
         }
     }
 
+    void distribute(const std::string&               topic,
+                    const Message&                   msg,
+                    const EntitlementCache::UserSet& entitled)
+    {
+        // Serialize the message once; every entitled user's queue holds a
+        // reference to the same buffer.
+        if (EntitlementCache::count(entitled) == 0) {
+            return;
+        }
+        std::ostringstream payload;
+        payload << topic << '\n';
+        msg.print(payload);
+        d_distributor_p->publish(entitled,
+                                 Distributor::frame(payload.str()));
+    }
+
 public :
-    SessionEventHandler(std::vector<Identity>      &identities,
-                        std::vector<int>           &uuids,
+    SessionEventHandler(IdentityPool               &identities,
                         std::vector<std::string>   &securities,
-                        const std::string          &field)
+                        const std::string          &field,
+                        Distributor                *distributor = 0)
         : d_identities(identities)
-        , d_uuids(uuids)
+        , d_entitlements(&identities)
         , d_securities(securities)
         , d_fieldName(field.c_str())
+        , d_distributor_p(distributor)
     {
     }
 
@@ -124,12 +162,21 @@ public :
         case Event::SESSION_STATUS:
         case Event::SERVICE_STATUS:
         case Event::REQUEST_STATUS:
+            printEvent(event);
+            break;
+
         case Event::AUTHORIZATION_STATUS:
+            d_entitlements.invalidate();
             printEvent(event);
             break;
 
         case Event::SUBSCRIPTION_DATA:
             try {
+                // Pick up revocations and entitlement changes of the users,
+                // which are delivered to the identity pool's queue.  This
+                // thread is its only consumer once 'authorizeUsers' is done.
+                std::vector<size_t> newlyReady;
+                d_identities.tryPoll(&newlyReady);
                 processSubscriptionDataEvent(event);
             } catch (Exception &e) {
                 std::cerr << "Library Exception!!! " << e.description()
@@ -150,8 +197,11 @@ class EntitlementsVerificationSubscriptionExample {
     std::string               d_field;
     std::vector<std::string>  d_securities;
     std::vector<int>          d_uuids;
-    std::vector<Identity>     d_identities;
     std::vector<std::string>  d_programAddresses;
+    int                       d_maxInFlight;
+    std::string               d_socketPath;
+    size_t                    d_queueCapacity;
+    std::vector<std::pair<int, int> > d_consumerUids;   // uuid, local uid
 
     SubscriptionList          d_subscriptions;
 
@@ -165,6 +215,16 @@ class EntitlementsVerificationSubscriptionExample {
             " eg:12345:10.20.30.40>]" << '\n'
             << "        [-ip    <ipAddress  = localhost>]" << '\n'
             << "        [-p     <tcpPort    = 8194>]" << '\n'
+            << "        [-w     <authorization requests in flight = 64>]"
+            << '\n'
+#ifndef _WIN32
+            << "        [-d     <socket path: distribute the data to the"
+            << " users' consumers>]" << '\n'
+            << "        [-q     <messages queued per user = 4096>]" << '\n'
+            << "        [-du    <uuid:uid: consumers of uuid run as local"
+            << " uid; by default only this process's user may connect>]"
+            << '\n'
+#endif
             << "Note:" << '\n'
             <<"Multiple securities and credentials can be" <<
             " specified. Only one field can be specified." << std::endl;
@@ -185,55 +245,28 @@ class EntitlementsVerificationSubscriptionExample {
         }
     }
 
-    bool authorizeUsers(EventQueue *authQueue, Session *session)
+    bool authorizeUsers(IdentityPool *identities, Session *session)
     {
-        Service authService = session->getService(APIAUTH_SVC);
-        bool is_any_user_authorized = false;
-
-        // Authorize each of the users
-        d_identities.reserve(d_uuids.size());
+        // Authorize the users with up to 'd_maxInFlight' requests
+        // outstanding rather than one after another, and subscribe once the
+        // first user is authorized; the others are entitled to the data as
+        // they become ready.
         for (size_t i = 0; i < d_uuids.size(); ++i) {
-            d_identities.push_back(session->createIdentity());
-            Request authRequest = authService.createAuthorizationRequest();
-            authRequest.set("uuid", d_uuids[i]);
-            authRequest.set("ipAddress", d_programAddresses[i].c_str());
-
-            CorrelationId correlator(d_uuids[i]);
-            session->sendAuthorizationRequest(authRequest,
-                                              &d_identities[i],
-                                              correlator,
-                                              authQueue);
-
-            Event event = authQueue->nextEvent();
-
-            if (event.eventType() == Event::RESPONSE ||
-                event.eventType() == Event::PARTIAL_RESPONSE ||
-                event.eventType() == Event::REQUEST_STATUS ||
-                event.eventType() == Event::AUTHORIZATION_STATUS) {
-
-                MessageIterator msgIter(event);
-                while (msgIter.next()) {
-                    Message msg = msgIter.message();
-
-                    if (msg.messageType() == AUTHORIZATION_SUCCESS) {
-                        std::cout << msg.correlationId().asInteger()
-                            << " authorization success"
-                            << std::endl;
-                        is_any_user_authorized = true;
-                    }
-                    else if (msg.messageType() == AUTHORIZATION_FAILURE) {
-                        std::cout << msg.correlationId().asInteger()
-                            << " authorization failed"
-                            << std::endl;
-                        std::cout << msg << std::endl;
-                    }
-                    else {
-                        std::cout << msg << std::endl;
-                    }
-                }
+            identities->add(d_uuids[i], d_programAddresses[i]);
+        }
+        identities->start(session, APIAUTH_SVC);
+
+        bool                subscribed  = false;
+        size_t              outstanding = identities->outstanding();
+        std::vector<size_t> newlyReady;
+        while (outstanding > 0) {
+            outstanding = identities->poll(&newlyReady, 10000);
+            if (!subscribed && !newlyReady.empty()) {
+                session->subscribe(d_subscriptions);
+                subscribed = true;
             }
         }
-        return is_any_user_authorized;
+        return subscribed;
     }
 
     bool parseCommandLine(int argc, char **argv)
@@ -267,6 +300,30 @@ class EntitlementsVerificationSubscriptionExample {
                 d_port = std::atoi(argv[++i]);
                 continue;
             }
+            if (!std::strcmp(argv[i],"-w") &&  i + 1 < argc) {
+                d_maxInFlight = std::atoi(argv[++i]);
+                continue;
+            }
+#ifndef _WIN32
+            if (!std::strcmp(argv[i],"-d") &&  i + 1 < argc) {
+                d_socketPath = argv[++i];
+                continue;
+            }
+            if (!std::strcmp(argv[i],"-q") &&  i + 1 < argc) {
+                d_queueCapacity = std::atoi(argv[++i]);
+                continue;
+            }
+            if (!std::strcmp(argv[i],"-du") &&  i + 1 < argc) {
+                ++i;
+                const char *colon = std::strchr(argv[i], ':');
+                if (!colon) {
+                    return false;
+                }
+                d_consumerUids.push_back(
+                    std::make_pair(std::atoi(argv[i]), std::atoi(colon + 1)));
+                continue;
+            }
+#endif
             return false;
         }
 
@@ -300,6 +357,8 @@ public:
     : d_host("localhost")
     , d_port(8194)
     , d_field("BEST_BID1")
+    , d_maxInFlight(64)
+    , d_queueCapacity(4096)
     {
     }
 
@@ -315,10 +374,13 @@ public:
 
         std::cout << "Connecting to " + d_host + ":" << d_port << std::endl;
 
-        SessionEventHandler eventHandler(d_identities,
-                                         d_uuids,
+        IdentityPool identities(d_maxInFlight);
+        Distributor  distributor(d_uuids.size(), d_queueCapacity);
+        SessionEventHandler eventHandler(identities,
                                          d_securities,
-                                         d_field);
+                                         d_field,
+                                         d_socketPath.empty() ? 0
+                                                              : &distributor);
         Session session(sessionOptions, &eventHandler);
 
         if (!session.start()) {
@@ -328,12 +390,34 @@ public:
 
         openServices(&session);
 
-        EventQueue authQueue;
+#ifndef _WIN32
+        // Serve the data to the users' consumers, which connect to
+        // 'd_socketPath' and identify themselves with their uuid.
+        UnixSocketTransport transport(&distributor,
+                                      &identities,
+                                      d_socketPath);
+        for (size_t i = 0; i < d_consumerUids.size(); ++i) {
+            for (size_t user = 0; user < d_uuids.size(); ++user) {
+                if (d_uuids[user] == d_consumerUids[i].first) {
+                    transport.setPeerUid(user, d_consumerUids[i].second);
+                }
+            }
+        }
+        if (!d_socketPath.empty()) {
+            if (!transport.start()) {
+                std::cerr << "Failed to listen on " << d_socketPath
+                    << std::endl;
+                std::exit(-1);
+            }
+            std::cout << "Distributing on " << d_socketPath << std::endl;
+        }
+#endif
 
-        // Authorize all the users that are interested in receiving data
-        if (authorizeUsers(&authQueue, &session)) {
-            // Make the various requests that we need to make
-            session.subscribe(d_subscriptions);
+        // Authorize all the users that are interested in receiving data,
+        // subscribing as soon as the first of them is authorized.
+        if (authorizeUsers(&identities, &session)) {
+            std::cout << identities.numReady() << " of "
+                << identities.size() << " users authorized" << std::endl;
         } else {
             std::cerr << "Unable to authorize users, Press Enter to Exit"
                 << std::endl;
@@ -343,17 +427,26 @@ public:
         char dummy[2];
         std::cin.getline(dummy,2);
 
+        // Stop the dispatcher thread first: until then the event handler is
+        // the consumer of the identity pool's queue.
+        session.stop();
+
         {
-            // Check if there were any authorization events received on the
-            // 'authQueue'
+            // Process any authorization events received on the identity
+            // pool's queue since the users were authorized.
 
-            Event event;
-            while (0 == authQueue.tryNextEvent(&event)) {
-                printEvent(event);
-            }
+            std::vector<size_t> newlyReady;
+            identities.tryPoll(&newlyReady);
         }
-
-        session.stop();
+#ifndef _WIN32
+        if (!d_socketPath.empty()) {
+            transport.stop();
+            std::cout << distributor.published() << " messages published, "
+                << distributor.deliveries() << " queued to users, "
+                << transport.framesSent() << " sent to "
+                << transport.accepted() << " consumers" << std::endl;
+        }
+#endif
         std::cout << "Exiting...\n";
     }
 
@@ -17,6 +17,8 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
  * IN THE SOFTWARE.
  */
+#include "BlpIntradayDecoder.h"
+
 #include <blpapi_session.h>
 #include <blpapi_eventdispatcher.h>
 
@@ -41,15 +43,6 @@ using namespace BloombergLP;
 using namespace blpapi;
 
 namespace {
-    const Name BAR_DATA("barData");
-    const Name BAR_TICK_DATA("barTickData");
-    const Name OPEN("open");
-    const Name HIGH("high");
-    const Name LOW("low");
-    const Name CLOSE("close");
-    const Name VOLUME("volume");
-    const Name NUM_EVENTS("numEvents");
-    const Name TIME("time");
     const Name RESPONSE_ERROR("responseError");
     const Name SESSION_TERMINATED("SessionTerminated");
     const Name CATEGORY("category");
@@ -134,6 +127,10 @@ class IntradayBarExample {
     std::string             d_clientCredentialsPassword;
     std::string             d_trustMaterial;
     bool                    d_readTlsData;
+    std::string             d_outputFile;
+    IntradayBarDecoder      d_decoder;
+    IntradayBarColumns      d_bars;
+    ArrowFileWriter         d_writer;
 
     void printUsage()
     {
@@ -147,6 +144,8 @@ class IntradayBarExample {
             <<"     [-g     <gapFillInitialBar = false>" << '\n'
             <<"     [-ip    <ipAddress = localhost>" << '\n'
             <<"     [-p     <tcpPort   = 8194>" << '\n'
+            <<"     [-o     <file: write the bars to an Arrow (Feather)"
+            <<" file instead of printing them>" << '\n'
             << "\t[-auth <option>] \tauthentication option: user|none|app=<app>|userapp=<app>|dir=<property> (default: none)" << std::endl
             << std::endl
             << "TLS OPTIONS (specify all or none):\n"
@@ -183,6 +182,8 @@ class IntradayBarExample {
                 d_barInterval = std::atoi(argv[++i]);
             } else if (!std::strcmp(argv[i],"-g")) {
                 d_gapFillInitialBar = true;
+            } else if (!std::strcmp(argv[i],"-o") && i + 1 < argc) {
+                d_outputFile = argv[++i];
             } else if (!std::strcmp(argv[i],"-sd") && i + 1 < argc) {
                 d_startDateTime = argv[++i];
             } else if (!std::strcmp(argv[i],"-ed") && i + 1 < argc) {
@@ -302,23 +303,22 @@ class IntradayBarExample {
     }
 
     void processMessage(Message &msg) {
-        Element data = msg.getElement(BAR_DATA).getElement(BAR_TICK_DATA);
-        int numBars = data.numValues();
+        size_t first = d_bars.size();
+        size_t numBars = d_decoder.decode(&d_bars, msg);
         std::cout <<"Response contains " << numBars << " bars" << std::endl;
+        if (d_writer.isOpen()) {
+            return;
+        }
         std::cout <<"Datetime\t\tOpen\t\tHigh\t\tLow\t\tClose" <<
             "\t\tNumEvents\tVolume" << std::endl;
-        for (int i = 0; i < numBars; ++i) {
-            Element bar = data.getValueAsElement(i);
-            Datetime time = bar.getElementAsDatetime(TIME);
-            assert(time.hasParts(DatetimeParts::DATE
-                               | DatetimeParts::HOURS
-                               | DatetimeParts::MINUTES));
-            double open = bar.getElementAsFloat64(OPEN);
-            double high = bar.getElementAsFloat64(HIGH);
-            double low = bar.getElementAsFloat64(LOW);
-            double close = bar.getElementAsFloat64(CLOSE);
-            int numEvents = bar.getElementAsInt32(NUM_EVENTS);
-            long long volume = bar.getElementAsInt64(VOLUME);
+        for (size_t i = first; i < d_bars.size(); ++i) {
+            Datetime time = IntradayTime::toDatetime(d_bars.d_times[i]);
+            double open = d_bars.d_open[i];
+            double high = d_bars.d_high[i];
+            double low = d_bars.d_low[i];
+            double close = d_bars.d_close[i];
+            int numEvents = d_bars.d_numEvents[i];
+            long long volume = d_bars.d_volume[i];
 
             std::cout.setf(std::ios::fixed, std::ios::floatfield);
             std::cout << time.month() << '/' << time.day() << '/' << time.year()
@@ -345,6 +345,13 @@ class IntradayBarExample {
             }
             processMessage(msg);
         }
+
+        // Write the bars of the whole event as one batch, and reuse the
+        // columns for the next event.
+        if (d_writer.isOpen()) {
+            d_bars.write(&d_writer);
+        }
+        d_bars.clear();
     }
 
     void sendIntradayBarRequest(Session &session, const Identity& identity)
@@ -523,11 +530,30 @@ public:
             return;
         }
 
+        if (!d_outputFile.empty()) {
+            IntradayBarColumns::addColumns(&d_writer);
+            if (0 != d_writer.open(d_outputFile.c_str())) {
+                std::cerr << "Failed to open " << d_outputFile << std::endl;
+                return;
+            }
+        }
+
         sendIntradayBarRequest(session, identity);
 
         // wait for events from session.
         eventLoop(session);
 
+        if (d_writer.isOpen()) {
+            long long numBars = d_writer.numRowsWritten();
+            if (0 != d_writer.close()) {
+                std::cerr << "Failed to write " << d_outputFile << std::endl;
+            }
+            else {
+                std::cout << "Wrote " << numBars << " bars to "
+                          << d_outputFile << std::endl;
+            }
+        }
+
         session.stop();
     }
 };
@@ -17,6 +17,8 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
  * IN THE SOFTWARE.
  */
+#include "BlpIntradayDecoder.h"
+
 #include <blpapi_session.h>
 #include <blpapi_eventdispatcher.h>
 
@@ -42,12 +44,6 @@ using namespace BloombergLP;
 using namespace blpapi;
 
 namespace {
-    const Name TICK_DATA("tickData");
-    const Name COND_CODE("conditionCodes");
-    const Name TICK_SIZE("size");
-    const Name TIME("time");
-    const Name TYPE("type");
-    const Name VALUE("value");
     const Name RESPONSE_ERROR("responseError");
     const Name CATEGORY("category");
     const Name MESSAGE("message");
@@ -131,6 +127,10 @@ class IntradayTickExample {
     std::string                 d_clientCredentialsPassword;
     std::string                 d_trustMaterial;
     bool                        d_readTlsData;
+    std::string                 d_outputFile;
+    IntradayTickDecoder         d_decoder;
+    IntradayTickColumns         d_ticks;
+    ArrowFileWriter             d_writer;
 
     void printUsage()
     {
@@ -144,6 +144,8 @@ class IntradayTickExample {
             << "    [-cc    <includeConditionCodes = false>" << '\n'
             << "    [-ip    <ipAddress = localhost>" << '\n'
             << "    [-p     <tcpPort   = 8194>" << '\n'
+            << "    [-o     <file: write the ticks to an Arrow (Feather)"
+            << " file instead of printing them>" << '\n'
             << "Notes:" << '\n'
             << "1) All times are in GMT." << '\n'
             << "2) Only one security can be specified." << std::endl
@@ -177,6 +179,8 @@ class IntradayTickExample {
                 d_events.push_back(argv[++i]);
             } else if (!std::strcmp(argv[i],"-cc")) {
                 d_conditionCodes = true;
+            } else if (!std::strcmp(argv[i],"-o") && i + 1 < argc) {
+                d_outputFile = argv[++i];
             } else if (!std::strcmp(argv[i],"-sd") && i + 1 < argc) {
                 d_startDateTime = argv[++i];
             } else if (!std::strcmp(argv[i],"-ed") && i + 1 < argc) {
@@ -306,26 +310,23 @@ class IntradayTickExample {
 
     void processMessage(Message &msg)
     {
-        Element data = msg.getElement(TICK_DATA).getElement(TICK_DATA);
-        int numItems = data.numValues();
+        size_t first = d_ticks.size();
+        d_decoder.decode(&d_ticks, msg);
+        if (d_writer.isOpen()) {
+            return;
+        }
         std::cout << "TIME\t\t\t\tTYPE\tVALUE\t\tSIZE\tCC" << std::endl;
         std::cout << "----\t\t\t\t----\t-----\t\t----\t--" << std::endl;
-        std::string cc;
-        std::string type;
-        for (int i = 0; i < numItems; ++i) {
-            Element item = data.getValueAsElement(i);
-            std::string timeString = item.getElementAsString(TIME);
-            type = item.getElementAsString(TYPE);
-            double value = item.getElementAsFloat64(VALUE);
-            int size = item.getElementAsInt32(TICK_SIZE);
-            if (item.hasElement(COND_CODE)) {
-                cc = item.getElementAsString(COND_CODE);
-            }  else {
-                cc.clear();
-            }
+        for (size_t i = first; i < d_ticks.size(); ++i) {
+            Datetime time = IntradayTime::toDatetime(d_ticks.d_times[i]);
+            const std::string& type = d_ticks.d_typeNames[d_ticks.d_types[i]];
+            double value = d_ticks.d_values[i];
+            int size = d_ticks.d_sizes[i];
+            const std::string& cc =
+                           d_ticks.d_conditionNames[d_ticks.d_conditions[i]];
 
             std::cout.setf(std::ios::fixed, std::ios::floatfield);
-            std::cout << timeString <<  "\t"
+            std::cout << time <<  "\t"
                 << type << "\t"
                 << std::setprecision(3)
                 << std::showpoint << value << "\t\t"
@@ -346,6 +347,13 @@ class IntradayTickExample {
             }
             processMessage(msg);
         }
+
+        // Write the ticks of the whole event as one batch, and reuse the
+        // columns for the next event.
+        if (d_writer.isOpen()) {
+            d_ticks.write(&d_writer);
+        }
+        d_ticks.clear();
     }
 
     void sendIntradayTickRequest(Session &session, const Identity& identity)
@@ -524,11 +532,30 @@ public:
             return;
         }
 
+        if (!d_outputFile.empty()) {
+            IntradayTickColumns::addColumns(&d_writer);
+            if (0 != d_writer.open(d_outputFile.c_str())) {
+                std::cerr << "Failed to open " << d_outputFile << std::endl;
+                return;
+            }
+        }
+
         sendIntradayTickRequest(session, identity);
 
         // wait for events from session.
         eventLoop(session);
 
+        if (d_writer.isOpen()) {
+            long long numTicks = d_writer.numRowsWritten();
+            if (0 != d_writer.close()) {
+                std::cerr << "Failed to write " << d_outputFile << std::endl;
+            }
+            else {
+                std::cout << "Wrote " << numTicks << " ticks to "
+                          << d_outputFile << std::endl;
+            }
+        }
+
         session.stop();
     }
 };
@@ -40,6 +40,7 @@
 #include <cstdlib>
 #include <ctime>
 
+#include "BlpPublishScheduler.h"
 #include "BlpThreadUtil.h"
 
 using namespace BloombergLP;
@@ -64,6 +65,7 @@ const char *AUTH_OPTION_DIR  = "dir=";
 
 volatile bool g_running = true;
 Mutex g_lock;
+PublishScheduler g_scheduler;
 
 enum AuthorizationStatus {
     WAITING,
@@ -101,6 +103,7 @@ public:
             if (event.eventType() == Event::SESSION_STATUS) {
                 if (msg.messageType() == SESSION_TERMINATED) {
                     g_running = false;
+                    g_scheduler.stop();
                 }
                 continue;
             }
@@ -127,6 +130,8 @@ class MktdataBroadcastPublisherExample
     std::string              d_topic;
     std::string              d_groupId;
     std::string              d_authOptions;
+    int                      d_intervalMs;
+    int                      d_windowMicros;
 
     void printUsage()
     {
@@ -140,7 +145,9 @@ class MktdataBroadcastPublisherExample
             << "\t[-m    <messageType>]\ttype of published event (default: MarketDataEvents)" << std::endl
             << "\t[-t    <topic>]      \ttopic (default: IBM Equity>]" << std::endl
             << "\t[-g    <groupId>]    \tpublisher groupId (defaults to unique value)" << std::endl
-            << "\t[-auth <option>]     \tauthentication option: user|none|app=<app>|dir=<property> (default: user)" << std::endl;
+            << "\t[-auth <option>]     \tauthentication option: user|none|app=<app>|dir=<property> (default: user)" << std::endl
+            << "\t[-iv   <millis>]     \tinterval between updates of a topic (default: 10000)" << std::endl
+            << "\t[-bw   <micros>]     \twindow over which updates are batched into one event (default: 500)" << std::endl;
     }
 
     bool parseCommandLine(int argc, char **argv)
@@ -160,6 +167,10 @@ class MktdataBroadcastPublisherExample
                 d_topic = argv[++i];
             else if (!std::strcmp(argv[i],"-g") && i + 1 < argc)
                 d_groupId = argv[++i];
+            else if (!std::strcmp(argv[i],"-iv") && i + 1 < argc)
+                d_intervalMs = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i],"-bw") && i + 1 < argc)
+                d_windowMicros = std::atoi(argv[++i]);
             else if (!std::strcmp(argv[i], "-auth") && i + 1 < argc) {
                 ++ i;
                 if (!std::strcmp(argv[i], AUTH_OPTION_NONE)) {
@@ -191,6 +202,13 @@ class MktdataBroadcastPublisherExample
             }
         }
 
+        if (d_intervalMs <= 0 || d_windowMicros < 0) {
+            std::cerr << "The interval must be positive and the window not"
+                      << " negative" << std::endl;
+            printUsage();
+            return false;
+        }
+
         if (d_hosts.empty()) {
             d_hosts.push_back("localhost");
         }
@@ -209,6 +227,8 @@ public:
         , d_messageType("MarketDataEvents")
         , d_topic("IBM Equity")
         , d_authOptions(AUTH_USER)
+        , d_intervalMs(10000)
+        , d_windowMicros(500)
     {
     }
 
@@ -365,6 +385,11 @@ public:
                 Topic topic = session.getTopic(topicList.messageAt(i));
                 stream->setTopic(topic);
                 myStreams.push_back(stream);
+
+                // Publish now, then every interval.
+                PublishScheduler::Handle handle = g_scheduler.add(stream);
+                g_scheduler.setPeriod(handle, d_intervalMs * 1000LL);
+                g_scheduler.trigger(handle);
             }
             else {
                 MutexGuard guard(&g_lock);
@@ -379,17 +404,20 @@ public:
 
         Service service = session.getService(d_service.c_str());
         Name PUBLISH_MESSAGE_TYPE(d_messageType.c_str());
+        g_scheduler.setWindow(d_windowMicros);
 
         // Now we will start publishing
         int tickCount = 1;
-        while (myStreams.size() > 0 && g_running) {
+        std::vector<void *> due;
+        while (myStreams.size() > 0
+            && g_running
+            && 0 == g_scheduler.wait(&due)) {
             Event event = service.createPublishEvent();
             EventFormatter eventFormatter(event);
 
-            for (MyStreams::iterator iter = myStreams.begin();
-                 iter != myStreams.end(); ++iter)
-            {
-                const Topic& topic = (*iter)->getTopic();
+            for (size_t j = 0; j < due.size(); ++j) {
+                MyStream *stream = static_cast<MyStream *>(due[j]);
+                const Topic& topic = stream->getTopic();
                 if (!topic.isActive())  {
                     std::cout << "[WARN] Publishing on an inactive topic."
                               << std::endl;
@@ -412,7 +440,6 @@ public:
             }
 
             session.publish(event);
-            SLEEP(10);
         }
 
         session.stop();
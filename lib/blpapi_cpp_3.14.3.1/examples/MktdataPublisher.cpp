@@ -17,6 +17,9 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
  * IN THE SOFTWARE.
  */
+#include "BlpPublishBatcher.h"
+#include "BlpPublishScheduler.h"
+#include "BlpStreamRegistry.h"
 #include "BlpThreadUtil.h"
 
 #include <blpapi_element.h>
@@ -72,21 +75,115 @@ const char* AUTH_OPTION_DIR       = "dir=";
 
 bool g_running = true;
 
+PublishScheduler g_scheduler;
+
 class MyStream
 {
-    const std::string       d_id;
-    const std::vector<Name> d_fields;
-    int                     d_lastValue;
-    int                     d_fieldsPublished;
+    const std::string        d_id;
+    const std::vector<Name>  d_fields;
+    int                      d_lastValue;
+    int                      d_fieldsPublished;
+
+    Topic                    d_topic;
+    bool                     d_isSubscribed;
+    PublishScheduler::Handle d_handle;
+
+    // The value each field was last published with, indexed like
+    // 'd_fields'.  Every synthetic value is made from integers, so one
+    // 'long long' identifies it; see 'value'.  'd_hasImage' is false until
+    // a full image is published, and again after the fields are cleared.
+    std::vector<long long>   d_published;
+    std::vector<size_t>      d_changed;
+    bool                     d_hasImage;
+
+    static int datatype(const SchemaElementDefinition& elementDef,
+                        const Name&                    field)
+        // Return the datatype of 'field' in 'elementDef', or -1 and report
+        // it if 'elementDef' has no such field.
+    {
+        if (!elementDef.typeDefinition().hasElementDefinition(field)) {
+            std::cerr << "Invalid field " << field << std::endl;
+            return -1;
+        }
+        return elementDef.typeDefinition().getElementDefinition(field)
+                                          .typeDefinition().datatype();
+    }
 
-    Topic                   d_topic;
-    bool                    d_isSubscribed;
+    long long value(size_t slot, int datatype) const
+        // Return the current value of the field at 'slot'.  Field 'i' moves
+        // once every 'i + 1' updates, so that later fields are slow-moving.
+        // Date and time fields are a day number and a second of that day,
+        // both derived from the same count, so that a field that did not
+        // move compares equal to its last published value.
+    {
+        int       i    = static_cast<int>(slot);
+        long long tick = d_lastValue / (i + 1) + i;
+        switch (datatype) {
+        case BLPAPI_DATATYPE_DATE:
+        case BLPAPI_DATATYPE_TIME:
+        case BLPAPI_DATATYPE_DATETIME:
+            return tick * 86400 + tick % 86400;
+        }
+        return tick;
+    }
+
+    void setField(EventFormatter& eventFormatter,
+                  size_t          slot,
+                  int             datatype,
+                  long long       value)
+    {
+        const Name& field = d_fields[slot];
+        int         v     = static_cast<int>(value);
+        switch (datatype) {
+        case BLPAPI_DATATYPE_BOOL:
+            eventFormatter.setElement(field, bool(v % 2 == 0));
+            break;
+        case BLPAPI_DATATYPE_CHAR:
+            eventFormatter.setElement(field, char(v % 100 + 32));
+            break;
+        case BLPAPI_DATATYPE_INT32:
+        case BLPAPI_DATATYPE_INT64:
+            eventFormatter.setElement(field, v);
+            break;
+        case BLPAPI_DATATYPE_FLOAT32:
+        case BLPAPI_DATATYPE_FLOAT64:
+            eventFormatter.setElement(field, v * 1.1f);
+            break;
+        case BLPAPI_DATATYPE_STRING:
+            {
+                std::ostringstream s;
+                s << "S" << v;
+                eventFormatter.setElement(field, s.str().c_str());
+            }
+            break;
+        case BLPAPI_DATATYPE_DATE:
+        case BLPAPI_DATATYPE_TIME:
+        case BLPAPI_DATATYPE_DATETIME:
+            {
+                long long day     = value / 86400;
+                long long seconds = value % 86400;
+                Datetime  datetime;
+                datetime.setDate(2011,
+                                 1,
+                                 static_cast<int>(day / 100 % 30) + 1);
+                datetime.setTime(static_cast<int>(seconds / 3600),
+                                 static_cast<int>(seconds % 3600 / 60),
+                                 static_cast<int>(seconds % 60));
+                datetime.setMilliseconds(static_cast<int>(slot));
+                eventFormatter.setElement(field, datetime);
+            }
+            break;
+        }
+    }
 
 public:
     MyStream()
     : d_id("")
     , d_lastValue(0)
     , d_fieldsPublished(0)
+    , d_isSubscribed(false)
+    , d_handle(g_scheduler.add(this))
+    , d_hasImage(false)
     {}
 
     MyStream(const std::string& id, const std::vector<Name>& fields)
@@ -94,6 +191,10 @@ public:
     , d_fields(fields)
     , d_lastValue(0)
     , d_fieldsPublished(0)
+    , d_isSubscribed(false)
+    , d_handle(g_scheduler.add(this))
+    , d_published(fields.size())
+    , d_hasImage(false)
     {}
 
     void setTopic(Topic topic) {
@@ -104,58 +205,59 @@ public:
         d_isSubscribed = isSubscribed;
     }
 
-    void fillData(EventFormatter&                eventFormatter,
-                  const SchemaElementDefinition& elementDef)
+    bool update(const SchemaElementDefinition& elementDef)
+        // Note in 'changedFields' the fields whose value differs from the
+        // one last published, or every field if no full image was published
+        // yet, and take their values as published.  Return true if any
+        // field is to be published.
     {
-        for (int i = 0; i < d_fields.size(); ++i) {
-            if (!elementDef.typeDefinition().hasElementDefinition(
-                    d_fields[i])) {
-                std::cerr << "Invalid field " << d_fields[i] << std::endl;
+        d_changed.clear();
+        for (size_t i = 0; i < d_fields.size(); ++i) {
+            int type = datatype(elementDef, d_fields[i]);
+            if (type < 0) {
                 continue;
             }
-            SchemaElementDefinition fieldDef =
-                elementDef.typeDefinition().getElementDefinition(d_fields[i]);
+            long long v = value(i, type);
+            if (!d_hasImage || v != d_published[i]) {
+                d_published[i] = v;
+                d_changed.push_back(i);
+            }
+        }
+        d_hasImage = true;
+        return !d_changed.empty();
+    }
 
-            switch (fieldDef.typeDefinition().datatype()) {
-            case BLPAPI_DATATYPE_BOOL:
-                eventFormatter.setElement(d_fields[i],
-                                          bool((d_lastValue + i) % 2 == 0));
-                break;
-            case BLPAPI_DATATYPE_CHAR:
-                eventFormatter.setElement(d_fields[i],
-                                          char((d_lastValue + i) % 100 + 32));
-                break;
-            case BLPAPI_DATATYPE_INT32:
-            case BLPAPI_DATATYPE_INT64:
-                eventFormatter.setElement(d_fields[i], d_lastValue + i);
-                break;
-            case BLPAPI_DATATYPE_FLOAT32:
-            case BLPAPI_DATATYPE_FLOAT64:
-                eventFormatter.setElement(d_fields[i],
-                                          (d_lastValue + i) * 1.1f);
-                break;
-            case BLPAPI_DATATYPE_STRING:
-                {
-                    std::ostringstream s;
-                    s << "S" << (d_lastValue + i);
-                    eventFormatter.setElement(d_fields[i], s.str().c_str());
-                }
-                break;
-            case BLPAPI_DATATYPE_DATE:
-            case BLPAPI_DATATYPE_TIME:
-            case BLPAPI_DATATYPE_DATETIME:
-                Datetime datetime;
-                datetime.setDate(2011, 1, d_lastValue / 100 % 30 + 1);
-                {
-                    time_t now = time(0);
-                    datetime.setTime(now / 3600 % 24,
-                                     now % 3600 / 60,
-                                     now % 60);
-                }
-                datetime.setMilliseconds(i);
-                eventFormatter.setElement(d_fields[i], datetime);
-                break;
+    const std::vector<size_t>& changedFields() const {
+        return d_changed;
+    }
+
+    void fillData(EventFormatter&                eventFormatter,
+                  const SchemaElementDefinition& elementDef)
+        // Set the fields noted by the last 'update'.
+    {
+        for (size_t i = 0; i < d_changed.size(); ++i) {
+            size_t slot = d_changed[i];
+            setField(eventFormatter,
+                     slot,
+                     datatype(elementDef, d_fields[slot]),
+                     d_published[slot]);
+        }
+    }
+
+    void fillImage(EventFormatter&                eventFormatter,
+                   const SchemaElementDefinition& elementDef)
+        // Set every field, to the value last published if there is a full
+        // image and to the current value otherwise.
+    {
+        for (size_t i = 0; i < d_fields.size(); ++i) {
+            int type = datatype(elementDef, d_fields[i]);
+            if (type < 0) {
+                continue;
             }
+            setField(eventFormatter,
+                     i,
+                     type,
+                     d_hasImage ? d_published[i] : value(i, type));
         }
     }
 
@@ -176,6 +278,9 @@ public:
                 eventFormatter.setElementNull(d_fields[i]);
             }
         }
+
+        // Subscribers no longer hold the values, so send a full image next.
+        d_hasImage = false;
     }
 
     const std::string& getId() { return d_id; }
@@ -190,12 +295,25 @@ public:
         return d_topic.isValid() && d_isSubscribed;
     }
 
+    void startPublishing(long long intervalMicros) {
+        // Publish an initial image now, then the fields that changed every
+        // 'intervalMicros'.
+        d_hasImage = false;
+        g_scheduler.setPeriod(d_handle, intervalMicros);
+        g_scheduler.trigger(d_handle);
+    }
+
+    void stopPublishing() {
+        g_scheduler.cancel(d_handle);
+    }
+
 };
 
-typedef std::map<std::string, MyStream*> MyStreams;
+typedef StreamRegistry<MyStream> MyStreams;
 
+// Each stream is guarded by the lock of its shard in 'g_streams'.  'g_mutex'
+// only guards 'g_authorizationStatus'.
 MyStreams g_streams;
-int       g_availableTopicCount;
 Mutex     g_mutex;
 
 enum AuthorizationStatus {
@@ -215,6 +333,41 @@ void printMessages(const Event& event)
     }
 }
 
+void estimateFieldBytes(std::vector<size_t>           *bytes,
+                        const std::vector<Name>&       fields,
+                        const SchemaElementDefinition& elementDef)
+    // Load into 'bytes' an estimate of the size of each of 'fields' as
+    // 'MyStream::fillData' formats it.
+{
+    bytes->assign(fields.size(), 0);
+    for (size_t i = 0; i < fields.size(); ++i) {
+        if (!elementDef.typeDefinition().hasElementDefinition(fields[i])) {
+            continue;
+        }
+        size_t valueBytes = 8;
+        switch (elementDef.typeDefinition().getElementDefinition(fields[i])
+                                           .typeDefinition().datatype()) {
+          case BLPAPI_DATATYPE_BOOL:
+          case BLPAPI_DATATYPE_CHAR:
+            valueBytes = 1;
+            break;
+          case BLPAPI_DATATYPE_INT32:
+          case BLPAPI_DATATYPE_FLOAT32:
+            valueBytes = 4;
+            break;
+          case BLPAPI_DATATYPE_STRING:
+            valueBytes = 16;
+            break;
+          case BLPAPI_DATATYPE_DATE:
+          case BLPAPI_DATATYPE_TIME:
+          case BLPAPI_DATATYPE_DATETIME:
+            valueBytes = 12;
+            break;
+        }
+        (*bytes)[i] = PublishBatcher::fieldBytes(fields[i], valueBytes);
+    }
+}
+
 } // namespace {
 
 class MyEventHandler : public ProviderEventHandler
@@ -224,18 +377,21 @@ class MyEventHandler : public ProviderEventHandler
     const std::vector<Name> d_fields;
     const std::vector<int>  d_eids;
     int                     d_resolveSubServiceCode;
+    long long               d_intervalMicros;
 
 public:
     MyEventHandler(const std::string&       serviceName,
                    const Name&              messageType,
                    const std::vector<Name>& fields,
                    const std::vector<int>&  eids,
-                   int                      resolveSubServiceCode)
+                   int                      resolveSubServiceCode,
+                   long long                intervalMicros)
     : d_serviceName(serviceName)
     , d_messageType(messageType)
     , d_fields(fields)
     , d_eids(eids)
     , d_resolveSubServiceCode(resolveSubServiceCode)
+    , d_intervalMicros(intervalMicros)
     {}
 
     bool processEvent(const Event& event, ProviderSession* session);
@@ -250,6 +406,7 @@ bool MyEventHandler::processEvent(const Event& event, ProviderSession* session)
             Message msg = iter.message();
             if (msg.messageType() == SESSION_TERMINATED) {
                 g_running = false;
+                g_scheduler.stop();
             }
         }
     }
@@ -261,55 +418,51 @@ bool MyEventHandler::processEvent(const Event& event, ProviderSession* session)
             std::cout << msg << std::endl;
             if (msg.messageType() == TOPIC_SUBSCRIBED) {
                 std::string topicStr = msg.getElementAsString("topic");
-                MutexGuard guard(&g_mutex);
-                MyStreams::iterator it = g_streams.find(topicStr);
-                if (it == g_streams.end()) {
+                MyStreams::ShardGuard guard(&g_streams, topicStr);
+                MyStream *stream = guard.find(topicStr);
+                if (!stream) {
                     // TopicList knows how to add an entry based on a
                     // TOPIC_SUBSCRIBED message.
                     topicList.add(msg);
-                    it = (g_streams.insert(MyStreams::value_type(
-                                     topicStr,
-                                     new MyStream(topicStr, d_fields)))).first;
+                    stream = guard.insert(topicStr,
+                                          new MyStream(topicStr, d_fields));
                 }
-                it->second->setSubscribedState(true);
-                if (it->second->isAvailable()) {
-                    ++g_availableTopicCount;
+                stream->setSubscribedState(true);
+                if (stream->isAvailable()) {
+                    stream->startPublishing(d_intervalMicros);
                 }
             }
             else if (msg.messageType() == TOPIC_UNSUBSCRIBED) {
                 std::string topicStr = msg.getElementAsString("topic");
-                MutexGuard guard(&g_mutex);
-                MyStreams::iterator it = g_streams.find(topicStr);
-                if (it == g_streams.end()) {
+                MyStreams::ShardGuard guard(&g_streams, topicStr);
+                MyStream *stream = guard.find(topicStr);
+                if (!stream) {
                     // we should never be coming here. TOPIC_UNSUBSCRIBED can
                     // not come before a TOPIC_SUBSCRIBED or TOPIC_CREATED
                     continue;
                 }
-                if (it->second->isAvailable()) {
-                    --g_availableTopicCount;
-                }
-                it->second->setSubscribedState(false);
+                stream->setSubscribedState(false);
+                stream->stopPublishing();
             }
             else if (msg.messageType() == TOPIC_CREATED) {
                 std::string topicStr = msg.getElementAsString("topic");
-                MutexGuard guard(&g_mutex);
-                MyStreams::iterator it = g_streams.find(topicStr);
-                if (it == g_streams.end()) {
-                    it = (g_streams.insert(MyStreams::value_type(
-                                     topicStr,
-                                     new MyStream(topicStr, d_fields)))).first;
+                MyStreams::ShardGuard guard(&g_streams, topicStr);
+                MyStream *stream = guard.find(topicStr);
+                if (!stream) {
+                    stream = guard.insert(topicStr,
+                                          new MyStream(topicStr, d_fields));
                 }
                 try {
                     Topic topic = session->getTopic(msg);
-                    it->second->setTopic(topic);
+                    stream->setTopic(topic);
                 } catch (blpapi::Exception &e) {
                     std::cerr << "Exception while processing TOPIC_CREATED: "
                               << e.description()
                               << std::endl;
                     continue;
                 }
-                if (it->second->isAvailable()) {
-                    ++g_availableTopicCount;
+                if (stream->isAvailable()) {
+                    stream->startPublishing(d_intervalMicros);
                 }
 
             }
@@ -317,9 +470,9 @@ bool MyEventHandler::processEvent(const Event& event, ProviderSession* session)
                 // Here we send a recap in response to a Recap request.
                 try {
                     std::string topicStr = msg.getElementAsString("topic");
-                    MyStreams::iterator it = g_streams.find(topicStr);
-                    MutexGuard guard(&g_mutex);
-                    if (it == g_streams.end() || !it->second->isAvailable()) {
+                    MyStreams::ShardGuard guard(&g_streams, topicStr);
+                    MyStream *stream = guard.find(topicStr);
+                    if (!stream || !stream->isAvailable()) {
                         continue;
                     }
                     Topic topic = session->getTopic(msg);
@@ -331,8 +484,8 @@ bool MyEventHandler::processEvent(const Event& event, ProviderSession* session)
                         service.getEventDefinition(d_messageType);
                     EventFormatter eventFormatter(recapEvent);
                     eventFormatter.appendRecapMessage(topic, &recapCid);
-                    it->second->fillData(eventFormatter, elementDef);
-                    guard.release()->unlock();
+                    stream->fillImage(eventFormatter, elementDef);
+                    guard.unlock();
                     session->publish(recapEvent);
                 } catch (blpapi::Exception &e) {
                     std::cerr << "Exception while processing TOPIC_RECAP: "
@@ -480,6 +633,10 @@ class MktdataPublisherExample
     std::string              d_groupId;
     std::string              d_authOptions;
     int                      d_clearInterval;
+    int                      d_intervalMs;
+    int                      d_windowMicros;
+    int                      d_maxEventBytes;
+    int                      d_maxEventMessages;
 
     bool                     d_useSsc;
     int                      d_sscBegin;
@@ -512,9 +669,17 @@ class MktdataPublisherExample
             << " (defaults to unique value)" << std::endl
             << "\t[-pri  <priority>]   \tset publisher priority level"
             << " (default: 10)" << std::endl
-            << "\t[-c    <event count>]\tnumber of events after which cache"
-            << " will be cleared (default: 0 i.e cache never cleared)"
-            << std::endl
+            << "\t[-c    <count>]      \tnumber of stream updates after which"
+            << " every stream is cleared (default: 0 i.e cache never"
+            << " cleared)" << std::endl
+            << "\t[-iv   <millis>]     \tinterval between updates of a topic"
+            << " (default: 1000)" << std::endl
+            << "\t[-bw   <micros>]     \twindow over which updates are"
+            << " batched into one event (default: 500)" << std::endl
+            << "\t[-eb   <bytes>]      \ttarget size of a published event"
+            << " (default: 65536)" << std::endl
+            << "\t[-em   <messages>]   \tmost messages in a published event"
+            << " (default: 1024)" << std::endl
             << "\t[-auth <option>]     \tauthentication option: user|none|"
             << "app=<app>|userapp=<app>|dir=<property> (default: user)"
             << std::endl
@@ -547,6 +712,14 @@ class MktdataPublisherExample
                 d_priority = std::atoi(argv[++i]);
             else if (!std::strcmp(argv[i],"-c") && i + 1 < argc)
                 d_clearInterval = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i],"-iv") && i + 1 < argc)
+                d_intervalMs = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i],"-bw") && i + 1 < argc)
+                d_windowMicros = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i],"-eb") && i + 1 < argc)
+                d_maxEventBytes = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i],"-em") && i + 1 < argc)
+                d_maxEventMessages = std::atoi(argv[++i]);
             else if (!std::strcmp(argv[i], "-auth") && i + 1 < argc) {
                 ++ i;
                 if (!std::strcmp(argv[i], AUTH_OPTION_NONE)) {
@@ -600,6 +773,13 @@ class MktdataPublisherExample
             }
         }
 
+        if (d_intervalMs <= 0 || d_windowMicros < 0) {
+            std::cerr << "The interval must be positive and the window not"
+                      << " negative" << std::endl;
+            printUsage();
+            return false;
+        }
+
         if (d_hosts.size() == 0) {
             d_hosts.push_back("localhost");
         }
@@ -617,6 +797,10 @@ public:
         , d_authOptions(AUTH_USER)
         , d_priority(10)
         , d_clearInterval(0)
+        , d_intervalMs(1000)
+        , d_windowMicros(500)
+        , d_maxEventBytes(PublishBatcher::k_DEFAULT_MAX_BYTES)
+        , d_maxEventMessages(PublishBatcher::k_DEFAULT_MAX_MESSAGES)
         , d_useSsc(false)
         , d_resolveSubServiceCode(INT_MIN)
     {
@@ -735,7 +919,9 @@ public:
                                       PUBLISH_MESSAGE_TYPE,
                                       d_fields,
                                       d_eids,
-                                      d_resolveSubServiceCode);
+                                      d_resolveSubServiceCode,
+                                      d_intervalMs * 1000LL);
+        g_scheduler.setWindow(d_windowMicros);
         ProviderSession session(sessionOptions, &myEventHandler, 0);
         d_session_p = & session;
         if (!session.start()) {
@@ -789,52 +975,97 @@ public:
             = service.getEventDefinition(PUBLISH_MESSAGE_TYPE);
         int eventCount = 0;
 
-        // Now we will start publishing
-        int numPublished = 0;
-        while (g_running) {
-            Event event = service.createPublishEvent();
-            {
-                MutexGuard guard(&g_mutex);
-                if (0 == g_availableTopicCount) {
-                    guard.release()->unlock();
-                    SLEEP(1);
+        // Now we will start publishing.  'wait' returns the streams that are
+        // due, which are those whose interval elapsed and those that just
+        // became available, batched over the scheduler's window.  The
+        // batcher packs their messages into as few events as the size
+        // budget allows, and the last one is flushed at the end of the pass.
+        // A full event is published before a stream's shard is locked,
+        // never while it is, so that a slow publish does not hold up
+        // subscription handling on that shard.
+        PublishBatcher batcher(&session,
+                               service,
+                               d_maxEventBytes,
+                               d_maxEventMessages,
+                               &printMessages);
+        std::vector<size_t> fieldBytes;
+        estimateFieldBytes(&fieldBytes, d_fields, elementDef);
+        size_t nullBytes  = PublishBatcher::k_MESSAGE_OVERHEAD;
+        size_t imageBytes = PublishBatcher::k_MESSAGE_OVERHEAD;
+        for (size_t i = 0; i < d_fields.size(); ++i) {
+            nullBytes  += PublishBatcher::fieldBytes(d_fields[i], 0);
+            imageBytes += fieldBytes[i];
+        }
+        long long numPublished = 0;
+        std::vector<void *> due;
+        while (g_running && 0 == g_scheduler.wait(&due)) {
+            if (d_clearInterval > 0 && eventCount >= d_clearInterval) {
+                // Clear every available stream at once, not only the due
+                // ones, and publish nothing else on this pass.
+                eventCount = 0;
+                for (size_t shard = 0; shard < g_streams.numShards();
+                                                                   ++shard) {
+                    // Streams are never removed, so an index stays valid
+                    // while the shard is unlocked.
+                    for (size_t j = 0;; ++j) {
+                        batcher.makeRoom(nullBytes);
+                        MyStreams::ShardGuard guard(&g_streams, shard);
+                        if (j >= guard.size()) {
+                            break;
+                        }
+                        MyStream *stream = guard.stream(j);
+                        if (!stream->isAvailable()) {
+                            continue;
+                        }
+                        stream->fillDataNull(
+                                batcher.appendMessage(PUBLISH_MESSAGE_TYPE,
+                                                      stream->topic(),
+                                                      nullBytes),
+                                elementDef);
+                    }
+                }
+                batcher.flush();
+                continue;
+            }
+
+            for (size_t i = 0; i < due.size(); ++i) {
+                MyStream *stream = static_cast<MyStream *>(due[i]);
+                batcher.makeRoom(imageBytes);
+                MyStreams::ShardGuard guard(&g_streams, stream->getId());
+                if (!stream->isAvailable()) {
                     continue;
                 }
 
-                bool publishNull = false;
-                if (d_clearInterval > 0 && eventCount == d_clearInterval) {
-                    eventCount = 0;
-                    publishNull = true;
+                // Publish only the fields that changed, and nothing if none
+                // did.  The first update after a stream becomes available,
+                // or after its fields were cleared, is a full image.
+                ++eventCount;
+                stream->next();
+                if (!stream->update(elementDef)) {
+                    continue;
                 }
-                EventFormatter eventFormatter(event);
-                for (MyStreams::iterator iter = g_streams.begin();
-                    iter != g_streams.end(); ++iter) {
-                    if (!iter->second->isAvailable()) {
-                        continue;
-                    }
-                    eventFormatter.appendMessage(
-                            PUBLISH_MESSAGE_TYPE,
-                            iter->second->topic());
-                    if (publishNull) {
-                        iter->second->fillDataNull(eventFormatter, elementDef);
-                    } else {
-                        ++eventCount;
-                        iter->second->next();
-                        iter->second->fillData(eventFormatter, elementDef);
-                    }
+                const std::vector<size_t>& changed = stream->changedFields();
+                size_t bytes = PublishBatcher::k_MESSAGE_OVERHEAD;
+                for (size_t j = 0; j < changed.size(); ++j) {
+                    bytes += fieldBytes[changed[j]];
                 }
+                stream->fillData(batcher.appendMessage(PUBLISH_MESSAGE_TYPE,
+                                                       stream->topic(),
+                                                       bytes),
+                                 elementDef);
             }
+            batcher.flush();
 
-            printMessages(event);
-            session.publish(event);
-            SLEEP(1);
-            if (++numPublished % 10 == 0) {
+            long long numEvents = batcher.statistics().d_events;
+            if (d_useSsc && numEvents / 10 > numPublished / 10) {
                deactivate();
                SLEEP(30);
                activate();
             }
-
+            numPublished = numEvents;
         }
+        std::cout << g_scheduler.statistics() << std::endl
+                  << batcher.statistics() << std::endl;
         session.stop();
     }
 };
@@ -17,6 +17,9 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
  * IN THE SOFTWARE.
  */
+#include "BlpPageDiff.h"
+#include "BlpPublishBatcher.h"
+#include "BlpPublishScheduler.h"
 #include "BlpThreadUtil.h"
 
 #include <blpapi_element.h>
@@ -72,6 +75,8 @@ bool g_running = true;
 
 Mutex g_lock;
 
+PublishScheduler g_scheduler;
+
 enum AuthorizationStatus {
     WAITING,
     AUTHORIZED,
@@ -84,18 +89,29 @@ class MyStream {
     const std::string d_id;
     volatile bool d_isInitialPaintSent;
 
+    Page d_page;       // the page as it is now
+    Page d_published;  // the page as subscribers last saw it
+
     Topic d_topic;
     bool  d_isSubscribed;
 
+    PublishScheduler::Handle d_handle;
+
   public:
     MyStream()
         : d_id(""),
-          d_isInitialPaintSent(false)
+          d_isInitialPaintSent(false),
+          d_isSubscribed(false),
+          d_handle(g_scheduler.add(this))
     {}
 
-    MyStream(std::string const& id)
+    MyStream(std::string const& id, int numRows, int numCols)
         : d_id(id),
-          d_isInitialPaintSent(false)
+          d_isInitialPaintSent(false),
+          d_page(numRows, numCols),
+          d_published(numRows, numCols),
+          d_isSubscribed(false),
+          d_handle(g_scheduler.add(this))
     {}
 
     std::string const& getId()
@@ -112,6 +128,23 @@ class MyStream {
     {
         d_isInitialPaintSent = value;
     }
+
+    Page& page() {
+        return d_page;
+    }
+
+    const Page& publishedPage() const {
+        return d_published;
+    }
+
+    void diff(std::vector<PageSpan> *spans) const {
+        PageDiff::diff(spans, d_published, d_page);
+    }
+
+    void markPublished() {
+        d_published = d_page;
+    }
+
     void setTopic(Topic topic) {
         d_topic = topic;
     }
@@ -128,12 +161,22 @@ class MyStream {
         return d_topic.isValid() && d_isSubscribed;
     }
 
+    void startPublishing(long long intervalMicros) {
+        // Publish the initial paint now, then an update every
+        // 'intervalMicros'.
+        g_scheduler.setPeriod(d_handle, intervalMicros);
+        g_scheduler.trigger(d_handle);
+    }
+
+    void stopPublishing() {
+        g_scheduler.cancel(d_handle);
+    }
+
 };
 
 typedef std::map<std::string, MyStream*> MyStreams;
 
 MyStreams g_streams;
-int       g_availableTopicCount;
 Mutex     g_mutex;
 
 void printMessages(const Event& event)
@@ -145,15 +188,53 @@ void printMessages(const Event& event)
     }
 }
 
+size_t estimateRowBytes(const PageSpan *spans, size_t numSpans)
+{
+    // Estimated size of a message updating 'numSpans' spans of one row.
+    static const Name ROW_NUM("rowNum");
+    static const Name START_COL("startCol");
+    static const Name LENGTH("length");
+    static const Name TEXT("text");
+
+    size_t bytes = PublishBatcher::k_MESSAGE_OVERHEAD
+                 + PublishBatcher::fieldBytes(ROW_NUM, 4);
+    for (size_t i = 0; i < numSpans; ++i) {
+        bytes += PublishBatcher::fieldBytes(START_COL, 4)
+               + PublishBatcher::fieldBytes(LENGTH, 4)
+               + PublishBatcher::fieldBytes(TEXT, spans[i].d_length);
+    }
+    return bytes;
+}
+
+size_t estimateImageBytes(const Page& page)
+{
+    std::vector<PageSpan> spans;
+    PageDiff::imageSpans(&spans, page);
+    size_t bytes = PublishBatcher::k_MESSAGE_OVERHEAD;
+    for (size_t i = 0; i < spans.size(); ++i) {
+        bytes += estimateRowBytes(&spans[i], 1);
+    }
+    return bytes;
+}
+
 } // namespace {
 
 class MyEventHandler : public ProviderEventHandler
 {
     const std::string d_serviceName;
+    long long         d_intervalMicros;
+    int               d_numRows;
+    int               d_numCols;
 
 public:
-    MyEventHandler(const std::string& serviceName)
+    MyEventHandler(const std::string& serviceName,
+                   long long          intervalMicros,
+                   int                numRows,
+                   int                numCols)
     : d_serviceName(serviceName)
+    , d_intervalMicros(intervalMicros)
+    , d_numRows(numRows)
+    , d_numCols(numCols)
     {}
 
     bool processEvent(const Event& event, ProviderSession* session);
@@ -168,6 +249,7 @@ bool MyEventHandler::processEvent(const Event& event, ProviderSession* session)
             Message msg = iter.message();
             if (msg.messageType() == SESSION_TERMINATED) {
                 g_running = false;
+                g_scheduler.stop();
             }
         }
     }
@@ -187,11 +269,13 @@ bool MyEventHandler::processEvent(const Event& event, ProviderSession* session)
                     topicList.add(msg);
                     it = (g_streams.insert(MyStreams::value_type(
                                      topicStr,
-                                     new MyStream(topicStr)))).first;
+                                     new MyStream(topicStr,
+                                                  d_numRows,
+                                                  d_numCols)))).first;
                 }
                 it->second->setSubscribedState(true);
                 if (it->second->isAvailable()) {
-                    ++g_availableTopicCount;
+                    it->second->startPublishing(d_intervalMicros);
                 }
             }
             else if (msg.messageType() == TOPIC_UNSUBSCRIBED) {
@@ -203,10 +287,8 @@ bool MyEventHandler::processEvent(const Event& event, ProviderSession* session)
                     // not come before a TOPIC_SUBSCRIBED or TOPIC_CREATED
                     continue;
                 }
-                if (it->second->isAvailable()) {
-                    --g_availableTopicCount;
-                }
                 it->second->setSubscribedState(false);
+                it->second->stopPublishing();
             }
             else if (msg.messageType() == TOPIC_CREATED) {
                 std::string topicStr = msg.getElementAsString("topic");
@@ -215,7 +297,9 @@ bool MyEventHandler::processEvent(const Event& event, ProviderSession* session)
                 if (it == g_streams.end()) {
                     it = (g_streams.insert(MyStreams::value_type(
                                      topicStr,
-                                     new MyStream(topicStr)))).first;
+                                     new MyStream(topicStr,
+                                                  d_numRows,
+                                                  d_numCols)))).first;
                 }
                 try {
                     Topic topic = session->getTopic(msg);
@@ -228,7 +312,7 @@ bool MyEventHandler::processEvent(const Event& event, ProviderSession* session)
                     continue;
                 }
                 if (it->second->isAvailable()) {
-                    ++g_availableTopicCount;
+                    it->second->startPublishing(d_intervalMicros);
                 }
             }
             else if (msg.messageType() == TOPIC_RECAP) {
@@ -247,22 +331,10 @@ bool MyEventHandler::processEvent(const Event& event, ProviderSession* session)
                     Event recapEvent = service.createPublishEvent();
                     EventFormatter eventFormatter(recapEvent);
                     eventFormatter.appendRecapMessage(topic, &recapCid);
-                    eventFormatter.setElement("numRows", 25);
-                    eventFormatter.setElement("numCols", 80);
-                    eventFormatter.pushElement("rowUpdate");
-                    for (int i = 1; i < 6; ++i) {
-                        eventFormatter.appendElement();
-                        eventFormatter.setElement("rowNum", i);
-                        eventFormatter.pushElement("spanUpdate");
-                        eventFormatter.appendElement();
-                        eventFormatter.setElement("startCol", 1);
-                        eventFormatter.setElement("length", 10);
-                        eventFormatter.setElement("text", "RECAP");
-                        eventFormatter.popElement();
-                        eventFormatter.popElement();
-                        eventFormatter.popElement();
-                    }
-                    eventFormatter.popElement();
+                    // The recap is the page as the other subscribers have
+                    // it, so that the next diff applies to it as well.
+                    PageDiff::formatImage(eventFormatter,
+                                          it->second->publishedPage());
                     guard.release()->unlock();
                     session->publish(recapEvent);
                 } catch (blpapi::Exception &e) {
@@ -342,6 +414,12 @@ class PagePublisherExample
     std::string              d_service;
     std::string              d_groupId;
     std::string              d_authOptions;
+    int                      d_intervalMs;
+    int                      d_windowMicros;
+    int                      d_maxEventBytes;
+    int                      d_maxEventMessages;
+    int                      d_numRows;
+    int                      d_numCols;
 
     void printUsage()
     {
@@ -353,7 +431,13 @@ class PagePublisherExample
             << "\t[-s    <service>]    \tservice name (default: //viper/page)" << std::endl
             << "\t[-g    <groupId>]    \tpublisher groupId (defaults to unique value)" << std::endl
             << "\t[-pri  <priority>]   \tset publisher priority level (default: 10)" << std::endl
-            << "\t[-auth <option>]     \tauthentication option: user|none|app=<app>|userapp=<app>|dir=<property> (default: user)" << std::endl;
+            << "\t[-auth <option>]     \tauthentication option: user|none|app=<app>|userapp=<app>|dir=<property> (default: user)" << std::endl
+            << "\t[-iv   <millis>]     \tinterval between updates of a topic (default: 10000)" << std::endl
+            << "\t[-bw   <micros>]     \twindow over which updates are batched into one event (default: 500)" << std::endl
+            << "\t[-eb   <bytes>]      \ttarget size of a published event (default: 65536)" << std::endl
+            << "\t[-em   <messages>]   \tmost messages in a published event (default: 1024)" << std::endl
+            << "\t[-rows <rows>]       \tnumber of rows of a page (default: 25)" << std::endl
+            << "\t[-cols <columns>]    \tnumber of columns of a page (default: 80)" << std::endl;
     }
 
     bool parseCommandLine(int argc, char **argv)
@@ -369,6 +453,18 @@ class PagePublisherExample
                 d_groupId = argv[++i];
             else if (!std::strcmp(argv[i],"-pri") && i + 1 < argc)
                 d_priority = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i],"-iv") && i + 1 < argc)
+                d_intervalMs = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i],"-bw") && i + 1 < argc)
+                d_windowMicros = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i],"-eb") && i + 1 < argc)
+                d_maxEventBytes = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i],"-em") && i + 1 < argc)
+                d_maxEventMessages = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i],"-rows") && i + 1 < argc)
+                d_numRows = std::atoi(argv[++i]);
+            else if (!std::strcmp(argv[i],"-cols") && i + 1 < argc)
+                d_numCols = std::atoi(argv[++i]);
             else if (!std::strcmp(argv[i], "-auth") && i + 1 < argc) {
                 ++ i;
                 if (!std::strcmp(argv[i], AUTH_OPTION_NONE)) {
@@ -403,6 +499,19 @@ class PagePublisherExample
             }
         }
 
+        if (d_numRows <= 0 || d_numCols <= 0) {
+            std::cerr << "Rows and columns must be positive" << std::endl;
+            printUsage();
+            return false;
+        }
+
+        if (d_intervalMs <= 0 || d_windowMicros < 0) {
+            std::cerr << "The interval must be positive and the window not"
+                      << " negative" << std::endl;
+            printUsage();
+            return false;
+        }
+
         if (d_hosts.size() == 0) {
             d_hosts.push_back("localhost");
         }
@@ -417,6 +526,12 @@ public:
         , d_service("//viper/page")
         , d_authOptions(AUTH_USER)
         , d_priority(10)
+        , d_intervalMs(10000)
+        , d_windowMicros(500)
+        , d_maxEventBytes(PublishBatcher::k_DEFAULT_MAX_BYTES)
+        , d_maxEventMessages(PublishBatcher::k_DEFAULT_MAX_MESSAGES)
+        , d_numRows(25)
+        , d_numCols(80)
     {
     }
 
@@ -501,7 +616,11 @@ public:
                   std::ostream_iterator<std::string>(std::cout, " "));
         std::cout << std::endl;
 
-        MyEventHandler myEventHandler(d_service);
+        MyEventHandler myEventHandler(d_service,
+                                      d_intervalMs * 1000LL,
+                                      d_numRows,
+                                      d_numCols);
+        g_scheduler.setWindow(d_windowMicros);
         ProviderSession session(sessionOptions, &myEventHandler, 0);
         if (!session.start()) {
             std::cerr <<"Failed to start session." << std::endl;
@@ -534,68 +653,68 @@ public:
 
         Service service = session.getService(d_service.c_str());
 
-        // Now we will start publishing
+        // Now we will start publishing, each time the scheduler says some
+        // streams are due.  The batcher packs the messages of a pass into
+        // as few events as the size budget allows.
+        PublishBatcher batcher(&session,
+                               service,
+                               d_maxEventBytes,
+                               d_maxEventMessages,
+                               &printMessages);
+
         int value=1;
-        while (g_running) {
-            Event event = service.createPublishEvent();
-            {
-                MutexGuard guard(&g_mutex);
-                if (0 == g_availableTopicCount) {
-                    guard.release()->unlock();
-                    SLEEP(1);
+        std::vector<void *> due;
+        std::vector<PageSpan> spans;
+        while (g_running && 0 == g_scheduler.wait(&due)) {
+            MutexGuard guard(&g_mutex);
+            for (size_t j = 0; j < due.size(); ++j) {
+                MyStream *stream = static_cast<MyStream *>(due[j]);
+                if (!stream->isAvailable()) {
                     continue;
                 }
+                std::ostringstream os;
+                os << ++value;
 
-                EventFormatter eventFormatter(event);
-                for (MyStreams::iterator iter = g_streams.begin();
-                    iter != g_streams.end(); ++iter) {
-                    if (!iter->second->isAvailable()) {
-                        continue;
-                    }
-                    std::ostringstream os;
-                    os << ++value;
-
-                    if (!iter->second->isInitialPaintSent()) {
-                        eventFormatter.appendRecapMessage(
-                                                        iter->second->topic());
-                        eventFormatter.setElement("numRows", 25);
-                        eventFormatter.setElement("numCols", 80);
-                        eventFormatter.pushElement("rowUpdate");
-                        for (int i = 1; i < 6; ++i) {
-                            eventFormatter.appendElement();
-                            eventFormatter.setElement("rowNum", i);
-                            eventFormatter.pushElement("spanUpdate");
-                            eventFormatter.appendElement();
-                            eventFormatter.setElement("startCol", 1);
-                            eventFormatter.setElement("length", 10);
-                            eventFormatter.setElement("text", "INITIAL");
-                            eventFormatter.setElement("fgColor", "RED");
-                            eventFormatter.popElement();
-                            eventFormatter.popElement();
-                            eventFormatter.popElement();
-                        }
-                        eventFormatter.popElement();
-                        iter->second->setIsInitialPaintSent(true);
+                Page& page = stream->page();
+                if (!stream->isInitialPaintSent()) {
+                    for (int i = 0; i < 5; ++i) {
+                        page.write(i, 0, "INITIAL");
                     }
+                    page.write(0, 0, os.str());
+
+                    EventFormatter& eventFormatter =
+                        batcher.appendRecapMessage(stream->topic(),
+                                                   estimateImageBytes(page));
+                    PageDiff::formatImage(eventFormatter, page);
+                    stream->markPublished();
+                    stream->setIsInitialPaintSent(true);
+                    continue;
+                }
 
-                    eventFormatter.appendMessage("RowUpdate",
-                                                 iter->second->topic());
-                    eventFormatter.setElement("rowNum", 1);
-                    eventFormatter.pushElement("spanUpdate");
-                    eventFormatter.appendElement();
-                    Name START_COL("startCol");
-                    eventFormatter.setElement(START_COL, 1);
-                    eventFormatter.setElement("length", int(os.str().size()));
-                    eventFormatter.setElement("text", os.str().c_str());
-                    eventFormatter.popElement();
-                    eventFormatter.popElement();
+                // Publish only the spans that changed since the last
+                // update, one 'RowUpdate' per row.
+                page.write(0, 0, os.str());
+                stream->diff(&spans);
+                for (size_t i = 0; i < spans.size(); ) {
+                    size_t n = 1;
+                    while (i + n < spans.size()
+                        && spans[i + n].d_row == spans[i].d_row) {
+                        ++n;
+                    }
+                    EventFormatter& eventFormatter =
+                        batcher.appendMessage(Name("RowUpdate"),
+                                              stream->topic(),
+                                              estimateRowBytes(&spans[i], n));
+                    PageDiff::formatRow(eventFormatter, page, &spans[i], n);
+                    i += n;
                 }
+                stream->markPublished();
             }
-
-            printMessages(event);
-            session.publish(event);
-            SLEEP(10);
+            guard.release()->unlock();
+            batcher.flush();
         }
+        std::cout << g_scheduler.statistics() << std::endl
+                  << batcher.statistics() << std::endl;
         session.stop();
     }
 };
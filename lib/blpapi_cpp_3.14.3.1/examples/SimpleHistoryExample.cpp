@@ -17,6 +17,8 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
  * IN THE SOFTWARE.
  */
+#include "BlpHistoryDownloader.h"
+
 #include <blpapi_session.h>
 #include <blpapi_eventdispatcher.h>
 
@@ -104,8 +106,73 @@ int readFromFile(const std::string& filename, std::string& buffer)
     return 0;
 }
 
+int readLines(const std::string& filename, std::vector<std::string> *lines)
+{
+    std::ifstream in(filename.c_str());
+    if (!in) {
+        std::cerr << "Failed to read file from " << filename << std::endl;
+        return 1;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line[line.size() - 1] == '\r') {
+            line.erase(line.size() - 1);
+        }
+        if (!line.empty()) {
+            lines->push_back(line);
+        }
+    }
+    return 0;
+}
+
 }
 
+class HistoryPrinter : public HistoryHandler
+{
+    const HistoryDownloader *d_downloader_p;
+    size_t                   d_progressInterval;
+
+public:
+    HistoryPrinter()
+        : d_downloader_p(0)
+        , d_progressInterval(1)
+    {
+    }
+
+    void setDownloader(const HistoryDownloader *downloader,
+                       size_t                   numChunks)
+    {
+        // Report progress about 20 times over the download.
+        d_downloader_p = downloader;
+        d_progressInterval = numChunks / 20 > 0 ? numChunks / 20 : 1;
+    }
+
+    void onSecurityData(const Element& securityData, const HistoryChunk&)
+    {
+        securityData.print(std::cout);
+        std::cout << std::endl;
+    }
+
+    void onChunkDone(const HistoryChunk&)
+    {
+        HistoryDownloader::Statistics stats = d_downloader_p->statistics();
+        if (stats.d_completed % d_progressInterval == 0) {
+            std::cout << stats << std::endl;
+        }
+    }
+
+    void onChunkFailed(const HistoryChunk& chunk, const Message& reason)
+    {
+        std::cerr << "Failed to download "
+                  << d_downloader_p->security(chunk.d_firstSecurity)
+                  << " (" << chunk.d_numSecurities << " securities, "
+                  << chunk.d_numFields << " fields) from "
+                  << chunk.d_startDate << " to " << chunk.d_endDate
+                  << " after " << chunk.d_attempts << " attempts: "
+                  << reason << std::endl;
+    }
+};
+
 class SimpleHistoryExample
 {
     std::string         d_host;
@@ -115,6 +182,14 @@ class SimpleHistoryExample
     std::string         d_clientCredentialsPassword;
     std::string         d_trustMaterial;
     bool                d_readTlsData;
+    std::vector<std::string> d_securities;
+    std::vector<std::string> d_fields;
+    std::string         d_startDate;
+    std::string         d_endDate;
+    std::string         d_periodicity;
+    HistoryLimits       d_limits;
+    int                 d_maxInFlight;
+    int                 d_maxAttempts;
 
     void printUsage()
     {
@@ -122,6 +197,19 @@ class SimpleHistoryExample
             << "Usage:" << std::endl
             << "\t[-ip   <ipAddress = localhost>" << std::endl
             << "\t[-p    <tcpPort   = 8194>" << std::endl
+            << "\t[-s    <security  = IBM US Equity, MSFT US Equity>]"
+            << std::endl
+            << "\t[-sf   <file of securities, one per line>]" << std::endl
+            << "\t[-f    <field     = PX_LAST, OPEN>]" << std::endl
+            << "\t[-sd   <startDate = 20060101>]" << std::endl
+            << "\t[-ed   <endDate   = 20061231>]" << std::endl
+            << "\t[-per  <periodicity = MONTHLY>]" << std::endl
+            << "\t[-ms   <max securities per request = 50>]" << std::endl
+            << "\t[-mf   <max fields per request = 25>]" << std::endl
+            << "\t[-mp   <max values per request = 50000>]" << std::endl
+            << "\t[-n    <max requests in flight"
+            << " = SessionOptions::maxPendingRequests>]" << std::endl
+            << "\t[-r    <attempts per request = 3>]" << std::endl
             << "\t[-auth <option>] \tauthentication option: user|none|app=<app>|userapp=<app>|dir=<property> (default: none)" << std::endl
             << std::endl
             << "TLS OPTIONS (specify all or none):\n"
@@ -141,6 +229,30 @@ class SimpleHistoryExample
             } else if (!std::strcmp(argv[i],"-p") &&  i + 1 < argc) {
                 d_port = std::atoi(argv[++i]);
                 continue;
+            } else if (!std::strcmp(argv[i],"-s") && i + 1 < argc) {
+                d_securities.push_back(argv[++i]);
+            } else if (!std::strcmp(argv[i],"-sf") && i + 1 < argc) {
+                if (readLines(argv[++i], &d_securities)) {
+                    return false;
+                }
+            } else if (!std::strcmp(argv[i],"-f") && i + 1 < argc) {
+                d_fields.push_back(argv[++i]);
+            } else if (!std::strcmp(argv[i],"-sd") && i + 1 < argc) {
+                d_startDate = argv[++i];
+            } else if (!std::strcmp(argv[i],"-ed") && i + 1 < argc) {
+                d_endDate = argv[++i];
+            } else if (!std::strcmp(argv[i],"-per") && i + 1 < argc) {
+                d_periodicity = argv[++i];
+            } else if (!std::strcmp(argv[i],"-ms") && i + 1 < argc) {
+                d_limits.d_maxSecurities = std::atoi(argv[++i]);
+            } else if (!std::strcmp(argv[i],"-mf") && i + 1 < argc) {
+                d_limits.d_maxFields = std::atoi(argv[++i]);
+            } else if (!std::strcmp(argv[i],"-mp") && i + 1 < argc) {
+                d_limits.d_maxPoints = std::atoi(argv[++i]);
+            } else if (!std::strcmp(argv[i],"-n") && i + 1 < argc) {
+                d_maxInFlight = std::atoi(argv[++i]);
+            } else if (!std::strcmp(argv[i],"-r") && i + 1 < argc) {
+                d_maxAttempts = std::atoi(argv[++i]);
             } else if (!std::strcmp(argv[i], "-auth") && i + 1 < argc) {
                 ++ i;
                 if (!std::strcmp(argv[i], AUTH_OPTION_NONE)) {
@@ -192,6 +304,15 @@ class SimpleHistoryExample
                 return false;
             }
         }
+
+        if (d_securities.empty()) {
+            d_securities.push_back("IBM US Equity");
+            d_securities.push_back("MSFT US Equity");
+        }
+        if (d_fields.empty()) {
+            d_fields.push_back("PX_LAST");
+            d_fields.push_back("OPEN");
+        }
         return true;
     }
 
@@ -260,6 +381,11 @@ public:
         , d_host("localhost")
         , d_authOptions("")
         , d_readTlsData(false)
+        , d_startDate("20060101")
+        , d_endDate("20061231")
+        , d_periodicity("MONTHLY")
+        , d_maxInFlight(0)
+        , d_maxAttempts(3)
     {
     }
 
@@ -271,6 +397,12 @@ public:
         sessionOptions.setServerHost(d_host.c_str());
         sessionOptions.setServerPort(d_port);
         sessionOptions.setAuthenticationOptions(d_authOptions.c_str());
+        if (d_maxInFlight > sessionOptions.maxPendingRequests()) {
+            sessionOptions.setMaxPendingRequests(d_maxInFlight);
+        }
+        if (d_maxInFlight <= 0) {
+            d_maxInFlight = sessionOptions.maxPendingRequests();
+        }
 
         std::cout << "Connecting to " <<  d_host << ":" << d_port << std::endl;
 
@@ -331,32 +463,37 @@ public:
             return;
         }
         Service refDataService = session.getService("//blp/refdata");
-        Request request = refDataService.createRequest("HistoricalDataRequest");
-        request.getElement("securities").appendValue("IBM US Equity");
-        request.getElement("securities").appendValue("MSFT US Equity");
-        request.getElement("fields").appendValue("PX_LAST");
-        request.getElement("fields").appendValue("OPEN");
-        request.set("periodicityAdjustment", "ACTUAL");
-        request.set("periodicitySelection", "MONTHLY");
-        request.set("startDate", "20060101");
-        request.set("endDate", "20061231");
-        request.set("maxDataPoints", 100);
-
-        std::cout << "Sending Request: " << request << std:: endl;
-        session.sendRequest(request, identity);
 
-        while (true) {
-            Event event = session.nextEvent();
-            MessageIterator msgIter(event);
-            while (msgIter.next()) {
-                Message msg = msgIter.message();
-                msg.asElement().print(std::cout);
-                std::cout << std::endl;
-            }
-            if (event.eventType() == Event::RESPONSE) {
-                break;
-            }
+        HistoryPrinter printer;
+        HistoryDownloader downloader(&session,
+                                     refDataService,
+                                     &printer,
+                                     d_maxInFlight,
+                                     d_maxAttempts);
+        downloader.setIdentity(identity);
+        for (size_t i = 0; i < d_securities.size(); ++i) {
+            downloader.addSecurity(d_securities[i]);
+        }
+        for (size_t i = 0; i < d_fields.size(); ++i) {
+            downloader.addField(d_fields[i]);
+        }
+        downloader.setOption("periodicityAdjustment", "ACTUAL");
+        downloader.setOption("periodicitySelection", d_periodicity);
+
+        size_t numChunks = downloader.plan(d_startDate, d_endDate, d_limits);
+        if (numChunks == 0) {
+            std::cerr << "Invalid dates " << d_startDate << " to "
+                      << d_endDate << std::endl;
+            return;
         }
+        printer.setDownloader(&downloader, numChunks);
+        std::cout << "Downloading " << d_securities.size()
+                  << " securities and " << d_fields.size() << " fields in "
+                  << numChunks << " requests, " << d_maxInFlight
+                  << " in flight" << std::endl;
+
+        downloader.run();
+        std::cout << downloader.statistics() << std::endl;
     }
 };
 
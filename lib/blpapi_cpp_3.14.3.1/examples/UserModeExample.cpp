@@ -17,6 +17,8 @@
  * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
  * IN THE SOFTWARE.
  */
+#include "BlpIdentityPool.h"
+
 #include <blpapi_session.h>
 #include <blpapi_eventdispatcher.h>
 
@@ -44,8 +46,6 @@ namespace {
     const Name SECURITY_DATA("securityData");
     const Name SECURITY("security");
     const Name EID_DATA("eidData");
-    const Name AUTHORIZATION_SUCCESS("AuthorizationSuccess");
-    const Name AUTHORIZATION_FAILURE("AuthorizationFailure");
 
     const char* REFRENCEDATA_REQUEST = "ReferenceDataRequest";
     const char* APIAUTH_SVC          = "//blp/apiauth";
@@ -70,9 +70,6 @@ namespace {
 
 class SessionEventHandler: public  EventHandler
 {
-    std::vector<Identity> &d_identities;
-    std::vector<int> &d_uuids;
-
     void processResponseEvent(const Event &event)
     {
         MessageIterator msgIter(event);
@@ -91,11 +88,6 @@ class SessionEventHandler: public  EventHandler
 
 public :
 
-    SessionEventHandler(std::vector<Identity> &identities,
-        std::vector<int> &uuids) :
-    d_identities(identities), d_uuids(uuids) {
-    }
-
     bool processEvent(const Event &event, Session *session)
     {
         switch(event.eventType()) {
@@ -131,8 +123,8 @@ class UserModeExample {
     int                       d_port;
     std::vector<std::string>  d_securities;
     std::vector<int>          d_uuids;
-    std::vector<Identity>     d_identities;
     std::vector<std::string>  d_programAddresses;
+    int                       d_maxInFlight;
 
     void printUsage()
     {
@@ -144,6 +136,8 @@ class UserModeExample {
             " eg:12345:10.20.30.40>]" << '\n'
             << "        [-ip    <ipAddress  = localhost>]" << '\n'
             << "        [-p     <tcpPort    = 8194>]" << '\n'
+            << "        [-w     <authorization requests in flight = 64>]"
+            << '\n'
             << "Note:" << '\n'
             <<"Multiple securities and credentials can be" <<
             " specified." << std::endl;
@@ -164,57 +158,31 @@ class UserModeExample {
         }
     }
 
-    bool authorizeUsers(EventQueue *authQueue, Session *session)
+    void authorizeUsers(IdentityPool *identities, Session *session)
     {
-        Service authService = session->getService(APIAUTH_SVC);
-        bool is_any_user_authorized = false;
-
-        // Authorize each of the users
-        d_identities.reserve(d_uuids.size());
+        // Authorize the users with up to 'd_maxInFlight' requests
+        // outstanding rather than one after another.
         for (size_t i = 0; i < d_uuids.size(); ++i) {
-            d_identities.push_back(session->createIdentity());
-            Request authRequest = authService.createAuthorizationRequest();
-            authRequest.set("uuid", d_uuids[i]);
-            authRequest.set("ipAddress", d_programAddresses[i].c_str());
-
-            session->sendAuthorizationRequest(authRequest,
-                                              &d_identities[i],
-                                              CorrelationId(i),
-                                              authQueue);
-
-            Event event = authQueue->nextEvent();
-
-            if (event.eventType() == Event::RESPONSE ||
-                event.eventType() == Event::PARTIAL_RESPONSE ||
-                event.eventType() == Event::REQUEST_STATUS ||
-                event.eventType() == Event::AUTHORIZATION_STATUS) {
-
-                MessageIterator msgIter(event);
-                while (msgIter.next()) {
-                    Message msg = msgIter.message();
-
-                    if (msg.messageType() == AUTHORIZATION_SUCCESS) {
-                        std::cout << d_uuids[msg.correlationId().asInteger()]
-                            << " authorization success"
-                            << std::endl;
-                        is_any_user_authorized = true;
-                    }
-                    else if (msg.messageType() == AUTHORIZATION_FAILURE) {
-                        std::cout << d_uuids[msg.correlationId().asInteger()]
-                            << " authorization failed"
-                            << std::endl;
-                        std::cout << msg << std::endl;
-                    }
-                    else {
-                        std::cout << msg << std::endl;
-                    }
-                }
+            identities->add(d_uuids[i], d_programAddresses[i]);
+        }
+        identities->start(session, APIAUTH_SVC);
+
+        size_t              outstanding = identities->outstanding();
+        std::vector<size_t> newlyReady;
+        while (outstanding > 0) {
+            outstanding = identities->poll(&newlyReady, 10000);
+            if (!newlyReady.empty()) {
+                sendRefDataRequests(session, *identities, newlyReady);
+                newlyReady.clear();
             }
         }
-        return is_any_user_authorized;
+        std::cout << identities->numReady() << " of " << identities->size()
+            << " users authorized" << std::endl;
     }
 
-    void sendRefDataRequest(Session *session)
+    void sendRefDataRequests(Session                   *session,
+                             const IdentityPool&        identities,
+                             const std::vector<size_t>& users)
     {
         Service service = session->getService(REFDATA_SVC);
         Request request = service.createRequest(REFRENCEDATA_REQUEST);
@@ -232,12 +200,12 @@ class UserModeExample {
 
         request.set("returnEids", true);
 
-        for (size_t j = 0; j < d_identities.size(); ++j) {
-            int uuid = d_uuids[j];
+        for (size_t j = 0; j < users.size(); ++j) {
+            int uuid = identities.uuid(users[j]);
             std::cout << "Sending RefDataRequest for User "
                       << uuid << std::endl;
             session->sendRequest(request,
-                                 d_identities[j],
+                                 identities.identity(users[j]),
                                  CorrelationId(uuid));
         }
     }
@@ -269,6 +237,11 @@ class UserModeExample {
                 d_port = std::atoi(argv[i]);
                 continue;
             }
+            else if (!std::strcmp(argv[i],"-w")) {
+                if (++i >= argc) return false;
+                d_maxInFlight = std::atoi(argv[i]);
+                continue;
+            }
             else return false;
         }
 
@@ -297,6 +270,7 @@ public:
     UserModeExample()
     : d_host("localhost")
     , d_port(8194)
+    , d_maxInFlight(64)
     {
     }
 
@@ -312,7 +286,8 @@ public:
 
         std::cout << "Connecting to " + d_host + ":" << d_port << std::endl;
 
-        SessionEventHandler eventHandler(d_identities, d_uuids);
+        SessionEventHandler eventHandler;
+        IdentityPool identities(d_maxInFlight);
         Session session(sessionOptions, &eventHandler);
 
         if (!session.start()) {
@@ -322,26 +297,20 @@ public:
 
         openServices(&session);
 
-        EventQueue authQueue;
-
-        // Authorize all the users that are interested in receiving data
-        if (authorizeUsers(&authQueue, &session)) {
-            // Make the various requests that we need to make
-            sendRefDataRequest(&session);
-        }
+        // Authorize all the users that are interested in receiving data,
+        // making each user's request as soon as the user is authorized
+        authorizeUsers(&identities, &session);
 
         // wait for enter key to exit application
         char dummy[2];
         std::cin.getline(dummy,2);
 
         {
-            // Check if there were any authorization events received on the
-            // 'authQueue'
+            // Process any authorization events received on the identity
+            // pool's queue since the users were authorized.
 
-            Event event;
-            while (0 == authQueue.tryNextEvent(&event)) {
-                printEvent(event);
-            }
+            std::vector<size_t> newlyReady;
+            identities.tryPoll(&newlyReady);
         }
 
         session.stop();
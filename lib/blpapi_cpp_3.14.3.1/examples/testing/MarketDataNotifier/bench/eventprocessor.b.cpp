@@ -0,0 +1,126 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <computeengine.h>
+#include <eventprocessor.h>
+#include <fieldregistry.h>
+#include <notifier.h>
+#include <testSchemas.h>
+#include <topictable.h>
+
+#include <blpapi_event.h>
+#include <blpapi_service.h>
+#include <blpapi_testutil.h>
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace blp    = BloombergLP::blpapi;
+namespace blptst = blp::test;
+
+namespace {
+const blp::Name MKTDATA_EVENTS("MarketDataEvents");
+
+// Discards everything, so that only the processing is measured.
+class NullNotifier : public INotifier {
+  public:
+    std::uint64_t d_values;
+
+    NullNotifier()
+    : d_values(0)
+    {
+    }
+
+    virtual void logSessionState(const blp::Message&)
+    {
+    }
+
+    virtual void logSubscriptionState(const blp::Message&)
+    {
+    }
+
+    virtual void sendToTerminal(double)
+    {
+        ++d_values;
+    }
+};
+
+// Return a SubscriptionEvent holding 'numMessages' messages, the 'i'th of
+// which is for topic id 'i'.
+blp::Event createMarketDataEvent(std::size_t numMessages)
+{
+    std::istringstream schemaStream(getMktDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+    const blp::SchemaElementDefinition schemaDef =
+        service.getEventDefinition(MKTDATA_EVENTS);
+
+    blp::Event event =
+        blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    for (std::size_t i = 0; i < numMessages; ++i) {
+        blptst::MessageProperties properties;
+        properties.setCorrelationId(TopicTable::correlationId(i));
+
+        std::ostringstream json;
+        json << "{\"LAST_PRICE\": " << 100.0 + i * 0.25
+             << ", \"BID\": " << 100.0 + i * 0.25 - 0.05
+             << ", \"ASK\": " << 100.0 + i * 0.25 + 0.05
+             << ", \"VOLUME\": " << 100 * (i + 1) << "}";
+        blptst::TestUtil::appendMessage(event, schemaDef, properties)
+            .formatMessageJson(json.str().c_str());
+    }
+    return event;
+}
+}
+
+// 'processEvent' computing inline, for events of 1, 10 and 100 messages.
+static void BM_ProcessEvent(benchmark::State& state)
+{
+    const std::size_t numMessages = static_cast<std::size_t>(state.range(0));
+    blp::Event        event       = createMarketDataEvent(numMessages);
+
+    std::vector<std::string> fields;
+    fields.push_back("BID");
+    fields.push_back("ASK");
+    fields.push_back("VOLUME");
+    FieldRegistry fieldRegistry(fields);
+
+    TopicTable topicTable;
+    for (std::size_t i = 0; i < numMessages; ++i) {
+        std::ostringstream topic;
+        topic << "/ticker/SYM" << i << " US Equity";
+        topicTable.add(topic.str());
+    }
+
+    NullNotifier   notifier;
+    ComputeEngine  computeEngine;
+    EventProcessor eventProcessor(
+        &notifier, &computeEngine, 0, &topicTable, &fieldRegistry);
+
+    for (auto _ : state) {
+        eventProcessor.processEvent(event, 0);
+    }
+    benchmark::DoNotOptimize(notifier.d_values);
+    state.SetItemsProcessed(state.iterations() * numMessages);
+}
+BENCHMARK(BM_ProcessEvent)->Arg(1)->Arg(10)->Arg(100);
@@ -0,0 +1,105 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <fieldregistry.h>
+#include <testSchemas.h>
+
+#include <blpapi_event.h>
+#include <blpapi_message.h>
+#include <blpapi_service.h>
+#include <blpapi_testutil.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace blp    = BloombergLP::blpapi;
+namespace blptst = blp::test;
+
+namespace {
+const blp::Name MKTDATA_EVENTS("MarketDataEvents");
+
+const char *const FIELDS[] = { "LAST_PRICE", "BID", "ASK", "VOLUME" };
+const std::size_t NUM_FIELDS = sizeof(FIELDS) / sizeof(FIELDS[0]);
+
+blp::Event createMarketDataEvent()
+{
+    std::istringstream schemaStream(getMktDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+
+    blp::Event event =
+        blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    blptst::MessageFormatter formatter = blptst::TestUtil::appendMessage(
+        event, service.getEventDefinition(MKTDATA_EVENTS));
+    formatter.formatMessageJson("{"
+                                "\"LAST_PRICE\": 142.80,"
+                                "\"BID\": 142.75,"
+                                "\"ASK\": 142.85,"
+                                "\"VOLUME\": 1200"
+                                "}");
+    return event;
+}
+
+blp::Message firstMessage(const blp::Event& event)
+{
+    blp::MessageIterator iter(event);
+    iter.next();
+    return iter.message();
+}
+}
+
+// The lookup 'EventProcessor' used to do: 'hasElement' followed by
+// 'getElementAsFloat64', both by C string, for every field.
+static void BM_CStringFieldLookup(benchmark::State& state)
+{
+    blp::Event   event = createMarketDataEvent();
+    blp::Message msg   = firstMessage(event);
+
+    for (auto _ : state) {
+        double sum = 0;
+        for (std::size_t i = 0; i < NUM_FIELDS; ++i) {
+            if (msg.hasElement(FIELDS[i])) {
+                sum += msg.getElementAsFloat64(FIELDS[i]);
+            }
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_FIELDS);
+}
+BENCHMARK(BM_CStringFieldLookup);
+
+// A single lookup per field by pre-interned 'blp::Name'.
+static void BM_FieldRegistryExtract(benchmark::State& state)
+{
+    blp::Event    event = createMarketDataEvent();
+    blp::Message  msg   = firstMessage(event);
+    FieldRegistry registry(
+        std::vector<std::string>(FIELDS, FIELDS + NUM_FIELDS));
+
+    FieldValues values;
+    for (auto _ : state) {
+        registry.extract(&values, msg);
+        benchmark::DoNotOptimize(values);
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_FIELDS);
+}
+BENCHMARK(BM_FieldRegistryExtract);
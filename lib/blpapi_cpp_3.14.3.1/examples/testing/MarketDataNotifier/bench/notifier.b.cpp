@@ -0,0 +1,107 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <bufferednotifier.h>
+#include <notifier.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <streambuf>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+// Formats like any stream buffer but discards the characters, so that the
+// cost of 'std::cout' formatting and flushing is measured without a
+// terminal.
+class NullBuffer : public std::streambuf {
+  protected:
+    virtual int overflow(int c)
+    {
+        return c;
+    }
+
+    virtual std::streamsize xsputn(const char *, std::streamsize count)
+    {
+        return count;
+    }
+};
+}
+
+// 'Notifier' writes and flushes 'std::cout' for every value.
+static void BM_NotifierSendToTerminal(benchmark::State& state)
+{
+    NullBuffer      nullBuffer;
+    std::streambuf *saved = std::cout.rdbuf(&nullBuffer);
+
+    Notifier notifier;
+    double   value = 100.0;
+    for (auto _ : state) {
+        notifier.sendToTerminal(value);
+        value += 0.25;
+    }
+    std::cout.rdbuf(saved);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NotifierSendToTerminal);
+
+// 'SynchronizedNotifier' adds an uncontended lock to the above.
+static void BM_SynchronizedNotifierSendToTerminal(benchmark::State& state)
+{
+    NullBuffer      nullBuffer;
+    std::streambuf *saved = std::cout.rdbuf(&nullBuffer);
+
+    Notifier             console;
+    SynchronizedNotifier notifier(&console);
+    double               value = 100.0;
+    for (auto _ : state) {
+        notifier.sendToTerminal(value);
+        value += 0.25;
+    }
+    std::cout.rdbuf(saved);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SynchronizedNotifierSendToTerminal);
+
+// 'BufferedNotifier' formats into a per-thread buffer that its writer
+// thread writes to /dev/null.
+static void BM_BufferedNotifierSendToTerminal(benchmark::State& state)
+{
+    int fd = ::open("/dev/null", O_WRONLY);
+    if (fd < 0) {
+        state.SkipWithError("cannot open /dev/null");
+        return;
+    }
+    {
+        BufferedNotifier notifier(fd, 64 * 1024, 10);
+        notifier.start();
+        double value = 100.0;
+        for (auto _ : state) {
+            notifier.sendToTerminal(value);
+            value += 0.25;
+        }
+        notifier.stop();
+    }
+    ::close(fd);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BufferedNotifierSendToTerminal);
@@ -0,0 +1,89 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <subscriber.h>
+#include <topictable.h>
+
+#include <blpapi_identity.h>
+#include <blpapi_session.h>
+#include <blpapi_subscriptionlist.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+namespace blp = BloombergLP::blpapi;
+
+namespace {
+// A session that accepts subscriptions without sending them anywhere, so
+// that only building them is measured.  As in the tests, a null handle keeps
+// the session from connecting.
+class NullSession : public blp::Session {
+  public:
+    NullSession()
+    : blp::Session(0)
+    {
+    }
+
+    virtual void subscribe(const blp::SubscriptionList& subscriptions,
+                           const blp::Identity&,
+                           const char *,
+                           int)
+    {
+        benchmark::DoNotOptimize(subscriptions.size());
+    }
+};
+}
+
+// 'Subscriber::subscribe' for 1k to 100k topics, including registering them
+// in a 'TopicTable'.
+static void BM_Subscribe(benchmark::State& state)
+{
+    const std::size_t numTopics = static_cast<std::size_t>(state.range(0));
+
+    std::vector<std::string> topics;
+    for (std::size_t i = 0; i < numTopics; ++i) {
+        std::ostringstream topic;
+        topic << "/ticker/SYM" << i << " US Equity";
+        topics.push_back(topic.str());
+    }
+    std::vector<std::string> fields;
+    fields.push_back("LAST_PRICE");
+    fields.push_back("BID");
+    fields.push_back("ASK");
+    const std::vector<std::string> options;
+
+    NullSession   session;
+    blp::Identity identity;
+    for (auto _ : state) {
+        TopicTable topicTable;
+        Subscriber subscriber(&session, &topicTable);
+        subscriber.subscribe(
+            "//blp/mktdata", topics, fields, options, identity);
+        benchmark::DoNotOptimize(topicTable.size());
+    }
+    state.SetItemsProcessed(state.iterations() * numTopics);
+}
+BENCHMARK(BM_Subscribe)
+    ->RangeMultiplier(10)
+    ->Range(1000, 100000)
+    ->Unit(benchmark::kMillisecond);
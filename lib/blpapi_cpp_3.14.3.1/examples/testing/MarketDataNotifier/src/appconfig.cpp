@@ -66,11 +66,60 @@ const char USAGE[] =
 "\t\t                        for the user\n"
 "\t\tmanual=<app>,<ip>,<usr> as user and application, with manually provided\n"
 "\t\t                        IP address and EMRS user\n"
+"\t[-ring <capacity>]     compute on a dedicated thread fed by a ring of\n"
+"\t                       <capacity> ticks (default: compute inline)\n"
+"\t[-overflow <policy>]   when the ring is full: drop, overwrite or block\n"
+"\t                       (default: drop)\n"
+"\t[-cpu  <cpu>]          pin the compute thread to <cpu> (default: unpinned)\n"
+"\t[-conflate <ms>]       publish only the latest tick of each topic every\n"
+"\t                       <ms> milliseconds; excludes -ring (default: off)\n"
+"\t[-flush <ms>]          buffer notifications and write them in batches at\n"
+"\t                       least every <ms> milliseconds (default: unbuffered)\n"
+"\t[-flushbytes <bytes>]  write a batch once a thread has buffered <bytes>\n"
+"\t                       (default: 65536)\n"
+"\t[-shards <n>]          spread the topics over <n> sessions by consistent\n"
+"\t                       hash; excludes -ring and -conflate (default: 1)\n"
+"\t[-dispatchers <n>]     dispatch events on a pool of <n> threads shared by\n"
+"\t                       all sessions; more than 1 excludes -ring and\n"
+"\t                       -conflate (default: one thread per session)\n"
+"\t[-latency <ms>]        record per-stage tick latencies and print their\n"
+"\t                       percentiles every <ms> milliseconds (default: off)\n"
+"\t[-record <file>]       capture subscription data to <file> for replay\n"
+"\t                       with marketDataReplayer (default: off)\n"
+"\t[-async]               with -auth, start the session and authorize\n"
+"\t                       without blocking; topics are subscribed once\n"
+"\t                       authorized and the identity is re-authorized if\n"
+"\t                       revoked\n"
+"\t[-reauth <seconds>]    with -async, also re-authorize every <seconds>\n"
+"\t                       (default: only when revoked)\n"
+"\t[-lvc <name>]          publish the last value of every field of every\n"
+"\t                       topic in the shared-memory segment <name>, for\n"
+"\t                       readers using lastvaluereader.h (default: off)\n"
+"\t[-ticks <seconds>]     keep every trade in a columnar tick store and\n"
+"\t                       print <seconds> bars of each topic on exit\n"
+"\t                       (default: off)\n"
+"\t[-spill <file>]        with -ticks, spill older chunks of ticks to <file>\n"
+"\t                       (default: keep every tick in memory)\n"
+"\t[-resident <chunks>]   with -spill, chunks of 4096 ticks kept in memory\n"
+"\t                       per topic (default: 16)\n"
 "\n";
 }
 
 AppConfig::AppConfig()
     :   d_port(8194)
+    ,   d_ringCapacity(0)
+    ,   d_overflowPolicy("drop")
+    ,   d_computeCpu(-1)
+    ,   d_conflationMs(0)
+    ,   d_flushMs(0)
+    ,   d_flushBytes(64 * 1024)
+    ,   d_shards(1)
+    ,   d_dispatcherThreads(0)
+    ,   d_latencyReportMs(0)
+    ,   d_asyncAuthorization(false)
+    ,   d_reauthorizeSeconds(0)
+    ,   d_tickBarSeconds(0)
+    ,   d_residentChunks(16)
 {
 }
 
@@ -94,6 +143,44 @@ bool AppConfig::parseCommandLine(int argc, char **argv)
             d_fields.push_back(argv[++i]);
         } else if (!std::strcmp(argv[i], "-o") && i + 1 < argc) {
             d_options.push_back(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-ring") && i + 1 < argc) {
+            d_ringCapacity = std::strtoul(argv[++i], 0, 10);
+        } else if (!std::strcmp(argv[i], "-overflow") && i + 1 < argc) {
+            d_overflowPolicy = argv[++i];
+            if (d_overflowPolicy != "drop"
+                    && d_overflowPolicy != "overwrite"
+                    && d_overflowPolicy != "block") {
+                printUsage();
+                return false;
+            }
+        } else if (!std::strcmp(argv[i], "-cpu") && i + 1 < argc) {
+            d_computeCpu = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-conflate") && i + 1 < argc) {
+            d_conflationMs = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-flush") && i + 1 < argc) {
+            d_flushMs = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-flushbytes") && i + 1 < argc) {
+            d_flushBytes = std::strtoul(argv[++i], 0, 10);
+        } else if (!std::strcmp(argv[i], "-shards") && i + 1 < argc) {
+            d_shards = std::strtoul(argv[++i], 0, 10);
+        } else if (!std::strcmp(argv[i], "-dispatchers") && i + 1 < argc) {
+            d_dispatcherThreads = std::strtoul(argv[++i], 0, 10);
+        } else if (!std::strcmp(argv[i], "-latency") && i + 1 < argc) {
+            d_latencyReportMs = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-record") && i + 1 < argc) {
+            d_recordPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "-async")) {
+            d_asyncAuthorization = true;
+        } else if (!std::strcmp(argv[i], "-reauth") && i + 1 < argc) {
+            d_reauthorizeSeconds = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-lvc") && i + 1 < argc) {
+            d_lastValueCacheName = argv[++i];
+        } else if (!std::strcmp(argv[i], "-ticks") && i + 1 < argc) {
+            d_tickBarSeconds = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-spill") && i + 1 < argc) {
+            d_tickSpillPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "-resident") && i + 1 < argc) {
+            d_residentChunks = std::strtoul(argv[++i], 0, 10);
         } else if (!std::strcmp(argv[i], "-auth") && i + 1 < argc) {
             ++i;
             if (!std::strcmp(argv[i], AUTH_OPTION_NONE)) {
@@ -123,6 +210,31 @@ bool AppConfig::parseCommandLine(int argc, char **argv)
         }
     }
 
+    if (d_ringCapacity > 0 && d_conflationMs > 0) {
+        printUsage();
+        std::cerr << "\n-ring and -conflate are mutually exclusive\n\n";
+        return false;
+    }
+
+    if (d_shards == 0) {
+        printUsage();
+        std::cerr << "\n-shards must be at least 1\n\n";
+        return false;
+    }
+
+    // The compute thread and the conflator are fed by a single producer.
+    if (d_shards > 1 && (d_ringCapacity > 0 || d_conflationMs > 0)) {
+        printUsage();
+        std::cerr << "\n-shards excludes -ring and -conflate\n\n";
+        return false;
+    }
+    if (d_dispatcherThreads > 1
+            && (d_ringCapacity > 0 || d_conflationMs > 0)) {
+        printUsage();
+        std::cerr << "\n-dispatchers excludes -ring and -conflate\n\n";
+        return false;
+    }
+
     if (d_hosts.empty()) {
         d_hosts.push_back("localhost");
     }
@@ -21,6 +21,7 @@
 #ifndef _APPCONFIG_H_
 #define _APPCONFIG_H_
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -33,6 +34,22 @@ class AppConfig {
     std::vector<std::string> d_options;
     std::string              d_authOptions;
     std::string              d_service;
+    std::size_t              d_ringCapacity;    // 0 computes inline
+    std::string              d_overflowPolicy;
+    int                      d_computeCpu;      // -1 leaves it unpinned
+    int                      d_conflationMs;    // 0 disables conflation
+    int                      d_flushMs;         // 0 writes every record
+    std::size_t              d_flushBytes;
+    std::size_t              d_shards;          // sessions to spread over
+    std::size_t              d_dispatcherThreads;  // 0: one per session
+    int                      d_latencyReportMs;    // 0 disables latency
+    std::string              d_recordPath;         // empty disables capture
+    bool                     d_asyncAuthorization;
+    int                      d_reauthorizeSeconds; // 0: only when revoked
+    std::string              d_lastValueCacheName; // empty: no cache
+    int                      d_tickBarSeconds;     // 0: no tick store
+    std::string              d_tickSpillPath;      // empty: never spill
+    std::size_t              d_residentChunks;     // per topic, if spilling
 
     AppConfig();
     bool parseCommandLine(int argc, char **argv);
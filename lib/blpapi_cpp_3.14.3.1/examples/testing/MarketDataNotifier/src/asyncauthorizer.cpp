@@ -0,0 +1,537 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "asyncauthorizer.h"
+
+#include <blpapi_element.h>
+#include <blpapi_exception.h>
+#include <blpapi_message.h>
+#include <blpapi_name.h>
+#include <blpapi_request.h>
+
+namespace blp = BloombergLP::blpapi;
+
+namespace {
+blp::Name SESSION_STARTED("SessionStarted");
+blp::Name SERVICE_OPENED("ServiceOpened");
+blp::Name TOKEN_SUCCESS("TokenGenerationSuccess");
+blp::Name TOKEN("token");
+blp::Name AUTHORIZATION_SUCCESS("AuthorizationSuccess");
+blp::Name AUTHORIZATION_REVOKED("AuthorizationRevoked");
+blp::Name REASON("reason");
+blp::Name DESCRIPTION("description");
+const char AUTH_SERVICE[] = "//blp/apiauth";
+
+// Correlation ids are integers holding the identity's id in the high word
+// and its request sequence in the low word; the class id tells what the
+// request was.  Subscriptions use class id 0 (see 'TopicTable').
+const int k_SERVICE_CLASS = 1;
+const int k_TOKEN_CLASS   = 2;
+const int k_AUTH_CLASS    = 3;
+
+const int k_POLL_MS    = 100;
+const int k_BACKOFF_MS = 500;    // doubled after each failed attempt
+
+std::uint32_t sequenceOf(const blp::CorrelationId& correlationId)
+{
+    return static_cast<std::uint32_t>(correlationId.asInteger());
+}
+
+std::string describe(const blp::Message& message)
+{
+    std::string reason = message.messageType().string();
+    if (message.hasElement(REASON)) {
+        blp::Element element = message.getElement(REASON);
+        if (element.hasElement(DESCRIPTION)) {
+            reason += ": ";
+            reason += element.getElementAsString(DESCRIPTION);
+        }
+    }
+    return reason;
+}
+}
+
+AsyncAuthorizer::AsyncAuthorizer(blp::Session           *session,
+                                 blp::EventHandler      *handler,
+                                 IAuthorizationListener *listener,
+                                 int                     timeoutMs,
+                                 int                     refreshMs)
+: d_session(session)
+, d_handler(handler)
+, d_listener(listener)
+, d_timeout(std::chrono::milliseconds(timeoutMs))
+, d_refresh(std::chrono::milliseconds(refreshMs > 0 ? refreshMs : 0))
+, d_serviceState(e_SESSION_DOWN)
+, d_running(false)
+{
+    d_statistics.d_authorized = 0;
+    d_statistics.d_revoked    = 0;
+    d_statistics.d_timedOut   = 0;
+    d_statistics.d_failures   = 0;
+}
+
+AsyncAuthorizer::~AsyncAuthorizer()
+{
+    stop();
+}
+
+std::size_t AsyncAuthorizer::addIdentity(const std::string& userId,
+                                         const std::string& ipAddress)
+{
+    Notifications notifications;
+    std::size_t   id;
+    {
+        std::lock_guard<std::mutex> guard(d_mutex);
+        id = d_entries.size();
+
+        std::unique_ptr<Entry> entry(new Entry);
+        entry->d_userId             = userId;
+        entry->d_ipAddress          = ipAddress;
+        entry->d_state              = e_PENDING;
+        entry->d_sequence           = 0;
+        entry->d_authorizedSequence = 0;
+        entry->d_attempts           = 0;
+        entry->d_deadline           = Clock::time_point::max();
+        entry->d_isCreated          = false;
+        entry->d_hasIdentity        = false;
+        d_entries.push_back(std::move(entry));
+
+        if (d_serviceState == e_CLOSED) {
+            openService();
+        }
+        else if (d_serviceState == e_OPEN) {
+            begin(&notifications, id, Clock::now());
+        }
+    }
+    notify(notifications);
+    return id;
+}
+
+bool AsyncAuthorizer::start()
+{
+    if (d_thread.joinable()) {
+        return false;
+    }
+
+    d_running = true;
+    d_thread  = std::thread(&AsyncAuthorizer::run, this);
+    return true;
+}
+
+void AsyncAuthorizer::stop()
+{
+    if (!d_thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(d_mutex);
+        d_running = false;
+    }
+    d_condition.notify_one();
+    d_thread.join();
+}
+
+void AsyncAuthorizer::run()
+{
+    std::unique_lock<std::mutex> lock(d_mutex);
+    while (d_running) {
+        if (d_condition.wait_for(lock, std::chrono::milliseconds(k_POLL_MS))
+                    == std::cv_status::timeout
+                && d_running) {
+            lock.unlock();
+            poll(Clock::now());
+            lock.lock();
+        }
+    }
+}
+
+bool AsyncAuthorizer::processEvent(const blp::Event&  event,
+                                   blp::Session      *session)
+{
+    const blp::Event::EventType eventType = event.eventType();
+    switch (eventType) {
+      case blp::Event::SESSION_STATUS:
+      case blp::Event::SERVICE_STATUS:
+      case blp::Event::TOKEN_STATUS:
+      case blp::Event::RESPONSE:
+      case blp::Event::PARTIAL_RESPONSE:
+      case blp::Event::REQUEST_STATUS:
+      case blp::Event::AUTHORIZATION_STATUS:
+        break;
+      default:
+        return d_handler->processEvent(event, session);
+    }
+
+    Notifications notifications;
+    bool          forward = false;
+    {
+        std::lock_guard<std::mutex> guard(d_mutex);
+        const Clock::time_point     now = Clock::now();
+        blp::MessageIterator        iter(event);
+        while (iter.next()) {
+            if (!handleMessage(&notifications,
+                               iter.message(),
+                               eventType,
+                               now)) {
+                forward = true;
+            }
+        }
+    }
+    notify(notifications);
+
+    return forward ? d_handler->processEvent(event, session) : true;
+}
+
+bool AsyncAuthorizer::handleMessage(Notifications         *notifications,
+                                    const blp::Message&    message,
+                                    blp::Event::EventType  eventType,
+                                    Clock::time_point      now)
+{
+    const blp::Name type = message.messageType();
+    if (eventType == blp::Event::SESSION_STATUS) {
+        if (type == SESSION_STARTED && d_serviceState == e_SESSION_DOWN) {
+            d_serviceState = e_CLOSED;
+            if (!d_entries.empty()) {
+                openService();
+            }
+        }
+        return false;
+    }
+
+    if (message.numCorrelationIds() == 0) {
+        return false;
+    }
+    const blp::CorrelationId cid = message.correlationId();
+    if (cid.valueType() != blp::CorrelationId::INT_VALUE) {
+        return false;
+    }
+
+    if (cid.classId() == k_SERVICE_CLASS) {
+        if (type == SERVICE_OPENED) {
+            d_service      = d_session->getService(AUTH_SERVICE);
+            d_serviceState = e_OPEN;
+            for (std::size_t id = 0; id < d_entries.size(); ++id) {
+                if (d_entries[id]->d_state == e_PENDING) {
+                    begin(notifications, id, now);
+                }
+            }
+        }
+        else {
+            d_serviceState = e_UNAVAILABLE;
+            for (std::size_t id = 0; id < d_entries.size(); ++id) {
+                if (d_entries[id]->d_state == e_PENDING) {
+                    d_entries[id]->d_state = e_FAILED;
+                    Notification notification;
+                    notification.d_id         = id;
+                    notification.d_authorized = false;
+                    notification.d_reason     = describe(message);
+                    notifications->push_back(notification);
+                }
+            }
+        }
+        return true;
+    }
+
+    if (cid.classId() != k_TOKEN_CLASS && cid.classId() != k_AUTH_CLASS) {
+        return false;
+    }
+
+    std::size_t id;
+    Entry      *entry = find(&id, cid);
+    if (!entry) {
+        return false;
+    }
+    const std::uint32_t sequence = sequenceOf(cid);
+
+    if (type == AUTHORIZATION_REVOKED) {
+        ++d_statistics.d_revoked;
+        if (entry->d_state == e_AUTHORIZED
+                && sequence == entry->d_authorizedSequence) {
+            entry->d_attempts = 0;
+            begin(notifications, id, now);
+        }
+        return true;
+    }
+
+    // Anything else is for the request in flight, or for one that was
+    // given up on.
+    if (sequence != entry->d_sequence) {
+        return true;
+    }
+
+    if (cid.classId() == k_TOKEN_CLASS) {
+        if (entry->d_state != e_GENERATING_TOKEN) {
+            return true;
+        }
+        if (type == TOKEN_SUCCESS) {
+            authorize(notifications,
+                      id,
+                      message.getElementAsString(TOKEN),
+                      now);
+        }
+        else {
+            ++d_statistics.d_failures;
+            retry(notifications, id, describe(message), now);
+        }
+        return true;
+    }
+
+    if (entry->d_state != e_AUTHORIZING) {
+        return true;
+    }
+    if (type == AUTHORIZATION_SUCCESS) {
+        entry->d_hasIdentity        = true;
+        entry->d_authorizedSequence = sequence;
+        entry->d_state              = e_AUTHORIZED;
+        entry->d_attempts           = 0;
+        entry->d_deadline           = d_refresh > Clock::duration::zero()
+                                    ? now + d_refresh
+                                    : Clock::time_point::max();
+        ++d_statistics.d_authorized;
+
+        Notification notification;
+        notification.d_id         = id;
+        notification.d_authorized = true;
+        notification.d_identity   = entry->d_identity;
+        notifications->push_back(notification);
+    }
+    else {
+        ++d_statistics.d_failures;
+        retry(notifications, id, describe(message), now);
+    }
+    return true;
+}
+
+void AsyncAuthorizer::openService()
+{
+    d_serviceState = e_OPENING;
+    d_session->openServiceAsync(AUTH_SERVICE,
+                                blp::CorrelationId(0LL, k_SERVICE_CLASS));
+}
+
+void AsyncAuthorizer::begin(Notifications     *notifications,
+                            std::size_t        id,
+                            Clock::time_point  now)
+{
+    Entry& entry = *d_entries[id];
+    ++entry.d_sequence;
+    entry.d_state    = e_GENERATING_TOKEN;
+    entry.d_deadline = now + d_timeout;
+
+    const blp::CorrelationId cid = correlationId(id, k_TOKEN_CLASS);
+    try {
+        if (entry.d_userId.empty()) {
+            d_session->generateToken(cid);
+        }
+        else {
+            d_session->generateToken(entry.d_userId.c_str(),
+                                     entry.d_ipAddress.c_str(),
+                                     cid);
+        }
+    }
+    catch (blp::Exception& e) {
+        retry(notifications, id, e.description(), now);
+    }
+}
+
+void AsyncAuthorizer::authorize(Notifications      *notifications,
+                                std::size_t         id,
+                                const std::string&  token,
+                                Clock::time_point   now)
+{
+    Entry& entry = *d_entries[id];
+    entry.d_state    = e_AUTHORIZING;
+    entry.d_deadline = now + d_timeout;
+
+    try {
+        blp::Request request = d_service.createAuthorizationRequest();
+        request.set(TOKEN, token.c_str());
+
+        // Re-authorizing the same identity keeps the subscriptions made with
+        // it entitled; the request it replaces would otherwise stay open.
+        if (!entry.d_isCreated) {
+            entry.d_identity  = d_session->createIdentity();
+            entry.d_isCreated = true;
+        }
+        if (entry.d_hasIdentity) {
+            try {
+                d_session->cancel(correlationId(id,
+                                                k_AUTH_CLASS,
+                                                entry.d_authorizedSequence));
+            }
+            catch (blp::Exception&) {
+                // The request may have been terminated already.
+            }
+        }
+        d_session->sendAuthorizationRequest(request,
+                                            &entry.d_identity,
+                                            correlationId(id, k_AUTH_CLASS));
+    }
+    catch (blp::Exception& e) {
+        retry(notifications, id, e.description(), now);
+    }
+}
+
+void AsyncAuthorizer::retry(Notifications      *notifications,
+                            std::size_t         id,
+                            const std::string&  reason,
+                            Clock::time_point   now)
+{
+    Entry& entry = *d_entries[id];
+    if (++entry.d_attempts >= k_MAX_ATTEMPTS) {
+        entry.d_state    = e_FAILED;
+        entry.d_deadline = Clock::time_point::max();
+
+        Notification notification;
+        notification.d_id         = id;
+        notification.d_authorized = false;
+        notification.d_reason     = reason;
+        notifications->push_back(notification);
+        return;
+    }
+
+    entry.d_state    = e_BACKING_OFF;
+    entry.d_deadline = now + std::chrono::milliseconds(
+                                   k_BACKOFF_MS << (entry.d_attempts - 1));
+}
+
+void AsyncAuthorizer::poll(Clock::time_point now)
+{
+    Notifications notifications;
+    {
+        std::lock_guard<std::mutex> guard(d_mutex);
+        for (std::size_t id = 0; id < d_entries.size(); ++id) {
+            Entry& entry = *d_entries[id];
+            if (now < entry.d_deadline) {
+                continue;
+            }
+
+            switch (entry.d_state) {
+              case e_GENERATING_TOKEN:
+              case e_AUTHORIZING: {
+                ++d_statistics.d_timedOut;
+                try {
+                    d_session->cancel(correlationId(
+                                        id,
+                                        entry.d_state == e_AUTHORIZING
+                                            ? k_AUTH_CLASS
+                                            : k_TOKEN_CLASS));
+                }
+                catch (blp::Exception&) {
+                    // The request may have completed meanwhile.
+                }
+                retry(&notifications, id, "Timed out", now);
+              } break;
+              case e_BACKING_OFF: {
+                begin(&notifications, id, now);
+              } break;
+              case e_AUTHORIZED: {
+                entry.d_attempts = 0;
+                begin(&notifications, id, now);
+              } break;
+              default: {
+                entry.d_deadline = Clock::time_point::max();
+              } break;
+            }
+        }
+    }
+    notify(notifications);
+}
+
+AsyncAuthorizer::Entry *AsyncAuthorizer::find(
+                                  std::size_t               *id,
+                                  const blp::CorrelationId&  correlationId)
+{
+    *id = static_cast<std::size_t>(
+            static_cast<unsigned long long>(correlationId.asInteger()) >> 32);
+    return *id < d_entries.size() ? d_entries[*id].get() : 0;
+}
+
+blp::CorrelationId AsyncAuthorizer::correlationId(std::size_t id,
+                                                  int         classId) const
+{
+    return correlationId(id, classId, d_entries[id]->d_sequence);
+}
+
+blp::CorrelationId AsyncAuthorizer::correlationId(std::size_t   id,
+                                                  int           classId,
+                                                  std::uint32_t sequence)
+{
+    const unsigned long long value =
+                    static_cast<unsigned long long>(id) << 32 | sequence;
+    return blp::CorrelationId(static_cast<long long>(value), classId);
+}
+
+void AsyncAuthorizer::notify(const Notifications& notifications)
+{
+    for (std::size_t i = 0; i < notifications.size(); ++i) {
+        const Notification& notification = notifications[i];
+        if (notification.d_authorized) {
+            d_listener->onAuthorized(notification.d_id,
+                                     notification.d_identity);
+        }
+        else {
+            d_listener->onAuthorizationFailed(notification.d_id,
+                                              notification.d_reason);
+        }
+    }
+}
+
+AsyncAuthorizer::State AsyncAuthorizer::state(std::size_t id) const
+{
+    std::lock_guard<std::mutex> guard(d_mutex);
+    return d_entries[id]->d_state;
+}
+
+blp::Identity AsyncAuthorizer::identity(std::size_t id) const
+{
+    std::lock_guard<std::mutex> guard(d_mutex);
+    return d_entries[id]->d_hasIdentity ? d_entries[id]->d_identity
+                                        : blp::Identity();
+}
+
+AsyncAuthorizer::Statistics AsyncAuthorizer::statistics() const
+{
+    std::lock_guard<std::mutex> guard(d_mutex);
+    return d_statistics;
+}
+
+const char *AsyncAuthorizer::stateName(State state)
+{
+    switch (state) {
+      case e_PENDING:          return "PENDING";
+      case e_GENERATING_TOKEN: return "GENERATING_TOKEN";
+      case e_AUTHORIZING:      return "AUTHORIZING";
+      case e_AUTHORIZED:       return "AUTHORIZED";
+      case e_BACKING_OFF:      return "BACKING_OFF";
+      case e_FAILED:           return "FAILED";
+    }
+    return "UNKNOWN";
+}
+
+std::ostream& operator<<(std::ostream&                      stream,
+                         const AsyncAuthorizer::Statistics& stats)
+{
+    return stream << "authorized=" << stats.d_authorized
+                  << " revoked=" << stats.d_revoked
+                  << " timedOut=" << stats.d_timedOut
+                  << " failures=" << stats.d_failures;
+}
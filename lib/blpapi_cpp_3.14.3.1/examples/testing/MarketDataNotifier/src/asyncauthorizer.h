@@ -0,0 +1,246 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _ASYNCAUTHORIZER_H_
+#define _ASYNCAUTHORIZER_H_
+
+#include <blpapi_correlationid.h>
+#include <blpapi_event.h>
+#include <blpapi_identity.h>
+#include <blpapi_service.h>
+#include <blpapi_session.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace blp = BloombergLP::blpapi;
+
+class IAuthorizationListener {
+  public:
+    virtual void onAuthorized(std::size_t          id,
+                              const blp::Identity& identity) = 0;
+        // Called each time the identity 'id' is authorized, the first time
+        // and after every re-authorization.  'identity' is the same every
+        // time, updated in place, so subscriptions made with it once stay
+        // entitled.
+
+    virtual void onAuthorizationFailed(std::size_t        id,
+                                       const std::string& reason) = 0;
+        // Called once the identity 'id' has failed to be authorized after
+        // every retry.  An identity reported before stays usable until the
+        // service revokes it.
+
+    virtual ~IAuthorizationListener() {}
+};
+
+// AsyncAuthorizer authorizes identities without blocking any thread.  It is
+// installed as the session's 'EventHandler' in front of another handler, to
+// which it forwards every event it does not own, so subscription data is
+// never held up by authorization.  Each identity goes through
+//
+//: e_PENDING            waiting for "//blp/apiauth" to open
+//: e_GENERATING_TOKEN   'generateToken' sent
+//: e_AUTHORIZING        authorization request sent with the token
+//: e_AUTHORIZED         reported to the listener
+//: e_BACKING_OFF        waiting to retry after a failure or timeout
+//: e_FAILED             gave up after 'k_MAX_ATTEMPTS'
+//
+// driven by the events the session delivers for its requests, so any number
+// of identities are authorized concurrently.  The authorization service is
+// opened with 'openServiceAsync' once the session has started (see
+// 'blp::Session::startAsync').  An identity is re-authorized when the
+// service revokes it, and, if 'refreshMs' is positive, that long after each
+// authorization, before its token is likely to expire.  Every
+// authorization request of an identity is sent for the same 'blp::Identity',
+// which the SDK updates in place on success and leaves unchanged on failure,
+// so it stays usable while it is re-authorized and subscriptions made with
+// it need not be made again.  The previous authorization request is
+// cancelled when a new one is sent.
+//
+// Once 'start'ed, a timer thread calls 'poll' to expire requests not
+// answered within 'timeoutMs' and to start retries and refreshes.  Events
+// may be delivered by several dispatcher threads.  The listener is called
+// without any lock held, from a dispatcher thread or the timer thread.
+class AsyncAuthorizer : public blp::EventHandler {
+  public:
+    typedef std::chrono::steady_clock Clock;
+
+    enum State {
+        e_PENDING,
+        e_GENERATING_TOKEN,
+        e_AUTHORIZING,
+        e_AUTHORIZED,
+        e_BACKING_OFF,
+        e_FAILED
+    };
+
+    struct Statistics {
+        std::uint64_t d_authorized;     // successful authorizations
+        std::uint64_t d_revoked;        // revocations received
+        std::uint64_t d_timedOut;       // requests that were not answered
+        std::uint64_t d_failures;       // failure responses
+    };
+
+    static const int k_MAX_ATTEMPTS = 5;
+
+  private:
+    struct Entry {
+        std::string       d_userId;      // empty unless authorized manually
+        std::string       d_ipAddress;
+        State             d_state;
+        std::uint32_t     d_sequence;    // of the request in flight
+        std::uint32_t     d_authorizedSequence;
+        int               d_attempts;
+        Clock::time_point d_deadline;    // of the request, retry or refresh
+        blp::Identity     d_identity;    // authorized in place
+        bool              d_isCreated;   // 'd_identity' was created
+        bool              d_hasIdentity; // 'd_identity' was authorized
+    };
+
+    enum ServiceState {
+        e_SESSION_DOWN,
+        e_CLOSED,
+        e_OPENING,
+        e_OPEN,
+        e_UNAVAILABLE
+    };
+
+    struct Notification {
+        std::size_t   d_id;
+        bool          d_authorized;
+        blp::Identity d_identity;
+        std::string   d_reason;
+    };
+
+    typedef std::vector<Notification> Notifications;
+
+    blp::Session                         *d_session;
+    blp::EventHandler                    *d_handler;
+    IAuthorizationListener               *d_listener;
+    Clock::duration                       d_timeout;
+    Clock::duration                       d_refresh;    // zero: never
+    mutable std::mutex                    d_mutex;
+    ServiceState                          d_serviceState;
+    blp::Service                          d_service;
+    std::vector<std::unique_ptr<Entry> >  d_entries;
+    Statistics                            d_statistics;
+    std::thread                           d_thread;
+    std::condition_variable               d_condition;
+    bool                                  d_running;
+
+    AsyncAuthorizer(const AsyncAuthorizer&);
+    AsyncAuthorizer& operator=(const AsyncAuthorizer&);
+
+    void run();
+
+    bool handleMessage(Notifications          *notifications,
+                       const blp::Message&     message,
+                       blp::Event::EventType   eventType,
+                       Clock::time_point       now);
+        // Advance the state machine the specified 'message' belongs to and
+        // return 'true', or return 'false' if it is not an authorization
+        // message.  The caller holds 'd_mutex'.
+
+    void openService();
+
+    void begin(Notifications     *notifications,
+               std::size_t        id,
+               Clock::time_point  now);
+        // Request a token for the identity 'id'.
+
+    void authorize(Notifications      *notifications,
+                   std::size_t         id,
+                   const std::string&  token,
+                   Clock::time_point   now);
+        // Send an authorization request for 'id' with 'token'.
+
+    void retry(Notifications      *notifications,
+               std::size_t         id,
+               const std::string&  reason,
+               Clock::time_point   now);
+        // Back off before the next attempt for 'id', or give up on it after
+        // 'k_MAX_ATTEMPTS'.
+
+    Entry *find(std::size_t *id, const blp::CorrelationId& correlationId);
+        // Load into 'id' the id of the identity 'correlationId' was made
+        // for and return its entry, or 0 if there is none.
+
+    blp::CorrelationId correlationId(std::size_t id, int classId) const;
+        // Return the id of the request in flight for 'id'.
+
+    static blp::CorrelationId correlationId(std::size_t   id,
+                                            int           classId,
+                                            std::uint32_t sequence);
+
+    void notify(const Notifications& notifications);
+
+  public:
+    AsyncAuthorizer(blp::Session           *session,
+                    blp::EventHandler      *handler,
+                    IAuthorizationListener *listener,
+                    int                     timeoutMs = 10000,
+                    int                     refreshMs = 0);
+        // Create an authorizer for 'session' forwarding non-authorization
+        // events to 'handler'.  'session' is only used once events arrive or
+        // 'poll' is called, so it may be constructed after this object.
+
+    ~AsyncAuthorizer();
+
+    std::size_t addIdentity(const std::string& userId    = std::string(),
+                            const std::string& ipAddress = std::string());
+        // Add an identity to authorize and return its id.  The identity is
+        // authorized with a token generated from the session's
+        // authentication options, or, if 'userId' is given, from 'userId'
+        // and 'ipAddress'.  Authorization starts as soon as the service is
+        // open.
+
+    bool start();
+
+    void stop();
+
+    virtual bool processEvent(const blp::Event& event, blp::Session *session);
+
+    void poll(Clock::time_point now);
+        // Expire unanswered requests and start the retries and refreshes
+        // that are due at 'now'.
+
+    State state(std::size_t id) const;
+
+    blp::Identity identity(std::size_t id) const;
+        // Return the identity last authorized for 'id', which is invalid if
+        // there was none.
+
+    Statistics statistics() const;
+
+    static const char *stateName(State state);
+};
+
+std::ostream& operator<<(std::ostream&                      stream,
+                         const AsyncAuthorizer::Statistics& stats);
+
+#endif
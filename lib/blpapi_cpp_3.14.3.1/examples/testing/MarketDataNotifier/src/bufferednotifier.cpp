@@ -0,0 +1,385 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "bufferednotifier.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const char SESSION_STATE[]      = "Logging Session state with:\n";
+const char SUBSCRIPTION_STATE[] = "Logging Subscription state with:\n";
+
+std::atomic<std::uint64_t> s_nextId(1);
+
+std::uint64_t nanosecondsBetween(std::chrono::steady_clock::time_point start,
+                                 std::chrono::steady_clock::time_point end)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               end - start).count();
+}
+
+void updateMax(std::atomic<std::uint64_t> *max, std::uint64_t value)
+{
+    if (value > max->load(std::memory_order_relaxed)) {
+        max->store(value, std::memory_order_relaxed);
+    }
+}
+
+struct Chunk {
+    const char  *d_data;
+    std::size_t  d_length;
+};
+
+void writeAll(int fd, std::vector<Chunk> *chunks)
+{
+#if defined(_WIN32)
+    for (std::size_t i = 0; i < chunks->size(); ++i) {
+        const char  *data   = (*chunks)[i].d_data;
+        std::size_t  length = (*chunks)[i].d_length;
+        while (length > 0) {
+            int written = _write(fd, data, static_cast<unsigned>(length));
+            if (written <= 0) {
+                return;
+            }
+            data   += written;
+            length -= written;
+        }
+    }
+#else
+#ifdef IOV_MAX
+    const std::size_t k_MAX_IOV = IOV_MAX;
+#else
+    const std::size_t k_MAX_IOV = 16;
+#endif
+    std::vector<iovec> iov(chunks->size());
+    for (std::size_t i = 0; i < chunks->size(); ++i) {
+        iov[i].iov_base = const_cast<char *>((*chunks)[i].d_data);
+        iov[i].iov_len  = (*chunks)[i].d_length;
+    }
+
+    std::size_t first = 0;
+    while (first < iov.size()) {
+        std::size_t count = iov.size() - first;
+        if (count > k_MAX_IOV) {
+            count = k_MAX_IOV;
+        }
+        ssize_t written = ::writev(fd, &iov[first], static_cast<int>(count));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+
+        // Skip what was written; a partial write resumes mid-chunk.
+        std::size_t remaining = static_cast<std::size_t>(written);
+        while (first < iov.size() && remaining >= iov[first].iov_len) {
+            remaining -= iov[first].iov_len;
+            ++first;
+        }
+        if (remaining > 0) {
+            iov[first].iov_base =
+                static_cast<char *>(iov[first].iov_base) + remaining;
+            iov[first].iov_len -= remaining;
+        }
+    }
+#endif
+}
+}
+
+BufferedNotifier::BufferedNotifier(int         fd,
+                                   std::size_t flushBytes,
+                                   int         flushIntervalMs)
+: d_id(s_nextId++)
+, d_fd(fd)
+, d_flushBytes(flushBytes ? flushBytes : 1)
+, d_capacity(4 * d_flushBytes)
+, d_flushInterval(flushIntervalMs)
+, d_flushRequested(false)
+, d_running(false)
+, d_records(0)
+, d_stalls(0)
+, d_bytes(0)
+, d_batches(0)
+, d_flushLatencyTotalNs(0)
+, d_flushLatencyMaxNs(0)
+, d_maxRecordAgeNs(0)
+{
+}
+
+BufferedNotifier::~BufferedNotifier()
+{
+    stop();
+}
+
+bool BufferedNotifier::start()
+{
+    std::lock_guard<std::mutex> guard(d_mutex);
+    if (d_writer.joinable()) {
+        return false;
+    }
+    d_running = true;
+    d_writer  = std::thread(&BufferedNotifier::run, this);
+    return true;
+}
+
+void BufferedNotifier::stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(d_mutex);
+        d_running = false;
+    }
+    d_wakeup.notify_one();
+    if (d_writer.joinable()) {
+        d_writer.join();
+    }
+    flush();
+}
+
+BufferedNotifier::ThreadBuffer *BufferedNotifier::localBuffer()
+{
+    // Cache the calling thread's buffer; the notifier id, unlike its
+    // address, is never reused.  The cache holds one notifier, so a thread
+    // that alternates between notifiers finds its buffer again by thread id
+    // rather than allocating another one on every switch.
+    static thread_local std::uint64_t  t_ownerId = 0;
+    static thread_local ThreadBuffer  *t_buffer  = 0;
+
+    if (t_ownerId != d_id) {
+        const std::thread::id self = std::this_thread::get_id();
+
+        std::lock_guard<std::mutex> guard(d_buffersMutex);
+        ThreadBuffer *found = 0;
+        for (std::size_t i = 0; i < d_buffers.size(); ++i) {
+            if (d_buffers[i]->d_owner == self) {
+                found = d_buffers[i].get();
+                break;
+            }
+        }
+        if (!found) {
+            std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer);
+            buffer->d_owner = self;
+            buffer->d_active.reserve(d_capacity);
+            buffer->d_flushing.reserve(d_capacity);
+            d_buffers.push_back(std::move(buffer));
+            found = d_buffers.back().get();
+        }
+        t_buffer  = found;
+        t_ownerId = d_id;
+    }
+    return t_buffer;
+}
+
+void BufferedNotifier::requestFlush()
+{
+    {
+        std::lock_guard<std::mutex> guard(d_mutex);
+        if (!d_running) {
+            return;
+        }
+        d_flushRequested = true;
+    }
+    d_wakeup.notify_one();
+}
+
+void BufferedNotifier::append(const char *data, std::size_t length)
+{
+    ThreadBuffer *buffer = localBuffer();
+    bool          full   = false;
+    {
+        std::unique_lock<std::mutex> lock(buffer->d_mutex);
+        if (!buffer->d_active.empty()
+                && buffer->d_active.size() + length > d_capacity) {
+            d_stalls.fetch_add(1, std::memory_order_relaxed);
+        }
+        while (!buffer->d_active.empty()
+                   && buffer->d_active.size() + length > d_capacity) {
+            bool running;
+            {
+                std::lock_guard<std::mutex> guard(d_mutex);
+                running = d_running;
+            }
+            if (running) {
+                requestFlush();
+                buffer->d_drained.wait_for(lock, d_flushInterval);
+            }
+            else {
+                lock.unlock();
+                flush();
+                lock.lock();
+            }
+        }
+
+        if (buffer->d_active.empty()) {
+            buffer->d_oldest = std::chrono::steady_clock::now();
+        }
+        buffer->d_active.insert(buffer->d_active.end(), data, data + length);
+        full = buffer->d_active.size() >= d_flushBytes;
+    }
+    d_records.fetch_add(1, std::memory_order_relaxed);
+
+    if (full) {
+        requestFlush();
+    }
+}
+
+void BufferedNotifier::run()
+{
+    std::unique_lock<std::mutex> lock(d_mutex);
+    while (d_running) {
+        if (!d_flushRequested) {
+            d_wakeup.wait_for(lock, d_flushInterval);
+        }
+        d_flushRequested = false;
+        lock.unlock();
+        flush();
+        lock.lock();
+    }
+}
+
+void BufferedNotifier::flush()
+{
+    std::lock_guard<std::mutex> flushGuard(d_flushMutex);
+
+    std::vector<ThreadBuffer *> buffers;
+    {
+        std::lock_guard<std::mutex> guard(d_buffersMutex);
+        for (std::size_t i = 0; i < d_buffers.size(); ++i) {
+            buffers.push_back(d_buffers[i].get());
+        }
+    }
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point oldest = start;
+
+    std::vector<Chunk> chunks;
+    std::size_t        bytes = 0;
+    for (std::size_t i = 0; i < buffers.size(); ++i) {
+        ThreadBuffer *buffer = buffers[i];
+        {
+            std::lock_guard<std::mutex> guard(buffer->d_mutex);
+            if (buffer->d_active.empty()) {
+                continue;
+            }
+            buffer->d_active.swap(buffer->d_flushing);
+            if (buffer->d_oldest < oldest) {
+                oldest = buffer->d_oldest;
+            }
+        }
+        buffer->d_drained.notify_all();
+
+        Chunk chunk = { buffer->d_flushing.data(),
+                        buffer->d_flushing.size() };
+        chunks.push_back(chunk);
+        bytes += chunk.d_length;
+    }
+
+    if (chunks.empty()) {
+        return;
+    }
+
+    writeAll(d_fd, &chunks);
+
+    for (std::size_t i = 0; i < buffers.size(); ++i) {
+        buffers[i]->d_flushing.clear();
+    }
+
+    std::chrono::steady_clock::time_point end =
+        std::chrono::steady_clock::now();
+    std::uint64_t latency = nanosecondsBetween(start, end);
+    d_bytes.store(d_bytes.load(std::memory_order_relaxed) + bytes,
+                  std::memory_order_relaxed);
+    d_batches.store(d_batches.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_relaxed);
+    d_flushLatencyTotalNs.store(
+        d_flushLatencyTotalNs.load(std::memory_order_relaxed) + latency,
+        std::memory_order_relaxed);
+    updateMax(&d_flushLatencyMaxNs, latency);
+    updateMax(&d_maxRecordAgeNs, nanosecondsBetween(oldest, end));
+}
+
+void BufferedNotifier::logSessionState(const blp::Message& msg)
+{
+    std::ostringstream stream;
+    stream << SESSION_STATE;
+    msg.print(stream) << '\n';
+    const std::string& record = stream.str();
+    append(record.data(), record.size());
+}
+
+void BufferedNotifier::logSubscriptionState(const blp::Message& msg)
+{
+    std::ostringstream stream;
+    stream << SUBSCRIPTION_STATE;
+    msg.print(stream) << '\n';
+    const std::string& record = stream.str();
+    append(record.data(), record.size());
+}
+
+void BufferedNotifier::sendToTerminal(double value)
+{
+    // "%g" matches the default 'std::ostream' formatting of 'Notifier'.
+    char record[64];
+    int  length = std::snprintf(record, sizeof(record), "VALUE = %g\n", value);
+    append(record, static_cast<std::size_t>(length));
+}
+
+BufferedNotifier::Statistics BufferedNotifier::statistics() const
+{
+    Statistics stats;
+    stats.d_records = d_records.load(std::memory_order_relaxed);
+    stats.d_bytes   = d_bytes.load(std::memory_order_relaxed);
+    stats.d_batches = d_batches.load(std::memory_order_relaxed);
+    stats.d_flushLatencyTotalNs =
+        d_flushLatencyTotalNs.load(std::memory_order_relaxed);
+    stats.d_flushLatencyMaxNs =
+        d_flushLatencyMaxNs.load(std::memory_order_relaxed);
+    stats.d_maxRecordAgeNs = d_maxRecordAgeNs.load(std::memory_order_relaxed);
+    stats.d_stalls         = d_stalls.load(std::memory_order_relaxed);
+    return stats;
+}
+
+std::ostream& operator<<(std::ostream&                       stream,
+                         const BufferedNotifier::Statistics& stats)
+{
+    stream << "BufferedNotifier: records=" << stats.d_records
+           << " bytes=" << stats.d_bytes
+           << " batches=" << stats.d_batches
+           << " flushLatencyAvgNs="
+           << (stats.d_batches
+                   ? stats.d_flushLatencyTotalNs / stats.d_batches
+                   : 0)
+           << " flushLatencyMaxNs=" << stats.d_flushLatencyMaxNs
+           << " maxRecordAgeNs=" << stats.d_maxRecordAgeNs
+           << " stalls=" << stats.d_stalls;
+    return stream;
+}
@@ -0,0 +1,134 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _BUFFEREDNOTIFIER_H_
+#define _BUFFEREDNOTIFIER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#include "notifier.h"
+
+// BufferedNotifier is an 'INotifier' that formats every record into a
+// preallocated buffer owned by the calling thread instead of writing it to
+// 'std::cout' with 'std::endl'.  A background writer thread swaps the
+// buffers out and writes them all with a single 'writev' once any buffer
+// holds 'flushBytes' or 'flushInterval' has elapsed, whichever comes first.
+// A record is therefore written at most 'flushInterval' plus one write
+// after it was produced; 'Statistics::d_maxRecordAgeNs' reports the worst
+// case actually observed.
+//
+// A thread whose buffer is full waits for the writer instead of growing it.
+class BufferedNotifier : public INotifier {
+  public:
+    struct Statistics {
+        std::uint64_t d_records;
+        std::uint64_t d_bytes;
+        std::uint64_t d_batches;
+        std::uint64_t d_flushLatencyTotalNs;
+        std::uint64_t d_flushLatencyMaxNs;
+        std::uint64_t d_maxRecordAgeNs;
+        std::uint64_t d_stalls;       // appends that waited for the writer
+    };
+
+  private:
+    struct ThreadBuffer {
+        std::thread::id                       d_owner;
+        std::mutex                            d_mutex;
+        std::condition_variable               d_drained;
+        std::vector<char>                     d_active;    // producer
+        std::vector<char>                     d_flushing;  // writer
+        std::chrono::steady_clock::time_point d_oldest;
+    };
+
+    typedef std::vector<std::unique_ptr<ThreadBuffer> > ThreadBuffers;
+
+    const std::uint64_t       d_id;
+    const int                 d_fd;
+    const std::size_t         d_flushBytes;
+    const std::size_t         d_capacity;
+    std::chrono::milliseconds d_flushInterval;
+
+    std::mutex                d_buffersMutex;
+    ThreadBuffers             d_buffers;
+    std::mutex                d_flushMutex;    // serializes 'flush'
+    std::vector<char>         d_scratch;       // 'flush' only
+
+    std::mutex                d_mutex;
+    std::condition_variable   d_wakeup;
+    bool                      d_flushRequested;
+    bool                      d_running;
+    std::thread               d_writer;
+
+    std::atomic<std::uint64_t> d_records;
+    std::atomic<std::uint64_t> d_stalls;
+
+    // Written by the writer thread only.
+    std::atomic<std::uint64_t> d_bytes;
+    std::atomic<std::uint64_t> d_batches;
+    std::atomic<std::uint64_t> d_flushLatencyTotalNs;
+    std::atomic<std::uint64_t> d_flushLatencyMaxNs;
+    std::atomic<std::uint64_t> d_maxRecordAgeNs;
+
+    BufferedNotifier(const BufferedNotifier&);
+    BufferedNotifier& operator=(const BufferedNotifier&);
+
+    ThreadBuffer *localBuffer();
+    void append(const char *data, std::size_t length);
+    void requestFlush();
+    void run();
+    void flush();
+
+  public:
+    BufferedNotifier(int         fd = 1,
+                     std::size_t flushBytes = 64 * 1024,
+                     int         flushIntervalMs = 10);
+        // Create a notifier writing to file descriptor 'fd', which it does
+        // not own.  Each thread's buffer holds four times 'flushBytes'.
+
+    virtual ~BufferedNotifier();
+        // Stop the writer after it has written every buffered record.
+
+    bool start();
+
+    void stop();
+        // Write every buffered record and stop the writer thread.
+
+    virtual void logSessionState(const blp::Message& msg);
+
+    virtual void logSubscriptionState(const blp::Message& msg);
+
+    virtual void sendToTerminal(double value);
+
+    Statistics statistics() const;
+};
+
+std::ostream& operator<<(std::ostream&                       stream,
+                         const BufferedNotifier::Statistics& stats);
+
+#endif
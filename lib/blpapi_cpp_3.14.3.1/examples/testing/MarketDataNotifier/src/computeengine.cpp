@@ -19,3 +19,8 @@
  */
 
 #include "computeengine.h"
+
+void ComputeEngine::computeBatch(double *results, const TickBatch& batch)
+{
+    ComputeKernels::scale(results, batch.d_prices, batch.d_count, 2.0);
+}
@@ -21,9 +21,36 @@
 #ifndef _COMPUTEENGINE_H_
 #define _COMPUTEENGINE_H_
 
+#include <cstddef>
+
+#include "computekernels.h"
+
+// TickBatch describes 'd_count' ticks as parallel arrays.  'd_sizes' and
+// 'd_timestamps' (nanoseconds since an arbitrary epoch) may be null if the
+// producer does not have them.
+struct TickBatch {
+    const double    *d_prices;
+    const double    *d_sizes;
+    const long long *d_timestamps;
+    std::size_t      d_count;
+
+    TickBatch()
+    : d_prices(0), d_sizes(0), d_timestamps(0), d_count(0)
+    {
+    }
+};
+
+// A compute engine is shared by every dispatcher thread, so both methods
+// must be safe to call concurrently.
 class IComputeEngine {
   public:
     virtual double someVeryComplexComputation(double lastValue) = 0;
+
+    virtual void computeBatch(double *results, const TickBatch& batch);
+        // Load into 'results[i]' the result for the 'i'th tick of 'batch'.
+        // The default implementation calls 'someVeryComplexComputation' once
+        // per tick; engines should override it with a vectorized version.
+
     virtual ~IComputeEngine() {}
 };
 
@@ -33,6 +60,16 @@ class ComputeEngine : public IComputeEngine {
     {
         return lastValue * 2.0;
     }
+
+    virtual void computeBatch(double *results, const TickBatch& batch);
 };
 
+inline
+void IComputeEngine::computeBatch(double *results, const TickBatch& batch)
+{
+    for (std::size_t i = 0; i < batch.d_count; ++i) {
+        results[i] = someVeryComplexComputation(batch.d_prices[i]);
+    }
+}
+
 #endif
@@ -0,0 +1,165 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "computekernels.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define COMPUTEKERNELS_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COMPUTEKERNELS_SSE2 1
+#endif
+
+namespace {
+#if defined(COMPUTEKERNELS_AVX2)
+double horizontalSum(__m256d value)
+{
+    __m128d low  = _mm256_castpd256_pd128(value);
+    __m128d high = _mm256_extractf128_pd(value, 1);
+    low          = _mm_add_pd(low, high);
+    return _mm_cvtsd_f64(_mm_add_sd(low, _mm_unpackhi_pd(low, low)));
+}
+#elif defined(COMPUTEKERNELS_SSE2)
+double horizontalSum(__m128d value)
+{
+    return _mm_cvtsd_f64(_mm_add_sd(value, _mm_unpackhi_pd(value, value)));
+}
+#endif
+}
+
+const char *ComputeKernels::instructionSet()
+{
+#if defined(COMPUTEKERNELS_AVX2)
+    return "AVX2";
+#elif defined(COMPUTEKERNELS_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+void ComputeKernels::scale(double       *results,
+                           const double *values,
+                           std::size_t   count,
+                           double        factor)
+{
+    std::size_t i = 0;
+#if defined(COMPUTEKERNELS_AVX2)
+    const __m256d f = _mm256_set1_pd(factor);
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(results + i,
+                         _mm256_mul_pd(_mm256_loadu_pd(values + i), f));
+    }
+#elif defined(COMPUTEKERNELS_SSE2)
+    const __m128d f = _mm_set1_pd(factor);
+    for (; i + 2 <= count; i += 2) {
+        _mm_storeu_pd(results + i, _mm_mul_pd(_mm_loadu_pd(values + i), f));
+    }
+#endif
+    for (; i < count; ++i) {
+        results[i] = values[i] * factor;
+    }
+}
+
+void ComputeKernels::notionalAndVolume(double       *notional,
+                                       double       *volume,
+                                       const double *prices,
+                                       const double *sizes,
+                                       std::size_t   count)
+{
+    double      n = 0;
+    double      v = 0;
+    std::size_t i = 0;
+#if defined(COMPUTEKERNELS_AVX2)
+    __m256d ns = _mm256_setzero_pd();
+    __m256d vs = _mm256_setzero_pd();
+    for (; i + 4 <= count; i += 4) {
+        __m256d s = _mm256_loadu_pd(sizes + i);
+        ns = _mm256_add_pd(ns,
+                           _mm256_mul_pd(_mm256_loadu_pd(prices + i), s));
+        vs = _mm256_add_pd(vs, s);
+    }
+    n = horizontalSum(ns);
+    v = horizontalSum(vs);
+#elif defined(COMPUTEKERNELS_SSE2)
+    __m128d ns = _mm_setzero_pd();
+    __m128d vs = _mm_setzero_pd();
+    for (; i + 2 <= count; i += 2) {
+        __m128d s = _mm_loadu_pd(sizes + i);
+        ns = _mm_add_pd(ns, _mm_mul_pd(_mm_loadu_pd(prices + i), s));
+        vs = _mm_add_pd(vs, s);
+    }
+    n = horizontalSum(ns);
+    v = horizontalSum(vs);
+#endif
+    for (; i < count; ++i) {
+        n += prices[i] * sizes[i];
+        v += sizes[i];
+    }
+    *notional = n;
+    *volume   = v;
+}
+
+double ComputeKernels::vwap(const double *prices,
+                            const double *sizes,
+                            std::size_t   count)
+{
+    double notional;
+    double volume;
+    notionalAndVolume(&notional, &volume, prices, sizes, count);
+    return volume != 0 ? notional / volume : 0;
+}
+
+double ComputeKernels::ewma(const double *values,
+                            std::size_t   count,
+                            double        alpha,
+                            double        initial)
+{
+    // s[n] = alpha * x[n] + d * s[n - 1] with d = 1 - alpha.  Four steps at
+    // once are s[n + 3] = d^4 * s[n - 1]
+    //                   + alpha * (d^3 x[n] + d^2 x[n + 1] + d x[n + 2]
+    //                                                          + x[n + 3]),
+    // which turns the recurrence into a dot product per block.
+    const double d     = 1.0 - alpha;
+    double       state = initial;
+    std::size_t  i     = 0;
+#if defined(COMPUTEKERNELS_AVX2)
+    const double  d4      = d * d * d * d;
+    const __m256d weights = _mm256_set_pd(alpha, alpha * d,
+                                          alpha * d * d, alpha * d * d * d);
+    for (; i + 4 <= count; i += 4) {
+        state = d4 * state + horizontalSum(
+                   _mm256_mul_pd(_mm256_loadu_pd(values + i), weights));
+    }
+#elif defined(COMPUTEKERNELS_SSE2)
+    const double  d2      = d * d;
+    const __m128d weights = _mm_set_pd(alpha, alpha * d);
+    for (; i + 2 <= count; i += 2) {
+        state = d2 * state
+              + horizontalSum(_mm_mul_pd(_mm_loadu_pd(values + i), weights));
+    }
+#endif
+    for (; i < count; ++i) {
+        state = alpha * values[i] + d * state;
+    }
+    return state;
+}
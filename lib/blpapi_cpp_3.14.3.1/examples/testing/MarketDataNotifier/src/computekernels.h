@@ -0,0 +1,65 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _COMPUTEKERNELS_H_
+#define _COMPUTEKERNELS_H_
+
+#include <cstddef>
+
+// ComputeKernels provides vectorized reference kernels over contiguous
+// arrays of tick data.  The instruction set is chosen at compile time: AVX2
+// if the compiler targets it (see the 'MARKETDATANOTIFIER_AVX2' CMake
+// option), otherwise SSE2 where available, otherwise plain scalar code.
+// Reductions are computed in a different order than a scalar loop would, so
+// results may differ from one in the last bits.
+struct ComputeKernels {
+    static const char *instructionSet();
+        // Return "AVX2", "SSE2" or "scalar".
+
+    static void scale(double       *results,
+                      const double *values,
+                      std::size_t   count,
+                      double        factor);
+        // Load 'values[i] * factor' into 'results[i]' for every 'i' in
+        // '[0, count)'.  'results' may be 'values'.
+
+    static void notionalAndVolume(double       *notional,
+                                  double       *volume,
+                                  const double *prices,
+                                  const double *sizes,
+                                  std::size_t   count);
+        // Load into 'notional' the sum of 'prices[i] * sizes[i]' and into
+        // 'volume' the sum of 'sizes[i]' over '[0, count)'.
+
+    static double vwap(const double *prices,
+                       const double *sizes,
+                       std::size_t   count);
+        // Return the volume-weighted average of 'prices', or 0 if the total
+        // size is 0.
+
+    static double ewma(const double *values,
+                       std::size_t   count,
+                       double        alpha,
+                       double        initial);
+        // Return the exponentially weighted moving average of 'values' with
+        // smoothing factor 'alpha', starting from 'initial'.
+};
+
+#endif
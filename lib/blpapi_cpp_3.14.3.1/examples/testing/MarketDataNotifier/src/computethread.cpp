@@ -0,0 +1,260 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "computethread.h"
+
+#include <chrono>
+#include <iostream>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+const int k_SPIN_BEFORE_SLEEP = 1000;
+const int k_IDLE_SLEEP_US     = 50;
+
+std::uint64_t nanosecondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - start).count();
+}
+
+bool pinToCpu(std::thread *thread, int cpu)
+{
+#if defined(__linux__)
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    return 0 == pthread_setaffinity_np(
+                    thread->native_handle(), sizeof(cpus), &cpus);
+#else
+    (void)thread;
+    (void)cpu;
+    return false;
+#endif
+}
+}
+
+ComputeThread::ComputeThread(IComputeEngine *computeEngine,
+                             INotifier      *notifier,
+                             std::size_t     capacity,
+                             OverflowPolicy  policy,
+                             int             cpu)
+: d_computeEngine(computeEngine)
+, d_notifier(notifier)
+, d_queue(capacity)
+, d_policy(policy)
+, d_cpu(cpu)
+, d_running(false)
+, d_enqueued(0)
+, d_dropped(0)
+, d_overwritten(0)
+, d_blocked(0)
+, d_enqueueLatencyTotalNs(0)
+, d_enqueueLatencyMaxNs(0)
+, d_processed(0)
+{
+}
+
+ComputeThread::~ComputeThread()
+{
+    stop();
+}
+
+bool ComputeThread::start()
+{
+    if (d_thread.joinable()) {
+        return false;
+    }
+
+    d_running.store(true, std::memory_order_release);
+    d_thread = std::thread(&ComputeThread::run, this);
+
+    if (d_cpu >= 0 && !pinToCpu(&d_thread, d_cpu)) {
+        std::cerr << "Failed to pin compute thread to CPU " << d_cpu
+                  << std::endl;
+    }
+    return true;
+}
+
+void ComputeThread::stop()
+{
+    if (!d_thread.joinable()) {
+        return;
+    }
+
+    d_running.store(false, std::memory_order_release);
+    d_thread.join();
+}
+
+void ComputeThread::push(const Tick& tick)
+{
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    switch (d_policy) {
+      case e_DROP:
+        if (!d_queue.tryPush(tick)) {
+            d_dropped.store(d_dropped.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+            return;
+        }
+        break;
+      case e_OVERWRITE:
+        if (d_queue.pushOverwrite(tick)) {
+            d_overwritten.store(
+                d_overwritten.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+        }
+        break;
+      case e_BLOCK:
+        if (!d_queue.tryPush(tick)) {
+            d_blocked.store(d_blocked.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+            while (!d_queue.tryPush(tick)) {
+                // Nothing will make room once the compute thread stopped.
+                if (!d_running.load(std::memory_order_acquire)) {
+                    d_dropped.store(
+                        d_dropped.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed);
+                    return;
+                }
+                std::this_thread::yield();
+            }
+        }
+        break;
+    }
+
+    std::uint64_t latency = nanosecondsSince(start);
+    d_enqueued.store(d_enqueued.load(std::memory_order_relaxed) + 1,
+                     std::memory_order_relaxed);
+    d_enqueueLatencyTotalNs.store(
+        d_enqueueLatencyTotalNs.load(std::memory_order_relaxed) + latency,
+        std::memory_order_relaxed);
+    if (latency > d_enqueueLatencyMaxNs.load(std::memory_order_relaxed)) {
+        d_enqueueLatencyMaxNs.store(latency, std::memory_order_relaxed);
+    }
+}
+
+bool ComputeThread::drain()
+{
+    // Pop up to 'k_BATCH_SIZE' ticks at a time so that the engine can
+    // compute them in one vectorized call.
+    static const std::size_t k_BATCH_SIZE = 64;
+
+    double prices[k_BATCH_SIZE];
+    double results[k_BATCH_SIZE];
+    bool   didWork = false;
+    Tick   tick;
+    for (;;) {
+        std::size_t count = 0;
+        while (count < k_BATCH_SIZE && d_queue.tryPop(&tick)) {
+            prices[count++] = tick.d_lastPrice;
+        }
+        if (count == 0) {
+            break;
+        }
+
+        TickBatch batch;
+        batch.d_prices = prices;
+        batch.d_count  = count;
+        d_computeEngine->computeBatch(results, batch);
+        for (std::size_t i = 0; i < count; ++i) {
+            d_notifier->sendToTerminal(results[i]);
+        }
+        d_processed.store(d_processed.load(std::memory_order_relaxed) + count,
+                          std::memory_order_relaxed);
+        didWork = true;
+    }
+    return didWork;
+}
+
+void ComputeThread::run()
+{
+    int idleSpins = 0;
+    while (d_running.load(std::memory_order_acquire)) {
+        if (drain()) {
+            idleSpins = 0;
+        }
+        else if (++idleSpins < k_SPIN_BEFORE_SLEEP) {
+            std::this_thread::yield();
+        }
+        else {
+            std::this_thread::sleep_for(
+                std::chrono::microseconds(k_IDLE_SLEEP_US));
+        }
+    }
+    drain();
+}
+
+ComputeThread::Statistics ComputeThread::statistics() const
+{
+    Statistics stats;
+    stats.d_enqueued    = d_enqueued.load(std::memory_order_relaxed);
+    stats.d_dropped     = d_dropped.load(std::memory_order_relaxed);
+    stats.d_overwritten = d_overwritten.load(std::memory_order_relaxed);
+    stats.d_blocked     = d_blocked.load(std::memory_order_relaxed);
+    stats.d_processed   = d_processed.load(std::memory_order_relaxed);
+    stats.d_enqueueLatencyTotalNs =
+        d_enqueueLatencyTotalNs.load(std::memory_order_relaxed);
+    stats.d_enqueueLatencyMaxNs =
+        d_enqueueLatencyMaxNs.load(std::memory_order_relaxed);
+    stats.d_highWaterMark = d_queue.highWaterMark();
+    stats.d_capacity      = d_queue.capacity();
+    return stats;
+}
+
+bool ComputeThread::parseOverflowPolicy(OverflowPolicy     *policy,
+                                        const std::string&  name)
+{
+    if (name == "drop") {
+        *policy = e_DROP;
+    }
+    else if (name == "overwrite") {
+        *policy = e_OVERWRITE;
+    }
+    else if (name == "block") {
+        *policy = e_BLOCK;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+std::ostream& operator<<(std::ostream&                    stream,
+                         const ComputeThread::Statistics& stats)
+{
+    stream << "ComputeThread: enqueued=" << stats.d_enqueued
+           << " processed=" << stats.d_processed
+           << " dropped=" << stats.d_dropped
+           << " overwritten=" << stats.d_overwritten
+           << " blocked=" << stats.d_blocked
+           << " highWaterMark=" << stats.d_highWaterMark
+           << '/' << stats.d_capacity
+           << " enqueueLatencyAvgNs="
+           << (stats.d_enqueued
+                   ? stats.d_enqueueLatencyTotalNs / stats.d_enqueued
+                   : 0)
+           << " enqueueLatencyMaxNs=" << stats.d_enqueueLatencyMaxNs;
+    return stream;
+}
@@ -0,0 +1,119 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _COMPUTETHREAD_H_
+#define _COMPUTETHREAD_H_
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <thread>
+
+#include "computeengine.h"
+#include "notifier.h"
+#include "spscqueue.h"
+#include "tick.h"
+
+// ComputeThread decouples the compute and notification stages from the
+// BLPAPI dispatcher thread.  'push' is called by the dispatcher (the single
+// producer) and only copies the tick into a bounded 'SpscQueue'; a dedicated,
+// optionally CPU-pinned, thread drains the queue and invokes 'IComputeEngine'
+// and 'INotifier'.  What happens when the ring is full is controlled by the
+// 'OverflowPolicy'.
+class ComputeThread : public ITickSink {
+  public:
+    enum OverflowPolicy {
+        e_DROP,       // discard the incoming tick
+        e_OVERWRITE,  // evict the oldest queued tick
+        e_BLOCK       // spin the dispatcher until there is room, or drop
+                      // the tick if the compute thread is not running
+    };
+
+    struct Statistics {
+        std::uint64_t d_enqueued;
+        std::uint64_t d_dropped;
+        std::uint64_t d_overwritten;
+        std::uint64_t d_blocked;
+        std::uint64_t d_processed;
+        std::uint64_t d_enqueueLatencyTotalNs;
+        std::uint64_t d_enqueueLatencyMaxNs;
+        std::size_t   d_highWaterMark;
+        std::size_t   d_capacity;
+    };
+
+  private:
+    IComputeEngine   *d_computeEngine;
+    INotifier        *d_notifier;
+    SpscQueue<Tick>   d_queue;
+    OverflowPolicy    d_policy;
+    int               d_cpu;
+    std::thread       d_thread;
+    std::atomic<bool> d_running;
+
+    // Producer-side counters, written only by the dispatcher thread.
+    std::atomic<std::uint64_t> d_enqueued;
+    std::atomic<std::uint64_t> d_dropped;
+    std::atomic<std::uint64_t> d_overwritten;
+    std::atomic<std::uint64_t> d_blocked;
+    std::atomic<std::uint64_t> d_enqueueLatencyTotalNs;
+    std::atomic<std::uint64_t> d_enqueueLatencyMaxNs;
+
+    // Consumer-side counter, written only by the compute thread.
+    std::atomic<std::uint64_t> d_processed;
+
+    ComputeThread(const ComputeThread&);
+    ComputeThread& operator=(const ComputeThread&);
+
+    void run();
+    bool drain();
+
+  public:
+    ComputeThread(IComputeEngine *computeEngine,
+                  INotifier      *notifier,
+                  std::size_t     capacity,
+                  OverflowPolicy  policy = e_DROP,
+                  int             cpu = -1);
+        // Create a compute thread whose ring holds at least 'capacity'
+        // ticks.  If 'cpu' is not negative the thread is pinned to it.
+
+    virtual ~ComputeThread();
+
+    bool start();
+
+    void stop();
+        // Stop the compute thread after it has drained every tick that was
+        // already queued.  Ticks pushed after 'stop' are queued but not
+        // processed, or dropped if the ring is full.
+
+    virtual void push(const Tick& tick);
+
+    Statistics statistics() const;
+
+    static bool parseOverflowPolicy(OverflowPolicy     *policy,
+                                    const std::string&  name);
+        // Load into the specified 'policy' the value named by 'name' ("drop",
+        // "overwrite" or "block").  Return false if 'name' is unknown.
+};
+
+std::ostream& operator<<(std::ostream&                    stream,
+                         const ComputeThread::Statistics& stats);
+
+#endif
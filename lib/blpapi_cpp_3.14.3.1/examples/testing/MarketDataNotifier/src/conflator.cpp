@@ -0,0 +1,201 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "conflator.h"
+
+#include <new>
+
+namespace {
+void increment(std::atomic<std::uint64_t> *counter, std::uint64_t value = 1)
+{
+    // Every counter has a single writer, so a read-modify-write is not
+    // needed.
+    counter->store(counter->load(std::memory_order_relaxed) + value,
+                   std::memory_order_relaxed);
+}
+}
+
+Conflator::Conflator(IComputeEngine *computeEngine,
+                     INotifier      *notifier,
+                     std::size_t     maxTopics,
+                     int             intervalMs)
+: d_computeEngine(computeEngine)
+, d_notifier(notifier)
+, d_interval(intervalMs)
+, d_slots(0)
+, d_capacity(maxTopics ? maxTopics : 1)
+, d_dirty(d_capacity)
+, d_running(false)
+, d_received(0)
+, d_conflated(0)
+, d_rejected(0)
+, d_published(0)
+, d_intervals(0)
+{
+    // 'std::vector' does not honour over-aligned types before C++17, so the
+    // slots are placed by hand at the first cache-line boundary.
+    d_storage.resize(d_capacity * sizeof(Slot) + alignof(Slot));
+    std::uintptr_t address =
+        reinterpret_cast<std::uintptr_t>(d_storage.data());
+    address = (address + alignof(Slot) - 1) & ~(alignof(Slot) - 1);
+    d_slots = reinterpret_cast<Slot *>(address);
+
+    for (std::size_t i = 0; i < d_capacity; ++i) {
+        Slot *slot = new (d_slots + i) Slot;
+        slot->d_lock.clear();
+        slot->d_dirty.store(false);
+    }
+    d_batch.reserve(d_capacity);
+}
+
+Conflator::~Conflator()
+{
+    stop();
+    for (std::size_t i = 0; i < d_capacity; ++i) {
+        d_slots[i].~Slot();
+    }
+}
+
+bool Conflator::start()
+{
+    if (d_thread.joinable()) {
+        return false;
+    }
+
+    d_running = true;
+    d_thread  = std::thread(&Conflator::run, this);
+    return true;
+}
+
+void Conflator::stop()
+{
+    if (!d_thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(d_mutex);
+        d_running = false;
+    }
+    d_condition.notify_one();
+    d_thread.join();
+}
+
+void Conflator::push(const Tick& tick)
+{
+    increment(&d_received);
+
+    const std::size_t index = tick.d_topic;
+    if (index >= d_capacity) {
+        increment(&d_rejected);
+        return;
+    }
+
+    Slot& slot = d_slots[index];
+    while (slot.d_lock.test_and_set(std::memory_order_acquire)) {
+    }
+    slot.d_tick = tick;
+    slot.d_lock.clear(std::memory_order_release);
+
+    // Only a clean-to-dirty transition queues the slot, so each index is in
+    // 'd_dirty' at most once and the queue can never overflow.
+    if (slot.d_dirty.exchange(true, std::memory_order_acq_rel)) {
+        increment(&d_conflated);
+    }
+    else {
+        d_dirty.tryPush(index);
+    }
+}
+
+std::size_t Conflator::pull(std::vector<Tick> *ticks)
+{
+    std::size_t count = 0;
+    std::size_t index;
+    while (d_dirty.tryPop(&index)) {
+        Slot& slot = d_slots[index];
+        slot.d_dirty.store(false, std::memory_order_release);
+
+        while (slot.d_lock.test_and_set(std::memory_order_acquire)) {
+        }
+        ticks->push_back(slot.d_tick);
+        slot.d_lock.clear(std::memory_order_release);
+        ++count;
+    }
+    increment(&d_published, count);
+    return count;
+}
+
+void Conflator::publish()
+{
+    d_batch.clear();
+    if (pull(&d_batch)) {
+        d_prices.resize(d_batch.size());
+        d_results.resize(d_batch.size());
+        for (std::size_t i = 0; i < d_batch.size(); ++i) {
+            d_prices[i] = d_batch[i].d_lastPrice;
+        }
+
+        TickBatch batch;
+        batch.d_prices = &d_prices[0];
+        batch.d_count  = d_prices.size();
+        d_computeEngine->computeBatch(&d_results[0], batch);
+        for (std::size_t i = 0; i < d_results.size(); ++i) {
+            d_notifier->sendToTerminal(d_results[i]);
+        }
+    }
+    increment(&d_intervals);
+}
+
+void Conflator::run()
+{
+    std::unique_lock<std::mutex> lock(d_mutex);
+    while (d_running) {
+        d_condition.wait_for(lock, d_interval);
+        lock.unlock();
+        publish();
+        lock.lock();
+    }
+    lock.unlock();
+    publish();
+}
+
+Conflator::Statistics Conflator::statistics() const
+{
+    Statistics stats;
+    stats.d_received  = d_received.load(std::memory_order_relaxed);
+    stats.d_conflated = d_conflated.load(std::memory_order_relaxed);
+    stats.d_rejected  = d_rejected.load(std::memory_order_relaxed);
+    stats.d_published = d_published.load(std::memory_order_relaxed);
+    stats.d_intervals = d_intervals.load(std::memory_order_relaxed);
+    stats.d_topics    = d_capacity;
+    return stats;
+}
+
+std::ostream& operator<<(std::ostream&                stream,
+                         const Conflator::Statistics& stats)
+{
+    stream << "Conflator: received=" << stats.d_received
+           << " conflated=" << stats.d_conflated
+           << " published=" << stats.d_published
+           << " rejected=" << stats.d_rejected
+           << " intervals=" << stats.d_intervals
+           << " topics=" << stats.d_topics;
+    return stream;
+}
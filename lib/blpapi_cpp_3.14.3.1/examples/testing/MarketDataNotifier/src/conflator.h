@@ -0,0 +1,120 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _CONFLATOR_H_
+#define _CONFLATOR_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#include "computeengine.h"
+#include "notifier.h"
+#include "spscqueue.h"
+#include "tick.h"
+
+// Conflator keeps only the latest tick per topic.  The dispatcher thread
+// 'push'es every tick into the last-value slot indexed by its topic id (see
+// 'TopicTable'); a slot that turns dirty is queued once on an 'SpscQueue'
+// of slot indices.  Every interval the conflation thread 'pull's the dirty
+// slots and runs 'IComputeEngine' and 'INotifier' on them, so downstream work
+// is proportional to the number of active topics rather than the number of
+// ticks.
+class Conflator : public ITickSink {
+  public:
+    struct Statistics {
+        std::uint64_t d_received;     // ticks pushed
+        std::uint64_t d_conflated;    // ticks that replaced an unsent tick
+        std::uint64_t d_rejected;     // ticks with an id beyond capacity
+        std::uint64_t d_published;    // ticks pulled
+        std::uint64_t d_intervals;
+        std::size_t   d_topics;
+    };
+
+  private:
+    struct alignas(64) Slot {
+        std::atomic_flag  d_lock;
+        std::atomic<bool> d_dirty;
+        Tick              d_tick;
+    };
+
+    IComputeEngine            *d_computeEngine;
+    INotifier                 *d_notifier;
+    std::chrono::milliseconds  d_interval;
+    std::vector<char>          d_storage;
+    Slot                      *d_slots;     // 'd_capacity' slots
+    std::size_t                d_capacity;
+    SpscQueue<std::size_t>     d_dirty;
+    std::vector<Tick>          d_batch;     // conflation thread only
+    std::vector<double>        d_prices;    // conflation thread only
+    std::vector<double>        d_results;   // conflation thread only
+    std::thread                d_thread;
+    std::mutex                 d_mutex;
+    std::condition_variable    d_condition;
+    bool                       d_running;
+
+    std::atomic<std::uint64_t> d_received;
+    std::atomic<std::uint64_t> d_conflated;
+    std::atomic<std::uint64_t> d_rejected;
+    std::atomic<std::uint64_t> d_published;
+    std::atomic<std::uint64_t> d_intervals;
+
+    Conflator(const Conflator&);
+    Conflator& operator=(const Conflator&);
+
+    void run();
+    void publish();
+
+  public:
+    Conflator(IComputeEngine *computeEngine,
+              INotifier      *notifier,
+              std::size_t     maxTopics,
+              int             intervalMs);
+        // Create a conflator for topic ids '[0, maxTopics)' which publishes
+        // dirty topics every 'intervalMs' milliseconds once started.
+
+    virtual ~Conflator();
+
+    bool start();
+
+    void stop();
+        // Stop the conflation thread after publishing whatever is dirty.
+
+    virtual void push(const Tick& tick);
+        // Store 'tick' as the latest value of its topic.  Dispatcher thread
+        // only.
+
+    std::size_t pull(std::vector<Tick> *ticks);
+        // Append the latest tick of every topic updated since the previous
+        // call to 'ticks' and return how many were appended.  Conflation
+        // thread only.
+
+    Statistics statistics() const;
+};
+
+std::ostream& operator<<(std::ostream&                stream,
+                         const Conflator::Statistics& stats);
+
+#endif
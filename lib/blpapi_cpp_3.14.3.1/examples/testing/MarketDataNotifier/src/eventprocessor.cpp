@@ -21,12 +21,162 @@
 #include "eventprocessor.h"
 
 #include <blpapi_message.h>
+#include <blpapi_name.h>
+
+#include <chrono>
 
 namespace blp = BloombergLP::blpapi;
 
+namespace {
+const blp::Name SIZE_LAST_TRADE("SIZE_LAST_TRADE");
+}
+
+void EventProcessor::init()
+{
+    d_sizeSlot    = d_fieldRegistry->slot(SIZE_LAST_TRADE);
+    d_epoch       = blp::HighResolutionClock::now();
+    d_epochWallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+    d_staleTicks.store(0, std::memory_order_relaxed);
+    d_lastValueCache    = 0;
+    d_firstLastValueRow = 0;
+    d_tickStore         = 0;
+    d_firstStoredTopic  = 0;
+    d_tradeType         = 0;
+}
+
+TopicState *EventProcessor::lock(std::size_t topic)
+{
+    if (!d_topicTable || topic >= d_topicTable->size()) {
+        return 0;
+    }
+    TopicState& topicState = (*d_topicTable)[topic];
+    topicState.d_lock.lock();
+    return &topicState;
+}
+
+bool EventProcessor::acceptLocked(TopicState *state,
+                                  double      lastPrice,
+                                  long long   receivedNs)
+{
+    if (receivedNs != 0 && receivedNs < state->d_lastReceivedNs) {
+        d_staleTicks.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (receivedNs != 0) {
+        state->d_lastReceivedNs = receivedNs;
+    }
+    state->d_lastPrice = lastPrice;
+    ++state->d_ticks;
+    return true;
+}
+
+bool EventProcessor::accept(TopicState  **state,
+                            std::size_t   topic,
+                            double        lastPrice,
+                            double        size,
+                            long long     receivedNs)
+{
+    *state = lock(topic);
+    if (!*state) {
+        return true;
+    }
+    if (!acceptLocked(*state, lastPrice, receivedNs)) {
+        (*state)->d_lock.unlock();
+        *state = 0;
+        return false;
+    }
+
+    TickBatch tick;
+    tick.d_prices = &lastPrice;
+    tick.d_sizes  = &size;
+    tick.d_count  = 1;
+    (*state)->d_analytics.update(tick);
+    return true;
+}
+
+void EventProcessor::flushBatch(Batch *batch, long long dispatchNs)
+{
+    if (batch->d_prices.empty()) {
+        return;
+    }
+    batch->d_results.resize(batch->d_prices.size());
+
+    TickBatch ticks;
+    ticks.d_prices     = &batch->d_prices[0];
+    ticks.d_sizes      = &batch->d_sizes[0];
+    ticks.d_timestamps = &batch->d_timestamps[0];
+    ticks.d_count      = batch->d_prices.size();
+    d_computeEngine->computeBatch(&batch->d_results[0], ticks);
+
+    long long computeNs = 0;
+    if (d_latencyMonitor) {
+        computeNs = nanosecondsSinceEpoch();
+        for (std::size_t i = 0; i < ticks.d_count; ++i) {
+            d_latencyMonitor->record(LatencyMonitor::e_DISPATCH_TO_COMPUTE,
+                                     computeNs - dispatchNs);
+        }
+    }
+
+    // Deliver the ticks in runs of one topic, holding its lock for the
+    // run, so that the run's accepted ticks update the topic's analytics
+    // in one batch, in the order they were delivered.
+    std::size_t end = 0;
+    for (std::size_t begin = 0; begin < ticks.d_count; begin = end) {
+        const std::size_t topic = batch->d_topics[begin];
+        end = begin + 1;
+        while (end < ticks.d_count && batch->d_topics[end] == topic) {
+            ++end;
+        }
+
+        TopicState *state = lock(topic);
+        batch->d_runPrices.clear();
+        batch->d_runSizes.clear();
+        for (std::size_t i = begin; i < end; ++i) {
+            if (state
+                    && !acceptLocked(state,
+                                     batch->d_prices[i],
+                                     batch->d_timestamps[i])) {
+                continue;
+            }
+            d_notifier->sendToTerminal(batch->d_results[i]);
+            batch->d_runPrices.push_back(batch->d_prices[i]);
+            batch->d_runSizes.push_back(batch->d_sizes[i]);
+
+            if (d_latencyMonitor) {
+                long long notifyNs = nanosecondsSinceEpoch();
+                d_latencyMonitor->record(LatencyMonitor::e_COMPUTE_TO_NOTIFY,
+                                         notifyNs - computeNs);
+                if (batch->d_timestamps[i] != 0) {
+                    d_latencyMonitor->record(
+                                       LatencyMonitor::e_RECEIVE_TO_NOTIFY,
+                                       notifyNs - batch->d_timestamps[i]);
+                }
+            }
+        }
+        if (state) {
+            TickBatch run;
+            run.d_prices = batch->d_runPrices.data();
+            run.d_sizes  = batch->d_runSizes.data();
+            run.d_count  = batch->d_runPrices.size();
+            state->d_analytics.update(run);
+            state->d_lock.unlock();
+        }
+    }
+    batch->d_topics.clear();
+    batch->d_prices.clear();
+    batch->d_sizes.clear();
+    batch->d_timestamps.clear();
+}
+
 bool EventProcessor::processEvent(const blp::Event&  event,
                                   blp::Session      *session)
 {
+    static thread_local Batch batch;
+
+    const long long dispatchNs = d_latencyMonitor ? nanosecondsSinceEpoch()
+                                                  : 0;
+
     blp::MessageIterator msgIter(event);
     while (msgIter.next()) {
         blp::Message msg = msgIter.message();
@@ -37,17 +187,78 @@ bool EventProcessor::processEvent(const blp::Event&  event,
           case blp::Event::SUBSCRIPTION_STATUS:
             d_notifier->logSubscriptionState(msg);
             break;
-          case blp::Event::SUBSCRIPTION_DATA:
-            if (msg.hasElement("LAST_PRICE")) {
-                double lastPrice = msg.getElementAsFloat64("LAST_PRICE");
-                double result =
-                    d_computeEngine->someVeryComplexComputation(lastPrice);
-                d_notifier->sendToTerminal(result);
+          case blp::Event::SUBSCRIPTION_DATA: {
+            Tick              tick;
+            const std::size_t lastPriceSlot = d_fieldRegistry->lastPriceSlot();
+            if (!d_fieldRegistry->extract(&tick.d_fields, msg)) {
+                break;
             }
-            break;
+            tick.d_topic = TopicTable::topicId(msg.correlationId());
+
+            blp::TimePoint received;
+            long long      receivedNs =
+                0 == msg.timeReceived(&received)
+                    ? blp::TimePointUtil::nanosecondsBetween(d_epoch, received)
+                    : 0;
+
+            // The cache keeps every field, whether or not the tick goes on
+            // to be computed.
+            if (d_lastValueCache && tick.d_topic != TopicTable::k_INVALID_ID) {
+                d_lastValueCache->update(d_firstLastValueRow + tick.d_topic,
+                                         tick.d_fields,
+                                         receivedNs);
+            }
+            if (!tick.d_fields.has(lastPriceSlot)) {
+                break;
+            }
+            tick.d_lastPrice = tick.d_fields.d_values[lastPriceSlot];
+
+            if (d_latencyMonitor && receivedNs != 0) {
+                d_latencyMonitor->record(LatencyMonitor::e_RECEIVE_TO_DISPATCH,
+                                         dispatchNs - receivedNs);
+            }
+            if (d_tickStore && tick.d_topic != TopicTable::k_INVALID_ID) {
+                const long long sinceEpochNs =
+                    receivedNs != 0 ? receivedNs : nanosecondsSinceEpoch();
+                d_tickStore->append(
+                    d_firstStoredTopic + tick.d_topic,
+                    d_epochWallNs + sinceEpochNs,
+                    tick.d_lastPrice,
+                    tick.d_fields.has(d_sizeSlot)
+                        ? tick.d_fields.d_values[d_sizeSlot]
+                        : 0,
+                    d_tradeType);
+            }
+
+            if (d_tickSink) {
+                TopicState *state = 0;
+                if (accept(&state,
+                           tick.d_topic,
+                           tick.d_lastPrice,
+                           tick.d_fields.has(d_sizeSlot)
+                               ? tick.d_fields.d_values[d_sizeSlot]
+                               : 0,
+                           receivedNs)) {
+                    d_tickSink->push(tick);
+                }
+                if (state) {
+                    state->d_lock.unlock();
+                }
+            }
+            else {
+                batch.d_topics.push_back(tick.d_topic);
+                batch.d_prices.push_back(tick.d_lastPrice);
+                batch.d_sizes.push_back(
+                    tick.d_fields.has(d_sizeSlot)
+                        ? tick.d_fields.d_values[d_sizeSlot]
+                        : 0);
+                batch.d_timestamps.push_back(receivedNs);
+            }
+          } break;
           default:
             return true;
         }
     }
+    flushBatch(&batch, dispatchNs);
     return true;
 }
@@ -22,23 +22,134 @@
 #define _EVENTPROCESSOR_H_
 
 #include <blpapi_event.h>
+#include <blpapi_highresolutionclock.h>
 #include <blpapi_session.h>
+#include <blpapi_timepoint.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 #include "computeengine.h"
+#include "fieldregistry.h"
+#include "lastvaluecache.h"
+#include "latencymonitor.h"
 #include "notifier.h"
+#include "tickstore.h"
+#include "tick.h"
+#include "topictable.h"
 
 namespace blp = BloombergLP::blpapi;
 
+// EventProcessor may be called concurrently when the session uses an
+// 'blp::EventDispatcher' with several threads.  The ticks of one topic are
+// then delivered one at a time, under the topic's lock, and never one older
+// than a tick already delivered: a tick received before the last one
+// delivered for its topic is dropped and counted as stale.  Ticks are not
+// held back to be reordered, so dropping is the only ordering there is, and
+// it needs both a 'TopicTable' and receive times to be recorded (see
+// 'blp::SessionOptions::setRecordSubscriptionDataReceiveTimes').  Without
+// receive times every tick is delivered, in whatever order the dispatcher
+// threads reach it.
 class EventProcessor : public blp::EventHandler {
   private:
-    INotifier      *d_notifier;
-    IComputeEngine *d_computeEngine;
+    // Ticks of the event being processed, computed in one batch when no
+    // tick sink is set, and the accepted ticks of the run of one topic
+    // being delivered.  There is one batch per dispatcher thread.
+    struct Batch {
+        std::vector<std::size_t> d_topics;
+        std::vector<double>      d_prices;
+        std::vector<double>      d_sizes;
+        std::vector<long long>   d_timestamps;
+        std::vector<double>      d_results;
+        std::vector<double>      d_runPrices;
+        std::vector<double>      d_runSizes;
+    };
+
+    INotifier                  *d_notifier;
+    IComputeEngine             *d_computeEngine;
+    ITickSink                  *d_tickSink;
+    TopicTable                 *d_topicTable;
+    const FieldRegistry        *d_fieldRegistry;
+    LatencyMonitor             *d_latencyMonitor;
+    LastValueCache             *d_lastValueCache;
+    std::size_t                 d_firstLastValueRow;
+    TickStore                  *d_tickStore;
+    std::size_t                 d_firstStoredTopic;
+    std::uint16_t               d_tradeType;
+    long long                   d_epochWallNs;  // 'd_epoch' since Unix epoch
+    std::size_t                 d_sizeSlot;
+    blp::TimePoint              d_epoch;
+    std::atomic<std::uint64_t>  d_staleTicks;
+
+    void init();
+    void flushBatch(Batch *batch, long long dispatchNs);
+
+    long long nanosecondsSinceEpoch() const;
+
+    TopicState *lock(std::size_t topic);
+        // Lock and return the state of 'topic', or return 0 if 'topic' is
+        // not in the topic table.
+
+    bool acceptLocked(TopicState *state,
+                      double      lastPrice,
+                      long long   receivedNs);
+        // Update 'state', which is locked, with a tick of 'lastPrice'
+        // received 'receivedNs' after 'd_epoch' (0 if unknown).  Return
+        // false if a tick received later was already accepted for it.
+
+    bool accept(TopicState  **state,
+                std::size_t   topic,
+                double        lastPrice,
+                double        size,
+                long long     receivedNs);
+        // Update the state of 'topic' with a tick as 'acceptLocked' does,
+        // and its analytics with the tick's 'lastPrice' and 'size', and
+        // load into 'state' that state, locked until the tick has been
+        // delivered, or 0 if 'topic' is not in the topic table.  Return
+        // false, leaving nothing locked, if a tick received later was
+        // already accepted for 'topic'.
 
   public:
     EventProcessor(INotifier *notifier, IComputeEngine *computeEngine);
+    EventProcessor(INotifier           *notifier,
+                   IComputeEngine      *computeEngine,
+                   ITickSink           *tickSink,
+                   TopicTable          *topicTable = 0,
+                   const FieldRegistry *fieldRegistry = 0,
+                   LatencyMonitor      *latencyMonitor = 0);
+        // If 'tickSink' is not null, subscription data is extracted into a
+        // 'Tick' and handed to it instead of being computed and sent to the
+        // terminal on the calling (dispatcher) thread.  If 'topicTable' is
+        // not null, the state of the topic each message belongs to is
+        // updated in it.  Fields are extracted with 'fieldRegistry', or
+        // 'FieldRegistry::lastPriceOnly()' if it is null.  Without a tick
+        // sink, the ticks of each event are computed with a single call to
+        // 'IComputeEngine::computeBatch', sizes being taken from
+        // 'SIZE_LAST_TRADE' if it is registered.  Either way the
+        // 'TopicAnalytics' of each topic are updated with its accepted
+        // ticks.  If 'latencyMonitor' is not
+        // null, the latency of every stage a tick goes through is recorded
+        // in it; with a tick sink only the receive to dispatch latency is.
     EventProcessor();
 
+    void setLastValueCache(LastValueCache *cache, std::size_t firstRow);
+        // Store the fields of every tick into 'cache', in the row of the
+        // tick's topic id plus 'firstRow'.  Must be called before events are
+        // processed.
+
+    void setTickStore(TickStore *store, std::size_t firstTopic);
+        // Append the last price and 'SIZE_LAST_TRADE' of every tick to
+        // 'store' as a TRADE of the topic with the tick's topic id plus
+        // 'firstTopic', timed when it was received.  Must be called before
+        // events are processed.
+
     virtual bool processEvent(const blp::Event& event, blp::Session *session);
+
+    std::uint64_t staleTicks() const;
+        // Return the number of ticks dropped because a tick of the same topic
+        // received later had already been delivered.
 };
 
 inline
@@ -46,7 +157,59 @@ EventProcessor::EventProcessor(INotifier      *notifier,
                                IComputeEngine *computeEngine)
 : d_notifier(notifier)
 , d_computeEngine(computeEngine)
+, d_tickSink(0)
+, d_topicTable(0)
+, d_fieldRegistry(&FieldRegistry::lastPriceOnly())
+, d_latencyMonitor(0)
+{
+    init();
+}
+
+inline
+EventProcessor::EventProcessor(INotifier           *notifier,
+                               IComputeEngine      *computeEngine,
+                               ITickSink           *tickSink,
+                               TopicTable          *topicTable,
+                               const FieldRegistry *fieldRegistry,
+                               LatencyMonitor      *latencyMonitor)
+: d_notifier(notifier)
+, d_computeEngine(computeEngine)
+, d_tickSink(tickSink)
+, d_topicTable(topicTable)
+, d_fieldRegistry(fieldRegistry ? fieldRegistry
+                                : &FieldRegistry::lastPriceOnly())
+, d_latencyMonitor(latencyMonitor)
+{
+    init();
+}
+
+inline
+void EventProcessor::setLastValueCache(LastValueCache *cache,
+                                       std::size_t     firstRow)
+{
+    d_lastValueCache    = cache;
+    d_firstLastValueRow = firstRow;
+}
+
+inline
+void EventProcessor::setTickStore(TickStore *store, std::size_t firstTopic)
+{
+    d_tickStore        = store;
+    d_firstStoredTopic = firstTopic;
+    d_tradeType        = store ? store->typeId("TRADE") : 0;
+}
+
+inline
+long long EventProcessor::nanosecondsSinceEpoch() const
+{
+    return blp::TimePointUtil::nanosecondsBetween(
+                                   d_epoch, blp::HighResolutionClock::now());
+}
+
+inline
+std::uint64_t EventProcessor::staleTicks() const
 {
+    return d_staleTicks.load(std::memory_order_relaxed);
 }
 
 #endif
@@ -0,0 +1,208 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "eventrecorder.h"
+
+#include <blpapi_element.h>
+#include <blpapi_highresolutionclock.h>
+#include <blpapi_service.h>
+#include <blpapi_testutil.h>
+#include <blpapi_types.h>
+
+#include <cstdio>
+
+namespace blptst = blp::test;
+
+namespace {
+void appendString(std::string *json, const char *value)
+{
+    json->push_back('"');
+    for (; *value; ++value) {
+        unsigned char c = static_cast<unsigned char>(*value);
+        if (c == '"' || c == '\\') {
+            json->push_back('\\');
+            json->push_back(static_cast<char>(c));
+        }
+        else if (c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof escaped, "\\u%04x", c);
+            json->append(escaped);
+        }
+        else {
+            json->push_back(static_cast<char>(c));
+        }
+    }
+    json->push_back('"');
+}
+
+bool appendValue(std::string *json, const blp::Element& element)
+{
+    char buffer[32];
+    switch (element.datatype()) {
+      case blp::DataType::BOOL: {
+        bool value;
+        if (0 != element.getValueAs(&value)) {
+            return false;
+        }
+        json->append(value ? "true" : "false");
+      } break;
+      case blp::DataType::BYTE:
+      case blp::DataType::INT32:
+      case blp::DataType::INT64: {
+        blp::Int64 value;
+        if (0 != element.getValueAs(&value)) {
+            return false;
+        }
+        std::snprintf(buffer, sizeof buffer, "%lld",
+                      static_cast<long long>(value));
+        json->append(buffer);
+      } break;
+      case blp::DataType::FLOAT32:
+      case blp::DataType::FLOAT64: {
+        blp::Float64 value;
+        if (0 != element.getValueAs(&value)) {
+            return false;
+        }
+        // 17 significant digits round-trip any double.
+        std::snprintf(buffer, sizeof buffer, "%.17g", value);
+        json->append(buffer);
+      } break;
+      case blp::DataType::CHAR:
+      case blp::DataType::STRING:
+      case blp::DataType::ENUMERATION:
+      case blp::DataType::DATE:
+      case blp::DataType::TIME:
+      case blp::DataType::DATETIME: {
+        std::string value;
+        if (0 != element.getValueAs(&value)) {
+            return false;
+        }
+        appendString(json, value.c_str());
+      } break;
+      default:
+        return false;
+    }
+    return true;
+}
+}
+
+EventRecorder::EventRecorder(std::ostream *capture, std::ostream *schema)
+: d_capture(capture)
+, d_schema(schema)
+, d_events(0)
+, d_started(false)
+{
+}
+
+void EventRecorder::record(const blp::Event&  event,
+                           const TopicTable  *topicTable)
+{
+    if (event.eventType() != blp::Event::SUBSCRIPTION_DATA) {
+        return;
+    }
+    blp::TimePoint now = blp::HighResolutionClock::now();
+
+    std::lock_guard<std::mutex> guard(d_mutex);
+    bool                        recorded = false;
+    blp::MessageIterator        msgIter(event);
+    while (msgIter.next()) {
+        blp::Message   msg = msgIter.message();
+        blp::TimePoint received;
+        if (0 != msg.timeReceived(&received)) {
+            received = now;
+        }
+        if (!d_started) {
+            d_started = true;
+            d_start   = received;
+            if (d_schema) {
+                blptst::TestUtil::serializeService(*d_schema, msg.service());
+                d_schema->flush();
+            }
+        }
+
+        char prefix[64];
+        std::snprintf(prefix,
+                      sizeof prefix,
+                      "{\"event\":%lu,\"ns\":%lld",
+                      static_cast<unsigned long>(d_events),
+                      blp::TimePointUtil::nanosecondsBetween(d_start,
+                                                             received));
+        d_line.assign(prefix);
+
+        const blp::CorrelationId cid = msg.correlationId();
+        if (cid.valueType() == blp::CorrelationId::INT_VALUE) {
+            std::snprintf(prefix, sizeof prefix, ",\"cid\":%lld",
+                          static_cast<long long>(cid.asInteger()));
+            d_line.append(prefix);
+
+            const std::size_t id = TopicTable::topicId(cid);
+            if (topicTable && id < topicTable->size()) {
+                d_line.append(",\"topic\":");
+                appendString(&d_line, (*topicTable)[id].d_topic.c_str());
+            }
+        }
+        d_line.append(",\"type\":");
+        appendString(&d_line, msg.messageType().string());
+        d_line.append(",\"msg\":");
+        formatMessage(&d_line, msg);
+        d_line.append("}\n");
+
+        d_capture->write(d_line.data(), d_line.size());
+        recorded = true;
+    }
+    if (recorded) {
+        ++d_events;
+    }
+}
+
+std::size_t EventRecorder::events() const
+{
+    std::lock_guard<std::mutex> guard(d_mutex);
+    return d_events;
+}
+
+void EventRecorder::formatMessage(std::string         *json,
+                                  const blp::Message&  msg)
+{
+    const blp::Element root  = msg.asElement();
+    bool               first = true;
+    json->push_back('{');
+    for (std::size_t i = 0; i < root.numElements(); ++i) {
+        blp::Element element = root.getElement(i);
+        if (element.isNull() || element.isArray()
+                || element.isComplexType()) {
+            continue;
+        }
+
+        const std::size_t mark = json->size();
+        if (!first) {
+            json->push_back(',');
+        }
+        appendString(json, element.name().string());
+        json->push_back(':');
+        if (appendValue(json, element)) {
+            first = false;
+        }
+        else {
+            json->resize(mark);
+        }
+    }
+    json->push_back('}');
+}
@@ -0,0 +1,112 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _EVENTRECORDER_H_
+#define _EVENTRECORDER_H_
+
+#include <blpapi_event.h>
+#include <blpapi_message.h>
+#include <blpapi_session.h>
+#include <blpapi_timepoint.h>
+
+#include <cstddef>
+#include <mutex>
+#include <ostream>
+#include <string>
+
+#include "topictable.h"
+
+namespace blp = BloombergLP::blpapi;
+
+// EventRecorder writes subscription data messages to a capture stream, one
+// JSON object per line:
+//
+//   {"event":0,"ns":0,"cid":3,"topic":"IBM US Equity",
+//    "type":"MarketDataEvents","msg":{...}}
+//
+// (on one line) where 'event' numbers the recorded events (messages of one
+// event share it), 'ns' is the time the message was received relative to
+// the first recorded message, 'cid' is the integer correlation id (omitted
+// for other kinds), 'topic' is the topic the 'TopicTable' of the recording
+// session holds for that id (omitted without one) and 'msg' holds the scalar fields of the message in the form
+// 'blp::test::MessageFormatter::formatMessageJson' accepts.  The schema of
+// the service the messages belong to is written once to the schema stream,
+// so that 'EventReplayer' can rebuild the events.
+//
+// Correlation ids are only unique within one session, so when several
+// sessions share a recorder the replay routes messages by 'topic'.  'record'
+// may be called from several dispatcher threads.
+class EventRecorder {
+  private:
+    std::ostream       *d_capture;
+    std::ostream       *d_schema;
+    mutable std::mutex  d_mutex;
+    std::size_t         d_events;
+    bool                d_started;
+    blp::TimePoint      d_start;
+    std::string         d_line;
+
+    EventRecorder(const EventRecorder&);
+    EventRecorder& operator=(const EventRecorder&);
+
+  public:
+    EventRecorder(std::ostream *capture, std::ostream *schema = 0);
+
+    void record(const blp::Event& event, const TopicTable *topicTable = 0);
+        // Write every message of 'event' if it is a subscription data event,
+        // with the topic of its correlation id in 'topicTable' if given.
+
+    std::size_t events() const;
+        // Return the number of events recorded so far.
+
+    static void formatMessage(std::string *json, const blp::Message& msg);
+        // Append to 'json' a JSON object holding every non-null scalar field
+        // of 'msg'.  Arrays and complex fields are skipped.
+};
+
+// RecordingEventHandler records every event with an 'EventRecorder', if one
+// is set, before forwarding it to another handler.  'topicTable' is that of
+// the session the handler is bound to.
+class RecordingEventHandler : public blp::EventHandler {
+  private:
+    EventRecorder     *d_recorder;
+    blp::EventHandler *d_handler;
+    const TopicTable  *d_topicTable;
+
+  public:
+    RecordingEventHandler(EventRecorder     *recorder,
+                          blp::EventHandler *handler,
+                          const TopicTable  *topicTable = 0)
+    : d_recorder(recorder)
+    , d_handler(handler)
+    , d_topicTable(topicTable)
+    {
+    }
+
+    virtual bool processEvent(const blp::Event& event, blp::Session *session)
+    {
+        if (d_recorder) {
+            d_recorder->record(event, d_topicTable);
+        }
+        return d_handler->processEvent(event, session);
+    }
+};
+
+#endif
@@ -0,0 +1,226 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "eventreplayer.h"
+
+#include <blpapi_correlationid.h>
+#include <blpapi_exception.h>
+#include <blpapi_name.h>
+#include <blpapi_testutil.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace blptst = blp::test;
+
+namespace {
+bool parseInteger(long long *value, const std::string& line, const char *key)
+{
+    std::string::size_type pos = line.find(key);
+    if (pos == std::string::npos) {
+        return false;
+    }
+    const char *begin = line.c_str() + pos + std::strlen(key);
+    char       *end   = 0;
+    *value            = std::strtoll(begin, &end, 10);
+    return end != begin;
+}
+
+bool parseString(std::string        *value,
+                 const std::string&  line,
+                 const char         *key)
+{
+    // Undo the escaping of 'EventRecorder': a backslash quotes the next
+    // character, and control characters never appear in topics.
+    std::string::size_type pos = line.find(key);
+    if (pos == std::string::npos) {
+        return false;
+    }
+    value->clear();
+    for (pos += std::strlen(key); pos < line.size(); ++pos) {
+        if (line[pos] == '"') {
+            return true;
+        }
+        if (line[pos] == '\\' && pos + 1 < line.size()) {
+            ++pos;
+        }
+        value->push_back(line[pos]);
+    }
+    return false;
+}
+}
+
+EventReplayer::EventReplayer(const blp::Service& service)
+: d_service(service)
+, d_malformed(0)
+, d_maxCorrelationId(-1)
+{
+}
+
+bool EventReplayer::parseRecord(Record *record, const std::string& line)
+{
+    // The keys are written in a fixed order, 'msg' last; nothing before it
+    // can contain a brace, so a search for each key is enough.
+    long long event = 0;
+    if (!parseInteger(&event, line, "\"event\":") || event < 0
+            || !parseInteger(&record->d_ns, line, "\"ns\":")) {
+        return false;
+    }
+    record->d_event = static_cast<std::size_t>(event);
+
+    const std::string::size_type msg = line.find(",\"msg\":");
+    if (msg == std::string::npos) {
+        return false;
+    }
+    const std::string header(line, 0, msg);
+    if (!parseInteger(&record->d_correlationId, header, "\"cid\":")) {
+        record->d_correlationId = -1;
+    }
+    if (!parseString(&record->d_topic, header, "\"topic\":\"")) {
+        record->d_topic.clear();
+    }
+
+    const std::string::size_type type = header.find("\"type\":\"");
+    if (type == std::string::npos) {
+        return false;
+    }
+    const std::string::size_type typeBegin = type + std::strlen("\"type\":\"");
+    const std::string::size_type typeEnd   = header.find('"', typeBegin);
+    if (typeEnd == std::string::npos) {
+        return false;
+    }
+    record->d_type.assign(header, typeBegin, typeEnd - typeBegin);
+
+    std::string::size_type end = line.find_last_of('}');
+    const std::string::size_type begin = msg + std::strlen(",\"msg\":");
+    if (end == std::string::npos || end <= begin) {
+        return false;
+    }
+    record->d_message.assign(line, begin, end - begin);
+    return !record->d_message.empty() && record->d_message[0] == '{';
+}
+
+long long EventReplayer::correlationId(const Record& record)
+{
+    if (record.d_topic.empty()) {
+        return record.d_correlationId;
+    }
+    std::map<std::string, long long>::const_iterator it =
+                                               d_topicIds.find(record.d_topic);
+    if (it != d_topicIds.end()) {
+        return it->second;
+    }
+    const long long id = static_cast<long long>(d_topics.size());
+    d_topics.push_back(record.d_topic);
+    d_topicIds[record.d_topic] = id;
+    return id;
+}
+
+std::size_t EventReplayer::load(std::istream& capture)
+{
+    std::string line;
+    Record      record;
+    std::size_t current = 0;
+    bool        open    = false;
+    while (std::getline(capture, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        if (!parseRecord(&record, line)) {
+            ++d_malformed;
+            continue;
+        }
+        if (!open || record.d_event != current) {
+            RecordedEvent recorded;
+            recorded.d_event = blptst::TestUtil::createEvent(
+                                              blp::Event::SUBSCRIPTION_DATA);
+            recorded.d_ns       = record.d_ns;
+            recorded.d_messages = 0;
+            d_events.push_back(recorded);
+            current = record.d_event;
+            open    = true;
+        }
+
+        try {
+            blptst::MessageProperties properties;
+            const long long           id = correlationId(record);
+            if (id >= 0) {
+                properties.setCorrelationId(blp::CorrelationId(id));
+                if (id > d_maxCorrelationId) {
+                    d_maxCorrelationId = id;
+                }
+            }
+            blptst::TestUtil::appendMessage(
+                d_events.back().d_event,
+                d_service.getEventDefinition(record.d_type.c_str()),
+                properties)
+                .formatMessageJson(record.d_message.c_str());
+            ++d_events.back().d_messages;
+        }
+        catch (const blp::Exception&) {
+            ++d_malformed;
+        }
+    }
+    return d_events.size();
+}
+
+EventReplayer::Statistics EventReplayer::replay(blp::EventHandler *handler,
+                                                double             speed,
+                                                blp::Session      *session)
+    const
+{
+    typedef std::chrono::steady_clock Clock;
+
+    Statistics stats;
+    stats.d_events   = 0;
+    stats.d_messages = 0;
+
+    const Clock::time_point start = Clock::now();
+    const long long         first = d_events.empty() ? 0 : d_events[0].d_ns;
+    for (std::size_t i = 0; i < d_events.size(); ++i) {
+        const RecordedEvent& recorded = d_events[i];
+        if (speed > 0) {
+            std::chrono::nanoseconds offset(static_cast<long long>(
+                                         (recorded.d_ns - first) / speed));
+            std::this_thread::sleep_until(start + offset);
+        }
+        handler->processEvent(recorded.d_event, session);
+        ++stats.d_events;
+        stats.d_messages += recorded.d_messages;
+    }
+    stats.d_elapsedSeconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+    return stats;
+}
+
+std::ostream& operator<<(std::ostream&                    stream,
+                         const EventReplayer::Statistics& stats)
+{
+    stream << "Replay: events=" << stats.d_events
+           << " messages=" << stats.d_messages
+           << " seconds=" << stats.d_elapsedSeconds
+           << " messagesPerSecond="
+           << (stats.d_elapsedSeconds > 0
+                   ? stats.d_messages / stats.d_elapsedSeconds
+                   : 0);
+    return stream;
+}
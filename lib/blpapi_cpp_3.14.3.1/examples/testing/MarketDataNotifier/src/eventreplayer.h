@@ -0,0 +1,133 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _EVENTREPLAYER_H_
+#define _EVENTREPLAYER_H_
+
+#include <blpapi_event.h>
+#include <blpapi_service.h>
+#include <blpapi_session.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace blp = BloombergLP::blpapi;
+
+// EventReplayer rebuilds the events written by 'EventRecorder' with
+// 'blp::test::TestUtil' and feeds them to an event handler, so that the
+// processing pipeline can be exercised and timed without a session.  Events
+// are built by 'load', ahead of the replay, so that 'replay' only measures
+// the handler.
+//
+// Messages recorded with a topic are replayed with a correlation id of their
+// own per topic, numbered from 0 in the order the topics first appear and
+// listed by 'topics', since the recorded ids of different sessions collide.
+// Messages recorded without one keep their recorded id.
+class EventReplayer {
+  public:
+    struct Record {
+        std::size_t d_event;
+        long long   d_ns;
+        long long   d_correlationId;    // -1 if none was recorded
+        std::string d_topic;            // empty if none was recorded
+        std::string d_type;
+        std::string d_message;          // JSON object
+    };
+
+    struct Statistics {
+        std::uint64_t d_events;
+        std::uint64_t d_messages;
+        double        d_elapsedSeconds;
+    };
+
+  private:
+    struct RecordedEvent {
+        blp::Event  d_event;
+        long long   d_ns;
+        std::size_t d_messages;
+    };
+
+    blp::Service                      d_service;
+    std::vector<RecordedEvent>        d_events;
+    std::size_t                       d_malformed;
+    long long                         d_maxCorrelationId;
+    std::vector<std::string>          d_topics;
+    std::map<std::string, long long>  d_topicIds;
+
+    long long correlationId(const Record& record);
+        // Return the correlation id to replay 'record' with, or -1.
+
+  public:
+    explicit EventReplayer(const blp::Service& service);
+        // Create a replayer building messages from the event definitions of
+        // 'service'.
+
+    static bool parseRecord(Record *record, const std::string& line);
+        // Load into 'record' the line of a capture.  Return false if 'line'
+        // is not in the format 'EventRecorder' writes.
+
+    std::size_t load(std::istream& capture);
+        // Build the events of 'capture' and return how many there are.
+        // Malformed lines and messages not matching the schema are skipped.
+
+    Statistics replay(blp::EventHandler *handler,
+                      double             speed,
+                      blp::Session      *session = 0) const;
+        // Pass every loaded event to 'handler'.  If 'speed' is positive the
+        // events are paced at 'speed' times the recorded rate, otherwise
+        // they are replayed as fast as possible.
+
+    std::size_t malformed() const;
+
+    long long maxCorrelationId() const;
+        // Return the largest integer correlation id loaded, or -1.
+
+    const std::vector<std::string>& topics() const;
+        // Return the recorded topics, indexed by the correlation id their
+        // messages are replayed with.
+};
+
+std::ostream& operator<<(std::ostream&                     stream,
+                         const EventReplayer::Statistics&  stats);
+
+inline
+std::size_t EventReplayer::malformed() const
+{
+    return d_malformed;
+}
+
+inline
+long long EventReplayer::maxCorrelationId() const
+{
+    return d_maxCorrelationId;
+}
+
+inline
+const std::vector<std::string>& EventReplayer::topics() const
+{
+    return d_topics;
+}
+
+#endif
@@ -0,0 +1,79 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "fieldregistry.h"
+
+#include <blpapi_element.h>
+
+namespace {
+const char LAST_PRICE[] = "LAST_PRICE";
+}
+
+FieldRegistry::FieldRegistry(const std::vector<std::string>& fields)
+: d_lastPriceSlot(0)
+{
+    blp::Name lastPrice(LAST_PRICE);
+    d_names.push_back(lastPrice);
+
+    for (std::size_t i = 0; i < fields.size(); ++i) {
+        if (d_names.size() == FieldValues::k_MAX_FIELDS) {
+            break;
+        }
+        blp::Name   name(fields[i].c_str());
+        std::size_t j = 0;
+        while (j < d_names.size() && d_names[j] != name) {
+            ++j;
+        }
+        if (j == d_names.size()) {
+            d_names.push_back(name);
+        }
+    }
+}
+
+const FieldRegistry& FieldRegistry::lastPriceOnly()
+{
+    static const FieldRegistry registry((std::vector<std::string>()));
+    return registry;
+}
+
+std::size_t FieldRegistry::slot(const blp::Name& name) const
+{
+    std::size_t i = 0;
+    while (i < d_names.size() && d_names[i] != name) {
+        ++i;
+    }
+    return i;
+}
+
+bool FieldRegistry::extract(FieldValues         *values,
+                            const blp::Message&  msg) const
+{
+    values->d_present = 0;
+
+    const blp::Element root = msg.asElement();
+    blp::Element       element;
+    for (std::size_t i = 0; i < d_names.size(); ++i) {
+        if (0 == root.getElement(&element, d_names[i])
+                && 0 == element.getValueAs(&values->d_values[i])) {
+            values->d_present |= 1u << i;
+        }
+    }
+    return values->d_present != 0;
+}
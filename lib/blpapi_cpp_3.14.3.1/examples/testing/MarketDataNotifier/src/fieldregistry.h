@@ -0,0 +1,82 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _FIELDREGISTRY_H_
+#define _FIELDREGISTRY_H_
+
+#include <blpapi_message.h>
+#include <blpapi_name.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "tick.h"
+
+namespace blp = BloombergLP::blpapi;
+
+// FieldRegistry resolves the configured fields to 'blp::Name's once, so that
+// extracting them from a message costs one lookup per field by interned name
+// rather than one or two lookups by C string.  'LAST_PRICE' is always
+// registered because the compute stage depends on it.  Fields beyond
+// 'FieldValues::k_MAX_FIELDS' are still subscribed to, but not extracted.
+class FieldRegistry {
+  private:
+    std::vector<blp::Name> d_names;
+    std::size_t            d_lastPriceSlot;
+
+  public:
+    explicit FieldRegistry(const std::vector<std::string>& fields);
+
+    static const FieldRegistry& lastPriceOnly();
+        // Return a registry holding only 'LAST_PRICE'.
+
+    bool extract(FieldValues *values, const blp::Message& msg) const;
+        // Load into 'values' every registered field of 'msg' that has a
+        // numeric value.  Return true if at least one field was found.
+
+    std::size_t slot(const blp::Name& name) const;
+        // Return the slot 'name' is extracted into, or 'size()' if it is not
+        // registered.
+
+    std::size_t size() const;
+    std::size_t lastPriceSlot() const;
+    const blp::Name& name(std::size_t slot) const;
+};
+
+inline
+std::size_t FieldRegistry::size() const
+{
+    return d_names.size();
+}
+
+inline
+std::size_t FieldRegistry::lastPriceSlot() const
+{
+    return d_lastPriceSlot;
+}
+
+inline
+const blp::Name& FieldRegistry::name(std::size_t slot) const
+{
+    return d_names[slot];
+}
+
+#endif
@@ -0,0 +1,242 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "lastvaluecache.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static_assert(FieldValues::k_MAX_FIELDS <= LastValueHeader::k_MAX_FIELDS,
+              "every extracted field must have a column");
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+              "shared-memory atomics must be lock-free");
+
+const std::size_t LastValueHeader::k_MAX_FIELDS;
+
+#ifndef _WIN32
+namespace {
+bool isStale(const std::string& name)
+    // Return true if the segment 'name' was provably left by a run that is
+    // over: it was never filled, or the process that filled it is gone.
+{
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd == -1) {
+        return errno == ENOENT;
+    }
+    struct stat status;
+    void       *base = MAP_FAILED;
+    if (fstat(fd, &status) == 0
+            && static_cast<std::size_t>(status.st_size)
+                                                >= sizeof(LastValueHeader)) {
+        base = mmap(0, sizeof(LastValueHeader), PROT_READ, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (base == MAP_FAILED) {
+        return true;                                 // too small for a header
+    }
+    const LastValueHeader *header = static_cast<LastValueHeader *>(base);
+    const bool stale =
+        header->d_magic.load(std::memory_order_acquire)
+                                                  != LastValueHeader::k_MAGIC
+        || (kill(header->d_writerPid, 0) == -1 && errno == ESRCH);
+    munmap(base, sizeof(LastValueHeader));
+    return stale;
+}
+}
+#endif
+
+LastValueCache::LastValueCache()
+: d_base(0)
+, d_size(0)
+, d_rows(0)
+, d_numRows(0)
+, d_staleUpdates(0)
+{
+}
+
+LastValueCache::~LastValueCache()
+{
+#ifndef _WIN32
+    if (d_base) {
+        munmap(d_base, d_size);
+        shm_unlink(d_name.c_str());
+    }
+#endif
+}
+
+bool LastValueCache::create(const std::string&              name,
+                            const std::vector<std::string>& topics,
+                            const FieldRegistry&            fields)
+{
+#ifdef _WIN32
+    std::cerr << "The last-value cache needs POSIX shared memory"
+              << std::endl;
+    return false;
+#else
+    // A truncated topic would never be found by 'LastValueReader::findTopic'.
+    for (std::size_t i = 0; i < topics.size(); ++i) {
+        if (topics[i].size() >= LastValueRow::k_TOPIC_SIZE) {
+            std::cerr << "Topic too long for the last-value cache (at most "
+                      << LastValueRow::k_TOPIC_SIZE - 1 << " characters): "
+                      << topics[i] << std::endl;
+            return false;
+        }
+    }
+
+    const std::size_t size = LastValueHeader::rowsOffset()
+                             + topics.size() * sizeof(LastValueRow);
+
+    // A segment left by a run that did not exit cleanly has the wrong size
+    // or stale values, and is replaced; readers holding it keep their
+    // mapping.  One that another process still writes is left alone.
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd == -1 && errno == EEXIST && isStale(name)) {
+        shm_unlink(name.c_str());
+        fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    }
+    if (fd == -1) {
+        if (errno == EEXIST) {
+            std::cerr << "Failed to create " << name << ": it is in use by"
+                      << " another process" << std::endl;
+        }
+        else {
+            std::cerr << "Failed to create " << name << ": "
+                      << std::strerror(errno) << std::endl;
+        }
+        return false;
+    }
+    void *base = MAP_FAILED;
+    if (ftruncate(fd, size) == 0) {
+        base = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    const int error = errno;
+    close(fd);
+    if (base == MAP_FAILED) {
+        std::cerr << "Failed to map " << name << ": " << std::strerror(error)
+                  << std::endl;
+        shm_unlink(name.c_str());
+        return false;
+    }
+
+    // 'ftruncate' zero-fills the segment, which is a valid state for every
+    // atomic: no field present and an even sequence.  The magic number is
+    // stored last so readers never see a header without its names.
+    LastValueHeader *header = new (base) LastValueHeader;
+    header->d_numRows   = static_cast<std::uint32_t>(topics.size());
+    header->d_numFields = static_cast<std::uint32_t>(
+                      std::min(fields.size(), LastValueHeader::k_MAX_FIELDS));
+    header->d_rowSize   = sizeof(LastValueRow);
+    header->d_writerPid = static_cast<std::int32_t>(getpid());
+    for (std::size_t i = 0; i < header->d_numFields; ++i) {
+        std::strncpy(header->d_fields[i],
+                     fields.name(i).string(),
+                     LastValueHeader::k_FIELD_NAME_SIZE - 1);
+    }
+
+    d_rows = reinterpret_cast<LastValueRow *>(static_cast<char *>(base)
+                                              + LastValueHeader::rowsOffset());
+    for (std::size_t i = 0; i < topics.size(); ++i) {
+        LastValueRow *row = new (&d_rows[i]) LastValueRow;
+        std::strncpy(row->d_topic,
+                     topics[i].c_str(),
+                     LastValueRow::k_TOPIC_SIZE - 1);
+    }
+
+    d_name    = name;
+    d_base    = base;
+    d_size    = size;
+    d_numRows = topics.size();
+    d_receivedNs.assign(topics.size(), 0);
+    header->d_magic.store(LastValueHeader::k_MAGIC, std::memory_order_release);
+    return true;
+#endif
+}
+
+void LastValueCache::update(std::size_t        row,
+                            const FieldValues& values,
+                            long long          receivedNs)
+{
+    if (row >= d_numRows) {
+        return;
+    }
+    LastValueRow& target = d_rows[row];
+
+    // Take the row: only the writer that moves the sequence from even to odd
+    // may write it.
+    std::uint64_t sequence = target.d_sequence.load(std::memory_order_relaxed);
+    for (;;) {
+        if (!(sequence & 1u)
+                && target.d_sequence.compare_exchange_weak(
+                                                  sequence,
+                                                  sequence + 1,
+                                                  std::memory_order_acquire,
+                                                  std::memory_order_relaxed)) {
+            break;
+        }
+        std::this_thread::yield();
+        sequence = target.d_sequence.load(std::memory_order_relaxed);
+    }
+
+    if (receivedNs != 0 && receivedNs < d_receivedNs[row]) {
+        // Nothing was written, so restoring the sequence leaves readers'
+        // copies valid.
+        target.d_sequence.store(sequence, std::memory_order_release);
+        d_staleUpdates.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (receivedNs != 0) {
+        d_receivedNs[row] = receivedNs;
+    }
+
+    // Readers that see any of the stores below also see the odd sequence.
+    std::atomic_thread_fence(std::memory_order_release);
+
+    std::uint32_t present = target.d_present.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < FieldValues::k_MAX_FIELDS; ++i) {
+        if (values.has(i)) {
+            target.d_values[i].store(values.d_values[i],
+                                     std::memory_order_relaxed);
+            present |= 1u << i;
+        }
+    }
+    target.d_present.store(present, std::memory_order_relaxed);
+    target.d_updatedNs.store(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count(),
+        std::memory_order_relaxed);
+    target.d_updates.store(
+        target.d_updates.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+
+    target.d_sequence.store(sequence + 2, std::memory_order_release);
+}
@@ -0,0 +1,98 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _LASTVALUECACHE_H_
+#define _LASTVALUECACHE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "fieldregistry.h"
+#include "lastvaluereader.h"
+#include "tick.h"
+
+// LastValueCache publishes the last value of every field of every topic in a
+// POSIX shared-memory segment, in the layout 'lastvaluereader.h' describes,
+// so that other processes read current prices from one feed instead of each
+// subscribing.  Rows are numbered in the order of the topics given to
+// 'create', and fields by their 'FieldRegistry' slot.
+//
+// 'update' may be called from several dispatcher threads: a writer takes a
+// row by making its sequence odd with a compare-and-swap.  An update received
+// before the last one applied to its row is dropped, as 'EventProcessor'
+// drops stale ticks.  The segment is removed when the cache is destroyed.
+class LastValueCache {
+  private:
+    std::string                d_name;
+    void                      *d_base;
+    std::size_t                d_size;
+    LastValueRow              *d_rows;
+    std::size_t                d_numRows;
+    std::vector<long long>     d_receivedNs;    // of the last update per row
+    std::atomic<std::uint64_t> d_staleUpdates;
+
+    LastValueCache(const LastValueCache&);
+    LastValueCache& operator=(const LastValueCache&);
+
+  public:
+    LastValueCache();
+    ~LastValueCache();
+
+    bool create(const std::string&              name,
+                const std::vector<std::string>& topics,
+                const FieldRegistry&            fields);
+        // Create the segment 'name', replacing any left by an earlier run
+        // that is over, with a row for each of 'topics' and a column for
+        // each field of 'fields'.  Field names are truncated to fit.  Return
+        // false, printing why, if a topic has 'LastValueRow::k_TOPIC_SIZE'
+        // or more characters, a running process owns 'name', or the segment
+        // could not be created.
+
+    void update(std::size_t        row,
+                const FieldValues& values,
+                long long          receivedNs);
+        // Store the fields present in 'values' into 'row', keeping the last
+        // value of the others.  'receivedNs' is when the tick was received,
+        // on a clock that is the same for every update of 'row', or 0 if
+        // unknown.  Rows out of range are ignored.
+
+    std::size_t numRows() const;
+
+    std::uint64_t staleUpdates() const;
+        // Return the number of updates dropped because a later one had
+        // already been applied to their row.
+};
+
+inline
+std::size_t LastValueCache::numRows() const
+{
+    return d_numRows;
+}
+
+inline
+std::uint64_t LastValueCache::staleUpdates() const
+{
+    return d_staleUpdates.load(std::memory_order_relaxed);
+}
+
+#endif
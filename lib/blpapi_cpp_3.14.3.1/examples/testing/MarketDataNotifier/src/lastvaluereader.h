@@ -0,0 +1,310 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _LASTVALUEREADER_H_
+#define _LASTVALUEREADER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// This header is the whole interface to the last-value cache that
+// 'marketDataNotifier -lvc <name>' publishes in the POSIX shared-memory
+// segment '<name>'.  It depends on nothing but the standard library, so any
+// process on the machine can include it to read current values without a
+// BLPAPI session.
+//
+// The segment is a 'LastValueHeader' followed by one 'LastValueRow' per
+// topic.  The header names the topics' fields, which are the same for every
+// row.  Each row is guarded by a seqlock: the writer makes 'd_sequence' odd
+// while it updates the row and even again once done, and a reader copies
+// the row and retries if the sequence was odd or changed meanwhile.  Reading
+// therefore takes neither a lock nor a system call, and never returns a row
+// that is half old and half new.  A reader gives up after
+// 'LastValueReader::k_MAX_ATTEMPTS' tries, so a writer that died while
+// updating a row leaves that row unavailable instead of hanging its readers.
+
+struct LastValueHeader {
+    static const std::uint32_t k_MAGIC           = 0x4c564331;  // "LVC1"
+    static const std::size_t   k_MAX_FIELDS      = 8;
+    static const std::size_t   k_FIELD_NAME_SIZE = 32;
+
+    std::atomic<std::uint32_t> d_magic;     // set once the segment is filled
+    std::uint32_t              d_numRows;
+    std::uint32_t              d_numFields;
+    std::uint32_t              d_rowSize;   // 'sizeof(LastValueRow)'
+    std::int32_t               d_writerPid; // process that created it
+    char                       d_fields[k_MAX_FIELDS][k_FIELD_NAME_SIZE];
+
+    static std::size_t rowsOffset();
+        // Return the offset of the first row from the start of the segment.
+};
+
+struct alignas(64) LastValueRow {
+    static const std::size_t k_TOPIC_SIZE = 64;
+
+    std::atomic<std::uint64_t> d_sequence;   // odd while being written
+    std::atomic<std::uint32_t> d_present;    // bit 'n': field 'n' has a value
+    std::atomic<long long>     d_updatedNs;  // since the Unix epoch
+    std::atomic<std::uint64_t> d_updates;
+    std::atomic<double>        d_values[LastValueHeader::k_MAX_FIELDS];
+    char                       d_topic[k_TOPIC_SIZE];  // never changes
+};
+
+inline
+std::size_t LastValueHeader::rowsOffset()
+{
+    const std::size_t alignment = alignof(LastValueRow);
+    return (sizeof(LastValueHeader) + alignment - 1) / alignment * alignment;
+}
+
+// LastValue is a consistent copy of one row.
+struct LastValue {
+    double        d_values[LastValueHeader::k_MAX_FIELDS];
+    std::uint32_t d_present;
+    long long     d_updatedNs;
+    std::uint64_t d_updates;
+
+    bool has(std::size_t field) const
+    {
+        return (d_present >> field) & 1u;
+    }
+};
+
+// LastValueReader maps a last-value cache read-only.  Look topics and fields
+// up once with 'findTopic' and 'findField', then 'read' as often as needed.
+class LastValueReader {
+  public:
+    static const int k_MAX_ATTEMPTS = 1 << 16;
+        // Tries to copy a row before 'read' reports it unavailable; an
+        // update takes well under a microsecond, so only a writer that
+        // stopped half way through exhausts them.
+
+  private:
+    const char            *d_base;
+    std::size_t            d_size;
+    const LastValueHeader *d_header;
+    const LastValueRow    *d_rows;
+
+    LastValueReader(const LastValueReader&);
+    LastValueReader& operator=(const LastValueReader&);
+
+  public:
+    LastValueReader();
+    ~LastValueReader();
+
+    bool open(const std::string& name);
+        // Map the cache published as 'name' (for example "/mktdata").
+        // Return false if it does not exist or is not a complete cache.
+
+    void close();
+
+    std::size_t numTopics() const;
+    std::size_t numFields() const;
+
+    std::size_t findTopic(const std::string& topic) const;
+        // Return the row of 'topic', or 'numTopics()' if it is not cached.
+
+    std::size_t findField(const std::string& field) const;
+        // Return the slot of 'field', or 'numFields()' if it is not cached.
+
+    const char *topic(std::size_t row) const;
+    const char *field(std::size_t slot) const;
+
+    bool read(LastValue *value, std::size_t row) const;
+        // Load into 'value' a consistent copy of 'row'.  Return false,
+        // leaving 'value' unspecified, if the row was being written on each
+        // of 'k_MAX_ATTEMPTS' tries.
+
+    bool read(double *value, std::size_t row, std::size_t field) const;
+        // Load into 'value' the last value of 'field' for 'row'.  Return
+        // false if none has been received or the row is unavailable.
+};
+
+inline
+LastValueReader::LastValueReader()
+: d_base(0)
+, d_size(0)
+, d_header(0)
+, d_rows(0)
+{
+}
+
+inline
+LastValueReader::~LastValueReader()
+{
+    close();
+}
+
+inline
+bool LastValueReader::open(const std::string& name)
+{
+    close();
+#ifdef _WIN32
+    (void)name;
+    return false;
+#else
+    int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat status;
+    void       *base = MAP_FAILED;
+    if (fstat(fd, &status) == 0
+            && static_cast<std::size_t>(status.st_size)
+                                                >= sizeof(LastValueHeader)) {
+        base = mmap(0, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        return false;
+    }
+    d_base   = static_cast<const char *>(base);
+    d_size   = status.st_size;
+    d_header = reinterpret_cast<const LastValueHeader *>(d_base);
+    const std::size_t offset = LastValueHeader::rowsOffset();
+    if (d_header->d_magic.load(std::memory_order_acquire)
+                                                 != LastValueHeader::k_MAGIC
+            || d_header->d_rowSize != sizeof(LastValueRow)
+            || d_header->d_numFields > LastValueHeader::k_MAX_FIELDS
+            || offset + d_header->d_numRows * sizeof(LastValueRow) > d_size) {
+        close();
+        return false;
+    }
+    d_rows = reinterpret_cast<const LastValueRow *>(d_base + offset);
+    return true;
+#endif
+}
+
+inline
+void LastValueReader::close()
+{
+#ifndef _WIN32
+    if (d_base) {
+        munmap(const_cast<char *>(d_base), d_size);
+    }
+#endif
+    d_base   = 0;
+    d_size   = 0;
+    d_header = 0;
+    d_rows   = 0;
+}
+
+inline
+std::size_t LastValueReader::numTopics() const
+{
+    return d_header ? d_header->d_numRows : 0;
+}
+
+inline
+std::size_t LastValueReader::numFields() const
+{
+    return d_header ? d_header->d_numFields : 0;
+}
+
+inline
+std::size_t LastValueReader::findTopic(const std::string& topic) const
+{
+    std::size_t row = 0;
+    while (row < numTopics()
+            && std::strncmp(d_rows[row].d_topic,
+                            topic.c_str(),
+                            LastValueRow::k_TOPIC_SIZE) != 0) {
+        ++row;
+    }
+    return row;
+}
+
+inline
+std::size_t LastValueReader::findField(const std::string& field) const
+{
+    std::size_t slot = 0;
+    while (slot < numFields()
+            && std::strncmp(d_header->d_fields[slot],
+                            field.c_str(),
+                            LastValueHeader::k_FIELD_NAME_SIZE) != 0) {
+        ++slot;
+    }
+    return slot;
+}
+
+inline
+const char *LastValueReader::topic(std::size_t row) const
+{
+    return d_rows[row].d_topic;
+}
+
+inline
+const char *LastValueReader::field(std::size_t slot) const
+{
+    return d_header->d_fields[slot];
+}
+
+inline
+bool LastValueReader::read(LastValue *value, std::size_t row) const
+{
+    const LastValueRow& source = d_rows[row];
+    for (int attempt = 0; attempt < k_MAX_ATTEMPTS; ++attempt) {
+        const std::uint64_t before =
+                             source.d_sequence.load(std::memory_order_acquire);
+        if (before & 1u) {
+            continue;                                    // being written
+        }
+        for (std::size_t i = 0; i < LastValueHeader::k_MAX_FIELDS; ++i) {
+            value->d_values[i] =
+                           source.d_values[i].load(std::memory_order_relaxed);
+        }
+        value->d_present   = source.d_present.load(std::memory_order_relaxed);
+        value->d_updatedNs =
+                            source.d_updatedNs.load(std::memory_order_relaxed);
+        value->d_updates   = source.d_updates.load(std::memory_order_relaxed);
+
+        // The copy is consistent if no write started before it finished.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (source.d_sequence.load(std::memory_order_relaxed) == before) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline
+bool LastValueReader::read(double      *value,
+                           std::size_t  row,
+                           std::size_t  field) const
+{
+    LastValue copy;
+    if (!read(&copy, row) || !copy.has(field)) {
+        return false;
+    }
+    *value = copy.d_values[field];
+    return true;
+}
+
+#endif
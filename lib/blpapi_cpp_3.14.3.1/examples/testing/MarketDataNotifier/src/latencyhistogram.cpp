@@ -0,0 +1,157 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "latencyhistogram.h"
+
+namespace {
+unsigned highestBit(std::uint64_t value)
+{
+    // Index of the most significant bit set in 'value', which must not be 0.
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    unsigned bit = 0;
+    while (value >>= 1) {
+        ++bit;
+    }
+    return bit;
+#endif
+}
+}
+
+const unsigned    LatencyHistogram::k_SUB_BITS;
+const std::size_t LatencyHistogram::k_SUB_BUCKETS;
+const unsigned    LatencyHistogram::k_MAX_BITS;
+const std::size_t LatencyHistogram::k_BUCKETS;
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+std::size_t LatencyHistogram::bucketOf(std::uint64_t valueNs)
+{
+    if (valueNs < k_SUB_BUCKETS) {
+        return static_cast<std::size_t>(valueNs);
+    }
+    unsigned bit = highestBit(valueNs);
+    if (bit >= k_MAX_BITS) {
+        return k_BUCKETS - 1;
+    }
+
+    // 'valueNs >> shift' keeps the 'k_SUB_BITS + 1' most significant bits,
+    // the highest of which is always set.
+    unsigned shift = bit - k_SUB_BITS;
+    return (shift + 1) * k_SUB_BUCKETS
+         + static_cast<std::size_t>((valueNs >> shift) - k_SUB_BUCKETS);
+}
+
+std::uint64_t LatencyHistogram::highestValueIn(std::size_t bucket)
+{
+    if (bucket < k_SUB_BUCKETS) {
+        return bucket;
+    }
+    unsigned      shift = static_cast<unsigned>(bucket / k_SUB_BUCKETS) - 1;
+    std::uint64_t lower = (k_SUB_BUCKETS + bucket % k_SUB_BUCKETS);
+    return ((lower + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::uint64_t valueNs)
+{
+    d_counts[bucketOf(valueNs)].fetch_add(1, std::memory_order_relaxed);
+    d_count.fetch_add(1, std::memory_order_relaxed);
+    d_totalNs.fetch_add(valueNs, std::memory_order_relaxed);
+
+    std::uint64_t max = d_maxNs.load(std::memory_order_relaxed);
+    while (valueNs > max
+           && !d_maxNs.compare_exchange_weak(
+                  max, valueNs, std::memory_order_relaxed)) {
+    }
+}
+
+std::uint64_t LatencyHistogram::valueAtPercentile(double percentile) const
+{
+    // Sum the buckets rather than trust 'd_count', which concurrent records
+    // may have moved on from.
+    std::uint64_t total = 0;
+    for (std::size_t i = 0; i < k_BUCKETS; ++i) {
+        total += d_counts[i].load(std::memory_order_relaxed);
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    std::uint64_t rank = static_cast<std::uint64_t>(
+                                          percentile / 100.0 * total + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    }
+    if (rank > total) {
+        rank = total;
+    }
+
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < k_BUCKETS; ++i) {
+        seen += d_counts[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            std::uint64_t value = highestValueIn(i);
+            std::uint64_t max   = d_maxNs.load(std::memory_order_relaxed);
+            return value < max ? value : max;
+        }
+    }
+    return d_maxNs.load(std::memory_order_relaxed);
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const
+{
+    Summary summary;
+    summary.d_count  = d_count.load(std::memory_order_relaxed);
+    summary.d_meanNs = summary.d_count
+                         ? d_totalNs.load(std::memory_order_relaxed)
+                               / summary.d_count
+                         : 0;
+    summary.d_p50Ns  = valueAtPercentile(50.0);
+    summary.d_p99Ns  = valueAtPercentile(99.0);
+    summary.d_p999Ns = valueAtPercentile(99.9);
+    summary.d_maxNs  = d_maxNs.load(std::memory_order_relaxed);
+    return summary;
+}
+
+void LatencyHistogram::reset()
+{
+    for (std::size_t i = 0; i < k_BUCKETS; ++i) {
+        d_counts[i].store(0, std::memory_order_relaxed);
+    }
+    d_count.store(0, std::memory_order_relaxed);
+    d_totalNs.store(0, std::memory_order_relaxed);
+    d_maxNs.store(0, std::memory_order_relaxed);
+}
+
+std::ostream& operator<<(std::ostream&                    stream,
+                         const LatencyHistogram::Summary& summary)
+{
+    stream << "count=" << summary.d_count
+           << " meanNs=" << summary.d_meanNs
+           << " p50Ns=" << summary.d_p50Ns
+           << " p99Ns=" << summary.d_p99Ns
+           << " p999Ns=" << summary.d_p999Ns
+           << " maxNs=" << summary.d_maxNs;
+    return stream;
+}
@@ -0,0 +1,91 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _LATENCYHISTOGRAM_H_
+#define _LATENCYHISTOGRAM_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// LatencyHistogram counts nanosecond latencies in log-linear buckets, in the
+// manner of HdrHistogram: every power of two is split into
+// 'k_SUB_BUCKETS' equal buckets, so any recorded value is known to within
+// 1 / k_SUB_BUCKETS (about 3%) with a fixed, small amount of memory.  Values
+// of 2^k_MAX_BITS ns (about 18 minutes) or more are counted in the last
+// bucket; the maximum is kept exactly.
+//
+// 'record' is wait-free and may be called from any number of threads;
+// 'summary' may run concurrently with it and then sees a consistent-enough
+// view for reporting.
+class LatencyHistogram {
+  public:
+    static const unsigned    k_SUB_BITS    = 5;
+    static const std::size_t k_SUB_BUCKETS = std::size_t(1) << k_SUB_BITS;
+    static const unsigned    k_MAX_BITS    = 40;
+    static const std::size_t k_BUCKETS     =
+                                 (k_MAX_BITS - k_SUB_BITS + 1) * k_SUB_BUCKETS;
+
+    struct Summary {
+        std::uint64_t d_count;
+        std::uint64_t d_meanNs;
+        std::uint64_t d_p50Ns;
+        std::uint64_t d_p99Ns;
+        std::uint64_t d_p999Ns;
+        std::uint64_t d_maxNs;
+    };
+
+  private:
+    std::atomic<std::uint64_t> d_counts[k_BUCKETS];
+    std::atomic<std::uint64_t> d_count;
+    std::atomic<std::uint64_t> d_totalNs;
+    std::atomic<std::uint64_t> d_maxNs;
+
+    LatencyHistogram(const LatencyHistogram&);
+    LatencyHistogram& operator=(const LatencyHistogram&);
+
+  public:
+    LatencyHistogram();
+
+    static std::size_t bucketOf(std::uint64_t valueNs);
+        // Return the index of the bucket 'valueNs' is counted in.
+
+    static std::uint64_t highestValueIn(std::size_t bucket);
+        // Return the largest value counted in 'bucket'.
+
+    void record(std::uint64_t valueNs);
+
+    std::uint64_t valueAtPercentile(double percentile) const;
+        // Return the highest value equivalent to the value below which
+        // 'percentile' percent of the recorded values fall, or 0 if nothing
+        // was recorded.
+
+    Summary summary() const;
+
+    void reset();
+        // Forget every recorded value.  Values recorded concurrently may be
+        // partly forgotten.
+};
+
+std::ostream& operator<<(std::ostream&                    stream,
+                         const LatencyHistogram::Summary& summary);
+
+#endif
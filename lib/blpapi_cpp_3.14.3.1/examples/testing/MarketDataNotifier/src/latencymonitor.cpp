@@ -0,0 +1,96 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "latencymonitor.h"
+
+LatencyMonitor::LatencyMonitor(std::ostream *stream, int intervalMs)
+: d_stream(stream)
+, d_interval(intervalMs)
+, d_running(false)
+{
+}
+
+LatencyMonitor::~LatencyMonitor()
+{
+    stop();
+}
+
+bool LatencyMonitor::start()
+{
+    if (d_thread.joinable()) {
+        return false;
+    }
+
+    d_running = true;
+    d_thread  = std::thread(&LatencyMonitor::run, this);
+    return true;
+}
+
+void LatencyMonitor::stop()
+{
+    if (!d_thread.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(d_mutex);
+        d_running = false;
+    }
+    d_condition.notify_one();
+    d_thread.join();
+    print(*d_stream);
+}
+
+void LatencyMonitor::run()
+{
+    std::unique_lock<std::mutex> lock(d_mutex);
+    while (d_running) {
+        if (d_condition.wait_for(lock, d_interval) == std::cv_status::timeout
+                && d_running) {
+            print(*d_stream);
+        }
+    }
+}
+
+void LatencyMonitor::print(std::ostream& stream) const
+{
+    for (int i = 0; i < e_NUM_STAGES; ++i) {
+        Stage stage = static_cast<Stage>(i);
+        stream << "Latency " << stageName(stage) << ": "
+               << d_histograms[i].summary() << '\n';
+    }
+    stream.flush();
+}
+
+const char *LatencyMonitor::stageName(Stage stage)
+{
+    switch (stage) {
+      case e_RECEIVE_TO_DISPATCH:
+        return "receive->dispatch";
+      case e_DISPATCH_TO_COMPUTE:
+        return "dispatch->compute";
+      case e_COMPUTE_TO_NOTIFY:
+        return "compute->notify";
+      case e_RECEIVE_TO_NOTIFY:
+        return "receive->notify";
+      default:
+        return "unknown";
+    }
+}
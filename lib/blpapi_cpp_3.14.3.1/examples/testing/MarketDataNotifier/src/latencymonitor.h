@@ -0,0 +1,102 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _LATENCYMONITOR_H_
+#define _LATENCYMONITOR_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+#include "latencyhistogram.h"
+
+// LatencyMonitor keeps one 'LatencyHistogram' per stage a tick goes
+// through:
+//
+//: e_RECEIVE_TO_DISPATCH  SDK receive time to the start of 'processEvent'
+//: e_DISPATCH_TO_COMPUTE  start of 'processEvent' to the end of the compute
+//:                        call for the tick's batch
+//: e_COMPUTE_TO_NOTIFY    end of the compute call to the tick's notification
+//: e_RECEIVE_TO_NOTIFY    end to end
+//
+// Once 'start'ed, a reporting thread prints every histogram to the stream
+// every 'intervalMs' milliseconds, and 'stop' prints them one last time.
+class LatencyMonitor {
+  public:
+    enum Stage {
+        e_RECEIVE_TO_DISPATCH,
+        e_DISPATCH_TO_COMPUTE,
+        e_COMPUTE_TO_NOTIFY,
+        e_RECEIVE_TO_NOTIFY,
+        e_NUM_STAGES
+    };
+
+  private:
+    LatencyHistogram          d_histograms[e_NUM_STAGES];
+    std::ostream             *d_stream;
+    std::chrono::milliseconds d_interval;
+    std::thread               d_thread;
+    std::mutex                d_mutex;
+    std::condition_variable   d_condition;
+    bool                      d_running;
+
+    LatencyMonitor(const LatencyMonitor&);
+    LatencyMonitor& operator=(const LatencyMonitor&);
+
+    void run();
+
+  public:
+    LatencyMonitor(std::ostream *stream, int intervalMs);
+
+    ~LatencyMonitor();
+
+    bool start();
+
+    void stop();
+
+    void record(Stage stage, long long latencyNs);
+        // Record 'latencyNs' for 'stage'.  Negative latencies, which clocks
+        // read on different cores can produce, are recorded as 0.
+
+    const LatencyHistogram& histogram(Stage stage) const;
+
+    void print(std::ostream& stream) const;
+
+    static const char *stageName(Stage stage);
+};
+
+inline
+void LatencyMonitor::record(Stage stage, long long latencyNs)
+{
+    d_histograms[stage].record(
+                   latencyNs > 0 ? static_cast<std::uint64_t>(latencyNs) : 0);
+}
+
+inline
+const LatencyHistogram& LatencyMonitor::histogram(Stage stage) const
+{
+    return d_histograms[stage];
+}
+
+#endif
@@ -18,22 +18,155 @@
  * IN THE SOFTWARE.
  */
 
+#include <blpapi_eventdispatcher.h>
 #include <blpapi_exception.h>
 #include <blpapi_session.h>
 
 #include "appconfig.h"
 #include "application.h"
+#include "asyncauthorizer.h"
 #include "authorizer.h"
+#include "bufferednotifier.h"
 #include "computeengine.h"
+#include "computethread.h"
+#include "conflator.h"
 #include "eventprocessor.h"
+#include "eventrecorder.h"
+#include "fieldregistry.h"
+#include "lastvaluecache.h"
+#include "latencymonitor.h"
+#include "meteredeventhandler.h"
 #include "notifier.h"
+#include "shardrouter.h"
 #include "subscriber.h"
+#include "tickstore.h"
 #include "tokengenerator.h"
+#include "topictable.h"
 
+#include <atomic>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
 
 namespace blp = BloombergLP::blpapi;
 
+namespace {
+// Shard is one session together with everything bound to it.  'd_config'
+// is a copy of the application's configuration holding only the topics
+// assigned to this shard.  With '-async' the session is started without
+// blocking and the shard subscribes when 'd_asyncAuthorizer' reports its
+// identity; otherwise 'd_application' starts, authorizes and subscribes in
+// turn.
+struct Shard : IAuthorizationListener {
+    std::size_t           d_index;
+    AppConfig             d_config;
+    TopicTable            d_topicTable;
+    EventProcessor        d_eventProcessor;
+    RecordingEventHandler d_recordingHandler;
+    MeteredEventHandler   d_eventHandler;
+    AsyncAuthorizer       d_asyncAuthorizer;
+    blp::Session          d_session;
+    TokenGenerator        d_tokenGenerator;
+    Authorizer            d_authorizer;
+    Subscriber            d_subscriber;
+    Application           d_application;
+    std::atomic<bool>     d_subscribed;
+
+    Shard(std::size_t                      index,
+          const AppConfig&                 config,
+          const std::vector<std::string>&  topics,
+          const blp::SessionOptions&       sessionOptions,
+          blp::EventDispatcher            *eventDispatcher,
+          INotifier                       *notifier,
+          IComputeEngine                  *computeEngine,
+          ITickSink                       *tickSink,
+          const FieldRegistry             *fieldRegistry,
+          LatencyMonitor                  *latencyMonitor,
+          EventRecorder                   *recorder)
+    : d_index(index)
+    , d_config(config)
+    , d_eventProcessor(notifier,
+                       computeEngine,
+                       tickSink,
+                       &d_topicTable,
+                       fieldRegistry,
+                       latencyMonitor)
+    , d_recordingHandler(recorder, &d_eventProcessor, &d_topicTable)
+    , d_eventHandler(&d_recordingHandler, index)
+    , d_asyncAuthorizer(&d_session,
+                        &d_eventHandler,
+                        this,
+                        10000,
+                        config.d_reauthorizeSeconds * 1000)
+    , d_session(sessionOptions,
+                isAsync(config)
+                    ? static_cast<blp::EventHandler *>(&d_asyncAuthorizer)
+                    : &d_eventHandler,
+                eventDispatcher)
+    , d_tokenGenerator(&d_session)
+    , d_authorizer(&d_session, &d_tokenGenerator)
+    , d_subscriber(&d_session, &d_topicTable)
+    , d_application(&d_session,
+                    &d_authorizer,
+                    &d_subscriber,
+                    &d_eventProcessor,
+                    &d_config)
+    , d_subscribed(false)
+    {
+        d_config.d_topics = topics;
+    }
+
+    static bool isAsync(const AppConfig& config)
+        // Without authentication options there is nothing to authorize, and
+        // the session is started as usual.
+    {
+        return config.d_asyncAuthorization && !config.d_authOptions.empty();
+    }
+
+    void run()
+    {
+        if (!isAsync(d_config)) {
+            d_application.run();
+            return;
+        }
+        d_asyncAuthorizer.addIdentity();
+        d_asyncAuthorizer.start();
+        if (!d_session.startAsync()) {
+            std::cerr << "Failed to start session." << std::endl;
+        }
+    }
+
+    virtual void onAuthorized(std::size_t, const blp::Identity& identity)
+    {
+        // The identity is re-authorized in place, so the subscriptions made
+        // with it the first time stay entitled and are never made again.
+        if (d_subscribed.exchange(true)) {
+            std::cout << "Shard " << d_index << " re-authorized" << std::endl;
+            return;
+        }
+        try {
+            d_subscriber.subscribe(d_config.d_service,
+                                   d_config.d_topics,
+                                   d_config.d_fields,
+                                   d_config.d_options,
+                                   identity);
+        }
+        catch (blp::Exception& e) {
+            std::cerr << "Library Exception" << e.description() << std::endl;
+        }
+    }
+
+    virtual void onAuthorizationFailed(std::size_t, const std::string& reason)
+    {
+        std::cerr << "Shard " << d_index << " no authorization: " << reason
+                  << std::endl;
+    }
+};
+}
+
 int main(int argc, char **argv)
 {
     // Initialize config based on command line options
@@ -43,30 +176,152 @@ int main(int argc, char **argv)
         return 1;
     }
 
-    Notifier            notifier;
-    ComputeEngine       computeEngine;
-    EventProcessor      eventProcessor(&notifier, &computeEngine);
+    Notifier         consoleNotifier;
+    BufferedNotifier bufferedNotifier(1, config.d_flushBytes, config.d_flushMs);
+    INotifier       *notifier = &consoleNotifier;
+    if (config.d_flushMs > 0) {
+        notifier = &bufferedNotifier;
+        bufferedNotifier.start();
+    }
+
+    ComputeEngine                 computeEngine;
+    ComputeThread::OverflowPolicy overflowPolicy = ComputeThread::e_DROP;
+    ComputeThread::parseOverflowPolicy(&overflowPolicy,
+                                       config.d_overflowPolicy);
+    ComputeThread computeThread(&computeEngine,
+                                notifier,
+                                config.d_ringCapacity,
+                                overflowPolicy,
+                                config.d_computeCpu);
+    Conflator conflator(&computeEngine,
+                        notifier,
+                        config.d_topics.size(),
+                        config.d_conflationMs);
+
+    ITickSink *tickSink = 0;
+    if (config.d_ringCapacity > 0) {
+        tickSink = &computeThread;
+        computeThread.start();
+    }
+    else if (config.d_conflationMs > 0) {
+        tickSink = &conflator;
+        conflator.start();
+    }
+    FieldRegistry fieldRegistry(config.d_fields);
+
+    // Latencies go to stderr so as not to interleave with notifications.
+    LatencyMonitor  latencyMonitor(&std::cerr, config.d_latencyReportMs);
+    LatencyMonitor *monitor = 0;
+    if (config.d_latencyReportMs > 0) {
+        monitor = &latencyMonitor;
+        latencyMonitor.start();
+    }
+
+    // With several shards or dispatcher threads every dispatcher thread
+    // reports to the same notifier; the buffered notifier is thread-safe,
+    // the console one is not.
+    SynchronizedNotifier synchronizedNotifier(notifier);
+    if ((config.d_shards > 1 || config.d_dispatcherThreads > 1)
+            && notifier != &bufferedNotifier) {
+        notifier = &synchronizedNotifier;
+    }
+
+    // Subscription data is captured for 'marketDataReplayer' if asked to.
+    std::ofstream                  capture;
+    std::ofstream                  captureSchema;
+    std::unique_ptr<EventRecorder> recorder;
+    if (!config.d_recordPath.empty()) {
+        capture.open(config.d_recordPath.c_str());
+        captureSchema.open((config.d_recordPath + ".schema").c_str());
+        if (!capture || !captureSchema) {
+            std::cerr << "Failed to open " << config.d_recordPath
+                      << std::endl;
+            return 1;
+        }
+        recorder.reset(new EventRecorder(&capture, &captureSchema));
+    }
+
+    // The sessions share the dispatcher pool if there is one.
+    std::unique_ptr<blp::EventDispatcher> eventDispatcher;
+    if (config.d_dispatcherThreads > 0) {
+        eventDispatcher.reset(
+                        new blp::EventDispatcher(config.d_dispatcherThreads));
+    }
+
     blp::SessionOptions sessionOptions;
     for (size_t i = 0; i < config.d_hosts.size(); ++i) {
         sessionOptions.setServerAddress(
             config.d_hosts[i].c_str(), config.d_port, i);
     }
     sessionOptions.setAuthenticationOptions(config.d_authOptions.c_str());
+    sessionOptions.setRecordSubscriptionDataReceiveTimes(true);
 
-    blp::Session   session(sessionOptions, &eventProcessor);
-    TokenGenerator tokenGenerator(&session);
+    ShardRouter                            router(config.d_shards);
+    std::vector<std::vector<std::string> > shardTopics;
+    router.partition(&shardTopics, config.d_topics);
 
-    Authorizer authorizer(&session, &tokenGenerator);
-    Subscriber subscriber(&session);
+    // The last-value cache and the tick store have a row per topic, the
+    // topics of each shard being contiguous and in the order the shard
+    // subscribes to them, so that a shard's topic ids map to rows by adding
+    // an offset.
+    LastValueCache           lastValueCache;
+    std::vector<std::string> cachedTopics;
+    for (std::size_t i = 0; i < shardTopics.size(); ++i) {
+        cachedTopics.insert(cachedTopics.end(),
+                            shardTopics[i].begin(),
+                            shardTopics[i].end());
+    }
+    if (!config.d_lastValueCacheName.empty()
+            && !lastValueCache.create(config.d_lastValueCacheName,
+                                      cachedTopics,
+                                      fieldRegistry)) {
+        return 1;
+    }
+    TickStore tickStore(config.d_tickBarSeconds > 0 ? cachedTopics.size() : 0,
+                        config.d_residentChunks);
+    if (!config.d_tickSpillPath.empty()
+            && !tickStore.spillTo(config.d_tickSpillPath)) {
+        std::cerr << "Failed to open " << config.d_tickSpillPath << std::endl;
+        return 1;
+    }
 
-    Application app(
-        &session, &authorizer, &subscriber, &eventProcessor, &config);
+    std::vector<std::unique_ptr<Shard> > shards;
+    std::size_t                          firstRow = 0;
+    for (std::size_t i = 0; i < shardTopics.size(); ++i) {
+        if (shardTopics[i].empty()) {
+            continue;
+        }
+        shards.emplace_back(new Shard(i,
+                                      config,
+                                      shardTopics[i],
+                                      sessionOptions,
+                                      eventDispatcher.get(),
+                                      notifier,
+                                      &computeEngine,
+                                      tickSink,
+                                      &fieldRegistry,
+                                      monitor,
+                                      recorder.get()));
+        if (!config.d_lastValueCacheName.empty()) {
+            shards.back()->d_eventProcessor.setLastValueCache(&lastValueCache,
+                                                              firstRow);
+        }
+        if (config.d_tickBarSeconds > 0) {
+            shards.back()->d_eventProcessor.setTickStore(&tickStore, firstRow);
+        }
+        firstRow += shardTopics[i].size();
+    }
 
-    try {
-        app.run();
+    if (eventDispatcher) {
+        eventDispatcher->start();
     }
-    catch (blp::Exception& e) {
-        std::cerr << "Library Exception" << e.description() << std::endl;
+    for (std::size_t i = 0; i < shards.size(); ++i) {
+        try {
+            shards[i]->run();
+        }
+        catch (blp::Exception& e) {
+            std::cerr << "Library Exception" << e.description() << std::endl;
+        }
     }
 
     // wait for enter key to exit application
@@ -74,5 +329,87 @@ int main(int argc, char **argv)
     char dummy[2];
     std::cin.getline(dummy, 2);
 
+    for (std::size_t i = 0; i < shards.size(); ++i) {
+        shards[i]->d_session.stop();
+        shards[i]->d_asyncAuthorizer.stop();
+    }
+    if (eventDispatcher) {
+        eventDispatcher->stop();
+    }
+    if (monitor) {
+        latencyMonitor.stop();
+    }
+    if (recorder) {
+        capture.flush();
+        std::cout << "Recorded " << recorder->events() << " events to "
+                  << config.d_recordPath << std::endl;
+    }
+    for (std::size_t i = 0; i < shards.size(); ++i) {
+        std::cout << shards[i]->d_eventHandler.statistics()
+                  << " staleTicks="
+                  << shards[i]->d_eventProcessor.staleTicks() << std::endl;
+        if (Shard::isAsync(config)) {
+            std::cout << "Shard " << shards[i]->d_index << " authorization: "
+                      << shards[i]->d_asyncAuthorizer.statistics()
+                      << std::endl;
+        }
+    }
+    for (std::size_t i = 0; i < shards.size(); ++i) {
+        const TopicTable& topicTable = shards[i]->d_topicTable;
+        for (std::size_t j = 0; j < topicTable.size(); ++j) {
+            const TopicAnalytics& analytics = topicTable[j].d_analytics;
+            if (analytics.ticks() == 0) {
+                continue;
+            }
+            std::cout << topicTable[j].d_topic
+                      << " vwap=" << analytics.vwap()
+                      << " ewma=" << analytics.ewma()
+                      << " volatility=" << analytics.volatility()
+                      << " ticks=" << analytics.ticks() << std::endl;
+        }
+    }
+    if (!config.d_lastValueCacheName.empty()) {
+        std::cout << "Last-value cache " << config.d_lastValueCacheName
+                  << ": " << lastValueCache.numRows() << " topics, "
+                  << lastValueCache.staleUpdates() << " stale updates"
+                  << std::endl;
+    }
+    if (config.d_tickBarSeconds > 0) {
+        // Summarize the session's trades of each topic in bars.
+        const long long intervalNs = config.d_tickBarSeconds * 1000000000LL;
+        std::vector<TickBar> bars;
+        for (std::size_t i = 0; i < cachedTopics.size(); ++i) {
+            bars.clear();
+            tickStore.downsample(&bars,
+                                 i,
+                                 0,
+                                 std::numeric_limits<long long>::max(),
+                                 intervalNs,
+                                 tickStore.typeId("TRADE"));
+            for (std::size_t j = 0; j < bars.size(); ++j) {
+                std::cout << cachedTopics[i] << " " << bars[j].d_startNs
+                          << " open=" << bars[j].d_open
+                          << " high=" << bars[j].d_high
+                          << " low=" << bars[j].d_low
+                          << " close=" << bars[j].d_close
+                          << " volume=" << bars[j].d_volume
+                          << " ticks=" << bars[j].d_numTicks << std::endl;
+            }
+        }
+        std::cout << tickStore.statistics() << std::endl;
+    }
+    if (tickSink == &computeThread) {
+        computeThread.stop();
+        std::cout << computeThread.statistics() << std::endl;
+    }
+    else if (tickSink == &conflator) {
+        conflator.stop();
+        std::cout << conflator.statistics() << std::endl;
+    }
+    if (notifier == &bufferedNotifier) {
+        bufferedNotifier.stop();
+        std::cout << bufferedNotifier.statistics() << std::endl;
+    }
+
     return 0;
 }
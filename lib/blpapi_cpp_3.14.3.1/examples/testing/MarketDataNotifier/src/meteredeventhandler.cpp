@@ -0,0 +1,127 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "meteredeventhandler.h"
+
+#include <blpapi_highresolutionclock.h>
+#include <blpapi_message.h>
+#include <blpapi_timepoint.h>
+
+namespace {
+void add(std::atomic<std::uint64_t> *counter, std::uint64_t value)
+{
+    // A session with an 'EventDispatcher' pool calls the handler from
+    // several threads at once, so the update must be atomic.
+    counter->fetch_add(value, std::memory_order_relaxed);
+}
+
+void updateMax(std::atomic<std::uint64_t> *max, std::uint64_t value)
+{
+    std::uint64_t current = max->load(std::memory_order_relaxed);
+    while (value > current
+           && !max->compare_exchange_weak(current,
+                                          value,
+                                          std::memory_order_relaxed)) {
+    }
+}
+}
+
+MeteredEventHandler::MeteredEventHandler(blp::EventHandler *handler,
+                                         std::size_t        shard)
+: d_handler(handler)
+, d_shard(shard)
+, d_start(std::chrono::steady_clock::now())
+, d_events(0)
+, d_messages(0)
+, d_lagSamples(0)
+, d_lagTotalNs(0)
+, d_lagMaxNs(0)
+{
+}
+
+bool MeteredEventHandler::processEvent(const blp::Event&  event,
+                                       blp::Session      *session)
+{
+    const bool     isData = event.eventType() == blp::Event::SUBSCRIPTION_DATA;
+    blp::TimePoint now    = blp::HighResolutionClock::now();
+
+    std::uint64_t messages   = 0;
+    std::uint64_t lagSamples = 0;
+    std::uint64_t lagTotal   = 0;
+    std::uint64_t lagMax     = 0;
+
+    blp::MessageIterator msgIter(event);
+    while (msgIter.next()) {
+        ++messages;
+        blp::TimePoint received;
+        if (isData && 0 == msgIter.message().timeReceived(&received)) {
+            long long lag =
+                blp::TimePointUtil::nanosecondsBetween(received, now);
+            if (lag < 0) {
+                lag = 0;
+            }
+            ++lagSamples;
+            lagTotal += lag;
+            if (static_cast<std::uint64_t>(lag) > lagMax) {
+                lagMax = lag;
+            }
+        }
+    }
+    add(&d_events, 1);
+    add(&d_messages, messages);
+    if (lagSamples) {
+        add(&d_lagSamples, lagSamples);
+        add(&d_lagTotalNs, lagTotal);
+        updateMax(&d_lagMaxNs, lagMax);
+    }
+
+    return d_handler->processEvent(event, session);
+}
+
+MeteredEventHandler::Statistics MeteredEventHandler::statistics() const
+{
+    Statistics stats;
+    stats.d_shard          = d_shard;
+    stats.d_events         = d_events.load(std::memory_order_relaxed);
+    stats.d_messages       = d_messages.load(std::memory_order_relaxed);
+    stats.d_lagSamples     = d_lagSamples.load(std::memory_order_relaxed);
+    stats.d_lagTotalNs     = d_lagTotalNs.load(std::memory_order_relaxed);
+    stats.d_lagMaxNs       = d_lagMaxNs.load(std::memory_order_relaxed);
+    stats.d_elapsedSeconds = std::chrono::duration<double>(
+                          std::chrono::steady_clock::now() - d_start).count();
+    return stats;
+}
+
+std::ostream& operator<<(std::ostream&                          stream,
+                         const MeteredEventHandler::Statistics& stats)
+{
+    stream << "Shard " << stats.d_shard
+           << ": events=" << stats.d_events
+           << " messages=" << stats.d_messages
+           << " messagesPerSecond="
+           << (stats.d_elapsedSeconds > 0
+                   ? stats.d_messages / stats.d_elapsedSeconds
+                   : 0)
+           << " lagAvgNs="
+           << (stats.d_lagSamples ? stats.d_lagTotalNs / stats.d_lagSamples
+                                  : 0)
+           << " lagMaxNs=" << stats.d_lagMaxNs;
+    return stream;
+}
@@ -0,0 +1,79 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _METEREDEVENTHANDLER_H_
+#define _METEREDEVENTHANDLER_H_
+
+#include <blpapi_event.h>
+#include <blpapi_session.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace blp = BloombergLP::blpapi;
+
+// MeteredEventHandler forwards every event to another handler and measures,
+// per session, the message throughput and the dispatch lag: the time between
+// the SDK receiving a subscription data message and the handler being called
+// for it.  Lag is only measured if the session records receive times (see
+// 'blp::SessionOptions::setRecordSubscriptionDataReceiveTimes').  Counters
+// are updated atomically by the session's dispatcher threads, of which there
+// are several if the session has an 'EventDispatcher' pool, and may be read
+// from any thread.
+class MeteredEventHandler : public blp::EventHandler {
+  public:
+    struct Statistics {
+        std::size_t   d_shard;
+        std::uint64_t d_events;
+        std::uint64_t d_messages;
+        std::uint64_t d_lagSamples;
+        std::uint64_t d_lagTotalNs;
+        std::uint64_t d_lagMaxNs;
+        double        d_elapsedSeconds;   // since construction
+    };
+
+  private:
+    blp::EventHandler                     *d_handler;
+    std::size_t                            d_shard;
+    std::chrono::steady_clock::time_point  d_start;
+    std::atomic<std::uint64_t>             d_events;
+    std::atomic<std::uint64_t>             d_messages;
+    std::atomic<std::uint64_t>             d_lagSamples;
+    std::atomic<std::uint64_t>             d_lagTotalNs;
+    std::atomic<std::uint64_t>             d_lagMaxNs;
+
+    MeteredEventHandler(const MeteredEventHandler&);
+    MeteredEventHandler& operator=(const MeteredEventHandler&);
+
+  public:
+    MeteredEventHandler(blp::EventHandler *handler, std::size_t shard);
+
+    virtual bool processEvent(const blp::Event& event, blp::Session *session);
+
+    Statistics statistics() const;
+};
+
+std::ostream& operator<<(std::ostream&                          stream,
+                         const MeteredEventHandler::Statistics& stats);
+
+#endif
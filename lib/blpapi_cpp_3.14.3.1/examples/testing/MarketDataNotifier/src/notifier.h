@@ -23,6 +23,7 @@
 
 #include <blpapi_message.h>
 #include <iostream>
+#include <mutex>
 
 namespace blp = BloombergLP::blpapi;
 
@@ -61,4 +62,38 @@ class Notifier : public INotifier {
     }
 };
 
+// SynchronizedNotifier serializes calls to another notifier, so that several
+// sessions (each calling from its own dispatcher thread) can share one
+// notifier that is not thread-safe.  Every record reaches the underlying
+// notifier whole.
+class SynchronizedNotifier : public INotifier {
+  private:
+    INotifier  *d_notifier;
+    std::mutex  d_mutex;
+
+  public:
+    explicit SynchronizedNotifier(INotifier *notifier)
+    : d_notifier(notifier)
+    {
+    }
+
+    virtual void logSessionState(const blp::Message& msg)
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        d_notifier->logSessionState(msg);
+    }
+
+    virtual void logSubscriptionState(const blp::Message& msg)
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        d_notifier->logSubscriptionState(msg);
+    }
+
+    virtual void sendToTerminal(double value)
+    {
+        std::lock_guard<std::mutex> lock(d_mutex);
+        d_notifier->sendToTerminal(value);
+    }
+};
+
 #endif
@@ -0,0 +1,145 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <blpapi_exception.h>
+#include <blpapi_testutil.h>
+
+#include "bufferednotifier.h"
+#include "computeengine.h"
+#include "eventprocessor.h"
+#include "eventreplayer.h"
+#include "fieldregistry.h"
+#include "notifier.h"
+#include "topictable.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace blp    = BloombergLP::blpapi;
+namespace blptst = blp::test;
+
+namespace {
+const char USAGE[] =
+"Replay subscription data captured by marketDataNotifier -record.\n\n"
+"Usage:\n"
+"\t -capture <file>       capture to replay\n"
+"\t[-schema <file>]       service schema (default: <capture>.schema)\n"
+"\t[-speed <factor>]      replay at <factor> times the recorded pace; 0\n"
+"\t                       replays as fast as possible (default: 0)\n"
+"\t[-f    <field>]        field to extract (default: LAST_PRICE)\n"
+"\t[-flush <ms>]          buffer notifications as marketDataNotifier does\n"
+"\t                       (default: unbuffered)\n"
+"\n";
+}
+
+int main(int argc, char **argv)
+{
+    std::string              capturePath;
+    std::string              schemaPath;
+    double                   speed   = 0;
+    int                      flushMs = 0;
+    std::vector<std::string> fields;
+    for (int i = 1; i < argc; ++i) {
+        if (!std::strcmp(argv[i], "-capture") && i + 1 < argc) {
+            capturePath = argv[++i];
+        } else if (!std::strcmp(argv[i], "-schema") && i + 1 < argc) {
+            schemaPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "-speed") && i + 1 < argc) {
+            speed = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-f") && i + 1 < argc) {
+            fields.push_back(argv[++i]);
+        } else if (!std::strcmp(argv[i], "-flush") && i + 1 < argc) {
+            flushMs = std::atoi(argv[++i]);
+        } else {
+            std::cout << USAGE << std::flush;
+            return 1;
+        }
+    }
+    if (capturePath.empty()) {
+        std::cout << USAGE << std::flush;
+        return 1;
+    }
+    if (schemaPath.empty()) {
+        schemaPath = capturePath + ".schema";
+    }
+
+    std::ifstream capture(capturePath.c_str());
+    std::ifstream schema(schemaPath.c_str());
+    if (!capture || !schema) {
+        std::cerr << "Failed to open " << capturePath << " or " << schemaPath
+                  << std::endl;
+        return 1;
+    }
+
+    try {
+        EventReplayer replayer(blptst::TestUtil::deserializeService(schema));
+        replayer.load(capture);
+        if (replayer.malformed()) {
+            std::cerr << "Skipped " << replayer.malformed()
+                      << " malformed records" << std::endl;
+        }
+
+        // Messages are replayed with the ids of the recorded topics, or, in
+        // a capture without topics, with the ids of the recording session;
+        // recreate as many topics so that every message finds its state.
+        const std::vector<std::string>& topics = replayer.topics();
+        TopicTable                      topicTable;
+        for (long long id = 0; id <= replayer.maxCorrelationId(); ++id) {
+            std::ostringstream topic;
+            if (id < static_cast<long long>(topics.size())) {
+                topic << topics[id];
+            } else {
+                topic << "topic-" << id;
+            }
+            topicTable.add(topic.str());
+        }
+
+        Notifier         consoleNotifier;
+        BufferedNotifier bufferedNotifier(1, 64 * 1024, flushMs);
+        INotifier       *notifier = &consoleNotifier;
+        if (flushMs > 0) {
+            notifier = &bufferedNotifier;
+            bufferedNotifier.start();
+        }
+
+        ComputeEngine  computeEngine;
+        FieldRegistry  fieldRegistry(fields);
+        EventProcessor eventProcessor(
+            notifier, &computeEngine, 0, &topicTable, &fieldRegistry);
+
+        EventReplayer::Statistics stats =
+            replayer.replay(&eventProcessor, speed);
+
+        if (notifier == &bufferedNotifier) {
+            bufferedNotifier.stop();
+        }
+        std::cerr << stats << std::endl;
+    }
+    catch (blp::Exception& e) {
+        std::cerr << "Library Exception" << e.description() << std::endl;
+        return 1;
+    }
+    return 0;
+}
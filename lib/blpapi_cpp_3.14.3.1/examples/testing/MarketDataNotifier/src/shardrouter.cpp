@@ -0,0 +1,88 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "shardrouter.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace {
+const std::uint64_t k_FNV_OFFSET = 14695981039346656037ULL;
+const std::uint64_t k_FNV_PRIME  = 1099511628211ULL;
+
+std::uint64_t mix(std::uint64_t value)
+{
+    // FNV-1a spreads short, similar keys poorly over the high bits, which is
+    // what the ring is ordered by; finish with the MurmurHash3 mixer.
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+    return value;
+}
+}
+
+const std::size_t ShardRouter::k_DEFAULT_VIRTUAL_NODES;
+
+ShardRouter::ShardRouter(std::size_t shardCount, std::size_t virtualNodes)
+: d_shardCount(shardCount)
+{
+    d_ring.reserve(shardCount * virtualNodes);
+    for (std::size_t shard = 0; shard < shardCount; ++shard) {
+        for (std::size_t node = 0; node < virtualNodes; ++node) {
+            std::ostringstream key;
+            key << "shard-" << shard << '#' << node;
+            d_ring.push_back(std::make_pair(hash(key.str()), shard));
+        }
+    }
+    std::sort(d_ring.begin(), d_ring.end());
+}
+
+std::uint64_t ShardRouter::hash(const std::string& value)
+{
+    std::uint64_t h = k_FNV_OFFSET;
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        h ^= static_cast<unsigned char>(value[i]);
+        h *= k_FNV_PRIME;
+    }
+    return mix(h);
+}
+
+std::size_t ShardRouter::shardOf(const std::string& topic) const
+{
+    std::vector<std::pair<std::uint64_t, std::size_t> >::const_iterator it =
+        std::lower_bound(d_ring.begin(),
+                         d_ring.end(),
+                         std::make_pair(hash(topic), std::size_t(0)));
+    if (it == d_ring.end()) {
+        it = d_ring.begin();
+    }
+    return it->second;
+}
+
+void ShardRouter::partition(std::vector<std::vector<std::string> > *shards,
+                            const std::vector<std::string>& topics) const
+{
+    shards->assign(d_shardCount, std::vector<std::string>());
+    for (std::size_t i = 0; i < topics.size(); ++i) {
+        (*shards)[shardOf(topics[i])].push_back(topics[i]);
+    }
+}
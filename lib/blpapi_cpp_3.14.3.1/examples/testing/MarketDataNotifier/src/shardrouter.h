@@ -0,0 +1,68 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _SHARDROUTER_H_
+#define _SHARDROUTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ShardRouter assigns topics to shards with a consistent hash: every shard
+// owns 'virtualNodes' points on a 64-bit ring and a topic belongs to the
+// shard owning the first point at or after the topic's hash.  Growing from
+// N to N + 1 shards therefore moves only about 1 / (N + 1) of the topics.
+// The hash (FNV-1a with a 64-bit finalizer) does not depend on the platform,
+// so the assignment is stable across runs and hosts.
+class ShardRouter {
+  private:
+    std::vector<std::pair<std::uint64_t, std::size_t> > d_ring;
+    std::size_t                                         d_shardCount;
+
+  public:
+    static const std::size_t k_DEFAULT_VIRTUAL_NODES = 64;
+
+    explicit ShardRouter(std::size_t shardCount,
+                         std::size_t virtualNodes = k_DEFAULT_VIRTUAL_NODES);
+        // Create a router over 'shardCount' shards.  The behavior is
+        // undefined unless 'shardCount > 0' and 'virtualNodes > 0'.
+
+    static std::uint64_t hash(const std::string& value);
+
+    std::size_t shardOf(const std::string& topic) const;
+        // Return the shard 'topic' is assigned to.
+
+    void partition(std::vector<std::vector<std::string> > *shards,
+                   const std::vector<std::string>&         topics) const;
+        // Load into 'shards' one list per shard holding the 'topics' assigned
+        // to it, in their original order.
+
+    std::size_t shardCount() const;
+};
+
+inline
+std::size_t ShardRouter::shardCount() const
+{
+    return d_shardCount;
+}
+
+#endif
@@ -0,0 +1,201 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _SPSCQUEUE_H_
+#define _SPSCQUEUE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// SpscQueue is a bounded, lock-free ring buffer for exactly one producer
+// thread and one consumer thread.  The capacity is rounded up to a power of
+// two so that slot indices are a mask away from the free-running head and
+// tail counters.
+//
+// Besides the usual 'tryPush'/'tryPop' the producer may call 'pushOverwrite',
+// which evicts the oldest element when the ring is full.  Both sides claim
+// that element with a CAS on the head counter.  The consumer also publishes
+// the index it is copying in 'd_reading' before it copies the slot; a
+// producer that has evicted that very element waits for the copy to finish
+// before it reuses the slot, so a slot is never written while it is read.
+// The consumer's CAS then fails, and it discards the copy and moves on to
+// the next element.
+template <class TYPE>
+class SpscQueue {
+  private:
+    static const std::size_t k_CACHE_LINE = 64;
+    static const std::size_t k_NOT_READING = ~std::size_t(0);
+
+    std::vector<TYPE> d_slots;
+    std::size_t       d_mask;
+
+    alignas(k_CACHE_LINE) std::atomic<std::size_t> d_head;
+    alignas(k_CACHE_LINE) std::atomic<std::size_t> d_tail;
+    alignas(k_CACHE_LINE) std::atomic<std::size_t> d_reading;
+    alignas(k_CACHE_LINE) std::atomic<std::size_t> d_highWaterMark;
+
+    SpscQueue(const SpscQueue&);
+    SpscQueue& operator=(const SpscQueue&);
+
+    void publish(std::size_t tail, std::size_t head, const TYPE& value);
+
+  public:
+    explicit SpscQueue(std::size_t capacity);
+
+    bool tryPush(const TYPE& value);
+        // Append the specified 'value' and return true, or return false if
+        // the queue is full.  Producer thread only.
+
+    bool pushOverwrite(const TYPE& value);
+        // Append the specified 'value', evicting the oldest element if the
+        // queue is full.  Return true if an element was evicted.  If the
+        // consumer is copying the evicted element, wait for it to finish.
+        // Producer thread only.
+
+    bool tryPop(TYPE *value);
+        // Move the oldest element into the specified 'value' and return
+        // true, or return false if the queue is empty.  Consumer thread only.
+
+    std::size_t size() const;
+    std::size_t capacity() const;
+
+    std::size_t highWaterMark() const;
+        // Return the largest number of elements ever held at once.
+};
+
+template <class TYPE>
+SpscQueue<TYPE>::SpscQueue(std::size_t capacity)
+: d_head(0)
+, d_tail(0)
+, d_reading(k_NOT_READING)
+, d_highWaterMark(0)
+{
+    static_assert(std::is_trivially_copyable<TYPE>::value,
+                  "SpscQueue elements must be trivially copyable");
+
+    std::size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+    d_slots.resize(size);
+    d_mask = size - 1;
+}
+
+template <class TYPE>
+inline
+void SpscQueue<TYPE>::publish(std::size_t  tail,
+                              std::size_t  head,
+                              const TYPE&  value)
+{
+    d_slots[tail & d_mask] = value;
+    d_tail.store(tail + 1, std::memory_order_release);
+
+    std::size_t depth = tail + 1 - head;
+    if (depth > d_highWaterMark.load(std::memory_order_relaxed)) {
+        d_highWaterMark.store(depth, std::memory_order_relaxed);
+    }
+}
+
+template <class TYPE>
+inline
+bool SpscQueue<TYPE>::tryPush(const TYPE& value)
+{
+    std::size_t tail = d_tail.load(std::memory_order_relaxed);
+    std::size_t head = d_head.load(std::memory_order_acquire);
+    if (tail - head > d_mask) {
+        return false;
+    }
+    publish(tail, head, value);
+    return true;
+}
+
+template <class TYPE>
+inline
+bool SpscQueue<TYPE>::pushOverwrite(const TYPE& value)
+{
+    bool        evicted = false;
+    std::size_t tail    = d_tail.load(std::memory_order_relaxed);
+    std::size_t head    = d_head.load(std::memory_order_acquire);
+    if (tail - head > d_mask) {
+        // On failure the consumer has just popped the element and is done
+        // with its slot.
+        evicted = d_head.compare_exchange_strong(head, head + 1);
+        if (evicted) {
+            // Sequentially consistent with the consumer's store to
+            // 'd_reading' and its check of 'd_head': either it saw the
+            // eviction and will not copy the slot, or it is seen here.
+            while (d_reading.load() == head) {
+                std::this_thread::yield();
+            }
+            ++head;
+        }
+    }
+    publish(tail, head, value);
+    return evicted;
+}
+
+template <class TYPE>
+inline
+bool SpscQueue<TYPE>::tryPop(TYPE *value)
+{
+    while (true) {
+        std::size_t head = d_head.load(std::memory_order_acquire);
+        if (head == d_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        d_reading.store(head);
+        if (d_head.load() != head) {
+            continue;                                  // evicted meanwhile
+        }
+        *value = d_slots[head & d_mask];
+        const bool popped = d_head.compare_exchange_strong(head, head + 1);
+        d_reading.store(k_NOT_READING, std::memory_order_release);
+        if (popped) {
+            return true;
+        }
+    }
+}
+
+template <class TYPE>
+inline
+std::size_t SpscQueue<TYPE>::size() const
+{
+    std::size_t head = d_head.load(std::memory_order_acquire);
+    return d_tail.load(std::memory_order_acquire) - head;
+}
+
+template <class TYPE>
+inline
+std::size_t SpscQueue<TYPE>::capacity() const
+{
+    return d_mask + 1;
+}
+
+template <class TYPE>
+inline
+std::size_t SpscQueue<TYPE>::highWaterMark() const
+{
+    return d_highWaterMark.load(std::memory_order_relaxed);
+}
+
+#endif
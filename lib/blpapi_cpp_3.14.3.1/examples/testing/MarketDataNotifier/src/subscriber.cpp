@@ -28,13 +28,18 @@ void Subscriber::subscribe(const std::string&              service,
                            const std::vector<std::string>& options,
                            const blp::Identity&            identity)
 {
+    if (d_topicTable) {
+        d_topicTable->reserve(d_topicTable->size() + topics.size());
+    }
+
     blp::SubscriptionList subscriptions;
     for (size_t i = 0; i < topics.size(); ++i) {
         std::string topic(service + topics[i]);
+        size_t      id = d_topicTable ? d_topicTable->add(topics[i]) : i;
         subscriptions.add(topic.c_str(),
                           fields,
                           options,
-                          blp::CorrelationId((char *)topics[i].c_str()));
+                          TopicTable::correlationId(id));
     }
 
     d_session->subscribe(subscriptions, identity);
@@ -25,6 +25,8 @@
 #include <blpapi_session.h>
 #include <blpapi_subscriptionlist.h>
 
+#include "topictable.h"
+
 namespace blp = BloombergLP::blpapi;
 
 class ISubscriber {
@@ -38,12 +40,18 @@ class ISubscriber {
     virtual ~ISubscriber() {}
 };
 
+// Subscriber subscribes to every topic with an integer 'CorrelationId'.  If a
+// 'TopicTable' is provided each topic is added to it and subscribed with the
+// id the table assigns; otherwise the id is the topic's position in 'topics'.
 class Subscriber : public ISubscriber {
   private:
     blp::Session *d_session;
+    TopicTable   *d_topicTable;
 
   public:
-    Subscriber(blp::Session *session) : d_session(session) {}
+    Subscriber(blp::Session *session, TopicTable *topicTable = 0)
+        : d_session(session), d_topicTable(topicTable)
+    {}
 
     virtual void subscribe(const std::string&              service,
                            const std::vector<std::string>& topics,
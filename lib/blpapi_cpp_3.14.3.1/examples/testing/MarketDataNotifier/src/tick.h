@@ -0,0 +1,57 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _TICK_H_
+#define _TICK_H_
+
+#include <cstddef>
+
+// Tick is the plain-old-data form of a SUBSCRIPTION_DATA message: everything
+// the compute stage needs, extracted on the dispatcher thread so that no
+// 'blp::Message' has to outlive the callback that delivered it.
+// FieldValues holds the numeric value of every field registered with a
+// 'FieldRegistry', indexed by the field's slot.  Bit 'n' of 'd_present' is
+// set if slot 'n' was found in the message.
+struct FieldValues {
+    static const std::size_t k_MAX_FIELDS = 8;
+
+    double   d_values[k_MAX_FIELDS];
+    unsigned d_present;
+
+    bool has(std::size_t slot) const
+    {
+        return (d_present >> slot) & 1u;
+    }
+};
+
+struct Tick {
+    std::size_t d_topic;      // id assigned by 'TopicTable'
+    double      d_lastPrice;
+    FieldValues d_fields;
+};
+
+class ITickSink {
+  public:
+    virtual void push(const Tick& tick) = 0;
+
+    virtual ~ITickSink() {}
+};
+
+#endif
@@ -0,0 +1,466 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "tickstore.h"
+
+#include "BlpIntradayDecoder.h"
+
+#include <blpapi_datetime.h>
+#include <blpapi_name.h>
+
+#include <algorithm>
+#include <iostream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+const blp::Name TICK_DATA("tickData");
+const blp::Name TIME("time");
+const blp::Name TYPE("type");
+const blp::Name VALUE("value");
+const blp::Name TICK_SIZE("size");
+const blp::Name COND_CODE("conditionCodes");
+
+#ifndef _WIN32
+std::size_t spilledChunkSize()
+    // Return the size of a chunk in the spill file, a whole number of pages
+    // so that every chunk can be mapped on its own.
+{
+    const std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    return (sizeof(TickChunk) + page - 1) / page * page;
+}
+#endif
+}
+
+const std::size_t   TickChunk::k_CAPACITY;
+const std::size_t   TickArena::k_CHUNKS_PER_SLAB;
+const std::uint16_t TickStore::k_ANY_TYPE;
+const std::uint16_t TickStore::k_NO_CONDITION;
+
+                              // ---------------
+                              // class TickArena
+                              // ---------------
+
+TickChunk *TickArena::allocate()
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    if (d_free.empty()) {
+        d_slabs.emplace_back(new TickChunk[k_CHUNKS_PER_SLAB]);
+        for (std::size_t i = k_CHUNKS_PER_SLAB; i > 0; --i) {
+            d_free.push_back(&d_slabs.back()[i - 1]);
+        }
+    }
+    TickChunk *chunk = d_free.back();
+    d_free.pop_back();
+
+    chunk->d_count   = 0;
+    chunk->d_sorted  = 1;
+    chunk->d_firstNs = 0;
+    chunk->d_lastNs  = 0;
+    return chunk;
+}
+
+void TickArena::deallocate(TickChunk *chunk)
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    d_free.push_back(chunk);
+}
+
+std::size_t TickArena::numSlabs() const
+{
+    std::lock_guard<std::mutex> lock(d_mutex);
+    return d_slabs.size();
+}
+
+                              // ---------------
+                              // class TickStore
+                              // ---------------
+
+TickStore::TickStore(std::size_t numTopics, std::size_t maxResidentChunks)
+: d_maxResidentChunks(maxResidentChunks)
+, d_spillFd(-1)
+, d_spillOffset(0)
+, d_spilledChunks(0)
+{
+    d_series.reserve(numTopics);
+    for (std::size_t i = 0; i < numTopics; ++i) {
+        d_series.emplace_back(new Series);
+        d_series.back()->d_firstResident = 0;
+        d_series.back()->d_ticks         = 0;
+    }
+
+    // Id 0 is no condition code at all.
+    d_conditionNames.push_back(std::string());
+    d_conditions[std::string()] = k_NO_CONDITION;
+}
+
+TickStore::~TickStore()
+{
+#ifndef _WIN32
+    for (std::size_t i = 0; i < d_series.size(); ++i) {
+        const Series& series = *d_series[i];
+        for (std::size_t j = 0; j < series.d_chunks.size(); ++j) {
+            if (series.d_spilled[j]) {
+                munmap(series.d_chunks[j], spilledChunkSize());
+            }
+        }
+    }
+    if (d_spillFd != -1) {
+        close(d_spillFd);
+    }
+#endif
+}
+
+bool TickStore::spillTo(const std::string& path)
+{
+#ifdef _WIN32
+    std::cerr << "Spilling ticks needs memory-mapped files" << std::endl;
+    return false;
+#else
+    std::lock_guard<std::mutex> lock(d_spillMutex);
+    int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+    if (fd == -1) {
+        return false;
+    }
+    if (d_spillFd != -1) {
+        close(d_spillFd);
+    }
+    d_spillFd     = fd;
+    d_spillOffset = 0;
+    return true;
+#endif
+}
+
+std::uint16_t TickStore::intern(Ids                      *ids,
+                                std::vector<std::string> *names,
+                                const std::string&        name)
+{
+    Ids::const_iterator it = ids->find(name);
+    if (it != ids->end()) {
+        return it->second;
+    }
+    // Past the last id every new name shares the last one.
+    if (names->size() >= k_ANY_TYPE) {
+        return static_cast<std::uint16_t>(k_ANY_TYPE - 1);
+    }
+    std::uint16_t id = static_cast<std::uint16_t>(names->size());
+    names->push_back(name);
+    (*ids)[name] = id;
+    return id;
+}
+
+std::uint16_t TickStore::typeId(const std::string& type)
+{
+    std::lock_guard<std::mutex> lock(d_namesMutex);
+    return intern(&d_types, &d_typeNames, type);
+}
+
+std::uint16_t TickStore::conditionId(const std::string& conditionCodes)
+{
+    std::lock_guard<std::mutex> lock(d_namesMutex);
+    return intern(&d_conditions, &d_conditionNames, conditionCodes);
+}
+
+std::string TickStore::typeName(std::uint16_t id) const
+{
+    std::lock_guard<std::mutex> lock(d_namesMutex);
+    return id < d_typeNames.size() ? d_typeNames[id] : std::string();
+}
+
+std::string TickStore::conditionName(std::uint16_t id) const
+{
+    std::lock_guard<std::mutex> lock(d_namesMutex);
+    return id < d_conditionNames.size() ? d_conditionNames[id]
+                                        : std::string();
+}
+
+void TickStore::append(std::size_t   topic,
+                       long long     timeNs,
+                       double        price,
+                       double        size,
+                       std::uint16_t type,
+                       std::uint16_t condition)
+{
+    if (topic >= d_series.size()) {
+        return;
+    }
+    Series&                     series = *d_series[topic];
+    std::lock_guard<std::mutex> lock(series.d_mutex);
+    appendLocked(&series, timeNs, price, size, type, condition);
+}
+
+void TickStore::appendLocked(Series        *series,
+                             long long      timeNs,
+                             double         price,
+                             double         size,
+                             std::uint16_t  type,
+                             std::uint16_t  condition)
+{
+    if (series->d_chunks.empty()
+            || series->d_chunks.back()->d_count == TickChunk::k_CAPACITY) {
+        series->d_chunks.push_back(d_arena.allocate());
+        series->d_spilled.push_back(false);
+        spill(series);
+    }
+
+    TickChunk&          chunk = *series->d_chunks.back();
+    const std::uint32_t i     = chunk.d_count;
+    if (i == 0) {
+        chunk.d_firstNs = timeNs;
+        chunk.d_lastNs  = timeNs;
+    }
+    else if (timeNs < chunk.d_lastNs) {
+        chunk.d_sorted  = 0;
+        chunk.d_firstNs = std::min(chunk.d_firstNs, timeNs);
+    }
+    else {
+        chunk.d_lastNs = timeNs;
+    }
+    chunk.d_times[i]      = timeNs;
+    chunk.d_prices[i]     = price;
+    chunk.d_sizes[i]      = size;
+    chunk.d_types[i]      = type;
+    chunk.d_conditions[i] = condition;
+    chunk.d_count         = i + 1;
+    ++series->d_ticks;
+}
+
+void TickStore::spill(Series *series)
+{
+    // Every chunk but the last one is sealed.
+    while (series->d_chunks.size() - 1 - series->d_firstResident
+                                                       > d_maxResidentChunks) {
+        const std::size_t index  = series->d_firstResident;
+        TickChunk        *mapped = spillChunk(*series->d_chunks[index]);
+        if (!mapped) {
+            return;                   // keep it in memory
+        }
+        d_arena.deallocate(series->d_chunks[index]);
+        series->d_chunks[index]  = mapped;
+        series->d_spilled[index] = true;
+        ++series->d_firstResident;
+    }
+}
+
+TickChunk *TickStore::spillChunk(const TickChunk& chunk)
+{
+#ifdef _WIN32
+    (void)chunk;
+    return 0;
+#else
+    std::lock_guard<std::mutex> lock(d_spillMutex);
+    if (d_spillFd == -1) {
+        return 0;
+    }
+
+    const std::size_t size   = spilledChunkSize();
+    const off_t       offset = static_cast<off_t>(d_spillOffset);
+    const ssize_t     length = static_cast<ssize_t>(sizeof(chunk));
+    if (ftruncate(d_spillFd, offset + size) != 0
+            || pwrite(d_spillFd, &chunk, sizeof(chunk), offset) != length) {
+        return 0;
+    }
+    void *mapped = mmap(0, size, PROT_READ, MAP_SHARED, d_spillFd, offset);
+    if (mapped == MAP_FAILED) {
+        return 0;
+    }
+    d_spillOffset += size;
+    ++d_spilledChunks;
+    return static_cast<TickChunk *>(mapped);
+#endif
+}
+
+std::size_t TickStore::appendTickData(std::size_t          topic,
+                                      const blp::Element&  data)
+{
+    // Accept the response's 'tickData' sequence as well as the array in it.
+    blp::Element ticks = data;
+    if (!ticks.isArray() && ticks.hasElement(TICK_DATA)) {
+        ticks = ticks.getElement(TICK_DATA);
+    }
+    if (topic >= d_series.size() || !ticks.isArray()) {
+        return 0;
+    }
+
+    // Types repeat from one tick to the next; look up each one once.
+    std::string   lastType;
+    std::uint16_t lastTypeId = typeId(lastType);
+
+    Series&                     series = *d_series[topic];
+    std::lock_guard<std::mutex> lock(series.d_mutex);
+    const std::size_t           numTicks = ticks.numValues();
+    for (std::size_t i = 0; i < numTicks; ++i) {
+        blp::Element item = ticks.getValueAsElement(i);
+        std::string  type = item.getElementAsString(TYPE);
+        if (type != lastType) {
+            lastType   = type;
+            lastTypeId = typeId(type);
+        }
+        std::uint16_t condition = k_NO_CONDITION;
+        if (item.hasElement(COND_CODE)) {
+            condition = conditionId(item.getElementAsString(COND_CODE));
+        }
+        appendLocked(&series,
+                     toNanoseconds(item.getElementAsDatetime(TIME)),
+                     item.getElementAsFloat64(VALUE),
+                     item.getElementAsFloat64(TICK_SIZE),
+                     lastTypeId,
+                     condition);
+    }
+    return numTicks;
+}
+
+void TickStore::scanChunk(std::vector<Row>  *rows,
+                          const TickChunk&   chunk,
+                          long long          beginNs,
+                          long long          endNs)
+{
+    if (chunk.d_count == 0 || chunk.d_lastNs < beginNs
+            || chunk.d_firstNs >= endNs) {
+        return;
+    }
+
+    const long long *times = chunk.d_times;
+    std::size_t      begin = 0;
+    std::size_t      end   = chunk.d_count;
+    if (chunk.d_sorted) {
+        begin = std::lower_bound(times, times + end, beginNs) - times;
+        end   = std::lower_bound(times + begin, times + end, endNs) - times;
+    }
+    for (std::size_t i = begin; i < end; ++i) {
+        if (times[i] < beginNs || times[i] >= endNs) {
+            continue;
+        }
+        Row row;
+        row.d_timeNs    = times[i];
+        row.d_price     = chunk.d_prices[i];
+        row.d_size      = chunk.d_sizes[i];
+        row.d_type      = chunk.d_types[i];
+        row.d_condition = chunk.d_conditions[i];
+        rows->push_back(row);
+    }
+}
+
+std::size_t TickStore::scan(std::vector<Row> *rows,
+                            std::size_t       topic,
+                            long long         beginNs,
+                            long long         endNs) const
+{
+    if (topic >= d_series.size()) {
+        return 0;
+    }
+    const std::size_t           before = rows->size();
+    Series&                     series = *d_series[topic];
+    std::lock_guard<std::mutex> lock(series.d_mutex);
+    for (std::size_t i = 0; i < series.d_chunks.size(); ++i) {
+        scanChunk(rows, *series.d_chunks[i], beginNs, endNs);
+    }
+    return rows->size() - before;
+}
+
+std::size_t TickStore::downsample(std::vector<TickBar> *bars,
+                                  std::size_t           topic,
+                                  long long             beginNs,
+                                  long long             endNs,
+                                  long long             intervalNs,
+                                  std::uint16_t         type) const
+{
+    if (intervalNs <= 0) {
+        return 0;
+    }
+    std::vector<Row> rows;
+    scan(&rows, topic, beginNs, endNs);
+
+    // Bars are built in time order even if some ticks arrived late.
+    std::stable_sort(rows.begin(),
+                     rows.end(),
+                     [](const Row& lhs, const Row& rhs) {
+                         return lhs.d_timeNs < rhs.d_timeNs;
+                     });
+
+    const std::size_t before = bars->size();
+    TickBar          *bar    = 0;
+    for (std::size_t i = 0; i < rows.size(); ++i) {
+        const Row& row = rows[i];
+        if (type != k_ANY_TYPE && row.d_type != type) {
+            continue;
+        }
+        const long long startNs = beginNs
+                          + (row.d_timeNs - beginNs) / intervalNs * intervalNs;
+        if (!bar || bar->d_startNs != startNs) {
+            TickBar next;
+            next.d_startNs  = startNs;
+            next.d_open     = row.d_price;
+            next.d_high     = row.d_price;
+            next.d_low      = row.d_price;
+            next.d_volume   = 0;
+            next.d_numTicks = 0;
+            bars->push_back(next);
+            bar = &bars->back();
+        }
+        bar->d_high   = std::max(bar->d_high, row.d_price);
+        bar->d_low    = std::min(bar->d_low, row.d_price);
+        bar->d_close  = row.d_price;
+        bar->d_volume += row.d_size;
+        ++bar->d_numTicks;
+    }
+    return bars->size() - before;
+}
+
+TickStore::Statistics TickStore::statistics() const
+{
+    Statistics stats;
+    stats.d_ticks          = 0;
+    stats.d_topics         = d_series.size();
+    stats.d_residentChunks = 0;
+    for (std::size_t i = 0; i < d_series.size(); ++i) {
+        Series&                     series = *d_series[i];
+        std::lock_guard<std::mutex> lock(series.d_mutex);
+        stats.d_ticks          += series.d_ticks;
+        stats.d_residentChunks += series.d_chunks.size()
+                                                     - series.d_firstResident;
+    }
+    {
+        std::lock_guard<std::mutex> lock(d_spillMutex);
+        stats.d_spilledChunks = d_spilledChunks;
+    }
+    stats.d_arenaSlabs = d_arena.numSlabs();
+    return stats;
+}
+
+long long TickStore::toNanoseconds(const blp::Datetime& datetime)
+{
+    return BloombergLP::IntradayTime::toNanoseconds(datetime);
+}
+
+std::ostream& operator<<(std::ostream&                stream,
+                         const TickStore::Statistics& stats)
+{
+    stream << "TickStore: ticks=" << stats.d_ticks
+           << " topics=" << stats.d_topics
+           << " residentChunks=" << stats.d_residentChunks
+           << " spilledChunks=" << stats.d_spilledChunks
+           << " arenaSlabs=" << stats.d_arenaSlabs;
+    return stream;
+}
@@ -0,0 +1,253 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _TICKSTORE_H_
+#define _TICKSTORE_H_
+
+#include <blpapi_element.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace blp = BloombergLP::blpapi;
+
+// TickChunk holds up to 'k_CAPACITY' ticks of one topic as parallel columns,
+// so that a scan over one column touches nothing else.  It is plain old data
+// and never holds a pointer, so a sealed (full) chunk can be written to a
+// file and used again through a read-only mapping of that file.
+struct TickChunk {
+    static const std::size_t k_CAPACITY = 4096;
+
+    std::uint32_t d_count;
+    std::uint32_t d_sorted;      // 1 while times are non-decreasing
+    long long     d_firstNs;     // smallest time in the chunk
+    long long     d_lastNs;      // largest time in the chunk
+    long long     d_times[k_CAPACITY];       // nanoseconds since Unix epoch
+    double        d_prices[k_CAPACITY];
+    double        d_sizes[k_CAPACITY];
+    std::uint16_t d_types[k_CAPACITY];       // 'TickStore::typeId'
+    std::uint16_t d_conditions[k_CAPACITY];  // 'TickStore::conditionId'
+};
+
+// TickArena hands out chunks carved from slabs of 'k_CHUNKS_PER_SLAB'
+// chunks, and recycles the chunks given back, so that appending does not go
+// to the heap once the store has warmed up.  Thread-safe.
+class TickArena {
+  public:
+    static const std::size_t k_CHUNKS_PER_SLAB = 16;
+
+  private:
+    std::vector<std::unique_ptr<TickChunk[]> > d_slabs;
+    std::vector<TickChunk *>                   d_free;
+    mutable std::mutex                         d_mutex;
+
+    TickArena(const TickArena&);
+    TickArena& operator=(const TickArena&);
+
+  public:
+    TickArena() {}
+
+    TickChunk *allocate();
+        // Return an empty chunk.
+
+    void deallocate(TickChunk *chunk);
+
+    std::size_t numSlabs() const;
+};
+
+// TickBar summarizes the ticks of one interval, like the bars of an
+// 'IntradayBarRequest'.
+struct TickBar {
+    long long   d_startNs;
+    double      d_open;
+    double      d_high;
+    double      d_low;
+    double      d_close;
+    double      d_volume;
+    std::size_t d_numTicks;
+};
+
+// TickStore keeps the ticks of every topic in memory, appended to chunked
+// columns allocated from a 'TickArena', for time-range queries that would
+// otherwise need an 'IntradayTickRequest'.  Ticks come from subscription
+// data (see 'EventProcessor::setTickStore') or from 'tickData' elements laid
+// out as in an 'IntradayTickResponse'.  Tick types (TRADE, BID, ...) and
+// condition codes are stored as small ids interned by the store.
+//
+// A topic's last chunk is open for appending; once full it is sealed.  If a
+// spill file is set, a topic keeps at most 'maxResidentChunks' sealed chunks
+// in memory: older ones are written to the file, mapped back read-only and
+// their memory returned to the arena, so the store can grow beyond memory
+// while queries still read every chunk through a pointer.
+//
+// Times are expected to be mostly increasing; a chunk that received a tick
+// older than its last one is scanned in full rather than by binary search.
+// Every function may be called from any thread; each topic has its own
+// lock.
+class TickStore {
+  public:
+    struct Row {
+        long long     d_timeNs;
+        double        d_price;
+        double        d_size;
+        std::uint16_t d_type;
+        std::uint16_t d_condition;
+    };
+
+    struct Statistics {
+        std::uint64_t d_ticks;
+        std::size_t   d_topics;
+        std::size_t   d_residentChunks;
+        std::size_t   d_spilledChunks;
+        std::size_t   d_arenaSlabs;
+    };
+
+    static const std::uint16_t k_ANY_TYPE     = 0xffff;
+    static const std::uint16_t k_NO_CONDITION = 0;
+
+  private:
+    struct Series {
+        std::vector<TickChunk *> d_chunks;       // oldest first
+        std::vector<bool>        d_spilled;      // per chunk
+        std::size_t              d_firstResident; // oldest unspilled sealed
+        std::uint64_t            d_ticks;
+        std::mutex               d_mutex;
+    };
+
+    typedef std::map<std::string, std::uint16_t> Ids;
+
+    TickArena                            d_arena;
+    std::vector<std::unique_ptr<Series> > d_series;
+    std::size_t                          d_maxResidentChunks;
+    int                                  d_spillFd;
+    std::uint64_t                        d_spillOffset;
+    std::size_t                          d_spilledChunks;
+    mutable std::mutex                   d_spillMutex;
+    std::vector<std::string>             d_typeNames;
+    std::vector<std::string>             d_conditionNames;
+    Ids                                  d_types;
+    Ids                                  d_conditions;
+    mutable std::mutex                   d_namesMutex;
+
+    TickStore(const TickStore&);
+    TickStore& operator=(const TickStore&);
+
+    static std::uint16_t intern(Ids                      *ids,
+                                std::vector<std::string> *names,
+                                const std::string&        name);
+
+    void appendLocked(Series        *series,
+                      long long      timeNs,
+                      double         price,
+                      double         size,
+                      std::uint16_t  type,
+                      std::uint16_t  condition);
+
+    void spill(Series *series);
+        // Spill the oldest resident sealed chunks of 'series' until at most
+        // 'd_maxResidentChunks' remain.  'series' is locked.
+
+    TickChunk *spillChunk(const TickChunk& chunk);
+        // Write 'chunk' to the spill file and return a read-only mapping of
+        // it, or 0 on failure.
+
+    static void scanChunk(std::vector<Row>  *rows,
+                          const TickChunk&   chunk,
+                          long long          beginNs,
+                          long long          endNs);
+
+  public:
+    TickStore(std::size_t numTopics, std::size_t maxResidentChunks = 16);
+        // Create a store for topic ids '[0, numTopics)', keeping up to
+        // 'maxResidentChunks' sealed chunks per topic in memory once a spill
+        // file is set.
+
+    ~TickStore();
+
+    bool spillTo(const std::string& path);
+        // Spill sealed chunks to 'path', which is created or truncated.
+        // Return false if it could not be opened.  Not available on Windows.
+
+    std::uint16_t typeId(const std::string& type);
+    std::uint16_t conditionId(const std::string& conditionCodes);
+        // Return the id of 'conditionCodes', 'k_NO_CONDITION' if empty.
+
+    std::string typeName(std::uint16_t id) const;
+    std::string conditionName(std::uint16_t id) const;
+
+    void append(std::size_t   topic,
+                long long     timeNs,
+                double        price,
+                double        size,
+                std::uint16_t type,
+                std::uint16_t condition = k_NO_CONDITION);
+        // Append a tick to 'topic'.  Ticks for topics out of range are
+        // ignored.
+
+    std::size_t appendTickData(std::size_t topic, const blp::Element& data);
+        // Append every tick of 'data' to 'topic' and return how many there
+        // were.  'data' is the 'tickData' element of an
+        // 'IntradayTickResponse', or the 'tickData' array within it, whose
+        // items hold 'time', 'type', 'value', 'size' and optionally
+        // 'conditionCodes'.
+
+    std::size_t scan(std::vector<Row> *rows,
+                     std::size_t       topic,
+                     long long         beginNs,
+                     long long         endNs) const;
+        // Append to 'rows' the ticks of 'topic' with a time in
+        // '[beginNs, endNs)', in the order they were appended, and return how
+        // many were appended.
+
+    std::size_t downsample(std::vector<TickBar> *bars,
+                           std::size_t           topic,
+                           long long             beginNs,
+                           long long             endNs,
+                           long long             intervalNs,
+                           std::uint16_t         type = k_ANY_TYPE) const;
+        // Append to 'bars' one bar per 'intervalNs' interval, starting at
+        // 'beginNs', holding ticks of 'topic' of 'type', and return how many
+        // were appended.  Intervals without ticks have no bar.
+
+    std::size_t numTopics() const;
+
+    Statistics statistics() const;
+
+    static long long toNanoseconds(const blp::Datetime& datetime);
+        // Return 'datetime' as nanoseconds since the Unix epoch, taking its
+        // offset into account if it has one.
+};
+
+std::ostream& operator<<(std::ostream&                stream,
+                         const TickStore::Statistics& stats);
+
+inline
+std::size_t TickStore::numTopics() const
+{
+    return d_series.size();
+}
+
+#endif
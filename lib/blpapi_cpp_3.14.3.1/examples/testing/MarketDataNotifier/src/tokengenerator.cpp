@@ -42,7 +42,7 @@ std::string TokenGenerator::generate(blp::EventQueue *queue)
 
     std::string token;
     d_session->generateToken(blp::CorrelationId(), queue);
-    blp::Event           event = queue->nextEvent();
+    blp::Event           event = queue->nextEvent(d_timeoutMs);
     blp::MessageIterator iter(event);
     if (event.eventType() == blp::Event::TOKEN_STATUS ||
         event.eventType() == blp::Event::REQUEST_STATUS) {
@@ -36,16 +36,20 @@ class ITokenGenerator {
 class TokenGenerator : public ITokenGenerator {
   private:
     blp::Session *d_session;
+    int           d_timeoutMs;
 
   public:
-    TokenGenerator(blp::Session *session);
+    TokenGenerator(blp::Session *session, int timeoutMs = 10000);
+        // Create a generator for 'session' that gives up on a token not
+        // received within 'timeoutMs' and returns an empty one.
 
     virtual std::string generate(blp::EventQueue *queue);
 };
 
 inline
-TokenGenerator::TokenGenerator(blp::Session *session)
+TokenGenerator::TokenGenerator(blp::Session *session, int timeoutMs)
 : d_session(session)
+, d_timeoutMs(timeoutMs)
 {
 }
 
@@ -0,0 +1,118 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "topicanalytics.h"
+
+#include <cmath>
+
+RollingVolatility::RollingVolatility(std::size_t window)
+: d_values(window < 2 ? 2 : window)
+, d_next(0)
+, d_count(0)
+, d_mean(0)
+, d_sumSquares(0)
+{
+}
+
+void RollingVolatility::add(double value)
+{
+    if (d_count < d_values.size()) {
+        ++d_count;
+        const double delta = value - d_mean;
+        d_mean       += delta / d_count;
+        d_sumSquares += delta * (value - d_mean);
+    }
+    else {
+        // Replace the oldest value: the mean moves by the difference over
+        // the window, and the sum of squares by the product of that
+        // difference with the deviations of both values.
+        const double oldest  = d_values[d_next];
+        const double oldMean = d_mean;
+        d_mean       += (value - oldest) / d_count;
+        d_sumSquares += (value - oldest) * (value - d_mean + oldest - oldMean);
+    }
+    d_values[d_next] = value;
+    d_next           = (d_next + 1) % d_values.size();
+
+    if (d_next == 0 && d_count == d_values.size()) {
+        // Once per window, recompute both from the values in two passes so
+        // that rounding errors of the updates do not accumulate.
+        double mean = 0;
+        for (std::size_t i = 0; i < d_count; ++i) {
+            mean += d_values[i];
+        }
+        mean /= d_count;
+        double sumSquares = 0;
+        for (std::size_t i = 0; i < d_count; ++i) {
+            sumSquares += (d_values[i] - mean) * (d_values[i] - mean);
+        }
+        d_mean       = mean;
+        d_sumSquares = sumSquares;
+    }
+}
+
+double RollingVolatility::value() const
+{
+    if (d_count < 2 || d_sumSquares <= 0) {
+        return 0;
+    }
+    return std::sqrt(d_sumSquares / (d_count - 1));
+}
+
+TopicAnalytics::TopicAnalytics(double ewmaAlpha, std::size_t window)
+: d_ewmaAlpha(ewmaAlpha)
+, d_notional(0)
+, d_volume(0)
+, d_ewma(0)
+, d_lastPrice(0)
+, d_ticks(0)
+, d_volatility(window)
+{
+}
+
+void TopicAnalytics::update(const TickBatch& batch)
+{
+    if (batch.d_count == 0) {
+        return;
+    }
+    if (batch.d_sizes) {
+        double notional;
+        double volume;
+        ComputeKernels::notionalAndVolume(&notional,
+                                          &volume,
+                                          batch.d_prices,
+                                          batch.d_sizes,
+                                          batch.d_count);
+        d_notional += notional;
+        d_volume   += volume;
+    }
+    d_ewma = ComputeKernels::ewma(batch.d_prices,
+                                  batch.d_count,
+                                  d_ewmaAlpha,
+                                  d_ticks ? d_ewma : batch.d_prices[0]);
+
+    for (std::size_t i = 0; i < batch.d_count; ++i) {
+        if (d_lastPrice != 0) {
+            d_volatility.add(batch.d_prices[i] / d_lastPrice - 1.0);
+        }
+        d_lastPrice = batch.d_prices[i];
+    }
+    d_ticks += batch.d_count;
+}
@@ -0,0 +1,127 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _TOPICANALYTICS_H_
+#define _TOPICANALYTICS_H_
+
+#include <cstddef>
+#include <vector>
+
+#include "computeengine.h"
+
+// RollingVolatility keeps the sample standard deviation of the last
+// 'window' values added to it.  The mean and the sum of squared deviations
+// are updated with Welford's method, adding each new value and removing the
+// one it replaces, so a value costs O(1) and the result does not suffer the
+// cancellation of a running sum of squares.  Both are recomputed from the
+// window once per window, so the rounding errors of the updates stay
+// bounded however many values are added.
+class RollingVolatility {
+  private:
+    std::vector<double> d_values;   // ring of the last 'window' values
+    std::size_t         d_next;
+    std::size_t         d_count;
+    double              d_mean;
+    double              d_sumSquares;
+
+  public:
+    explicit RollingVolatility(std::size_t window);
+        // Create an empty window of 'window' values; 'window' must be at
+        // least 2.
+
+    void add(double value);
+
+    double value() const;
+        // Return the sample standard deviation of the values in the window,
+        // or 0 if it holds fewer than two.
+
+    std::size_t count() const;
+};
+
+// TopicAnalytics accumulates the analytics of one topic across the batches
+// of its ticks: the VWAP since the first tick, an EWMA of prices, and the
+// volatility of the simple returns between consecutive prices over a
+// rolling window.  The VWAP and the EWMA of a batch are computed with the
+// 'ComputeKernels'.  It is not thread-safe; 'EventProcessor' updates it
+// under the topic's lock.
+class TopicAnalytics {
+  private:
+    double            d_ewmaAlpha;
+    double            d_notional;
+    double            d_volume;
+    double            d_ewma;
+    double            d_lastPrice;
+    std::size_t       d_ticks;
+    RollingVolatility d_volatility;
+
+  public:
+    explicit TopicAnalytics(double      ewmaAlpha = 0.1,
+                            std::size_t window = 100);
+        // Create analytics smoothing the EWMA with 'ewmaAlpha' and taking
+        // the volatility of the last 'window' returns.
+
+    void update(const TickBatch& batch);
+        // Fold the ticks of 'batch', which are consecutive ticks of the
+        // topic, into the analytics.  Sizes count towards the VWAP only if
+        // 'batch' has them.
+
+    double vwap() const;
+        // Return the VWAP, or 0 if no size was traded.
+
+    double ewma() const;
+        // Return the EWMA, seeded with the first price, or 0 if there was
+        // no tick.
+
+    double volatility() const;
+
+    std::size_t ticks() const;
+};
+
+inline
+std::size_t RollingVolatility::count() const
+{
+    return d_count;
+}
+
+inline
+double TopicAnalytics::vwap() const
+{
+    return d_volume != 0 ? d_notional / d_volume : 0;
+}
+
+inline
+double TopicAnalytics::ewma() const
+{
+    return d_ewma;
+}
+
+inline
+double TopicAnalytics::volatility() const
+{
+    return d_volatility.value();
+}
+
+inline
+std::size_t TopicAnalytics::ticks() const
+{
+    return d_ticks;
+}
+
+#endif
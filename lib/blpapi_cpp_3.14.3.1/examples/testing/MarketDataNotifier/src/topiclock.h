@@ -0,0 +1,61 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _TOPICLOCK_H_
+#define _TOPICLOCK_H_
+
+#include <mutex>
+
+// TopicLock is the lock of one topic's state.  It is held while a tick of
+// the topic is delivered, which may block on a notifier, so a thread that
+// waits for it sleeps instead of spinning.  Unlike 'std::mutex' it can be
+// copied, so that it can live in elements of a 'std::vector': a copy is a
+// new, unlocked lock, and copying a lock that is held does not copy the
+// holder.
+class TopicLock {
+  private:
+    std::mutex d_mutex;
+
+  public:
+    TopicLock()
+    {
+    }
+
+    TopicLock(const TopicLock&)
+    {
+    }
+
+    TopicLock& operator=(const TopicLock&)
+    {
+        return *this;
+    }
+
+    void lock()
+    {
+        d_mutex.lock();
+    }
+
+    void unlock()
+    {
+        d_mutex.unlock();
+    }
+};
+
+#endif
@@ -0,0 +1,131 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef _TOPICTABLE_H_
+#define _TOPICTABLE_H_
+
+#include <blpapi_correlationid.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "topicanalytics.h"
+#include "topiclock.h"
+
+namespace blp = BloombergLP::blpapi;
+
+// TopicState is the state of one topic.  When events are dispatched on
+// several threads, every field but 'd_topic' must be accessed under
+// 'd_lock'.
+struct TopicState {
+    std::string    d_topic;
+    double         d_lastPrice;
+    std::uint64_t  d_ticks;
+    long long      d_lastReceivedNs;   // of the newest tick accepted, or 0
+    TopicAnalytics d_analytics;        // of the ticks accepted
+    TopicLock      d_lock;
+};
+
+// TopicTable assigns every subscribed topic a dense integer id, starting at
+// 0, and keeps the per-topic state contiguously indexed by that id.  The id
+// is used as an integer 'CorrelationId' for the subscription, so routing a
+// message back to its topic is a bounds check and an array access.
+//
+// Topics must all be added before the subscriptions are made; the table is
+// then only read, and topic states updated under their own lock.
+class TopicTable {
+  private:
+    std::vector<TopicState> d_topics;
+
+  public:
+    static const std::size_t k_INVALID_ID = static_cast<std::size_t>(-1);
+
+    void reserve(std::size_t numTopics);
+
+    std::size_t add(const std::string& topic);
+        // Append 'topic' to the table and return its id.
+
+    static blp::CorrelationId correlationId(std::size_t id);
+        // Return the 'CorrelationId' to subscribe with for 'id'.
+
+    static std::size_t topicId(const blp::CorrelationId& correlationId);
+        // Return the id carried by 'correlationId', or 'k_INVALID_ID' if it
+        // was not created by 'correlationId(std::size_t)'.
+
+    TopicState *find(const blp::CorrelationId& correlationId);
+        // Return the state of the topic 'correlationId' was made for, or 0
+        // if it does not belong to this table.
+
+    TopicState& operator[](std::size_t id);
+    const TopicState& operator[](std::size_t id) const;
+
+    std::size_t size() const;
+};
+
+inline
+void TopicTable::reserve(std::size_t numTopics)
+{
+    d_topics.reserve(numTopics);
+}
+
+inline
+blp::CorrelationId TopicTable::correlationId(std::size_t id)
+{
+    return blp::CorrelationId(static_cast<long long>(id));
+}
+
+inline
+std::size_t TopicTable::topicId(const blp::CorrelationId& correlationId)
+{
+    if (correlationId.valueType() != blp::CorrelationId::INT_VALUE
+            || correlationId.asInteger() < 0) {
+        return k_INVALID_ID;
+    }
+    return static_cast<std::size_t>(correlationId.asInteger());
+}
+
+inline
+TopicState *TopicTable::find(const blp::CorrelationId& correlationId)
+{
+    std::size_t id = topicId(correlationId);
+    return id < d_topics.size() ? &d_topics[id] : 0;
+}
+
+inline
+TopicState& TopicTable::operator[](std::size_t id)
+{
+    return d_topics[id];
+}
+
+inline
+const TopicState& TopicTable::operator[](std::size_t id) const
+{
+    return d_topics[id];
+}
+
+inline
+std::size_t TopicTable::size() const
+{
+    return d_topics.size();
+}
+
+#endif
@@ -0,0 +1,405 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <asyncauthorizer.h>
+#include <mockSession.h>
+#include <testSchemas.h>
+#include <messageTypes.h>
+
+#include <blpapi_event.h>
+#include <blpapi_identity.h>
+#include <blpapi_service.h>
+#include <blpapi_testutil.h>
+
+#include <sstream>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using namespace testing;
+
+namespace blp    = BloombergLP::blpapi;
+namespace blptst = blp::test;
+
+namespace {
+const blp::Name SESSION_STARTED("SessionStarted");
+const blp::Name SERVICE_OPENED("ServiceOpened");
+const blp::Name AUTHORIZATION_REVOKED("AuthorizationRevoked");
+const blp::Name MKTDATA_EVENTS("MarketDataEvents");
+
+class MockEventHandler : public blp::EventHandler {
+  public:
+    MOCK_METHOD2(processEvent, bool(const blp::Event&, blp::Session *));
+};
+
+class MockAuthorizationListener : public IAuthorizationListener {
+  public:
+    MOCK_METHOD2(onAuthorized, void(std::size_t, const blp::Identity&));
+
+    MOCK_METHOD2(onAuthorizationFailed,
+                 void(std::size_t, const std::string&));
+};
+
+blp::Event createAdminEvent(blp::Event::EventType      eventType,
+                            const blp::Name&           messageType,
+                            const blp::CorrelationId&  correlationId,
+                            const char                *content = 0)
+{
+    blp::Event event = blptst::TestUtil::createEvent(eventType);
+
+    blptst::MessageProperties properties;
+    if (correlationId.valueType() != blp::CorrelationId::UNSET_VALUE) {
+        properties.setCorrelationId(correlationId);
+    }
+    blptst::MessageFormatter formatter = blptst::TestUtil::appendMessage(
+            event,
+            blptst::TestUtil::getAdminMessageDefinition(messageType),
+            properties);
+    if (content) {
+        formatter.formatMessageJson(content);
+    }
+    return event;
+}
+}
+
+class AsyncAuthorizerTest : public testing::Test
+{
+  protected:
+    MockSession                           d_session;
+    NiceMock<MockEventHandler>            d_handler;
+    StrictMock<MockAuthorizationListener> d_listener;
+    AsyncAuthorizer                       d_authorizer;
+    blp::Service                          d_service;
+
+  public:
+    AsyncAuthorizerTest()
+    : d_authorizer(&d_session, &d_handler, &d_listener, 10000, 0)
+    {
+    }
+
+    virtual void SetUp()
+    {
+        std::istringstream schemaStream(getApiAuthSchemaString());
+        d_service = blptst::TestUtil::deserializeService(schemaStream);
+    }
+
+    blp::CorrelationId openService()
+        // Start the session and open the authorization service, and return
+        // the 'CorrelationId' of the token requested for the first identity
+        // added.
+    {
+        blp::CorrelationId serviceCid;
+        EXPECT_CALL(d_session, openServiceAsync(_, _))
+            .WillOnce(DoAll(SaveArg<1>(&serviceCid),
+                            Return(blp::CorrelationId())));
+        d_authorizer.processEvent(
+            createAdminEvent(blp::Event::SESSION_STATUS,
+                             SESSION_STARTED,
+                             blp::CorrelationId()),
+            &d_session);
+
+        blp::CorrelationId tokenCid;
+        EXPECT_CALL(d_session, getService(_)).WillOnce(Return(d_service));
+        EXPECT_CALL(d_session, generateToken(_, _))
+            .WillOnce(DoAll(SaveArg<0>(&tokenCid),
+                            Return(blp::CorrelationId())));
+        d_authorizer.processEvent(
+            createAdminEvent(blp::Event::SERVICE_STATUS,
+                             SERVICE_OPENED,
+                             serviceCid),
+            &d_session);
+        return tokenCid;
+    }
+
+    blp::CorrelationId receiveToken(const blp::CorrelationId& tokenCid)
+        // Deliver a token for 'tokenCid' and return the 'CorrelationId' of
+        // the authorization request sent with it.
+    {
+        blp::CorrelationId authCid;
+        EXPECT_CALL(d_session, createIdentity())
+            .WillOnce(Return(blp::Identity()));
+        EXPECT_CALL(d_session, sendAuthorizationRequest(_, _, _, _))
+            .WillOnce(DoAll(SaveArg<2>(&authCid),
+                            Return(blp::CorrelationId())));
+        d_authorizer.processEvent(
+            createAdminEvent(blp::Event::TOKEN_STATUS,
+                             TOKEN_SUCCESS,
+                             tokenCid,
+                             "{\"token\": \"dummyToken\"}"),
+            &d_session);
+        return authCid;
+    }
+};
+
+//
+// Concern: Verify that an identity goes from token generation to
+// authorization on events alone, and is reported to the listener.
+//
+// Plan:
+// 1. Add an identity, then deliver SessionStarted and ServiceOpened and
+//    expect the service to be opened asynchronously and a token requested.
+// 2. Deliver the token and expect an authorization request.
+// 3. Deliver AuthorizationSuccess for that request and verify that the
+//    listener is told and that the identity is authorized.
+//
+TEST_F(AsyncAuthorizerTest, AuthorizesOnEvents)
+{
+    const std::size_t id = d_authorizer.addIdentity();
+    ASSERT_EQ(AsyncAuthorizer::e_PENDING, d_authorizer.state(id));
+
+    const blp::CorrelationId tokenCid = openService();
+    ASSERT_EQ(AsyncAuthorizer::e_GENERATING_TOKEN, d_authorizer.state(id));
+
+    const blp::CorrelationId authCid = receiveToken(tokenCid);
+    ASSERT_EQ(AsyncAuthorizer::e_AUTHORIZING, d_authorizer.state(id));
+
+    EXPECT_CALL(d_listener, onAuthorized(id, _));
+    d_authorizer.processEvent(createAdminEvent(blp::Event::RESPONSE,
+                                               AUTHORIZATION_SUCCESS,
+                                               authCid),
+                              &d_session);
+
+    ASSERT_EQ(AsyncAuthorizer::e_AUTHORIZED, d_authorizer.state(id));
+    ASSERT_EQ(1u, d_authorizer.statistics().d_authorized);
+}
+
+//
+// Concern: Verify that subscription data is forwarded while an identity is
+// being authorized, and that authorization events are not.
+//
+// Plan:
+// 1. Start authorizing an identity.
+// 2. Deliver a SubscriptionData event and expect it to reach the handler.
+// 3. Deliver the token and expect the handler not to see it.
+//
+TEST_F(AsyncAuthorizerTest, ForwardsSubscriptionData)
+{
+    d_authorizer.addIdentity();
+    const blp::CorrelationId tokenCid = openService();
+
+    std::istringstream schemaStream(getMktDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+    blp::Event   data    =
+        blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    blptst::TestUtil::appendMessage(
+        data, service.getEventDefinition(MKTDATA_EVENTS))
+        .formatMessageJson("{\"LAST_PRICE\": 1.0}");
+
+    EXPECT_CALL(d_handler, processEvent(_, &d_session))
+        .WillOnce(Return(true));
+    ASSERT_TRUE(d_authorizer.processEvent(data, &d_session));
+    Mock::VerifyAndClearExpectations(&d_handler);
+
+    EXPECT_CALL(d_handler, processEvent(_, _)).Times(0);
+    receiveToken(tokenCid);
+}
+
+//
+// Concern: Verify that identities are authorized concurrently.
+//
+// Plan:
+// 1. Add three identities, the last one with a manual user id.
+// 2. Open the service and verify that a token is requested for each before
+//    any is received.
+//
+TEST_F(AsyncAuthorizerTest, AuthorizesIdentitiesConcurrently)
+{
+    d_authorizer.addIdentity();
+    d_authorizer.addIdentity();
+    d_authorizer.addIdentity("user", "10.0.0.1");
+
+    EXPECT_CALL(d_session, generateToken(StrEq("user"),
+                                         StrEq("10.0.0.1"),
+                                         _,
+                                         _))
+        .WillOnce(Return(blp::CorrelationId()));
+
+    blp::CorrelationId serviceCid;
+    EXPECT_CALL(d_session, openServiceAsync(_, _))
+        .WillOnce(DoAll(SaveArg<1>(&serviceCid),
+                        Return(blp::CorrelationId())));
+    d_authorizer.processEvent(createAdminEvent(blp::Event::SESSION_STATUS,
+                                               SESSION_STARTED,
+                                               blp::CorrelationId()),
+                              &d_session);
+
+    EXPECT_CALL(d_session, getService(_)).WillOnce(Return(d_service));
+    EXPECT_CALL(d_session, generateToken(_, _))
+        .Times(2)
+        .WillRepeatedly(Return(blp::CorrelationId()));
+    d_authorizer.processEvent(createAdminEvent(blp::Event::SERVICE_STATUS,
+                                               SERVICE_OPENED,
+                                               serviceCid),
+                              &d_session);
+
+    for (std::size_t id = 0; id < 3; ++id) {
+        ASSERT_EQ(AsyncAuthorizer::e_GENERATING_TOKEN,
+                  d_authorizer.state(id));
+    }
+}
+
+//
+// Concern: Verify that a revoked identity is re-authorized, and that the
+// old identity is kept until then.
+//
+// Plan:
+// 1. Authorize an identity.
+// 2. Deliver AuthorizationRevoked for it and expect a new token request.
+// 3. Verify that the identity is being re-authorized and the revocation
+//    counted.
+//
+TEST_F(AsyncAuthorizerTest, ReauthorizesWhenRevoked)
+{
+    const std::size_t        id      = d_authorizer.addIdentity();
+    const blp::CorrelationId authCid = receiveToken(openService());
+
+    EXPECT_CALL(d_listener, onAuthorized(id, _));
+    d_authorizer.processEvent(createAdminEvent(blp::Event::RESPONSE,
+                                               AUTHORIZATION_SUCCESS,
+                                               authCid),
+                              &d_session);
+
+    EXPECT_CALL(d_session, generateToken(_, _))
+        .WillOnce(Return(blp::CorrelationId()));
+    d_authorizer.processEvent(
+        createAdminEvent(blp::Event::AUTHORIZATION_STATUS,
+                         AUTHORIZATION_REVOKED,
+                         authCid),
+        &d_session);
+
+    ASSERT_EQ(AsyncAuthorizer::e_GENERATING_TOKEN, d_authorizer.state(id));
+    ASSERT_EQ(1u, d_authorizer.statistics().d_revoked);
+}
+
+//
+// Concern: Verify that a revoked identity is authorized again in place: the
+// new request is sent for the same 'blp::Identity', the request it replaces
+// is cancelled, and nothing is unsubscribed or subscribed again.
+//
+// Plan:
+// 1. Authorize an identity and keep the identity the request was sent for.
+// 2. Revoke it and deliver a new token, and expect the first authorization
+//    request to be cancelled before the second is sent, for the same
+//    identity and without creating another.
+// 3. Deliver AuthorizationSuccess and verify that the listener is told
+//    again without any subscription being touched.
+//
+TEST_F(AsyncAuthorizerTest, ReauthorizesIdentityInPlace)
+{
+    const std::size_t  id        = d_authorizer.addIdentity();
+    blp::CorrelationId tokenCid  = openService();
+    blp::Identity     *identity  = 0;
+    blp::CorrelationId firstCid;
+
+    EXPECT_CALL(d_session, createIdentity())
+        .WillOnce(Return(blp::Identity()));
+    EXPECT_CALL(d_session, sendAuthorizationRequest(_, _, _, _))
+        .WillOnce(DoAll(SaveArg<1>(&identity),
+                        SaveArg<2>(&firstCid),
+                        Return(blp::CorrelationId())));
+    d_authorizer.processEvent(
+        createAdminEvent(blp::Event::TOKEN_STATUS,
+                         TOKEN_SUCCESS,
+                         tokenCid,
+                         "{\"token\": \"dummyToken\"}"),
+        &d_session);
+
+    EXPECT_CALL(d_listener, onAuthorized(id, _)).Times(2);
+    EXPECT_CALL(d_session, subscribe(_, _, _, _)).Times(0);
+    EXPECT_CALL(d_session, unsubscribe(_)).Times(0);
+    d_authorizer.processEvent(createAdminEvent(blp::Event::RESPONSE,
+                                               AUTHORIZATION_SUCCESS,
+                                               firstCid),
+                              &d_session);
+
+    EXPECT_CALL(d_session, generateToken(_, _))
+        .WillOnce(DoAll(SaveArg<0>(&tokenCid),
+                        Return(blp::CorrelationId())));
+    d_authorizer.processEvent(
+        createAdminEvent(blp::Event::AUTHORIZATION_STATUS,
+                         AUTHORIZATION_REVOKED,
+                         firstCid),
+        &d_session);
+
+    blp::CorrelationId secondCid;
+    Sequence           sequence;
+    EXPECT_CALL(d_session, createIdentity()).Times(0);
+    EXPECT_CALL(d_session,
+                cancel(TypedEq<const blp::CorrelationId&>(firstCid)))
+        .InSequence(sequence);
+    EXPECT_CALL(d_session, sendAuthorizationRequest(_, identity, _, _))
+        .InSequence(sequence)
+        .WillOnce(DoAll(SaveArg<2>(&secondCid),
+                        Return(blp::CorrelationId())));
+    d_authorizer.processEvent(
+        createAdminEvent(blp::Event::TOKEN_STATUS,
+                         TOKEN_SUCCESS,
+                         tokenCid,
+                         "{\"token\": \"dummyToken\"}"),
+        &d_session);
+    ASSERT_NE(firstCid, secondCid);
+
+    d_authorizer.processEvent(createAdminEvent(blp::Event::RESPONSE,
+                                               AUTHORIZATION_SUCCESS,
+                                               secondCid),
+                              &d_session);
+    ASSERT_EQ(AsyncAuthorizer::e_AUTHORIZED, d_authorizer.state(id));
+    ASSERT_EQ(2u, d_authorizer.statistics().d_authorized);
+}
+
+//
+// Concern: Verify that an unanswered request is cancelled and retried, and
+// that the listener is told once every attempt has timed out.
+//
+// Plan:
+// 1. Start authorizing an identity.
+// 2. Poll past the timeout and expect the token request to be cancelled and
+//    the identity to back off.
+// 3. Keep polling far enough apart for every retry to start and time out,
+//    and expect a failure after 'k_MAX_ATTEMPTS' attempts.
+//
+TEST_F(AsyncAuthorizerTest, RetriesAndFailsAfterTimeouts)
+{
+    const std::size_t id = d_authorizer.addIdentity();
+    openService();
+
+    EXPECT_CALL(d_session, cancel(An<const blp::CorrelationId&>()))
+        .Times(AsyncAuthorizer::k_MAX_ATTEMPTS);
+    EXPECT_CALL(d_session, generateToken(_, _))
+        .Times(AsyncAuthorizer::k_MAX_ATTEMPTS - 1)
+        .WillRepeatedly(Return(blp::CorrelationId()));
+
+    AsyncAuthorizer::Clock::time_point now = AsyncAuthorizer::Clock::now();
+    now += std::chrono::minutes(1);
+    d_authorizer.poll(now);
+    ASSERT_EQ(AsyncAuthorizer::e_BACKING_OFF, d_authorizer.state(id));
+
+    EXPECT_CALL(d_listener, onAuthorizationFailed(id, _));
+    for (int i = 1; i < AsyncAuthorizer::k_MAX_ATTEMPTS; ++i) {
+        now += std::chrono::minutes(1);
+        d_authorizer.poll(now);            // retry
+        now += std::chrono::minutes(1);
+        d_authorizer.poll(now);            // time out
+    }
+
+    ASSERT_EQ(AsyncAuthorizer::e_FAILED, d_authorizer.state(id));
+    ASSERT_EQ(static_cast<std::uint64_t>(AsyncAuthorizer::k_MAX_ATTEMPTS),
+              d_authorizer.statistics().d_timedOut);
+}
@@ -0,0 +1,205 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <bufferednotifier.h>
+
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace {
+std::string readAll(std::FILE *file)
+{
+    std::fflush(file);
+    std::fseek(file, 0, SEEK_SET);
+
+    std::string contents;
+    char        buffer[4096];
+    std::size_t length;
+    while ((length = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        contents.append(buffer, length);
+    }
+    return contents;
+}
+}
+
+class BufferedNotifierTest : public testing::Test {
+  protected:
+    std::FILE *d_file;
+
+  public:
+    virtual void SetUp()
+    {
+        d_file = std::tmpfile();
+        ASSERT_TRUE(d_file != 0);
+    }
+
+    virtual void TearDown()
+    {
+        std::fclose(d_file);
+    }
+};
+
+//
+// Concern: Verify that records are written in order, formatted as the
+// console 'Notifier' formats them, and that the counters add up.
+//
+// Plan:
+// 1. Create a started BufferedNotifier writing to a temporary file.
+// 2. Send two values to the terminal and stop the notifier.
+// 3. Verify the file contents and the statistics.
+//
+TEST_F(BufferedNotifierTest, WritesRecordsInOrder)
+{
+    BufferedNotifier notifier(fileno(d_file), 1024, 1000);
+    ASSERT_TRUE(notifier.start());
+
+    notifier.sendToTerminal(1.5);
+    notifier.sendToTerminal(2.0);
+    notifier.stop();
+
+    const std::string expected("VALUE = 1.5\nVALUE = 2\n");
+    ASSERT_EQ(expected, readAll(d_file));
+
+    BufferedNotifier::Statistics stats = notifier.statistics();
+    ASSERT_EQ(2u, stats.d_records);
+    ASSERT_EQ(expected.size(), stats.d_bytes);
+    ASSERT_EQ(1u, stats.d_batches);
+}
+
+//
+// Concern: Verify that a buffered record is written once the flush interval
+// has elapsed even though the size threshold was not reached.
+//
+// Plan:
+// 1. Create a started BufferedNotifier with a large size threshold and a
+//    short flush interval.
+// 2. Send one value and wait, without stopping the notifier, until it has
+//    been written.
+// 3. Verify that the record age stayed within a generous bound.
+//
+TEST_F(BufferedNotifierTest, FlushesOnInterval)
+{
+    BufferedNotifier notifier(fileno(d_file), 1024 * 1024, 5);
+    ASSERT_TRUE(notifier.start());
+
+    notifier.sendToTerminal(42.0);
+    for (int i = 0; i < 1000 && notifier.statistics().d_batches == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    BufferedNotifier::Statistics stats = notifier.statistics();
+    ASSERT_EQ(1u, stats.d_batches);
+    ASSERT_LT(stats.d_maxRecordAgeNs, 1000u * 1000 * 1000);
+    ASSERT_EQ("VALUE = 42\n", readAll(d_file));
+}
+
+//
+// Concern: Verify that records from several threads are written without
+// being interleaved or lost, including when a buffer fills up.
+//
+// Plan:
+// 1. Create a started BufferedNotifier with a tiny size threshold, so the
+//    per-thread buffers fill up and the writer runs many batches.
+// 2. Send values from several threads concurrently and stop the notifier.
+// 3. Verify that every line is intact and that none is missing.
+//
+TEST_F(BufferedNotifierTest, ConcurrentThreads)
+{
+    const int k_THREADS = 4;
+    const int k_RECORDS = 2000;
+
+    BufferedNotifier notifier(fileno(d_file), 64, 1);
+    ASSERT_TRUE(notifier.start());
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < k_THREADS; ++t) {
+        threads.push_back(std::thread([&notifier, t, k_RECORDS]() {
+            for (int i = 0; i < k_RECORDS; ++i) {
+                notifier.sendToTerminal(t * k_RECORDS + i);
+            }
+        }));
+    }
+    for (std::size_t t = 0; t < threads.size(); ++t) {
+        threads[t].join();
+    }
+    notifier.stop();
+
+    std::vector<bool>  seen(k_THREADS * k_RECORDS, false);
+    std::istringstream lines(readAll(d_file));
+    std::string        line;
+    int                count = 0;
+    while (std::getline(lines, line)) {
+        ASSERT_EQ(0u, line.find("VALUE = "));
+        int value = std::stoi(line.substr(8));
+        ASSERT_FALSE(seen[value]);
+        seen[value] = true;
+        ++count;
+    }
+    ASSERT_EQ(k_THREADS * k_RECORDS, count);
+    ASSERT_EQ(static_cast<std::uint64_t>(count),
+              notifier.statistics().d_records);
+}
+
+//
+// Concern: Verify that a thread alternating between two notifiers keeps
+// writing to each of them correctly.
+//
+// Plan:
+// 1. Create two started BufferedNotifiers writing to different files.
+// 2. From one thread, send values to them alternately and stop both.
+// 3. Verify that each file holds its own values, in order.
+//
+TEST_F(BufferedNotifierTest, AlternatingNotifiers)
+{
+    std::FILE *other = std::tmpfile();
+    ASSERT_TRUE(other != 0);
+    {
+        BufferedNotifier first(fileno(d_file), 1024, 1000);
+        BufferedNotifier second(fileno(other), 1024, 1000);
+        ASSERT_TRUE(first.start());
+        ASSERT_TRUE(second.start());
+
+        for (int i = 0; i < 100; ++i) {
+            first.sendToTerminal(i);
+            second.sendToTerminal(-i);
+        }
+        first.stop();
+        second.stop();
+        ASSERT_EQ(100u, first.statistics().d_records);
+        ASSERT_EQ(100u, second.statistics().d_records);
+    }
+
+    std::ostringstream expectedFirst;
+    std::ostringstream expectedSecond;
+    for (int i = 0; i < 100; ++i) {
+        expectedFirst << "VALUE = " << i << '\n';
+        expectedSecond << "VALUE = " << -i << '\n';
+    }
+    ASSERT_EQ(expectedFirst.str(), readAll(d_file));
+    ASSERT_EQ(expectedSecond.str(), readAll(other));
+    std::fclose(other);
+}
@@ -0,0 +1,147 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <computeengine.h>
+#include <computekernels.h>
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace {
+// Sizes that exercise the vector loops as well as the scalar tails.
+const std::size_t k_COUNTS[] = { 0, 1, 2, 3, 4, 5, 7, 8, 9, 31, 1000 };
+
+std::vector<double> makePrices(std::size_t count)
+{
+    std::vector<double> prices(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        prices[i] = 100.0 + std::sin(i * 0.37) * 5.0 + i * 0.01;
+    }
+    return prices;
+}
+
+std::vector<double> makeSizes(std::size_t count)
+{
+    std::vector<double> sizes(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        sizes[i] = static_cast<double>(1 + (i * 7) % 13);
+    }
+    return sizes;
+}
+
+const double *data(const std::vector<double>& values)
+{
+    return values.empty() ? 0 : &values[0];
+}
+}
+
+//
+// Concern: Verify that every kernel matches a straightforward scalar
+// implementation, whichever instruction set it was built for.
+//
+TEST(ComputeKernelsTest, Scale)
+{
+    for (std::size_t c = 0; c < sizeof k_COUNTS / sizeof *k_COUNTS; ++c) {
+        const std::size_t   count  = k_COUNTS[c];
+        std::vector<double> prices = makePrices(count);
+        std::vector<double> results(count + 1, -1.0);
+
+        ComputeKernels::scale(&results[0], data(prices), count, 2.0);
+
+        for (std::size_t i = 0; i < count; ++i) {
+            ASSERT_EQ(prices[i] * 2.0, results[i])
+                << ComputeKernels::instructionSet();
+        }
+        ASSERT_EQ(-1.0, results[count]);
+    }
+}
+
+TEST(ComputeKernelsTest, Vwap)
+{
+    for (std::size_t c = 0; c < sizeof k_COUNTS / sizeof *k_COUNTS; ++c) {
+        const std::size_t   count  = k_COUNTS[c];
+        std::vector<double> prices = makePrices(count);
+        std::vector<double> sizes  = makeSizes(count);
+
+        double notional = 0;
+        double volume   = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            notional += prices[i] * sizes[i];
+            volume   += sizes[i];
+        }
+        double expected = volume != 0 ? notional / volume : 0;
+
+        ASSERT_NEAR(expected,
+                    ComputeKernels::vwap(data(prices), data(sizes), count),
+                    1e-9);
+
+        double sumNotional = -1;
+        double sumVolume   = -1;
+        ComputeKernels::notionalAndVolume(&sumNotional,
+                                          &sumVolume,
+                                          data(prices),
+                                          data(sizes),
+                                          count);
+        ASSERT_NEAR(notional, sumNotional, 1e-9 * (1 + notional));
+        ASSERT_EQ(volume, sumVolume);
+    }
+}
+
+TEST(ComputeKernelsTest, Ewma)
+{
+    const double alpha = 0.2;
+    for (std::size_t c = 0; c < sizeof k_COUNTS / sizeof *k_COUNTS; ++c) {
+        const std::size_t   count  = k_COUNTS[c];
+        std::vector<double> prices = makePrices(count);
+
+        double expected = 50.0;
+        for (std::size_t i = 0; i < count; ++i) {
+            expected = alpha * prices[i] + (1 - alpha) * expected;
+        }
+
+        ASSERT_NEAR(expected,
+                    ComputeKernels::ewma(data(prices), count, alpha, 50.0),
+                    1e-9);
+    }
+}
+
+//
+// Concern: Verify that the batch API of 'ComputeEngine' gives the same
+// results as the scalar one.
+//
+TEST(ComputeEngineTest, ComputeBatchMatchesScalar)
+{
+    ComputeEngine       engine;
+    std::vector<double> prices = makePrices(37);
+    std::vector<double> results(prices.size());
+
+    TickBatch batch;
+    batch.d_prices = &prices[0];
+    batch.d_count  = prices.size();
+    engine.computeBatch(&results[0], batch);
+
+    for (std::size_t i = 0; i < prices.size(); ++i) {
+        ASSERT_EQ(engine.someVeryComplexComputation(prices[i]), results[i]);
+    }
+}
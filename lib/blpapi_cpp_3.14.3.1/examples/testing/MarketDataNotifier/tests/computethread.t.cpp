@@ -0,0 +1,287 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <computethread.h>
+#include <spscqueue.h>
+#include <mockComputeEngine.h>
+#include <mockNotifier.h>
+
+#include <thread>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using namespace testing;
+
+namespace {
+Tick makeTick(double lastPrice)
+{
+    Tick tick;
+    tick.d_topic     = 0;
+    tick.d_lastPrice = lastPrice;
+    return tick;
+}
+}
+
+//
+// Concern: Verify that the queue capacity is rounded up to a power of two and
+// that elements come out in the order they were pushed.
+//
+// Plan:
+// 1. Create a queue asking for a capacity of 3.
+// 2. Fill it and verify a further 'tryPush' fails.
+// 3. Drain it and verify the order and the high-water mark.
+//
+TEST(SpscQueueTest, FifoAndCapacity)
+{
+    SpscQueue<int> queue(3);
+    ASSERT_EQ(4u, queue.capacity());
+
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(queue.tryPush(i));
+    }
+    ASSERT_FALSE(queue.tryPush(4));
+    ASSERT_EQ(4u, queue.size());
+
+    int value = -1;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(queue.tryPop(&value));
+        ASSERT_EQ(i, value);
+    }
+    ASSERT_FALSE(queue.tryPop(&value));
+    ASSERT_EQ(4u, queue.highWaterMark());
+}
+
+//
+// Concern: Verify that 'pushOverwrite' evicts the oldest element only when
+// the queue is full.
+//
+// Plan:
+// 1. Push two elements into a queue of capacity 2 with 'pushOverwrite' and
+//    verify nothing is evicted.
+// 2. Push a third and verify the first one is evicted.
+//
+TEST(SpscQueueTest, PushOverwriteEvictsOldest)
+{
+    SpscQueue<int> queue(2);
+
+    ASSERT_FALSE(queue.pushOverwrite(1));
+    ASSERT_FALSE(queue.pushOverwrite(2));
+    ASSERT_TRUE(queue.pushOverwrite(3));
+
+    int value = 0;
+    ASSERT_TRUE(queue.tryPop(&value));
+    ASSERT_EQ(2, value);
+    ASSERT_TRUE(queue.tryPop(&value));
+    ASSERT_EQ(3, value);
+    ASSERT_FALSE(queue.tryPop(&value));
+}
+
+//
+// Concern: Verify that the consumer never pops an element the producer
+// overwrote while it was being copied.
+//
+// Plan:
+// 1. Overwrite a small queue as fast as possible from one thread with
+//    elements whose halves must match, while another thread pops.
+// 2. Verify that every popped element is whole and that elements come out
+//    in increasing order.
+//
+TEST(SpscQueueTest, PushOverwriteNeverTearsElements)
+{
+    struct Pair {
+        long long d_first;
+        long long d_second;
+    };
+    static const long long k_COUNT = 1000000;
+
+    SpscQueue<Pair>   queue(4);
+    std::atomic<bool> done(false);
+    std::thread       producer([&]() {
+        for (long long i = 1; i <= k_COUNT; ++i) {
+            Pair pair = { i, -i };
+            queue.pushOverwrite(pair);
+        }
+        done.store(true);
+    });
+
+    long long last = 0;
+    Pair      pair;
+    for (;;) {
+        const bool finished = done.load();
+        while (queue.tryPop(&pair)) {
+            ASSERT_EQ(-pair.d_first, pair.d_second);
+            ASSERT_LT(last, pair.d_first);
+            last = pair.d_first;
+        }
+        if (finished) {
+            break;
+        }
+    }
+    producer.join();
+    ASSERT_EQ(k_COUNT, last);
+}
+
+//
+// Concern: Verify that the compute thread computes every queued tick in
+// order and sends the results to the notifier.
+//
+// Plan:
+// 1. Push three ticks before starting the thread.
+// 2. Set up expectations on the compute engine and notifier in sequence.
+// 3. Start and stop the thread; 'stop' drains what is already queued.
+// 4. Verify the statistics.
+//
+TEST(ComputeThreadTest, ProcessesTicksInOrder)
+{
+    MockComputeEngine computeEngine;
+    MockNotifier      notifier;
+    ComputeThread     computeThread(&computeEngine, &notifier, 8);
+
+    // Ticks are computed in batches, so only the order of the computations
+    // and the order of the notifications are checked.
+    Sequence computations;
+    Sequence notifications;
+    for (int i = 1; i <= 3; ++i) {
+        EXPECT_CALL(computeEngine, someVeryComplexComputation(i))
+            .InSequence(computations)
+            .WillOnce(Return(i * 10.0));
+        EXPECT_CALL(notifier, sendToTerminal(i * 10.0))
+            .InSequence(notifications);
+    }
+
+    for (int i = 1; i <= 3; ++i) {
+        computeThread.push(makeTick(i));
+    }
+    ASSERT_TRUE(computeThread.start());
+    computeThread.stop();
+
+    ComputeThread::Statistics stats = computeThread.statistics();
+    ASSERT_EQ(3u, stats.d_enqueued);
+    ASSERT_EQ(3u, stats.d_processed);
+    ASSERT_EQ(0u, stats.d_dropped);
+    ASSERT_EQ(3u, stats.d_highWaterMark);
+}
+
+//
+// Concern: Verify that the drop policy discards the incoming tick when the
+// ring is full.
+//
+// Plan:
+// 1. Push three ticks into a ring of capacity 2 without starting the thread.
+// 2. Verify that only the first two ticks are processed once it runs.
+//
+TEST(ComputeThreadTest, DropPolicyDiscardsNewest)
+{
+    MockComputeEngine computeEngine;
+    MockNotifier      notifier;
+    ComputeThread     computeThread(
+        &computeEngine, &notifier, 2, ComputeThread::e_DROP);
+
+    EXPECT_CALL(computeEngine, someVeryComplexComputation(1.0))
+        .WillOnce(Return(1.0));
+    EXPECT_CALL(computeEngine, someVeryComplexComputation(2.0))
+        .WillOnce(Return(2.0));
+    EXPECT_CALL(notifier, sendToTerminal(_)).Times(2);
+
+    computeThread.push(makeTick(1.0));
+    computeThread.push(makeTick(2.0));
+    computeThread.push(makeTick(3.0));
+
+    ComputeThread::Statistics stats = computeThread.statistics();
+    ASSERT_EQ(2u, stats.d_enqueued);
+    ASSERT_EQ(1u, stats.d_dropped);
+
+    computeThread.start();
+    computeThread.stop();
+}
+
+//
+// Concern: Verify that the overwrite policy keeps the newest ticks when the
+// ring is full.
+//
+// Plan:
+// 1. Push three ticks into a ring of capacity 2 without starting the thread.
+// 2. Verify that only the last two ticks are processed once it runs.
+//
+TEST(ComputeThreadTest, OverwritePolicyKeepsNewest)
+{
+    MockComputeEngine computeEngine;
+    MockNotifier      notifier;
+    ComputeThread     computeThread(
+        &computeEngine, &notifier, 2, ComputeThread::e_OVERWRITE);
+
+    EXPECT_CALL(computeEngine, someVeryComplexComputation(2.0))
+        .WillOnce(Return(2.0));
+    EXPECT_CALL(computeEngine, someVeryComplexComputation(3.0))
+        .WillOnce(Return(3.0));
+    EXPECT_CALL(notifier, sendToTerminal(_)).Times(2);
+
+    computeThread.push(makeTick(1.0));
+    computeThread.push(makeTick(2.0));
+    computeThread.push(makeTick(3.0));
+
+    ComputeThread::Statistics stats = computeThread.statistics();
+    ASSERT_EQ(3u, stats.d_enqueued);
+    ASSERT_EQ(1u, stats.d_overwritten);
+    ASSERT_EQ(2u, stats.d_highWaterMark);
+
+    computeThread.start();
+    computeThread.stop();
+}
+
+//
+// Concern: Verify that the block policy does not spin the dispatcher forever
+// once nothing drains the ring.
+//
+// Plan:
+// 1. Fill a ring of capacity 2 without starting the thread.
+// 2. Push a third tick and verify that it returns and is counted as dropped.
+//
+TEST(ComputeThreadTest, BlockPolicyDropsWhenStopped)
+{
+    MockComputeEngine computeEngine;
+    MockNotifier      notifier;
+    ComputeThread     computeThread(
+        &computeEngine, &notifier, 2, ComputeThread::e_BLOCK);
+
+    computeThread.push(makeTick(1.0));
+    computeThread.push(makeTick(2.0));
+    computeThread.push(makeTick(3.0));
+
+    ComputeThread::Statistics stats = computeThread.statistics();
+    ASSERT_EQ(2u, stats.d_enqueued);
+    ASSERT_EQ(1u, stats.d_blocked);
+    ASSERT_EQ(1u, stats.d_dropped);
+}
+
+//
+// Concern: Verify that overflow policy names are parsed.
+//
+TEST(ComputeThreadTest, ParseOverflowPolicy)
+{
+    ComputeThread::OverflowPolicy policy = ComputeThread::e_DROP;
+
+    ASSERT_TRUE(ComputeThread::parseOverflowPolicy(&policy, "block"));
+    ASSERT_EQ(ComputeThread::e_BLOCK, policy);
+    ASSERT_TRUE(ComputeThread::parseOverflowPolicy(&policy, "overwrite"));
+    ASSERT_EQ(ComputeThread::e_OVERWRITE, policy);
+    ASSERT_FALSE(ComputeThread::parseOverflowPolicy(&policy, "fifo"));
+}
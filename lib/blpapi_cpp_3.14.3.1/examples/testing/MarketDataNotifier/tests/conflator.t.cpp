@@ -0,0 +1,136 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <conflator.h>
+#include <mockComputeEngine.h>
+#include <mockNotifier.h>
+
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using namespace testing;
+
+namespace {
+const std::size_t TOPIC_A = 0;
+const std::size_t TOPIC_B = 1;
+const std::size_t TOPIC_C = 2;
+
+Tick makeTick(std::size_t topic, double lastPrice)
+{
+    Tick tick;
+    tick.d_topic     = topic;
+    tick.d_lastPrice = lastPrice;
+    return tick;
+}
+}
+
+class ConflatorTest : public testing::Test {
+  protected:
+    MockComputeEngine d_computeEngine;
+    MockNotifier      d_notifier;
+};
+
+//
+// Concern: Verify that only the latest tick of each topic is pulled, and
+// only for topics updated since the previous pull.
+//
+// Plan:
+// 1. Push three ticks for topic A and one for topic B.
+// 2. Pull and verify one tick per topic carrying the latest price.
+// 3. Push one more tick for topic B, pull again and verify only B is
+//    returned.
+// 4. Verify the statistics.
+//
+TEST_F(ConflatorTest, PullReturnsLatestDirtyTopics)
+{
+    Conflator conflator(&d_computeEngine, &d_notifier, 2, 1000);
+
+    conflator.push(makeTick(TOPIC_A, 1.0));
+    conflator.push(makeTick(TOPIC_A, 2.0));
+    conflator.push(makeTick(TOPIC_B, 10.0));
+    conflator.push(makeTick(TOPIC_A, 3.0));
+
+    std::vector<Tick> ticks;
+    ASSERT_EQ(2u, conflator.pull(&ticks));
+    ASSERT_EQ(TOPIC_A, ticks[0].d_topic);
+    ASSERT_EQ(3.0, ticks[0].d_lastPrice);
+    ASSERT_EQ(TOPIC_B, ticks[1].d_topic);
+    ASSERT_EQ(10.0, ticks[1].d_lastPrice);
+
+    ticks.clear();
+    ASSERT_EQ(0u, conflator.pull(&ticks));
+
+    conflator.push(makeTick(TOPIC_B, 11.0));
+    ASSERT_EQ(1u, conflator.pull(&ticks));
+    ASSERT_EQ(11.0, ticks[0].d_lastPrice);
+
+    Conflator::Statistics stats = conflator.statistics();
+    ASSERT_EQ(5u, stats.d_received);
+    ASSERT_EQ(2u, stats.d_conflated);
+    ASSERT_EQ(3u, stats.d_published);
+    ASSERT_EQ(0u, stats.d_rejected);
+}
+
+//
+// Concern: Verify that ticks with a topic id beyond the conflator's capacity
+// are rejected rather than corrupting another topic's slot.
+//
+TEST_F(ConflatorTest, RejectsTopicsBeyondCapacity)
+{
+    Conflator conflator(&d_computeEngine, &d_notifier, 2, 1000);
+
+    conflator.push(makeTick(TOPIC_A, 1.0));
+    conflator.push(makeTick(TOPIC_B, 2.0));
+    conflator.push(makeTick(TOPIC_C, 3.0));
+
+    std::vector<Tick> ticks;
+    ASSERT_EQ(2u, conflator.pull(&ticks));
+    ASSERT_EQ(1u, conflator.statistics().d_rejected);
+}
+
+//
+// Concern: Verify that the conflation thread computes and notifies the
+// latest value of each dirty topic.
+//
+// Plan:
+// 1. Push several ticks for two topics before starting the thread.
+// 2. Set up expectations for one computation and notification per topic.
+// 3. Start and stop the conflator; 'stop' publishes what is dirty.
+//
+TEST_F(ConflatorTest, PublishesConflatedTicks)
+{
+    Conflator conflator(&d_computeEngine, &d_notifier, 2, 1000);
+
+    conflator.push(makeTick(TOPIC_A, 1.0));
+    conflator.push(makeTick(TOPIC_A, 2.0));
+    conflator.push(makeTick(TOPIC_B, 5.0));
+
+    EXPECT_CALL(d_computeEngine, someVeryComplexComputation(2.0))
+        .WillOnce(Return(4.0));
+    EXPECT_CALL(d_computeEngine, someVeryComplexComputation(5.0))
+        .WillOnce(Return(10.0));
+    EXPECT_CALL(d_notifier, sendToTerminal(4.0));
+    EXPECT_CALL(d_notifier, sendToTerminal(10.0));
+
+    ASSERT_TRUE(conflator.start());
+    conflator.stop();
+}
@@ -18,6 +18,7 @@
  * IN THE SOFTWARE.
  */
 
+#include <blpapi_datetime.h>
 #include <blpapi_event.h>
 #include <blpapi_messageformatter.h>
 #include <blpapi_request.h>
@@ -27,6 +28,7 @@
 
 #include <fstream>
 #include <sstream>
+#include <vector>
 #include <testSchemas.h>
 
 #include "gmock/gmock.h"
@@ -42,6 +44,23 @@
 namespace blp    = BloombergLP::blpapi;
 namespace blptst = blp::test;
 
+class MockTickSink : public ITickSink {
+  public:
+    MOCK_METHOD1(push, void(const Tick&));
+};
+
+// Records the size of every batch it is asked to compute.
+class BatchRecordingEngine : public ComputeEngine {
+  public:
+    std::vector<std::size_t> d_batchSizes;
+
+    virtual void computeBatch(double *results, const TickBatch& batch)
+    {
+        d_batchSizes.push_back(batch.d_count);
+        ComputeEngine::computeBatch(results, batch);
+    }
+};
+
 namespace {
 const blp::Name SESSION_STARTED("SessionStarted");
 const blp::Name SUBSCRIPTION_STARTED("SubscriptionStarted");
@@ -185,3 +204,250 @@ TEST_F(EventProcessorTest, NotifierReceivesSubscriptionData)
 
     d_eventProcessor->processEvent(event, d_session);
 }
+
+//
+// Concern
+// Verify that when a tick sink is provided, subscription data is handed to it
+// and neither the compute engine nor the notifier is called on the
+// dispatcher thread.
+//
+// Plan:
+// 1. Create an EventProcessor with a mock tick sink.
+// 2. Create a SubscriptionEvent with a `MarketDataEvents' message as above.
+// 3. Setup expectation and save the tick pushed to the sink.
+// 4. Verify that the tick carries LAST_PRICE.
+//
+TEST_F(EventProcessorTest, TickSinkReceivesSubscriptionData)
+{
+    MockTickSink   tickSink;
+    EventProcessor eventProcessor(d_notifier, d_computeEngine, &tickSink);
+
+    std::istringstream schemaStream(getMktDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+
+    const blp::SchemaElementDefinition schemaDef =
+        service.getEventDefinition(MKTDATA_EVENTS);
+
+    blp::Event event =
+        blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    blptst::MessageFormatter formatter =
+        blptst::TestUtil::appendMessage(event, schemaDef);
+    formatter.formatMessageJson("{\"LAST_PRICE\": 142.80}");
+
+    Tick tick;
+    tick.d_topic     = 0;
+    tick.d_lastPrice = 0;
+    EXPECT_CALL(tickSink, push(testing::_))
+        .WillOnce(testing::SaveArg<0>(&tick));
+    EXPECT_CALL(*d_computeEngine, someVeryComplexComputation(testing::_))
+        .Times(0);
+    EXPECT_CALL(*d_notifier, sendToTerminal(testing::_)).Times(0);
+
+    eventProcessor.processEvent(event, d_session);
+
+    ASSERT_EQ(142.80, tick.d_lastPrice);
+    ASSERT_EQ(TopicTable::k_INVALID_ID, tick.d_topic);
+}
+
+//
+// Concern
+// Verify that a message is routed to its topic's state by the integer
+// correlation id assigned by the topic table.
+//
+// Plan:
+// 1. Create a topic table with two topics and an EventProcessor using it.
+// 2. Create a SubscriptionEvent with a `MarketDataEvents' message whose
+//    correlation id is that of the second topic.
+// 3. Verify that only the second topic's state is updated and that the tick
+//    pushed to the sink carries its id.
+//
+TEST_F(EventProcessorTest, TopicTableRoutesByCorrelationId)
+{
+    TopicTable topicTable;
+    topicTable.add("/ticker/IBM US Equity");
+    const std::size_t id = topicTable.add("/ticker/MSFT US Equity");
+
+    MockTickSink   tickSink;
+    EventProcessor eventProcessor(
+        d_notifier, d_computeEngine, &tickSink, &topicTable);
+
+    std::istringstream schemaStream(getMktDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+
+    const blp::SchemaElementDefinition schemaDef =
+        service.getEventDefinition(MKTDATA_EVENTS);
+
+    blptst::MessageProperties properties;
+    properties.setCorrelationId(TopicTable::correlationId(id));
+
+    blp::Event event =
+        blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    blptst::MessageFormatter formatter =
+        blptst::TestUtil::appendMessage(event, schemaDef, properties);
+    formatter.formatMessageJson("{\"LAST_PRICE\": 42.5}");
+
+    Tick tick;
+    tick.d_topic     = TopicTable::k_INVALID_ID;
+    tick.d_lastPrice = 0;
+    EXPECT_CALL(tickSink, push(testing::_))
+        .WillOnce(testing::SaveArg<0>(&tick));
+
+    eventProcessor.processEvent(event, d_session);
+
+    ASSERT_EQ(id, tick.d_topic);
+    ASSERT_EQ(0u, topicTable[0].d_ticks);
+    ASSERT_EQ(1u, topicTable[id].d_ticks);
+    ASSERT_EQ(42.5, topicTable[id].d_lastPrice);
+}
+
+//
+// Concern
+// Verify that the ticks of one event are computed with a single batch call
+// and sent to the terminal in message order.
+//
+// Plan:
+// 1. Create an EventProcessor with an engine recording its batch sizes.
+// 2. Create a SubscriptionEvent with three `MarketDataEvents' messages, the
+//    second one without LAST_PRICE.
+// 3. Verify that one batch of two ticks was computed and that both results
+//    were sent to the terminal in order.
+//
+TEST_F(EventProcessorTest, ComputesOneBatchPerEvent)
+{
+    BatchRecordingEngine engine;
+    EventProcessor       eventProcessor(d_notifier, &engine);
+
+    std::istringstream schemaStream(getMktDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+
+    const blp::SchemaElementDefinition schemaDef =
+        service.getEventDefinition(MKTDATA_EVENTS);
+
+    blp::Event event =
+        blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    blptst::TestUtil::appendMessage(event, schemaDef)
+        .formatMessageJson("{\"LAST_PRICE\": 10.0}");
+    blptst::TestUtil::appendMessage(event, schemaDef)
+        .formatMessageJson("{\"BID\": 11.0}");
+    blptst::TestUtil::appendMessage(event, schemaDef)
+        .formatMessageJson("{\"LAST_PRICE\": 12.0}");
+
+    testing::InSequence sequence;
+    EXPECT_CALL(*d_notifier, sendToTerminal(20.0));
+    EXPECT_CALL(*d_notifier, sendToTerminal(24.0));
+
+    eventProcessor.processEvent(event, d_session);
+
+    ASSERT_EQ(1u, engine.d_batchSizes.size());
+    ASSERT_EQ(2u, engine.d_batchSizes[0]);
+}
+
+//
+// Concern
+// Verify that a tick received before the last tick delivered for its topic
+// is dropped, as it would be if the events had been processed out of order
+// by a dispatcher pool.
+//
+// Plan:
+// 1. Create a topic table with one topic and an EventProcessor using it.
+// 2. Create a SubscriptionEvent with two `MarketDataEvents' messages for
+//    the topic, the second one received one second before the first.
+// 3. Verify that only the first tick is sent to the terminal, that the
+//    topic state holds its price and that one stale tick is counted.
+//
+TEST_F(EventProcessorTest, DropsTicksReceivedOutOfOrder)
+{
+    TopicTable        topicTable;
+    const std::size_t id = topicTable.add("/ticker/IBM US Equity");
+    ComputeEngine     engine;
+    EventProcessor    eventProcessor(d_notifier, &engine, 0, &topicTable);
+
+    std::istringstream schemaStream(getMktDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+
+    const blp::SchemaElementDefinition schemaDef =
+        service.getEventDefinition(MKTDATA_EVENTS);
+
+    blptst::MessageProperties later;
+    later.setCorrelationId(TopicTable::correlationId(id))
+        .setTimeReceived(blp::Datetime(2021, 1, 1, 12, 0, 1));
+    blptst::MessageProperties earlier;
+    earlier.setCorrelationId(TopicTable::correlationId(id))
+        .setTimeReceived(blp::Datetime(2021, 1, 1, 12, 0, 0));
+
+    blp::Event event =
+        blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    blptst::TestUtil::appendMessage(event, schemaDef, later)
+        .formatMessageJson("{\"LAST_PRICE\": 10.0}");
+    blptst::TestUtil::appendMessage(event, schemaDef, earlier)
+        .formatMessageJson("{\"LAST_PRICE\": 9.0}");
+
+    EXPECT_CALL(*d_notifier, sendToTerminal(20.0));
+
+    eventProcessor.processEvent(event, d_session);
+
+    ASSERT_EQ(1u, eventProcessor.staleTicks());
+    ASSERT_EQ(1u, topicTable[id].d_ticks);
+    ASSERT_EQ(10.0, topicTable[id].d_lastPrice);
+    ASSERT_EQ(1u, topicTable[id].d_analytics.ticks());
+    ASSERT_EQ(10.0, topicTable[id].d_analytics.ewma());
+}
+
+//
+// Concern
+// Verify that the analytics of every topic are updated with its ticks, in
+// order, when the ticks of several topics are interleaved in one event.
+//
+// Plan:
+// 1. Create a topic table with two topics and an EventProcessor using it.
+// 2. Create a SubscriptionEvent with ticks for the first, first, second and
+//    first topic.
+// 3. Verify that the analytics of each topic match analytics updated with
+//    that topic's prices one at a time.
+//
+TEST_F(EventProcessorTest, UpdatesTopicAnalytics)
+{
+    TopicTable        topicTable;
+    const std::size_t ibm  = topicTable.add("/ticker/IBM US Equity");
+    const std::size_t msft = topicTable.add("/ticker/MSFT US Equity");
+    ComputeEngine     engine;
+    EventProcessor    eventProcessor(d_notifier, &engine, 0, &topicTable);
+
+    std::istringstream schemaStream(getMktDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+
+    const blp::SchemaElementDefinition schemaDef =
+        service.getEventDefinition(MKTDATA_EVENTS);
+
+    const std::size_t topics[] = { ibm, ibm, msft, ibm };
+    const double      prices[] = { 10.0, 10.5, 20.0, 10.25 };
+    blp::Event        event    =
+        blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    TopicAnalytics    expected[2];
+    for (std::size_t i = 0; i < 4; ++i) {
+        blptst::MessageProperties properties;
+        properties.setCorrelationId(TopicTable::correlationId(topics[i]));
+        std::ostringstream json;
+        json << "{\"LAST_PRICE\": " << prices[i] << "}";
+        blptst::TestUtil::appendMessage(event, schemaDef, properties)
+            .formatMessageJson(json.str().c_str());
+
+        TickBatch tick;
+        tick.d_prices = &prices[i];
+        tick.d_count  = 1;
+        expected[topics[i]].update(tick);
+    }
+
+    EXPECT_CALL(*d_notifier, sendToTerminal(testing::_)).Times(4);
+
+    eventProcessor.processEvent(event, d_session);
+
+    for (std::size_t id = 0; id < 2; ++id) {
+        const TopicAnalytics& analytics = topicTable[id].d_analytics;
+        ASSERT_EQ(expected[id].ticks(), analytics.ticks());
+        ASSERT_DOUBLE_EQ(expected[id].ewma(), analytics.ewma());
+        ASSERT_DOUBLE_EQ(expected[id].volatility(), analytics.volatility());
+    }
+    ASSERT_EQ(3u, topicTable[ibm].d_analytics.ticks());
+    ASSERT_LT(0.0, topicTable[ibm].d_analytics.volatility());
+}
@@ -0,0 +1,214 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <computeengine.h>
+#include <eventprocessor.h>
+#include <eventrecorder.h>
+#include <eventreplayer.h>
+#include <mockNotifier.h>
+#include <testSchemas.h>
+#include <topictable.h>
+
+#include <blpapi_event.h>
+#include <blpapi_service.h>
+#include <blpapi_testutil.h>
+
+#include <sstream>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace blp    = BloombergLP::blpapi;
+namespace blptst = blp::test;
+
+namespace {
+const blp::Name MKTDATA_EVENTS("MarketDataEvents");
+}
+
+//
+// Concern: Verify that a capture line is split into its parts, and that
+// lines in another format are rejected.
+//
+TEST(EventReplayerTest, ParsesRecords)
+{
+    EventReplayer::Record record;
+    ASSERT_TRUE(EventReplayer::parseRecord(
+        &record,
+        "{\"event\":4,\"ns\":1500,\"cid\":7,\"type\":\"MarketDataEvents\","
+        "\"msg\":{\"LAST_PRICE\":142.8,\"VOLUME\":10}}"));
+    ASSERT_EQ(4u, record.d_event);
+    ASSERT_EQ(1500, record.d_ns);
+    ASSERT_EQ(7, record.d_correlationId);
+    ASSERT_EQ("", record.d_topic);
+    ASSERT_EQ("MarketDataEvents", record.d_type);
+    ASSERT_EQ("{\"LAST_PRICE\":142.8,\"VOLUME\":10}", record.d_message);
+
+    ASSERT_TRUE(EventReplayer::parseRecord(
+        &record,
+        "{\"event\":5,\"ns\":1600,\"cid\":0,\"topic\":\"IBM \\\"US\\\"\","
+        "\"type\":\"MarketDataEvents\",\"msg\":{\"LAST_PRICE\":1}}"));
+    ASSERT_EQ(0, record.d_correlationId);
+    ASSERT_EQ("IBM \"US\"", record.d_topic);
+    ASSERT_EQ("MarketDataEvents", record.d_type);
+
+    ASSERT_TRUE(EventReplayer::parseRecord(
+        &record,
+        "{\"event\":0,\"ns\":0,\"type\":\"MarketDataEvents\",\"msg\":{}}"));
+    ASSERT_EQ(-1, record.d_correlationId);
+    ASSERT_EQ("{}", record.d_message);
+
+    ASSERT_FALSE(EventReplayer::parseRecord(&record, "not a record"));
+    ASSERT_FALSE(EventReplayer::parseRecord(
+        &record, "{\"event\":0,\"ns\":0,\"type\":\"MarketDataEvents\"}"));
+}
+
+//
+// Concern: Verify that recorded events are replayed through EventProcessor
+// with the same messages and correlation ids.
+//
+// Plan:
+// 1. Record two SubscriptionEvents, the first with two messages for topics
+//    0 and 1, the second with one message for topic 1.
+// 2. Load the capture with the mktdata schema and replay it as fast as
+//    possible into an EventProcessor using a topic table of two topics.
+// 3. Verify the notifications, the topic states and the statistics.
+//
+TEST(EventReplayerTest, ReplaysRecordedEvents)
+{
+    std::istringstream schemaStream(getMktDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+
+    const blp::SchemaElementDefinition schemaDef =
+        service.getEventDefinition(MKTDATA_EVENTS);
+
+    std::ostringstream capture;
+    EventRecorder      recorder(&capture);
+
+    blptst::MessageProperties topic0;
+    topic0.setCorrelationId(TopicTable::correlationId(0));
+    blptst::MessageProperties topic1;
+    topic1.setCorrelationId(TopicTable::correlationId(1));
+
+    blp::Event first =
+        blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    blptst::TestUtil::appendMessage(first, schemaDef, topic0)
+        .formatMessageJson("{\"LAST_PRICE\": 1.5, \"VOLUME\": 100}");
+    blptst::TestUtil::appendMessage(first, schemaDef, topic1)
+        .formatMessageJson("{\"LAST_PRICE\": 2.25}");
+    recorder.record(first);
+
+    blp::Event second =
+        blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    blptst::TestUtil::appendMessage(second, schemaDef, topic1)
+        .formatMessageJson("{\"LAST_PRICE\": 3.0}");
+    recorder.record(second);
+    ASSERT_EQ(2u, recorder.events());
+
+    std::istringstream replay(capture.str());
+    EventReplayer      replayer(service);
+    ASSERT_EQ(2u, replayer.load(replay));
+    ASSERT_EQ(0u, replayer.malformed());
+    ASSERT_EQ(1, replayer.maxCorrelationId());
+
+    TopicTable topicTable;
+    topicTable.add("/ticker/A");
+    topicTable.add("/ticker/B");
+    MockNotifier   notifier;
+    ComputeEngine  computeEngine;
+    EventProcessor eventProcessor(&notifier, &computeEngine, 0, &topicTable);
+
+    testing::InSequence sequence;
+    EXPECT_CALL(notifier, sendToTerminal(3.0));
+    EXPECT_CALL(notifier, sendToTerminal(4.5));
+    EXPECT_CALL(notifier, sendToTerminal(6.0));
+
+    EventReplayer::Statistics stats = replayer.replay(&eventProcessor, 0);
+    ASSERT_EQ(2u, stats.d_events);
+    ASSERT_EQ(3u, stats.d_messages);
+    ASSERT_EQ(1u, topicTable[0].d_ticks);
+    ASSERT_EQ(2u, topicTable[1].d_ticks);
+    ASSERT_EQ(3.0, topicTable[1].d_lastPrice);
+}
+
+//
+// Concern: Verify that messages of sessions whose correlation ids collide
+// are replayed to their own topics.
+//
+// Plan:
+// 1. Record a message for id 0 of each of two topic tables, as two shards
+//    would, and a second one for the first table.
+// 2. Load the capture and verify that each topic was given its own id.
+// 3. Replay it into an EventProcessor with a table of those topics and
+//    verify the topic states.
+//
+TEST(EventReplayerTest, RoutesByTopic)
+{
+    std::istringstream schemaStream(getMktDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+
+    const blp::SchemaElementDefinition schemaDef =
+        service.getEventDefinition(MKTDATA_EVENTS);
+
+    std::ostringstream capture;
+    EventRecorder      recorder(&capture);
+    TopicTable         firstShard;
+    firstShard.add("/ticker/A");
+    TopicTable         secondShard;
+    secondShard.add("/ticker/B");
+
+    blptst::MessageProperties topic0;
+    topic0.setCorrelationId(TopicTable::correlationId(0));
+
+    blp::Event first =
+        blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    blptst::TestUtil::appendMessage(first, schemaDef, topic0)
+        .formatMessageJson("{\"LAST_PRICE\": 1.5}");
+    recorder.record(first, &firstShard);
+
+    blp::Event second =
+        blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    blptst::TestUtil::appendMessage(second, schemaDef, topic0)
+        .formatMessageJson("{\"LAST_PRICE\": 2.5}");
+    recorder.record(second, &secondShard);
+    recorder.record(first, &firstShard);
+
+    std::istringstream replay(capture.str());
+    EventReplayer      replayer(service);
+    ASSERT_EQ(3u, replayer.load(replay));
+    ASSERT_EQ(1, replayer.maxCorrelationId());
+    ASSERT_EQ(2u, replayer.topics().size());
+    ASSERT_EQ("/ticker/A", replayer.topics()[0]);
+    ASSERT_EQ("/ticker/B", replayer.topics()[1]);
+
+    TopicTable topicTable;
+    topicTable.add(replayer.topics()[0]);
+    topicTable.add(replayer.topics()[1]);
+    MockNotifier   notifier;
+    ComputeEngine  computeEngine;
+    EventProcessor eventProcessor(&notifier, &computeEngine, 0, &topicTable);
+    EXPECT_CALL(notifier, sendToTerminal(testing::_)).Times(3);
+
+    replayer.replay(&eventProcessor, 0);
+    ASSERT_EQ(2u, topicTable[0].d_ticks);
+    ASSERT_EQ(1.5, topicTable[0].d_lastPrice);
+    ASSERT_EQ(1u, topicTable[1].d_ticks);
+    ASSERT_EQ(2.5, topicTable[1].d_lastPrice);
+}
@@ -0,0 +1,110 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <fieldregistry.h>
+#include <testSchemas.h>
+
+#include <blpapi_event.h>
+#include <blpapi_message.h>
+#include <blpapi_service.h>
+#include <blpapi_testutil.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace blp    = BloombergLP::blpapi;
+namespace blptst = blp::test;
+
+namespace {
+const blp::Name MKTDATA_EVENTS("MarketDataEvents");
+}
+
+//
+// Concern: Verify that 'LAST_PRICE' is always registered first and that
+// duplicate fields are registered once.
+//
+TEST(FieldRegistryTest, RegistersLastPriceAndUniqueFields)
+{
+    std::vector<std::string> fields;
+    fields.push_back("BID");
+    fields.push_back("LAST_PRICE");
+    fields.push_back("BID");
+    fields.push_back("VOLUME");
+
+    FieldRegistry registry(fields);
+
+    ASSERT_EQ(3u, registry.size());
+    ASSERT_EQ(0u, registry.lastPriceSlot());
+    ASSERT_EQ(blp::Name("LAST_PRICE"), registry.name(0));
+    ASSERT_EQ(blp::Name("BID"), registry.name(1));
+    ASSERT_EQ(blp::Name("VOLUME"), registry.name(2));
+    ASSERT_EQ(2u, registry.slot(blp::Name("VOLUME")));
+    ASSERT_EQ(registry.size(), registry.slot(blp::Name("ASK")));
+}
+
+//
+// Concern: Verify that every registered field present in a message is
+// extracted in one call, and that absent fields are flagged as such.
+//
+// Plan:
+// 1. Register LAST_PRICE, BID, ASK and VOLUME.
+// 2. Create a SubscriptionEvent with a `MarketDataEvents' message holding
+//    LAST_PRICE, BID and VOLUME.
+// 3. Extract and verify the values and presence bits.
+//
+TEST(FieldRegistryTest, ExtractsRegisteredFields)
+{
+    std::vector<std::string> fields;
+    fields.push_back("BID");
+    fields.push_back("ASK");
+    fields.push_back("VOLUME");
+    FieldRegistry registry(fields);
+
+    std::istringstream schemaStream(getMktDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+
+    blp::Event event =
+        blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    blptst::MessageFormatter formatter = blptst::TestUtil::appendMessage(
+        event, service.getEventDefinition(MKTDATA_EVENTS));
+    formatter.formatMessageJson("{"
+                                "\"LAST_PRICE\": 142.80,"
+                                "\"BID\": 142.75,"
+                                "\"VOLUME\": 1200"
+                                "}");
+
+    blp::MessageIterator iter(event);
+    ASSERT_TRUE(iter.next());
+
+    FieldValues values;
+    ASSERT_TRUE(registry.extract(&values, iter.message()));
+
+    ASSERT_TRUE(values.has(0));
+    ASSERT_EQ(142.80, values.d_values[0]);
+    ASSERT_TRUE(values.has(1));
+    ASSERT_EQ(142.75, values.d_values[1]);
+    ASSERT_FALSE(values.has(2));
+    ASSERT_TRUE(values.has(3));
+    ASSERT_EQ(1200.0, values.d_values[3]);
+}
@@ -0,0 +1,317 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <fieldregistry.h>
+#include <lastvaluecache.h>
+#include <lastvaluereader.h>
+#include <tick.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace {
+FieldValues makeValues(double lastPrice, double bid, bool hasBid)
+{
+    FieldValues values;
+    values.d_values[0] = lastPrice;
+    values.d_values[1] = bid;
+    values.d_present   = hasBid ? 3u : 1u;
+    return values;
+}
+}
+
+class LastValueCacheTest : public testing::Test {
+  protected:
+    std::string              d_name;
+    std::vector<std::string> d_topics;
+    FieldRegistry            d_fields;
+
+  public:
+    LastValueCacheTest()
+    : d_name("/marketDataNotifierTest" + std::to_string(getpid()))
+    , d_fields(std::vector<std::string>(1, "BID"))
+    {
+        d_topics.push_back("IBM US Equity");
+        d_topics.push_back("MSFT US Equity");
+    }
+};
+
+//
+// Concern: Verify that a reader in the same process sees the topics and
+// fields of the cache, and the last value of each field.
+//
+// Plan:
+// 1. Create a cache of two topics and fields 'LAST_PRICE' and 'BID'.
+// 2. Open it with a 'LastValueReader' and look the topics and fields up.
+// 3. Update the second topic with both fields, then with 'LAST_PRICE' only,
+//    and verify that 'BID' keeps its value.
+//
+TEST_F(LastValueCacheTest, PublishesLastValues)
+{
+    LastValueCache cache;
+    ASSERT_TRUE(cache.create(d_name, d_topics, d_fields));
+
+    LastValueReader reader;
+    ASSERT_TRUE(reader.open(d_name));
+    ASSERT_EQ(2u, reader.numTopics());
+    ASSERT_EQ(2u, reader.numFields());
+    const std::size_t row = reader.findTopic("MSFT US Equity");
+    const std::size_t bid = reader.findField("BID");
+    ASSERT_EQ(1u, row);
+    ASSERT_EQ(1u, bid);
+    ASSERT_EQ(2u, reader.findTopic("AAPL US Equity"));
+
+    double value = 0;
+    ASSERT_FALSE(reader.read(&value, row, bid));
+
+    cache.update(1, makeValues(100.0, 99.5, true), 1);
+    cache.update(1, makeValues(101.0, 0, false), 2);
+
+    LastValue last;
+    ASSERT_TRUE(reader.read(&last, row));
+    ASSERT_EQ(2u, last.d_updates);
+    ASSERT_EQ(101.0, last.d_values[0]);
+    ASSERT_TRUE(reader.read(&value, row, bid));
+    ASSERT_EQ(99.5, value);
+    ASSERT_NE(0, last.d_updatedNs);
+
+    ASSERT_TRUE(reader.read(&last, 0));
+    ASSERT_EQ(0u, last.d_updates);
+    ASSERT_FALSE(last.has(0));
+}
+
+//
+// Concern: Verify that an update received before the last one applied to
+// its row is dropped.
+//
+TEST_F(LastValueCacheTest, DropsStaleUpdates)
+{
+    LastValueCache cache;
+    ASSERT_TRUE(cache.create(d_name, d_topics, d_fields));
+
+    cache.update(0, makeValues(2.0, 0, false), 200);
+    cache.update(0, makeValues(1.0, 0, false), 100);
+
+    LastValueReader reader;
+    ASSERT_TRUE(reader.open(d_name));
+    double value = 0;
+    ASSERT_TRUE(reader.read(&value, 0, 0));
+    ASSERT_EQ(2.0, value);
+    ASSERT_EQ(1u, cache.staleUpdates());
+}
+
+//
+// Concern: Verify that a reader never sees a row half way through an
+// update.
+//
+// Plan:
+// 1. Update one row on another thread, setting both fields to the same
+//    increasing value.
+// 2. Read the row concurrently and verify that both fields always hold the
+//    same value.
+//
+TEST_F(LastValueCacheTest, ReadsAreConsistent)
+{
+    LastValueCache cache;
+    ASSERT_TRUE(cache.create(d_name, d_topics, d_fields));
+    LastValueReader reader;
+    ASSERT_TRUE(reader.open(d_name));
+
+    const int   k_UPDATES = 200000;
+    std::thread writer([&cache, k_UPDATES]() {
+        for (int i = 1; i <= k_UPDATES; ++i) {
+            cache.update(0, makeValues(i, i, true), i);
+        }
+    });
+
+    LastValue last;
+    last.d_updates = 0;
+    do {
+        LastValue copy;
+        if (reader.read(&copy, 0)) {
+            ASSERT_EQ(copy.d_values[0], copy.d_values[1]);
+            last = copy;
+        }
+    } while (last.d_updates < static_cast<std::uint64_t>(k_UPDATES));
+    writer.join();
+}
+
+//
+// Concern: Verify that a reader does not open a cache that does not exist,
+// and that the cache is removed when destroyed.
+//
+TEST_F(LastValueCacheTest, ReaderNeedsCache)
+{
+    LastValueReader reader;
+    ASSERT_FALSE(reader.open(d_name));
+    {
+        LastValueCache cache;
+        ASSERT_TRUE(cache.create(d_name, d_topics, d_fields));
+    }
+    ASSERT_FALSE(reader.open(d_name));
+}
+
+//
+// Concern: Verify that a row left odd by a writer that stopped half way
+// through an update is reported unavailable instead of hanging the reader.
+//
+// Plan:
+// 1. Create a cache, map it writable from the test, and make the sequence
+//    of the first row odd as a writer taking it would.
+// 2. Verify that both 'read' overloads return false for that row and still
+//    read the second row.
+//
+TEST_F(LastValueCacheTest, AbandonedRowIsUnavailable)
+{
+    LastValueCache cache;
+    ASSERT_TRUE(cache.create(d_name, d_topics, d_fields));
+    cache.update(0, makeValues(1.0, 0, false), 1);
+    cache.update(1, makeValues(2.0, 0, false), 1);
+
+    const std::size_t size = LastValueHeader::rowsOffset()
+                             + d_topics.size() * sizeof(LastValueRow);
+    const int fd = shm_open(d_name.c_str(), O_RDWR, 0);
+    ASSERT_NE(-1, fd);
+    void *base = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(MAP_FAILED, base);
+    LastValueRow *rows = reinterpret_cast<LastValueRow *>(
+                      static_cast<char *>(base) + LastValueHeader::rowsOffset());
+    rows[0].d_sequence.fetch_add(1);
+
+    LastValueReader reader;
+    ASSERT_TRUE(reader.open(d_name));
+    LastValue last;
+    ASSERT_FALSE(reader.read(&last, 0));
+    double value = 0;
+    ASSERT_FALSE(reader.read(&value, 0, 0));
+    ASSERT_TRUE(reader.read(&value, 1, 0));
+    ASSERT_EQ(2.0, value);
+    munmap(base, size);
+}
+
+//
+// Concern: Verify that a topic too long to be stored whole is rejected
+// rather than truncated, since a truncated topic could never be found.
+//
+TEST_F(LastValueCacheTest, RejectsLongTopics)
+{
+    d_topics.push_back(std::string(LastValueRow::k_TOPIC_SIZE - 1, 'x'));
+    {
+        LastValueCache cache;
+        ASSERT_TRUE(cache.create(d_name, d_topics, d_fields));
+        LastValueReader reader;
+        ASSERT_TRUE(reader.open(d_name));
+        ASSERT_EQ(2u, reader.findTopic(d_topics.back()));
+    }
+
+    d_topics.push_back(std::string(LastValueRow::k_TOPIC_SIZE, 'y'));
+    LastValueCache cache;
+    ASSERT_FALSE(cache.create(d_name, d_topics, d_fields));
+    LastValueReader reader;
+    ASSERT_FALSE(reader.open(d_name));
+}
+
+//
+// Concern: Verify that a cache still written by a running process is not
+// replaced by a second one of the same name.
+//
+// Plan:
+// 1. Create a cache and update a row.
+// 2. Verify that creating a second cache of the same name fails and that
+//    the first is still readable.
+// 3. Destroy the first cache and verify that the second can be created.
+//
+TEST_F(LastValueCacheTest, KeepsCacheInUse)
+{
+    LastValueCache second;
+    {
+        LastValueCache first;
+        ASSERT_TRUE(first.create(d_name, d_topics, d_fields));
+        first.update(0, makeValues(1.0, 0, false), 1);
+
+        ASSERT_FALSE(second.create(d_name, d_topics, d_fields));
+        LastValueReader reader;
+        ASSERT_TRUE(reader.open(d_name));
+        double value = 0;
+        ASSERT_TRUE(reader.read(&value, 0, 0));
+        ASSERT_EQ(1.0, value);
+    }
+    ASSERT_TRUE(second.create(d_name, d_topics, d_fields));
+}
+
+//
+// Concern: Verify that a segment left by a run that is over is replaced,
+// whether it was never filled or its writer has exited.
+//
+// Plan:
+// 1. Make an empty segment, as a run stopped before filling it would
+//    leave, and verify that a cache can be created over it.
+// 2. Set the writer of that cache to a child process that has exited, as
+//    a run that did not exit cleanly would leave it, and verify that a
+//    second cache can be created over it and is readable.
+//
+TEST_F(LastValueCacheTest, ReplacesStaleCache)
+{
+    const int fd = shm_open(d_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    ASSERT_NE(-1, fd);
+    close(fd);
+
+    LastValueCache first;
+    ASSERT_TRUE(first.create(d_name, d_topics, d_fields));
+
+    const pid_t child = fork();
+    if (child == 0) {
+        _exit(0);
+    }
+    ASSERT_NE(-1, child);
+    ASSERT_EQ(child, waitpid(child, 0, 0));
+
+    const int rw = shm_open(d_name.c_str(), O_RDWR, 0);
+    ASSERT_NE(-1, rw);
+    void *base = mmap(0,
+                      sizeof(LastValueHeader),
+                      PROT_READ | PROT_WRITE,
+                      MAP_SHARED,
+                      rw,
+                      0);
+    close(rw);
+    ASSERT_NE(MAP_FAILED, base);
+    static_cast<LastValueHeader *>(base)->d_writerPid = child;
+    munmap(base, sizeof(LastValueHeader));
+
+    LastValueCache second;
+    ASSERT_TRUE(second.create(d_name, d_topics, d_fields));
+    second.update(1, makeValues(2.0, 0, false), 1);
+    LastValueReader reader;
+    ASSERT_TRUE(reader.open(d_name));
+    double value = 0;
+    ASSERT_TRUE(reader.read(&value, 1, 0));
+    ASSERT_EQ(2.0, value);
+}
@@ -0,0 +1,135 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <latencyhistogram.h>
+#include <latencymonitor.h>
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+//
+// Concern: Verify that every value falls in a bucket whose highest value is
+// at least the value and within the histogram's relative precision of it,
+// and that buckets are contiguous.
+//
+TEST(LatencyHistogramTest, BucketsCoverValuesWithBoundedError)
+{
+    for (std::uint64_t value = 0; value < 1000000; value += 1 + value / 7) {
+        std::size_t   bucket  = LatencyHistogram::bucketOf(value);
+        std::uint64_t highest = LatencyHistogram::highestValueIn(bucket);
+        ASSERT_GE(highest, value);
+        ASSERT_LE(highest - value, value / LatencyHistogram::k_SUB_BUCKETS);
+        if (bucket > 0) {
+            ASSERT_LT(LatencyHistogram::highestValueIn(bucket - 1), value);
+        }
+    }
+    ASSERT_EQ(LatencyHistogram::k_BUCKETS - 1,
+              LatencyHistogram::bucketOf(~std::uint64_t(0)));
+}
+
+//
+// Concern: Verify the percentiles, mean and maximum of a known distribution.
+//
+// Plan:
+// 1. Record 1..1000 microseconds.
+// 2. Verify that every percentile is within 1/32 of the exact one and that
+//    the maximum is exact.
+//
+TEST(LatencyHistogramTest, Percentiles)
+{
+    LatencyHistogram histogram;
+    for (std::uint64_t i = 1; i <= 1000; ++i) {
+        histogram.record(i * 1000);
+    }
+
+    LatencyHistogram::Summary summary = histogram.summary();
+    ASSERT_EQ(1000u, summary.d_count);
+    ASSERT_EQ(500500u, summary.d_meanNs);
+    ASSERT_NEAR(500000.0, static_cast<double>(summary.d_p50Ns), 500000 / 32);
+    ASSERT_NEAR(990000.0, static_cast<double>(summary.d_p99Ns), 990000 / 32);
+    ASSERT_NEAR(999000.0, static_cast<double>(summary.d_p999Ns), 999000 / 32);
+    ASSERT_EQ(1000000u, summary.d_maxNs);
+    ASSERT_LE(summary.d_p999Ns, summary.d_maxNs);
+
+    histogram.reset();
+    ASSERT_EQ(0u, histogram.summary().d_count);
+    ASSERT_EQ(0u, histogram.valueAtPercentile(50.0));
+}
+
+//
+// Concern: Verify that concurrent records are all counted.
+//
+TEST(LatencyHistogramTest, ConcurrentRecords)
+{
+    const int        k_THREADS = 4;
+    const int        k_RECORDS = 10000;
+    LatencyHistogram histogram;
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < k_THREADS; ++t) {
+        threads.push_back(std::thread([&histogram, t]() {
+            for (int i = 0; i < k_RECORDS; ++i) {
+                histogram.record(static_cast<std::uint64_t>(t * 1000 + i));
+            }
+        }));
+    }
+    for (std::size_t t = 0; t < threads.size(); ++t) {
+        threads[t].join();
+    }
+
+    LatencyHistogram::Summary summary = histogram.summary();
+    ASSERT_EQ(std::uint64_t(k_THREADS * k_RECORDS), summary.d_count);
+    ASSERT_EQ(std::uint64_t((k_THREADS - 1) * 1000 + k_RECORDS - 1),
+              summary.d_maxNs);
+}
+
+//
+// Concern: Verify that the monitor prints every stage when it stops and that
+// negative latencies are recorded as 0.
+//
+TEST(LatencyMonitorTest, PrintsEveryStageOnStop)
+{
+    std::ostringstream stream;
+    LatencyMonitor     monitor(&stream, 60000);
+
+    ASSERT_TRUE(monitor.start());
+    monitor.record(LatencyMonitor::e_RECEIVE_TO_DISPATCH, 1500);
+    monitor.record(LatencyMonitor::e_COMPUTE_TO_NOTIFY, -20);
+    monitor.stop();
+
+    const std::string output = stream.str();
+    EXPECT_NE(std::string::npos,
+              output.find("Latency receive->dispatch: count=1"));
+    EXPECT_NE(std::string::npos,
+              output.find("Latency dispatch->compute: count=0"));
+    EXPECT_NE(std::string::npos,
+              output.find("Latency compute->notify: count=1"));
+    EXPECT_NE(std::string::npos,
+              output.find("Latency receive->notify: count=0"));
+    ASSERT_EQ(0u,
+              monitor.histogram(LatencyMonitor::e_COMPUTE_TO_NOTIFY)
+                  .summary()
+                  .d_maxNs);
+}
@@ -0,0 +1,91 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <meteredeventhandler.h>
+#include <mockSession.h>
+#include <testSchemas.h>
+
+#include <blpapi_datetime.h>
+#include <blpapi_event.h>
+#include <blpapi_service.h>
+#include <blpapi_testutil.h>
+
+#include <sstream>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace blp    = BloombergLP::blpapi;
+namespace blptst = blp::test;
+
+class MockEventHandler : public blp::EventHandler {
+  public:
+    MOCK_METHOD2(processEvent, bool(const blp::Event&, blp::Session *));
+};
+
+namespace {
+const blp::Name MKTDATA_EVENTS("MarketDataEvents");
+}
+
+//
+// Concern: Verify that every event is forwarded and that events, messages
+// and lag samples are counted for the shard.
+//
+// Plan:
+// 1. Create a SubscriptionEvent with two `MarketDataEvents' messages, only
+//    the first of which carries a receive time.
+// 2. Process it through a MeteredEventHandler wrapping a mock handler.
+// 3. Verify that the mock handler received the event and that the
+//    statistics count one event, two messages and one lag sample.
+//
+TEST(MeteredEventHandlerTest, ForwardsAndCountsMessages)
+{
+    MockSession         session;
+    MockEventHandler    handler;
+    MeteredEventHandler meteredHandler(&handler, 3);
+
+    std::istringstream schemaStream(getMktDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+
+    const blp::SchemaElementDefinition schemaDef =
+        service.getEventDefinition(MKTDATA_EVENTS);
+
+    blptst::MessageProperties properties;
+    properties.setTimeReceived(blp::Datetime(2021, 1, 1, 12, 0, 0));
+
+    blp::Event event =
+        blptst::TestUtil::createEvent(blp::Event::SUBSCRIPTION_DATA);
+    blptst::TestUtil::appendMessage(event, schemaDef, properties)
+        .formatMessageJson("{\"LAST_PRICE\": 1.0}");
+    blptst::TestUtil::appendMessage(event, schemaDef)
+        .formatMessageJson("{\"LAST_PRICE\": 2.0}");
+
+    EXPECT_CALL(handler, processEvent(testing::_, &session))
+        .WillOnce(testing::Return(true));
+
+    ASSERT_TRUE(meteredHandler.processEvent(event, &session));
+
+    MeteredEventHandler::Statistics stats = meteredHandler.statistics();
+    ASSERT_EQ(3u, stats.d_shard);
+    ASSERT_EQ(1u, stats.d_events);
+    ASSERT_EQ(2u, stats.d_messages);
+    ASSERT_EQ(1u, stats.d_lagSamples);
+    ASSERT_EQ(stats.d_lagMaxNs, stats.d_lagTotalNs);
+}
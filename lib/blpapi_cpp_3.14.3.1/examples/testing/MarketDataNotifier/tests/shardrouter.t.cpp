@@ -0,0 +1,108 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <shardrouter.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace {
+std::vector<std::string> makeTopics(std::size_t count)
+{
+    std::vector<std::string> topics;
+    for (std::size_t i = 0; i < count; ++i) {
+        std::ostringstream topic;
+        topic << "/ticker/SYM" << i << " US Equity";
+        topics.push_back(topic.str());
+    }
+    return topics;
+}
+}
+
+//
+// Concern: Verify that a single shard owns every topic.
+//
+TEST(ShardRouterTest, SingleShardOwnsEverything)
+{
+    ShardRouter              router(1);
+    std::vector<std::string> topics = makeTopics(100);
+
+    for (std::size_t i = 0; i < topics.size(); ++i) {
+        ASSERT_EQ(0u, router.shardOf(topics[i]));
+    }
+}
+
+//
+// Concern: Verify that partitioning keeps every topic exactly once, in its
+// original order, and spreads topics roughly evenly.
+//
+// Plan:
+// 1. Partition 10000 topics over 4 shards.
+// 2. Verify the shard of every topic and that each shard holds between half
+//    and twice its fair share.
+//
+TEST(ShardRouterTest, PartitionIsCompleteAndBalanced)
+{
+    const std::size_t        k_SHARDS = 4;
+    ShardRouter              router(k_SHARDS);
+    std::vector<std::string> topics = makeTopics(10000);
+
+    std::vector<std::vector<std::string> > shards;
+    router.partition(&shards, topics);
+    ASSERT_EQ(k_SHARDS, shards.size());
+
+    std::size_t total = 0;
+    for (std::size_t s = 0; s < shards.size(); ++s) {
+        total += shards[s].size();
+        EXPECT_GT(shards[s].size(), topics.size() / k_SHARDS / 2);
+        EXPECT_LT(shards[s].size(), topics.size() / k_SHARDS * 2);
+        for (std::size_t i = 0; i < shards[s].size(); ++i) {
+            ASSERT_EQ(s, router.shardOf(shards[s][i]));
+        }
+    }
+    ASSERT_EQ(topics.size(), total);
+    ASSERT_EQ(topics[0], shards[router.shardOf(topics[0])][0]);
+}
+
+//
+// Concern: Verify that adding a shard only moves topics to the new shard and
+// moves a small fraction of them.
+//
+TEST(ShardRouterTest, AddingAShardMovesFewTopics)
+{
+    ShardRouter              before(4);
+    ShardRouter              after(5);
+    std::vector<std::string> topics = makeTopics(10000);
+
+    std::size_t moved = 0;
+    for (std::size_t i = 0; i < topics.size(); ++i) {
+        std::size_t from = before.shardOf(topics[i]);
+        std::size_t to   = after.shardOf(topics[i]);
+        if (from != to) {
+            ASSERT_EQ(4u, to);
+            ++moved;
+        }
+    }
+    EXPECT_LT(moved, topics.size() / 3);
+}
@@ -0,0 +1,76 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <subscriber.h>
+#include <topictable.h>
+#include <mockSession.h>
+
+#include <blpapi_identity.h>
+#include <blpapi_subscriptionlist.h>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using namespace testing;
+
+namespace blp = BloombergLP::blpapi;
+
+//
+// Concern: Verify that every topic is subscribed with the dense integer
+// correlation id assigned by the topic table.
+//
+// Plan:
+// 1. Create a Subscriber with a topic table that already has one topic.
+// 2. Set up expectation and save the subscription list passed to the
+//    session.
+// 3. Verify the topics are appended to the table and subscribed with their
+//    ids as integer correlation ids.
+//
+TEST(SubscriberTest, SubscribesWithTopicTableIds)
+{
+    MockSession session;
+    TopicTable  topicTable;
+    topicTable.add("/ticker/VOD LN Equity");
+    Subscriber  subscriber(&session, &topicTable);
+
+    std::vector<std::string> topics;
+    topics.push_back("/ticker/IBM US Equity");
+    topics.push_back("/ticker/MSFT US Equity");
+    std::vector<std::string> fields(1, "LAST_PRICE");
+    std::vector<std::string> options;
+
+    blp::SubscriptionList subscriptions;
+    EXPECT_CALL(session, subscribe(_, _, _, _))
+        .WillOnce(SaveArg<0>(&subscriptions));
+
+    subscriber.subscribe(
+        "//blp/mktdata", topics, fields, options, blp::Identity());
+
+    ASSERT_EQ(3u, topicTable.size());
+    ASSERT_EQ(topics[1], topicTable[2].d_topic);
+
+    ASSERT_EQ(2u, subscriptions.size());
+    for (size_t i = 0; i < subscriptions.size(); ++i) {
+        blp::CorrelationId cid = subscriptions.correlationIdAt(i);
+        ASSERT_EQ(blp::CorrelationId::INT_VALUE, cid.valueType());
+        ASSERT_EQ(static_cast<long long>(i + 1), cid.asInteger());
+        ASSERT_EQ(&topicTable[i + 1], topicTable.find(cid));
+    }
+}
@@ -201,6 +201,41 @@ const char *k_mktdataSchema("<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\
    </schema>\
 </ServiceDefinition>");
 
+// Following is a snippet of refdata service schema, holding the intraday
+// tick request and the layout of its response.
+const char *k_refdataSchema("<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\
+<ServiceDefinition name=\"blp.refdata\" version=\"1.0.1.0\">\
+   <service name=\"//blp/refdata\" version=\"1.0.0.0\">\
+      <operation name=\"IntradayTickRequest\" serviceId=\"88\">\
+         <request>IntradayTickRequest</request>\
+         <response>IntradayTickResponse</response>\
+         <responseSelection>IntradayTickResponse</responseSelection>\
+      </operation>\
+   </service>\
+   <schema>\
+      <sequenceType name=\"IntradayTickRequest\">\
+         <element name=\"security\" type=\"String\"/>\
+         <element name=\"startDateTime\" type=\"Datetime\"/>\
+         <element name=\"endDateTime\" type=\"Datetime\"/>\
+      </sequenceType>\
+      <sequenceType name=\"IntradayTick\">\
+         <element name=\"time\" type=\"Datetime\"/>\
+         <element name=\"type\" type=\"String\"/>\
+         <element name=\"value\" type=\"Float64\"/>\
+         <element name=\"size\" type=\"Int32\"/>\
+         <element name=\"conditionCodes\" type=\"String\" minOccurs=\"0\"\
+            maxOccurs=\"1\"/>\
+      </sequenceType>\
+      <sequenceType name=\"IntradayTickData\">\
+         <element name=\"tickData\" type=\"IntradayTick\" minOccurs=\"0\"\
+            maxOccurs=\"unbounded\"/>\
+      </sequenceType>\
+      <sequenceType name=\"IntradayTickResponse\">\
+         <element name=\"tickData\" type=\"IntradayTickData\"/>\
+      </sequenceType>\
+   </schema>\
+</ServiceDefinition>");
+
 const char *getApiAuthSchemaString()
 {
     return k_apiauthSchema;
@@ -210,3 +245,8 @@ const char *getMktDataSchemaString()
 {
     return k_mktdataSchema;
 }
+
+const char *getRefDataSchemaString()
+{
+    return k_refdataSchema;
+}
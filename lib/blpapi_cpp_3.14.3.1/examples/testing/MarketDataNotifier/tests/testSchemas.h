@@ -21,7 +21,8 @@
 //
 // testSchemas.h
 // This file contains example schemas for services (/blp/mktdata,
-// /blp/admin/, and /blp/auth) that are used by this application.
+// /blp/refdata, /blp/admin/, and /blp/auth) that are used by this
+// application.
 // These schemas may not be same as the schemas used by the services.
 //
 #ifndef _TEST_SCHEMAS_
@@ -29,5 +30,6 @@
 
 const char *getApiAuthSchemaString();
 const char *getMktDataSchemaString();
+const char *getRefDataSchemaString();
 
 #endif
@@ -0,0 +1,241 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <testSchemas.h>
+#include <tickstore.h>
+
+#include <blpapi_datetime.h>
+#include <blpapi_event.h>
+#include <blpapi_message.h>
+#include <blpapi_service.h>
+#include <blpapi_testutil.h>
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace blp    = BloombergLP::blpapi;
+namespace blptst = blp::test;
+
+namespace {
+const long long k_SECOND = 1000000000LL;
+}
+
+//
+// Concern: Verify that a time-range scan returns exactly the ticks in the
+// range, across chunk boundaries.
+//
+// Plan:
+// 1. Append two and a half chunks of ticks one second apart.
+// 2. Scan a range starting and ending inside different chunks and verify
+//    the first, last and number of ticks returned.
+// 3. Verify that other topics and empty ranges return nothing.
+//
+TEST(TickStoreTest, ScansTimeRanges)
+{
+    TickStore           store(2);
+    const std::uint16_t trade = store.typeId("TRADE");
+    const std::size_t   count = TickChunk::k_CAPACITY * 5 / 2;
+    for (std::size_t i = 0; i < count; ++i) {
+        store.append(0, i * k_SECOND, 100.0 + i, 10, trade);
+    }
+
+    std::vector<TickStore::Row> rows;
+    const long long begin = 4000 * k_SECOND;
+    const long long end   = 9000 * k_SECOND;
+    ASSERT_EQ(5000u, store.scan(&rows, 0, begin, end));
+    ASSERT_EQ(begin, rows.front().d_timeNs);
+    ASSERT_EQ(4100.0, rows.front().d_price);
+    ASSERT_EQ(end - k_SECOND, rows.back().d_timeNs);
+    ASSERT_EQ(trade, rows.back().d_type);
+
+    rows.clear();
+    ASSERT_EQ(0u, store.scan(&rows, 1, 0, end));
+    ASSERT_EQ(0u, store.scan(&rows, 0, end, end));
+    ASSERT_EQ(0u, store.scan(&rows, 2, 0, end));
+
+    TickStore::Statistics stats = store.statistics();
+    ASSERT_EQ(count, stats.d_ticks);
+    ASSERT_EQ(3u, stats.d_residentChunks);
+}
+
+//
+// Concern: Verify that ticks appended out of time order are still found.
+//
+TEST(TickStoreTest, ScansLateTicks)
+{
+    TickStore           store(1);
+    const std::uint16_t trade = store.typeId("TRADE");
+    store.append(0, 10 * k_SECOND, 1.0, 1, trade);
+    store.append(0, 30 * k_SECOND, 3.0, 1, trade);
+    store.append(0, 20 * k_SECOND, 2.0, 1, trade);
+    store.append(0, 5 * k_SECOND, 0.5, 1, trade);
+
+    std::vector<TickStore::Row> rows;
+    ASSERT_EQ(2u, store.scan(&rows, 0, 15 * k_SECOND, 31 * k_SECOND));
+    ASSERT_EQ(3.0, rows[0].d_price);
+    ASSERT_EQ(2.0, rows[1].d_price);
+
+    rows.clear();
+    ASSERT_EQ(1u, store.scan(&rows, 0, 0, 6 * k_SECOND));
+    ASSERT_EQ(0.5, rows[0].d_price);
+}
+
+//
+// Concern: Verify that downsampling builds one bar per interval with ticks
+// of the requested type.
+//
+// Plan:
+// 1. Append trades and bids over three minutes, none in the second minute.
+// 2. Downsample the trades into one-minute bars and verify their open,
+//    high, low, close, volume and tick count.
+//
+TEST(TickStoreTest, DownsamplesIntoBars)
+{
+    TickStore           store(1);
+    const std::uint16_t trade = store.typeId("TRADE");
+    const std::uint16_t bid   = store.typeId("BID");
+    const long long     start = 1559568600 * k_SECOND;
+    store.append(0, start + 1 * k_SECOND, 10.0, 100, trade);
+    store.append(0, start + 2 * k_SECOND, 9.0, 1000, bid);
+    store.append(0, start + 20 * k_SECOND, 12.0, 50, trade);
+    store.append(0, start + 40 * k_SECOND, 8.0, 25, trade);
+    store.append(0, start + 59 * k_SECOND, 11.0, 25, trade);
+    store.append(0, start + 150 * k_SECOND, 13.0, 10, trade);
+
+    std::vector<TickBar> bars;
+    ASSERT_EQ(2u,
+              store.downsample(&bars,
+                               0,
+                               start,
+                               start + 180 * k_SECOND,
+                               60 * k_SECOND,
+                               trade));
+    ASSERT_EQ(start, bars[0].d_startNs);
+    ASSERT_EQ(10.0, bars[0].d_open);
+    ASSERT_EQ(12.0, bars[0].d_high);
+    ASSERT_EQ(8.0, bars[0].d_low);
+    ASSERT_EQ(11.0, bars[0].d_close);
+    ASSERT_EQ(200.0, bars[0].d_volume);
+    ASSERT_EQ(4u, bars[0].d_numTicks);
+    ASSERT_EQ(start + 120 * k_SECOND, bars[1].d_startNs);
+    ASSERT_EQ(13.0, bars[1].d_open);
+    ASSERT_EQ(1u, bars[1].d_numTicks);
+}
+
+//
+// Concern: Verify that sealed chunks beyond the resident limit are spilled
+// to the file and still scanned.
+//
+// Plan:
+// 1. Create a store keeping one sealed chunk in memory, spilling to a
+//    temporary file.
+// 2. Append four and a half chunks of ticks and verify that three chunks
+//    were spilled.
+// 3. Scan every tick and verify their values.
+//
+TEST(TickStoreTest, SpillsSealedChunks)
+{
+    const std::string path = "tickstore.t." + std::to_string(getpid());
+    TickStore         store(1, 1);
+    ASSERT_TRUE(store.spillTo(path));
+
+    const std::uint16_t trade = store.typeId("TRADE");
+    const std::size_t   count = TickChunk::k_CAPACITY * 9 / 2;
+    for (std::size_t i = 0; i < count; ++i) {
+        store.append(0, i, static_cast<double>(i), 1, trade);
+    }
+
+    TickStore::Statistics stats = store.statistics();
+    ASSERT_EQ(3u, stats.d_spilledChunks);
+    ASSERT_EQ(2u, stats.d_residentChunks);
+
+    std::vector<TickStore::Row> rows;
+    ASSERT_EQ(count, store.scan(&rows, 0, 0, count));
+    for (std::size_t i = 0; i < count; ++i) {
+        ASSERT_EQ(static_cast<double>(i), rows[i].d_price);
+    }
+    std::remove(path.c_str());
+}
+
+//
+// Concern: Verify that the ticks of an 'IntradayTickResponse' are appended
+// with their type, size, condition codes and time.
+//
+// Plan:
+// 1. Build an IntradayTickResponse holding a trade with condition codes
+//    and a bid without.
+// 2. Append its 'tickData' and scan the ticks back.
+//
+TEST(TickStoreTest, AppendsIntradayTickData)
+{
+    std::istringstream schemaStream(getRefDataSchemaString());
+    blp::Service service = blptst::TestUtil::deserializeService(schemaStream);
+    blp::Event   event   = blptst::TestUtil::createEvent(blp::Event::RESPONSE);
+    blptst::TestUtil::appendMessage(
+        event,
+        service.getOperation("IntradayTickRequest").responseDefinition(0))
+        .formatMessageJson(
+            "{\"tickData\": {\"tickData\": ["
+            "{\"time\": \"2019-06-03T13:30:00.000\", \"type\": \"TRADE\","
+            " \"value\": 10.5, \"size\": 100, \"conditionCodes\": \"R6\"},"
+            "{\"time\": \"2019-06-03T13:30:01.000\", \"type\": \"BID\","
+            " \"value\": 10.25, \"size\": 300}]}}");
+
+    TickStore            store(1);
+    blp::MessageIterator iter(event);
+    ASSERT_TRUE(iter.next());
+    ASSERT_EQ(2u, store.appendTickData(0, iter.message().asElement()
+                                              .getElement("tickData")));
+
+    std::vector<TickStore::Row> rows;
+    ASSERT_EQ(2u, store.scan(&rows, 0, 0, 1600000000 * k_SECOND));
+    ASSERT_EQ(1559568600 * k_SECOND, rows[0].d_timeNs);
+    ASSERT_EQ("TRADE", store.typeName(rows[0].d_type));
+    ASSERT_EQ(10.5, rows[0].d_price);
+    ASSERT_EQ(100.0, rows[0].d_size);
+    ASSERT_EQ("R6", store.conditionName(rows[0].d_condition));
+    ASSERT_EQ("BID", store.typeName(rows[1].d_type));
+    ASSERT_EQ(TickStore::k_NO_CONDITION, rows[1].d_condition);
+}
+
+//
+// Concern: Verify that datetimes are converted to nanoseconds since the
+// Unix epoch, with their offset and fraction of a second.
+//
+TEST(TickStoreTest, ConvertsDatetimes)
+{
+    ASSERT_EQ(0, TickStore::toNanoseconds(blp::Datetime(1970, 1, 1, 0, 0, 0)));
+    ASSERT_EQ(1559568600 * k_SECOND + 250000000,
+              TickStore::toNanoseconds(
+                  blp::Datetime(2019, 6, 3, 13, 30, 0, 250)));
+    ASSERT_EQ(951782400 * k_SECOND,
+              TickStore::toNanoseconds(blp::Datetime(2000, 2, 29, 0, 0, 0)));
+
+    blp::Datetime newYork(2019, 6, 3, 9, 30, 0);
+    newYork.setOffset(-240);
+    ASSERT_EQ(1559568600 * k_SECOND, TickStore::toNanoseconds(newYork));
+}
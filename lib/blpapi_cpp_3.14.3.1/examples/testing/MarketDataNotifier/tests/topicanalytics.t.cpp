@@ -0,0 +1,161 @@
+/* Copyright 2019. Bloomberg Finance L.P.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:  The above
+ * copyright notice and this permission notice shall be included in all copies
+ * or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <computekernels.h>
+#include <topicanalytics.h>
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace {
+double sampleDeviation(const std::vector<double>& values,
+                       std::size_t                first,
+                       std::size_t                last)
+    // Return the sample standard deviation of 'values[first, last)',
+    // computed in two passes.
+{
+    const std::size_t n = last - first;
+    if (n < 2) {
+        return 0;
+    }
+    double mean = 0;
+    for (std::size_t i = first; i < last; ++i) {
+        mean += values[i];
+    }
+    mean /= n;
+    double sumSquares = 0;
+    for (std::size_t i = first; i < last; ++i) {
+        sumSquares += (values[i] - mean) * (values[i] - mean);
+    }
+    return std::sqrt(sumSquares / (n - 1));
+}
+}
+
+//
+// Concern: Verify that the rolling volatility is that of the last 'window'
+// values only, and stays accurate for values far from zero, where a
+// running sum of squares cancels.
+//
+// Plan:
+// 1. Add values around 1e9 to a window of 8 one at a time.
+// 2. After each, compare with a two-pass deviation of the last 8 values.
+//
+TEST(RollingVolatilityTest, MatchesTwoPassOverWindow)
+{
+    const std::size_t   k_WINDOW = 8;
+    RollingVolatility   volatility(k_WINDOW);
+    std::vector<double> values;
+    ASSERT_EQ(0, volatility.value());
+    for (std::size_t i = 0; i < 1000; ++i) {
+        values.push_back(1e9 + std::sin(i * 0.37) + (i % 3) * 0.25);
+        volatility.add(values.back());
+
+        const std::size_t first = values.size() > k_WINDOW
+                                      ? values.size() - k_WINDOW
+                                      : 0;
+        ASSERT_EQ(values.size() - first, volatility.count());
+        ASSERT_NEAR(sampleDeviation(values, first, values.size()),
+                    volatility.value(),
+                    1e-6);
+    }
+}
+
+//
+// Concern: Verify that analytics updated in several batches are the same as
+// analytics updated in one, and match their definitions.
+//
+// Plan:
+// 1. Update one 'TopicAnalytics' with 20 ticks at once and another with
+//    the same ticks in batches of 1, 3 and 16.
+// 2. Verify the VWAP, the EWMA seeded with the first price, and the
+//    volatility of the returns in the window of both.
+//
+TEST(TopicAnalyticsTest, BatchesAccumulate)
+{
+    const std::size_t   k_COUNT = 20;
+    std::vector<double> prices;
+    std::vector<double> sizes;
+    for (std::size_t i = 0; i < k_COUNT; ++i) {
+        prices.push_back(100.0 + std::sin(i * 0.37) * 5.0);
+        sizes.push_back(static_cast<double>(1 + (i * 7) % 13));
+    }
+
+    TopicAnalytics whole(0.5, 10);
+    TickBatch      batch;
+    batch.d_prices = &prices[0];
+    batch.d_sizes  = &sizes[0];
+    batch.d_count  = k_COUNT;
+    whole.update(batch);
+
+    TopicAnalytics    pieces(0.5, 10);
+    const std::size_t counts[] = { 1, 3, 16 };
+    std::size_t       offset   = 0;
+    for (std::size_t i = 0; i < 3; ++i) {
+        batch.d_prices = &prices[offset];
+        batch.d_sizes  = &sizes[offset];
+        batch.d_count  = counts[i];
+        pieces.update(batch);
+        offset += counts[i];
+    }
+
+    double              expectedEwma = prices[0];
+    std::vector<double> returns;
+    for (std::size_t i = 0; i < k_COUNT; ++i) {
+        expectedEwma = 0.5 * prices[i] + 0.5 * expectedEwma;
+        if (i > 0) {
+            returns.push_back(prices[i] / prices[i - 1] - 1.0);
+        }
+    }
+    const double expectedVolatility = sampleDeviation(returns,
+                                                      returns.size() - 10,
+                                                      returns.size());
+
+    ASSERT_EQ(k_COUNT, whole.ticks());
+    ASSERT_EQ(k_COUNT, pieces.ticks());
+    ASSERT_NEAR(ComputeKernels::vwap(&prices[0], &sizes[0], k_COUNT),
+                whole.vwap(),
+                1e-9);
+    ASSERT_NEAR(whole.vwap(), pieces.vwap(), 1e-9);
+    ASSERT_NEAR(expectedEwma, whole.ewma(), 1e-9);
+    ASSERT_NEAR(expectedEwma, pieces.ewma(), 1e-9);
+    ASSERT_NEAR(expectedVolatility, whole.volatility(), 1e-12);
+    ASSERT_NEAR(expectedVolatility, pieces.volatility(), 1e-12);
+}
+
+//
+// Concern: Verify that analytics without sizes have no VWAP.
+//
+TEST(TopicAnalyticsTest, NoSizesNoVwap)
+{
+    const double   prices[] = { 10.0, 11.0 };
+    TopicAnalytics analytics;
+    TickBatch      batch;
+    batch.d_prices = prices;
+    batch.d_count  = 2;
+    analytics.update(batch);
+
+    ASSERT_EQ(0, analytics.vwap());
+    ASSERT_EQ(2u, analytics.ticks());
+    ASSERT_EQ(0, analytics.volatility());
+}
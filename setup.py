@@ -0,0 +1,26 @@
+import os
+
+import pybind11
+from setuptools import Extension, setup
+
+BLPAPI_ROOT = os.environ.get('BLPAPI_ROOT', 'lib/blpapi_cpp_3.14.3.1')
+
+setup(
+    name='trades',
+    packages=['trades'],
+    ext_modules=[
+        Extension(
+            'trades._refdata',
+            sources=['trades/_refdata.cpp'],
+            include_dirs=[
+                pybind11.get_include(),
+                os.path.join(BLPAPI_ROOT, 'include'),
+                os.path.join(BLPAPI_ROOT, 'examples'),
+            ],
+            library_dirs=[os.path.join(BLPAPI_ROOT, 'Linux')],
+            libraries=['blpapi3_64'],
+            extra_compile_args=['-std=c++11'],
+            language='c++',
+        ),
+    ],
+)
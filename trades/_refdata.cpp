@@ -0,0 +1,269 @@
+// Python bindings for the bulk reference data engine in
+// lib/blpapi_cpp_3.14.3.1/examples/BlpRefDataEngine.h, built by setup.py as
+// 'trades._refdata'.  'Connection.ref' sends every security and field in
+// pipelined ReferenceDataRequests and returns a 'Result' whose 'values' is a
+// (fields, securities) NumPy array over the engine's own buffer.
+
+#include <BlpRefDataEngine.h>
+
+#include <blpapi_exception.h>
+#include <blpapi_session.h>
+#include <blpapi_sessionoptions.h>
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace py = pybind11;
+namespace blp = BloombergLP::blpapi;
+
+using BloombergLP::RefDataColumns;
+using BloombergLP::RefDataEngine;
+
+namespace {
+
+class RequestError : public std::runtime_error {
+    // Raised as 'trades._refdata.RequestError' when the data did not come
+    // back; the session is still usable.
+
+  public:
+    explicit RequestError(const std::string& what)
+    : std::runtime_error(what)
+    {
+    }
+};
+
+bool allFailed(const RefDataColumns& result)
+{
+    // A cell fails on its own, or with the rest of its security.
+    const std::size_t numSecurities = result.numSecurities();
+    if (numSecurities == 0 || result.numFields() == 0) {
+        return false;
+    }
+    for (std::size_t s = 0; s < numSecurities; ++s) {
+        if (!result.d_securityErrors[s].empty()) {
+            continue;
+        }
+        for (std::size_t f = 0; f < result.numFields(); ++f) {
+            if (result.d_errors.find(result.cell(s, f))
+                                                   == result.d_errors.end()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+std::string describeErrors(const RefDataColumns& result)
+{
+    // List the first few errors; a failed request fails every cell of it.
+    const std::size_t k_MAX_LISTED  = 10;
+    const std::size_t numSecurities = result.numSecurities();
+    std::size_t       count         = 0;
+    std::string       text;
+    for (std::size_t s = 0; s < numSecurities; ++s) {
+        if (!result.d_securityErrors[s].empty()) {
+            if (count++ < k_MAX_LISTED) {
+                text += "\n  " + result.d_securities[s] + ": "
+                        + result.d_securityErrors[s];
+            }
+        }
+    }
+    for (const auto& entry : result.d_errors) {
+        if (count++ < k_MAX_LISTED) {
+            text += "\n  " + result.d_securities[entry.first % numSecurities]
+                    + " " + result.d_fields[entry.first / numSecurities]
+                    + ": " + entry.second;
+        }
+    }
+    if (count > k_MAX_LISTED) {
+        text += "\n  and " + std::to_string(count - k_MAX_LISTED) + " more";
+    }
+    return text;
+}
+
+class Connection {
+    blp::SessionOptions             d_options;
+    std::unique_ptr<blp::Session>   d_session;
+    std::unique_ptr<RefDataEngine>  d_engine;
+    int                             d_timeoutMs;
+    std::size_t                     d_securitiesPerRequest;
+    std::size_t                     d_maxInFlight;
+    RefDataEngine::Statistics       d_lastStatistics;
+
+  public:
+    Connection(const std::string& host,
+               int                port,
+               int                timeoutMs,
+               std::size_t        securitiesPerRequest,
+               std::size_t        maxInFlight)
+    : d_timeoutMs(timeoutMs)
+    , d_securitiesPerRequest(securitiesPerRequest)
+    , d_maxInFlight(maxInFlight)
+    {
+        d_options.setServerHost(host.c_str());
+        d_options.setServerPort(static_cast<unsigned short>(port));
+        d_session.reset(new blp::Session(d_options));
+    }
+
+    void start()
+    {
+        if (d_engine) {
+            return;
+        }
+        if (!d_session->start()) {
+            throw std::runtime_error("Failed to start session");
+        }
+        if (!d_session->openService("//blp/refdata")) {
+            d_session->stop();
+            throw std::runtime_error("Failed to open //blp/refdata");
+        }
+        d_engine.reset(new RefDataEngine(
+                                   d_session.get(),
+                                   d_session->getService("//blp/refdata"),
+                                   d_securitiesPerRequest,
+                                   d_maxInFlight));
+    }
+
+    void stop()
+    {
+        if (d_engine) {
+            d_engine.reset();
+            d_session->stop();
+        }
+    }
+
+    std::shared_ptr<RefDataColumns> ref(
+                                  const std::vector<std::string>& securities,
+                                  const std::vector<std::string>& fields)
+    {
+        if (!d_engine) {
+            throw std::runtime_error("Connection is not started");
+        }
+        std::shared_ptr<RefDataColumns> result(new RefDataColumns());
+        int rc = d_engine->fetch(result.get(),
+                                 securities,
+                                 fields,
+                                 d_timeoutMs,
+                                 &d_lastStatistics);
+        if (rc == RefDataEngine::e_TIMEOUT) {
+            throw std::runtime_error("Timed out waiting for reference data"
+                                     + describeErrors(*result));
+        }
+        if (rc == RefDataEngine::e_REQUEST_FAILED) {
+            throw RequestError("Reference data request failed"
+                               + describeErrors(*result));
+        }
+        if (allFailed(*result)) {
+            throw RequestError("No reference data was returned"
+                               + describeErrors(*result));
+        }
+        return result;
+    }
+
+    py::dict statistics() const
+    {
+        py::dict stats;
+        stats["requests"]   = d_lastStatistics.d_requests;
+        stats["messages"]   = d_lastStatistics.d_messages;
+        stats["values"]     = d_lastStatistics.d_values;
+        stats["elapsed_ns"] = d_lastStatistics.d_elapsedNs;
+        return stats;
+    }
+};
+
+py::array values(py::object self)
+{
+    // The array is a view of 'd_values' and keeps 'self' alive as its base.
+    const RefDataColumns& result = self.cast<const RefDataColumns&>();
+    const std::size_t     rows   = result.numFields();
+    const std::size_t     cols   = result.numSecurities();
+    return py::array_t<double>({ rows, cols },
+                               { cols * sizeof(double), sizeof(double) },
+                               result.d_values.data(),
+                               self);
+}
+
+py::dict cells(const RefDataColumns&                result,
+               const std::map<size_t, std::string>& byCell)
+{
+    // Key by (security, field) rather than by cell.
+    py::dict    dict;
+    std::size_t numSecurities = result.numSecurities();
+    for (const auto& entry : byCell) {
+        dict[py::make_tuple(result.d_securities[entry.first % numSecurities],
+                            result.d_fields[entry.first / numSecurities])] =
+            entry.second;
+    }
+    return dict;
+}
+
+}  // close unnamed namespace
+
+PYBIND11_MODULE(_refdata, m)
+{
+    m.doc() = "Bulk Bloomberg reference data over pipelined requests";
+
+    py::class_<RefDataColumns, std::shared_ptr<RefDataColumns>>(m, "Result")
+        .def_property_readonly(
+            "securities",
+            [](const RefDataColumns& r) { return r.d_securities; })
+        .def_property_readonly(
+            "fields",
+            [](const RefDataColumns& r) { return r.d_fields; })
+        .def_property_readonly("values", &values,
+                               "(fields, securities) float64 array, NaN "
+                               "where there is no numeric value")
+        .def_property_readonly(
+            "strings",
+            [](const RefDataColumns& r) { return cells(r, r.d_strings); },
+            "{(security, field): str} for values that are not numbers")
+        .def_property_readonly(
+            "errors",
+            [](const RefDataColumns& r) { return cells(r, r.d_errors); },
+            "{(security, field): str} for field exceptions and failed "
+            "requests")
+        .def_property_readonly(
+            "security_errors",
+            [](const RefDataColumns& r) {
+                py::dict dict;
+                for (std::size_t i = 0; i < r.numSecurities(); ++i) {
+                    if (!r.d_securityErrors[i].empty()) {
+                        dict[py::str(r.d_securities[i])] =
+                                                      r.d_securityErrors[i];
+                    }
+                }
+                return dict;
+            });
+
+    py::class_<Connection>(m, "Connection")
+        .def(py::init<const std::string&,
+                      int,
+                      int,
+                      std::size_t,
+                      std::size_t>(),
+             py::arg("host"),
+             py::arg("port"),
+             py::arg("timeout") = 5000,
+             py::arg("securities_per_request") = 100,
+             py::arg("max_in_flight") = 16)
+        .def("start", &Connection::start,
+             py::call_guard<py::gil_scoped_release>())
+        .def("stop", &Connection::stop,
+             py::call_guard<py::gil_scoped_release>())
+        .def("ref", &Connection::ref,
+             py::arg("securities"),
+             py::arg("fields"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("statistics", &Connection::statistics);
+
+    py::register_exception<blp::Exception>(m, "BlpapiError");
+    py::register_exception<RequestError>(m, "RequestError");
+}
@@ -0,0 +1,61 @@
+import threading
+
+import numpy as np
+import pandas as pd
+
+from trades import _refdata
+
+HOST = '192.168.1.196'
+PORT = 6970
+TIMEOUT_MS = 5000
+
+_lock = threading.Lock()
+_connection = None
+
+
+def _connect():
+    global _connection
+    if _connection is None:
+        connection = _refdata.Connection(HOST, PORT, timeout=TIMEOUT_MS)
+        connection.start()
+        _connection = connection
+    return _connection
+
+
+def ref(securities, fields):
+    """Reference data for every security and field, shaped like pdblp's
+    BCon.ref: one row per (ticker, field) with the value or NaN.
+
+    Raises _refdata.RequestError, listing the errors, if a request failed
+    or no cell has a value, and RuntimeError if the data timed out."""
+    securities = [str(s) for s in securities]
+    fields = [str(f) for f in fields]
+    if not securities or not fields:
+        return pd.DataFrame(columns=['ticker', 'field', 'value'])
+
+    global _connection
+    with _lock:
+        try:
+            result = _connect().ref(securities, fields)
+        except _refdata.RequestError:
+            raise
+        except Exception:
+            # Start over with a fresh session on the next call.
+            if _connection is not None:
+                _connection.stop()
+                _connection = None
+            raise
+
+    data = pd.DataFrame({
+        'ticker': np.tile(result.securities, len(result.fields)),
+        'field': np.repeat(result.fields, len(result.securities)),
+        'value': result.values.ravel(),
+    })
+    strings = result.strings
+    if strings:
+        data['value'] = data['value'].astype(object)
+        keys = list(zip(data['ticker'], data['field']))
+        for i, key in enumerate(keys):
+            if key in strings:
+                data.at[i, 'value'] = strings[key]
+    return data
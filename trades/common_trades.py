@@ -2,7 +2,7 @@ import pandas as pd
 import numpy as np
 import re
 
-import pdblp
+from trades import bloomberg
 
 from trades.odbc import *
 
@@ -10,11 +10,7 @@ from trades.odbc import *
 def getLmePrices(ser: pd.Series):
     if ser.empty:
         return pd.DataFrame(columns=['ticker', 'value'])
-    con = pdblp.BCon(debug=False, host='192.168.1.196', port=6970, timeout=5000)
-    con.start()
-    data = con.ref(list(ser), 'PX_SETTLE')
-    con.stop()
-    return data
+    return bloomberg.ref(list(ser), ['PX_SETTLE'])
 
 
 # input_data
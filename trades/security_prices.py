@@ -1,16 +1,15 @@
 import pandas as pd
 
-import pdblp
+from trades import bloomberg
 
 from trades.odbc import *
 
 
 def getSecPrices(df: pd.DataFrame):
-    con = pdblp.BCon(debug=True, host='192.168.1.196', port=6970, timeout=5000)
-    con.start()
-    data = pd.concat([con.ref(list(df['BloombergCode'][df['field'] == field]), field) for field in df.field.unique()])
-    con.stop()
-    return data
+    # One pipelined batch for every code and field, then keep only the pairs asked for.
+    data = bloomberg.ref(df['BloombergCode'].unique(), df['field'].unique())
+    wanted = df[['BloombergCode', 'field']].drop_duplicates().rename(columns={'BloombergCode': 'ticker'})
+    return data.merge(wanted, on=['ticker', 'field'])
 
 
 def logic(date):